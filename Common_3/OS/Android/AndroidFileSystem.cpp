@@ -136,8 +136,11 @@ bool initFileSystem(FileSystemInitDesc* pDesc)
 	return true;
 }
 
+void exitAsyncFileIO();
+
 void exitFileSystem()
 {
+	exitAsyncFileIO();
 	gInitialized = false;
 }
 
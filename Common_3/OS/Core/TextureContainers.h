@@ -737,7 +737,7 @@ if (!(exp))                   \
 
 	TinyKtx_Callbacks callbacks
 	{
-		[](void* user, char const* msg) { LOGF(eERROR, msg); },
+		[](void* user, char const* msg) { LOGF(eERROR, "%s", msg); },
 		[](void* user, size_t size) { return tf_malloc(size); },
 		[](void* user, void* memory) { tf_free(memory); },
 		[](void* user, void* buffer, size_t byteCount) { return fsReadFromStream((FileStream*)user, buffer, (ssize_t)byteCount); },
@@ -22,156 +22,606 @@
  * under the License.
 */
 
+
 #include "../Interfaces/IThread.h"
 #include "../Interfaces/ILog.h"
 
 #include "ThreadSystem.h"
+#include "Atomics.h"
 #include "../Interfaces/IMemory.h"
 
+#define THREAD_SYSTEM_CACHE_LINE_SIZE 64
+#define THREAD_SYSTEM_INITIAL_DEQUE_SIZE 256
+#define THREAD_SYSTEM_INITIAL_INBOX_SIZE 64
+// Target number of parallel-for chunks per thread when no grain size is given
+#define THREAD_SYSTEM_PARALLEL_FOR_CHUNKS_PER_THREAD 8
+// Number of failed search rounds a worker does before it goes to sleep
+#define THREAD_SYSTEM_SPIN_COUNT 64
+
 struct ThreadedTask
 {
-	TaskFunc  mTask;
-	void*     mUser;
-	uintptr_t mStart;
-	uintptr_t mEnd;
+	TaskFunc     mTask;
+	void*        mUser;
+	uintptr_t    mStart;
+	uintptr_t    mEnd;
+	TaskCounter* pCounter;
+	// Set for parallel-for chunks: [mStart, mEnd) is handed to the range function in one go and split on demand
+	const ParallelForDesc* pParallelFor;
 };
 
-struct ThreadSystem
+// Task waiting for a counter to reach zero before it gets queued
+struct TaskContinuation
+{
+	ThreadedTask      mTask;
+	TaskContinuation* pNext;
+};
+
+/************************************************************************/
+// Chase-Lev work-stealing deque
+// The owner pushes and pops at the bottom, any other thread steals from the top.
+// Buffers replaced during growth are kept alive until shutdown since a thief may still read from them.
+/************************************************************************/
+struct TaskDequeBuffer
+{
+	TaskDequeBuffer* pPrev;
+	uint64_t         mMask;
+	ThreadedTask     mTasks[1];
+};
+
+struct ALIGNAS(THREAD_SYSTEM_CACHE_LINE_SIZE) TaskDeque
+{
+	tfrg_atomic64_t  mTop;
+	uint8_t          mPadTop[THREAD_SYSTEM_CACHE_LINE_SIZE - sizeof(uint64_t)];
+	tfrg_atomic64_t  mBottom;
+	tfrg_atomicptr_t mBuffer;
+};
+
+static TaskDequeBuffer* allocDequeBuffer(uint64_t size, TaskDequeBuffer* pPrev)
+{
+	TaskDequeBuffer* pBuffer = (TaskDequeBuffer*)tf_malloc(sizeof(TaskDequeBuffer) + (size - 1) * sizeof(ThreadedTask));
+	pBuffer->pPrev = pPrev;
+	pBuffer->mMask = size - 1;
+	return pBuffer;
+}
+
+static void initDeque(TaskDeque* pDeque)
+{
+	pDeque->mTop = 0;
+	pDeque->mBottom = 0;
+	pDeque->mBuffer = (uintptr_t)allocDequeBuffer(THREAD_SYSTEM_INITIAL_DEQUE_SIZE, NULL);
+}
+
+static void exitDeque(TaskDeque* pDeque)
 {
-	ThreadDesc                 mThreadDescs[MAX_LOAD_THREADS];
-	ThreadHandle               mThread[MAX_LOAD_THREADS];
-	ThreadedTask			   mLoadTask[MAX_SYSTEM_TASKS];
-	uint32_t				   mBegin, mEnd;
-	ConditionVariable          mQueueCond;
-	Mutex                      mQueueMutex;
-	ConditionVariable          mIdleCond;
-	uint32_t                   mNumLoaders;
-	uint32_t                   mNumIdleLoaders;
-	volatile bool              mRun;
+	TaskDequeBuffer* pBuffer = (TaskDequeBuffer*)pDeque->mBuffer;
+	while (pBuffer)
+	{
+		TaskDequeBuffer* pPrev = pBuffer->pPrev;
+		tf_free(pBuffer);
+		pBuffer = pPrev;
+	}
+}
+
+// Owner only
+static void pushDeque(TaskDeque* pDeque, const ThreadedTask& task)
+{
+	int64_t          bottom = (int64_t)tfrg_atomic64_load_relaxed(&pDeque->mBottom);
+	int64_t          top = (int64_t)tfrg_atomic64_load_acquire(&pDeque->mTop);
+	TaskDequeBuffer* pBuffer = (TaskDequeBuffer*)tfrg_atomicptr_load_relaxed(&pDeque->mBuffer);
+
+	if (bottom - top > (int64_t)pBuffer->mMask)
+	{
+		TaskDequeBuffer* pNewBuffer = allocDequeBuffer((pBuffer->mMask + 1) * 2, pBuffer);
+		for (int64_t i = top; i < bottom; ++i)
+			pNewBuffer->mTasks[i & pNewBuffer->mMask] = pBuffer->mTasks[i & pBuffer->mMask];
+		tfrg_memorybarrier_full();
+		tfrg_atomicptr_store_relaxed(&pDeque->mBuffer, (uintptr_t)pNewBuffer);
+		pBuffer = pNewBuffer;
+	}
+
+	pBuffer->mTasks[bottom & pBuffer->mMask] = task;
+	tfrg_memorybarrier_full();
+	tfrg_atomic64_store_relaxed(&pDeque->mBottom, (uint64_t)(bottom + 1));
+}
+
+// Owner only
+static bool popDeque(TaskDeque* pDeque, ThreadedTask* pTask)
+{
+	int64_t          bottom = (int64_t)tfrg_atomic64_load_relaxed(&pDeque->mBottom) - 1;
+	TaskDequeBuffer* pBuffer = (TaskDequeBuffer*)tfrg_atomicptr_load_relaxed(&pDeque->mBuffer);
+	tfrg_atomic64_store_relaxed(&pDeque->mBottom, (uint64_t)bottom);
+	tfrg_memorybarrier_full();
+	int64_t top = (int64_t)tfrg_atomic64_load_relaxed(&pDeque->mTop);
+
+	if (top > bottom)
+	{
+		tfrg_atomic64_store_relaxed(&pDeque->mBottom, (uint64_t)(bottom + 1));
+		return false;
+	}
 
+	*pTask = pBuffer->mTasks[bottom & pBuffer->mMask];
+	if (top == bottom)
+	{
+		// Last element: race against thieves
+		bool won = (int64_t)tfrg_atomic64_cas_relaxed(&pDeque->mTop, (uint64_t)top, (uint64_t)(top + 1)) == top;
+		tfrg_atomic64_store_relaxed(&pDeque->mBottom, (uint64_t)(bottom + 1));
+		return won;
+	}
+
+	return true;
+}
+
+// Any thread. With pCounter set, only a top task signaling pCounter is taken
+static bool stealDeque(TaskDeque* pDeque, ThreadedTask* pTask, const TaskCounter* pCounter)
+{
+	int64_t top = (int64_t)tfrg_atomic64_load_acquire(&pDeque->mTop);
+	tfrg_memorybarrier_full();
+	int64_t bottom = (int64_t)tfrg_atomic64_load_acquire(&pDeque->mBottom);
+
+	if (top >= bottom)
+		return false;
+
+	TaskDequeBuffer* pBuffer = (TaskDequeBuffer*)tfrg_atomicptr_load_acquire(&pDeque->mBuffer);
+	ThreadedTask     task = pBuffer->mTasks[top & pBuffer->mMask];
+	if (pCounter && task.pCounter != pCounter)
+		return false;
+	if ((int64_t)tfrg_atomic64_cas_relaxed(&pDeque->mTop, (uint64_t)top, (uint64_t)(top + 1)) != top)
+		return false;
+
+	*pTask = task;
+	return true;
+}
+
+/************************************************************************/
+// Mutex protected FIFO used for tasks coming from threads outside of the pool
+/************************************************************************/
+struct TaskInbox
+{
+	Mutex         mMutex;
+	ThreadedTask* pTasks;
+	uint32_t      mCapacity;
+	uint32_t      mHead;
+	uint32_t      mCount;
+};
+
+static void initInbox(TaskInbox* pInbox)
+{
+	pInbox->mMutex.Init();
+	pInbox->pTasks = (ThreadedTask*)tf_malloc(THREAD_SYSTEM_INITIAL_INBOX_SIZE * sizeof(ThreadedTask));
+	pInbox->mCapacity = THREAD_SYSTEM_INITIAL_INBOX_SIZE;
+	pInbox->mHead = 0;
+	pInbox->mCount = 0;
+}
+
+static void exitInbox(TaskInbox* pInbox)
+{
+	tf_free(pInbox->pTasks);
+	pInbox->mMutex.Destroy();
+}
+
+// mMutex must be held
+static void pushInbox(TaskInbox* pInbox, const ThreadedTask& task)
+{
+	if (pInbox->mCount == pInbox->mCapacity)
+	{
+		ThreadedTask* pTasks = (ThreadedTask*)tf_malloc(pInbox->mCapacity * 2 * sizeof(ThreadedTask));
+		for (uint32_t i = 0; i < pInbox->mCount; ++i)
+			pTasks[i] = pInbox->pTasks[(pInbox->mHead + i) % pInbox->mCapacity];
+		tf_free(pInbox->pTasks);
+		pInbox->pTasks = pTasks;
+		pInbox->mCapacity *= 2;
+		pInbox->mHead = 0;
+	}
+
+	pInbox->pTasks[(pInbox->mHead + pInbox->mCount) % pInbox->mCapacity] = task;
+	++pInbox->mCount;
+}
+
+// mMutex must be held
+static bool popInbox(TaskInbox* pInbox, ThreadedTask* pTask)
+{
+	if (!pInbox->mCount)
+		return false;
+
+	*pTask = pInbox->pTasks[pInbox->mHead];
+	pInbox->mHead = (pInbox->mHead + 1) % pInbox->mCapacity;
+	--pInbox->mCount;
+	return true;
+}
+
+/************************************************************************/
+// Thread system
+/************************************************************************/
+struct ALIGNAS(THREAD_SYSTEM_CACHE_LINE_SIZE) ThreadSystemWorker
+{
+	TaskDeque     mDeque;
+	TaskInbox     mInbox;
+	ThreadDesc    mThreadDesc;
+	ThreadHandle  mThread;
+	ThreadSystem* pThreadSystem;
+	uint32_t      mRandomState;
 #if defined(NX64)
-	ThreadTypeNX			   mThreadType[MAX_LOAD_THREADS];
+	ThreadTypeNX  mThreadType;
 #endif
 };
 
-bool assistThreadSystemTasks(ThreadSystem* pThreadSystem, uint32_t* pIds, size_t count)
+struct ThreadSystem
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	if (pThreadSystem->mBegin == pThreadSystem->mEnd)
+	ThreadSystemWorker* pWorkers;
+	uint32_t            mNumLoaders;
+	// Number of task entries currently sitting in deques or inboxes
+	tfrg_atomic32_t     mQueuedTasks;
+	// Number of task indices which have been added but not finished yet
+	tfrg_atomic64_t     mPendingTasks;
+	tfrg_atomic32_t     mNumSleepingLoaders;
+	// Number of threads blocked in waitTaskCounter
+	tfrg_atomic32_t     mNumCounterWaiters;
+	// Bumped by every push while mNumCounterWaiters is set, tells a waiter that new tasks may be worth searching
+	tfrg_atomic32_t     mCounterGeneration;
+	tfrg_atomic32_t     mNextInbox;
+	Mutex               mSleepMutex;
+	ConditionVariable   mQueueCond;
+	ConditionVariable   mIdleCond;
+	ConditionVariable   mCounterCond;
+	volatile bool       mRun;
+};
+
+static thread_local ThreadSystemWorker* pCurrentWorker = NULL;
+
+static ThreadSystemWorker* getCurrentWorker(ThreadSystem* pThreadSystem)
+{
+	return (pCurrentWorker && pCurrentWorker->pThreadSystem == pThreadSystem) ? pCurrentWorker : NULL;
+}
+
+static void pushTask(ThreadSystem* pThreadSystem, const ThreadedTask& task)
+{
+	ThreadSystemWorker* pWorker = getCurrentWorker(pThreadSystem);
+	if (pWorker)
 	{
-		pThreadSystem->mQueueMutex.Release();
-		return false;
+		pushDeque(&pWorker->mDeque, task);
+	}
+	else
+	{
+		uint32_t   inbox = tfrg_atomic32_add_relaxed(&pThreadSystem->mNextInbox, 1) % pThreadSystem->mNumLoaders;
+		TaskInbox* pInbox = &pThreadSystem->pWorkers[inbox].mInbox;
+		MutexLock  lock(pInbox->mMutex);
+		pushInbox(pInbox, task);
 	}
 
-	uint32_t taskSize = pThreadSystem->mBegin >= pThreadSystem->mEnd ? pThreadSystem->mBegin - pThreadSystem->mEnd : MAX_SYSTEM_TASKS - (pThreadSystem->mEnd - pThreadSystem->mBegin);
-	ThreadedTask resourceTask;
-	bool found = false;
+	// Full barrier, pairs with the sleeper count increments in taskThreadFunc and waitTaskCounter
+	tfrg_atomic32_add_relaxed(&pThreadSystem->mQueuedTasks, 1);
+	if (tfrg_atomic32_load_relaxed(&pThreadSystem->mNumSleepingLoaders))
+	{
+		MutexLock lock(pThreadSystem->mSleepMutex);
+		pThreadSystem->mQueueCond.WakeOne();
+	}
+	if (tfrg_atomic32_load_relaxed(&pThreadSystem->mNumCounterWaiters))
+	{
+		MutexLock lock(pThreadSystem->mSleepMutex);
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mCounterGeneration, 1);
+		pThreadSystem->mCounterCond.WakeAll();
+	}
+}
 
-	for (uint32_t i = 0; i < taskSize; ++i)
+static void lockCounter(TaskCounter* pCounter)
+{
+	while (tfrg_atomic32_cas_relaxed(&pCounter->mLock, 0, 1) != 0)
 	{
-		uint32_t index = (pThreadSystem->mEnd + i) % MAX_SYSTEM_TASKS;
-		resourceTask = pThreadSystem->mLoadTask[index];
+	}
+}
 
-		for (size_t j = 0; j < count; ++j)
+static void unlockCounter(TaskCounter* pCounter)
+{
+	tfrg_atomic32_store_release(&pCounter->mLock, 0);
+}
+
+// count is the number of times runTask will be called for this entry and its remainders
+static void addTask(ThreadSystem* pThreadSystem, const ThreadedTask& task, uint64_t count, TaskCounter* pWaitCounter)
+{
+	tfrg_atomic64_add_relaxed(&pThreadSystem->mPendingTasks, count);
+	if (task.pCounter)
+		tfrg_atomic64_add_relaxed(&task.pCounter->mValue, count);
+
+	if (pWaitCounter && tfrg_atomic64_load_acquire(&pWaitCounter->mValue))
+	{
+		lockCounter(pWaitCounter);
+		if (tfrg_atomic64_load_relaxed(&pWaitCounter->mValue))
 		{
-			if (pIds[j] == resourceTask.mStart)
-			{
-				found = true;
-				break;
-			}
+			TaskContinuation* pContinuation = (TaskContinuation*)tf_malloc(sizeof(TaskContinuation));
+			pContinuation->mTask = task;
+			pContinuation->pNext = pWaitCounter->pContinuations;
+			pWaitCounter->pContinuations = pContinuation;
+			unlockCounter(pWaitCounter);
+			return;
 		}
+		unlockCounter(pWaitCounter);
+	}
 
-		if (found)
-		{
-			if (resourceTask.mStart + 1 == resourceTask.mEnd)
-			{
-				pThreadSystem->mLoadTask[index] = pThreadSystem->mLoadTask[pThreadSystem->mEnd];
-				++pThreadSystem->mEnd;
-				pThreadSystem->mEnd = pThreadSystem->mEnd % MAX_SYSTEM_TASKS;
-			}
-			else
-			{
-				++pThreadSystem->mLoadTask[index].mStart;
-			}
+	pushTask(pThreadSystem, task);
+}
+
+static void signalCounter(ThreadSystem* pThreadSystem, TaskCounter* pCounter)
+{
+	for (;;)
+	{
+		uint64_t value = tfrg_atomic64_load_relaxed(&pCounter->mValue);
+		ASSERT(value);
+		if (value == 1)
 			break;
-		}
+		if ((uint64_t)tfrg_atomic64_cas_relaxed(&pCounter->mValue, value, value - 1) == value)
+			return;
 	}
 
-	pThreadSystem->mQueueMutex.Release();
+	// Last index: the final decrement happens under the lock so a waiter (see isTaskCounterDone) cannot return and
+	// release the counter while we still touch it. The counter may also have been re-armed by a new task in the
+	// meantime, in which case its continuations stay put.
+	lockCounter(pCounter);
+	TaskContinuation* pContinuation = NULL;
+	if (tfrg_atomic64_add_relaxed(&pCounter->mValue, (uint64_t)-1) == 1)
+	{
+		pContinuation = pCounter->pContinuations;
+		pCounter->pContinuations = NULL;
+	}
+	unlockCounter(pCounter);
 
-	if (!found)
+	while (pContinuation)
 	{
-		return false;
+		TaskContinuation* pNext = pContinuation->pNext;
+		pushTask(pThreadSystem, pContinuation->mTask);
+		tf_free(pContinuation);
+		pContinuation = pNext;
 	}
 
-	resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
-	return true;
+	if (tfrg_atomic32_load_relaxed(&pThreadSystem->mNumCounterWaiters))
+	{
+		MutexLock lock(pThreadSystem->mSleepMutex);
+		pThreadSystem->mCounterCond.WakeAll();
+	}
 }
 
-bool assistThreadSystem(ThreadSystem* pThreadSystem)
+static bool stealTask(ThreadSystem* pThreadSystem, ThreadSystemWorker* pThief, ThreadedTask* pTask)
+{
+	const uint32_t numLoaders = pThreadSystem->mNumLoaders;
+	uint32_t       first = 0;
+	if (pThief)
+	{
+		// xorshift to pick a random victim so thieves do not all hammer the same worker
+		uint32_t x = pThief->mRandomState;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		pThief->mRandomState = x;
+		first = x % numLoaders;
+	}
+
+	for (uint32_t i = 0; i < numLoaders; ++i)
+	{
+		ThreadSystemWorker* pVictim = &pThreadSystem->pWorkers[(first + i) % numLoaders];
+		if (pVictim != pThief && stealDeque(&pVictim->mDeque, pTask, NULL))
+			return true;
+
+		TaskInbox* pInbox = &pVictim->mInbox;
+		if (pInbox->mCount && pInbox->mMutex.TryAcquire())
+		{
+			bool found = popInbox(pInbox, pTask);
+			pInbox->mMutex.Release();
+			if (found)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static bool findTask(ThreadSystem* pThreadSystem, ThreadSystemWorker* pWorker, ThreadedTask* pTask)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	if (pThreadSystem->mBegin != pThreadSystem->mEnd)
+	bool found = false;
+	if (pWorker)
 	{
-		ThreadedTask resourceTask = pThreadSystem->mLoadTask[pThreadSystem->mEnd];
-		if (resourceTask.mStart + 1 == resourceTask.mEnd)
+		found = popDeque(&pWorker->mDeque, pTask);
+		if (!found && pWorker->mInbox.mCount)
 		{
-			++pThreadSystem->mEnd;
-			pThreadSystem->mEnd = pThreadSystem->mEnd % MAX_SYSTEM_TASKS;
+			MutexLock lock(pWorker->mInbox.mMutex);
+			found = popInbox(&pWorker->mInbox, pTask);
 		}
-		else
+	}
+
+	if (!found)
+		found = stealTask(pThreadSystem, pWorker, pTask);
+
+	if (found)
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mQueuedTasks, -1);
+
+	return found;
+}
+
+static uintptr_t getParallelForGrainSize(ThreadSystem* pThreadSystem, const ParallelForDesc* pDesc)
+{
+	if (pDesc->mGrainSize)
+		return pDesc->mGrainSize;
+
+	// Small enough for splitting to balance heterogeneous cores, big enough to amortize the function call
+	const uintptr_t count = pDesc->mEnd - pDesc->mBegin;
+	return max<uintptr_t>(count / (THREAD_SYSTEM_PARALLEL_FOR_CHUNKS_PER_THREAD * (pThreadSystem->mNumLoaders + 1)), 1);
+}
+
+static void runParallelForRange(ThreadSystem* pThreadSystem, const ParallelForDesc* pDesc, uintptr_t begin, uintptr_t end)
+{
+	const uintptr_t grainSize = getParallelForGrainSize(pThreadSystem, pDesc);
+	while (begin < end)
+	{
+		// Lazy binary splitting: give away the upper half whenever nothing is queued, so a thread running out of
+		// work always finds something to steal while busy threads keep their ranges to themselves
+		while (end - begin > grainSize && (int32_t)tfrg_atomic32_load_relaxed(&pThreadSystem->mQueuedTasks) <= 0)
 		{
-			++pThreadSystem->mLoadTask[pThreadSystem->mEnd].mStart;
+			uintptr_t middle = begin + (end - begin) / 2;
+			addTask(pThreadSystem, ThreadedTask{ NULL, NULL, middle, end, pDesc->pSignalCounter, pDesc }, 1, NULL);
+			end = middle;
 		}
-		pThreadSystem->mQueueMutex.Release();
-		resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
 
-		return true;
+		uintptr_t chunkEnd = min<uintptr_t>(begin + grainSize, end);
+		pDesc->pFunc(pDesc->pUser, begin, chunkEnd);
+		begin = chunkEnd;
+	}
+}
+
+static void runTask(ThreadSystem* pThreadSystem, const ThreadedTask& task)
+{
+	if (task.pParallelFor)
+	{
+		runParallelForRange(pThreadSystem, task.pParallelFor, task.mStart, task.mEnd);
 	}
 	else
 	{
-		pThreadSystem->mQueueMutex.Release();
-		return false;
+		// Hand the rest of a range back to the pool before running the first index so idle workers can pick it up
+		if (task.mStart + 1 < task.mEnd)
+			pushTask(pThreadSystem, ThreadedTask{ task.mTask, task.mUser, task.mStart + 1, task.mEnd, task.pCounter, NULL });
+
+		task.mTask(task.mUser, task.mStart);
+	}
+
+	if (task.pCounter)
+		signalCounter(pThreadSystem, task.pCounter);
+
+	if (tfrg_atomic64_add_relaxed(&pThreadSystem->mPendingTasks, (uint64_t)-1) == 1)
+	{
+		MutexLock lock(pThreadSystem->mSleepMutex);
+		pThreadSystem->mIdleCond.WakeAll();
 	}
 }
 
-static void taskThreadFunc(void* pThreadData)
+// Only tasks waiting in the inboxes can be searched, tasks in the deques are owned by their workers.
+// This covers the common case of a non-worker thread waiting for specific tasks it has added itself.
+template <typename Pred>
+static bool assistInboxTask(ThreadSystem* pThreadSystem, Pred pred)
 {
-	ThreadSystem* pThreadSystem = (ThreadSystem*)pThreadData;
-	while (pThreadSystem->mRun)
+	for (uint32_t w = 0; w < pThreadSystem->mNumLoaders; ++w)
 	{
-		pThreadSystem->mQueueMutex.Acquire();
-		++pThreadSystem->mNumIdleLoaders;
-		while (pThreadSystem->mRun && pThreadSystem->mBegin == pThreadSystem->mEnd)
-		{
-			pThreadSystem->mIdleCond.WakeAll();
-			pThreadSystem->mQueueCond.Wait(pThreadSystem->mQueueMutex);
-		}
-		--pThreadSystem->mNumIdleLoaders;
-		if (pThreadSystem->mBegin != pThreadSystem->mEnd)
+		TaskInbox*   pInbox = &pThreadSystem->pWorkers[w].mInbox;
+		ThreadedTask resourceTask = {};
+		bool         found = false;
+
+		if (!pInbox->mCount)
+			continue;
+
+		pInbox->mMutex.Acquire();
+		for (uint32_t i = 0; i < pInbox->mCount; ++i)
 		{
-			ThreadedTask resourceTask = pThreadSystem->mLoadTask[pThreadSystem->mEnd];// pThreadSystem->mLoadQueue.front();
-			if (resourceTask.mStart + 1 == resourceTask.mEnd)
-			{
-				++pThreadSystem->mEnd;
-				pThreadSystem->mEnd = pThreadSystem->mEnd % MAX_SYSTEM_TASKS;
-			}
-			else
+			uint32_t index = (pInbox->mHead + i) % pInbox->mCapacity;
+			resourceTask = pInbox->pTasks[index];
+
+			if (pred(resourceTask))
 			{
-				++pThreadSystem->mLoadTask[pThreadSystem->mEnd].mStart;
+				found = true;
+				// Parallel-for chunks are taken as a whole, they split themselves
+				if (resourceTask.pParallelFor || resourceTask.mStart + 1 == resourceTask.mEnd)
+				{
+					pInbox->pTasks[index] = pInbox->pTasks[pInbox->mHead];
+					pInbox->mHead = (pInbox->mHead + 1) % pInbox->mCapacity;
+					--pInbox->mCount;
+					tfrg_atomic32_add_relaxed(&pThreadSystem->mQueuedTasks, -1);
+				}
+				else
+				{
+					++pInbox->pTasks[index].mStart;
+				}
+				break;
 			}
-			pThreadSystem->mQueueMutex.Release();
-			resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
 		}
-		else
+		pInbox->mMutex.Release();
+
+		if (found)
 		{
-			pThreadSystem->mQueueMutex.Release();
+			if (!resourceTask.pParallelFor)
+				resourceTask.mEnd = resourceTask.mStart + 1;
+			runTask(pThreadSystem, resourceTask);
+			return true;
 		}
 	}
-	pThreadSystem->mQueueMutex.Acquire();
-	++pThreadSystem->mNumIdleLoaders;
-	pThreadSystem->mIdleCond.WakeAll();
-	pThreadSystem->mQueueMutex.Release();
+
+	return false;
+}
+
+// Runs one queued task signaling pCounter. Deques are only looked at from the ends the caller may take from:
+// the bottom of its own deque and the top of the others.
+// The bottom task of the caller's own deque is run whatever its counter, tasks of pCounter queued below it could
+// not be reached otherwise and nobody else may run them, e.g. with a single worker.
+static bool assistCounterTask(ThreadSystem* pThreadSystem, ThreadSystemWorker* pWorker, const TaskCounter* pCounter)
+{
+	ThreadedTask resourceTask;
+	bool         found = pWorker && popDeque(&pWorker->mDeque, &resourceTask);
+
+	for (uint32_t i = 0; !found && i < pThreadSystem->mNumLoaders; ++i)
+	{
+		ThreadSystemWorker* pVictim = &pThreadSystem->pWorkers[i];
+		found = pVictim != pWorker && stealDeque(&pVictim->mDeque, &resourceTask, pCounter);
+	}
+
+	if (found)
+	{
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mQueuedTasks, -1);
+		runTask(pThreadSystem, resourceTask);
+		return true;
+	}
+
+	return assistInboxTask(pThreadSystem, [pCounter](const ThreadedTask& task) { return task.pCounter == pCounter; });
+}
+
+bool assistThreadSystemTasks(ThreadSystem* pThreadSystem, uint32_t* pIds, size_t count)
+{
+	return assistInboxTask(pThreadSystem, [pIds, count](const ThreadedTask& task) {
+		if (task.pParallelFor)
+			return false;
+		for (size_t j = 0; j < count; ++j)
+		{
+			if (pIds[j] == task.mStart)
+				return true;
+		}
+		return false;
+	});
+}
+
+bool assistThreadSystem(ThreadSystem* pThreadSystem)
+{
+	ThreadedTask resourceTask;
+	if (!findTask(pThreadSystem, getCurrentWorker(pThreadSystem), &resourceTask))
+		return false;
+
+	runTask(pThreadSystem, resourceTask);
+	return true;
+}
+
+static void taskThreadFunc(void* pThreadData)
+{
+	ThreadSystemWorker* pWorker = (ThreadSystemWorker*)pThreadData;
+	ThreadSystem*       pThreadSystem = pWorker->pThreadSystem;
+	pCurrentWorker = pWorker;
+
+	uint32_t spin = 0;
+	while (pThreadSystem->mRun)
+	{
+		ThreadedTask resourceTask;
+		if (findTask(pThreadSystem, pWorker, &resourceTask))
+		{
+			runTask(pThreadSystem, resourceTask);
+			spin = 0;
+			continue;
+		}
+
+		if (++spin < THREAD_SYSTEM_SPIN_COUNT)
+			continue;
+
+		spin = 0;
+		pThreadSystem->mSleepMutex.Acquire();
+		// Full barrier, pairs with the queued task increment in pushTask
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, 1);
+		while (pThreadSystem->mRun && (int32_t)tfrg_atomic32_load_relaxed(&pThreadSystem->mQueuedTasks) <= 0)
+			pThreadSystem->mQueueCond.Wait(pThreadSystem->mSleepMutex);
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, -1);
+		pThreadSystem->mSleepMutex.Release();
+	}
+
+	pCurrentWorker = NULL;
 }
 
 void initThreadSystem(ThreadSystem** ppThreadSystem, uint32_t numRequestedThreads, int preferredCore, bool migrateEnabled, const char* threadName)
@@ -179,46 +629,91 @@ void initThreadSystem(ThreadSystem** ppThreadSystem, uint32_t numRequestedThread
 	ThreadSystem* pThreadSystem = tf_new(ThreadSystem);
 
 	uint32_t numThreads = max<uint32_t>(Thread::GetNumCPUCores() - 1, 1);
-	uint32_t numLoaders = min<uint32_t>(numThreads, min<uint32_t>(numRequestedThreads, MAX_LOAD_THREADS));
+	uint32_t numLoaders = max<uint32_t>(min<uint32_t>(numThreads, numRequestedThreads), 1);
 
-	pThreadSystem->mQueueMutex.Init();
+	pThreadSystem->mSleepMutex.Init();
 	pThreadSystem->mQueueCond.Init();
 	pThreadSystem->mIdleCond.Init();
-	
+	pThreadSystem->mCounterCond.Init();
+
 	pThreadSystem->mRun = true;
-	pThreadSystem->mNumIdleLoaders = 0;
-	pThreadSystem->mBegin = 0;
-	pThreadSystem->mEnd = 0;
+	pThreadSystem->mQueuedTasks = 0;
+	pThreadSystem->mPendingTasks = 0;
+	pThreadSystem->mNumSleepingLoaders = 0;
+	pThreadSystem->mNumCounterWaiters = 0;
+	pThreadSystem->mCounterGeneration = 0;
+	pThreadSystem->mNextInbox = 0;
+	pThreadSystem->mNumLoaders = numLoaders;
+	pThreadSystem->pWorkers =
+		(ThreadSystemWorker*)tf_calloc_memalign(numLoaders, alignof(ThreadSystemWorker), sizeof(ThreadSystemWorker));
+
+	for (uint32_t i = 0; i < numLoaders; ++i)
+	{
+		ThreadSystemWorker* pWorker = &pThreadSystem->pWorkers[i];
+		initDeque(&pWorker->mDeque);
+		initInbox(&pWorker->mInbox);
+		pWorker->pThreadSystem = pThreadSystem;
+		pWorker->mRandomState = 0x9E3779B9u * (i + 1);
+	}
 
-	for (unsigned i = 0; i < numLoaders; ++i)
+	// All deques need to exist before any worker starts stealing
+	for (uint32_t i = 0; i < numLoaders; ++i)
 	{
-		pThreadSystem->mThreadDescs[i].pFunc = taskThreadFunc;
-		pThreadSystem->mThreadDescs[i].pData = pThreadSystem;
+		ThreadSystemWorker* pWorker = &pThreadSystem->pWorkers[i];
+		pWorker->mThreadDesc.pFunc = taskThreadFunc;
+		pWorker->mThreadDesc.pData = pWorker;
 
 #if defined(NX64)
-		pThreadSystem->mThreadDescs[i].pThreadStack = aligned_alloc(THREAD_STACK_ALIGNMENT_NX, ALIGNED_THREAD_STACK_SIZE_NX);
-		pThreadSystem->mThreadDescs[i].hThread = &pThreadSystem->mThreadType[i];
-		pThreadSystem->mThreadDescs[i].preferredCore = preferredCore;
-		pThreadSystem->mThreadDescs[i].pThreadName = threadName;
-		pThreadSystem->mThreadDescs[i].migrateEnabled = migrateEnabled;
+		pWorker->mThreadDesc.pThreadStack = aligned_alloc(THREAD_STACK_ALIGNMENT_NX, ALIGNED_THREAD_STACK_SIZE_NX);
+		pWorker->mThreadDesc.hThread = &pWorker->mThreadType;
+		pWorker->mThreadDesc.preferredCore = preferredCore;
+		pWorker->mThreadDesc.pThreadName = threadName;
+		pWorker->mThreadDesc.migrateEnabled = migrateEnabled;
 #endif
 
-		pThreadSystem->mThread[i] = create_thread(&pThreadSystem->mThreadDescs[i]);
+		pWorker->mThread = create_thread(&pWorker->mThreadDesc);
 	}
-	pThreadSystem->mNumLoaders = numLoaders;
 
 	*ppThreadSystem = pThreadSystem;
 }
 
 void addThreadSystemTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t index)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	pThreadSystem->mLoadTask[pThreadSystem->mBegin++] = ThreadedTask{ task, user, index, index + 1 };
-	pThreadSystem->mBegin = pThreadSystem->mBegin % MAX_SYSTEM_TASKS;
-	LOGF_IF(LogLevel::eERROR, pThreadSystem->mBegin == pThreadSystem->mEnd, "Maximum amount of thread task reached: mBegin (%d), mEnd(%d), Max(%d)", pThreadSystem->mBegin, pThreadSystem->mEnd, MAX_SYSTEM_TASKS);
-	ASSERT(pThreadSystem->mBegin != pThreadSystem->mEnd);
-	pThreadSystem->mQueueMutex.Release();
-	pThreadSystem->mQueueCond.WakeAll();
+	ThreadSystemTaskDesc desc = { task, user, index, index + 1 };
+	addThreadSystemTasks(pThreadSystem, &desc);
+}
+
+void addThreadSystemTasks(ThreadSystem* pThreadSystem, const ThreadSystemTaskDesc* pDesc)
+{
+	ASSERT(pDesc);
+	if (pDesc->mStart >= pDesc->mEnd)
+		return;
+
+	ThreadedTask task = { pDesc->pTask, pDesc->pUser, pDesc->mStart, pDesc->mEnd, pDesc->pSignalCounter, NULL };
+	addTask(pThreadSystem, task, (uint64_t)(pDesc->mEnd - pDesc->mStart), pDesc->pWaitCounter);
+}
+
+void addThreadSystemParallelFor(ThreadSystem* pThreadSystem, const ParallelForDesc* pDesc)
+{
+	ASSERT(pDesc && pDesc->pFunc);
+	if (pDesc->mBegin >= pDesc->mEnd)
+		return;
+
+	ThreadedTask task = { NULL, NULL, pDesc->mBegin, pDesc->mEnd, pDesc->pSignalCounter, pDesc };
+	addTask(pThreadSystem, task, 1, pDesc->pWaitCounter);
+}
+
+void parallelFor(ThreadSystem* pThreadSystem, uintptr_t begin, uintptr_t end, uintptr_t grainSize, TaskRangeFunc func, void* user)
+{
+	if (begin >= end)
+		return;
+
+	TaskCounter     counter = {};
+	ParallelForDesc desc = { func, user, begin, end, grainSize, &counter, NULL };
+
+	// The calling thread takes the whole range and splits it as workers run out of work
+	runParallelForRange(pThreadSystem, &desc, begin, end);
+	waitTaskCounter(pThreadSystem, &counter);
 }
 
 uint32_t getThreadSystemThreadCount(ThreadSystem* pThreadSystem)
@@ -228,59 +723,98 @@ uint32_t getThreadSystemThreadCount(ThreadSystem* pThreadSystem)
 
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	pThreadSystem->mLoadTask[pThreadSystem->mBegin++] = ThreadedTask{ task, user, 0, count };
-	pThreadSystem->mBegin = pThreadSystem->mBegin % MAX_SYSTEM_TASKS;
-	LOGF_IF(LogLevel::eERROR, pThreadSystem->mBegin == pThreadSystem->mEnd, "Maximum amount of thread task reached: mBegin (%d), mEnd(%d), Max(%d)", pThreadSystem->mBegin, pThreadSystem->mEnd, MAX_SYSTEM_TASKS);
-	ASSERT(pThreadSystem->mBegin != pThreadSystem->mEnd);
-	pThreadSystem->mQueueMutex.Release();
-	pThreadSystem->mQueueCond.WakeAll();
+	ThreadSystemTaskDesc desc = { task, user, 0, count };
+	addThreadSystemTasks(pThreadSystem, &desc);
 }
 
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t start, uintptr_t end)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	pThreadSystem->mLoadTask[pThreadSystem->mBegin++] = ThreadedTask{ task, user, start, end };
-	pThreadSystem->mBegin = pThreadSystem->mBegin % MAX_SYSTEM_TASKS;
-	LOGF_IF(LogLevel::eERROR, pThreadSystem->mBegin == pThreadSystem->mEnd, "Maximum amount of thread task reached: mBegin (%d), mEnd(%d), Max(%d)", pThreadSystem->mBegin, pThreadSystem->mEnd, MAX_SYSTEM_TASKS);
-	ASSERT(pThreadSystem->mBegin != pThreadSystem->mEnd);
-	pThreadSystem->mQueueMutex.Release();
-	pThreadSystem->mQueueCond.WakeAll();
+	ThreadSystemTaskDesc desc = { task, user, start, end };
+	addThreadSystemTasks(pThreadSystem, &desc);
 }
 
 void shutdownThreadSystem(ThreadSystem* pThreadSystem)
 {
-	pThreadSystem->mQueueMutex.Acquire();
+	pThreadSystem->mSleepMutex.Acquire();
 	pThreadSystem->mRun = false;
-	pThreadSystem->mQueueMutex.Release();
 	pThreadSystem->mQueueCond.WakeAll();
-	pThreadSystem->mBegin = 0;
-	pThreadSystem->mEnd = 0;
+	pThreadSystem->mIdleCond.WakeAll();
+	pThreadSystem->mCounterCond.WakeAll();
+	pThreadSystem->mSleepMutex.Release();
 
 	uint32_t numLoaders = pThreadSystem->mNumLoaders;
 	for (uint32_t i = 0; i < numLoaders; ++i)
 	{
-		destroy_thread(pThreadSystem->mThread[i]);
+		destroy_thread(pThreadSystem->pWorkers[i].mThread);
+	}
+
+	for (uint32_t i = 0; i < numLoaders; ++i)
+	{
+		exitDeque(&pThreadSystem->pWorkers[i].mDeque);
+		exitInbox(&pThreadSystem->pWorkers[i].mInbox);
 	}
 
+	tf_free(pThreadSystem->pWorkers);
 	pThreadSystem->mQueueCond.Destroy();
 	pThreadSystem->mIdleCond.Destroy();
-	pThreadSystem->mQueueMutex.Destroy();
+	pThreadSystem->mCounterCond.Destroy();
+	pThreadSystem->mSleepMutex.Destroy();
 	tf_delete(pThreadSystem);
 }
 
+void initTaskCounter(TaskCounter* pCounter)
+{
+	pCounter->mValue = 0;
+	pCounter->mLock = 0;
+	pCounter->pContinuations = NULL;
+}
+
+bool isTaskCounterDone(const TaskCounter* pCounter)
+{
+	if (tfrg_atomic64_load_acquire((tfrg_atomic64_t*)&pCounter->mValue))
+		return false;
+
+	// Wait for the last signaling thread to be done with the counter
+	tfrg_memorybarrier_full();
+	return tfrg_atomic32_load_acquire((tfrg_atomic32_t*)&pCounter->mLock) == 0;
+}
+
+void waitTaskCounter(ThreadSystem* pThreadSystem, TaskCounter* pCounter)
+{
+	ThreadSystemWorker* pWorker = getCurrentWorker(pThreadSystem);
+	while (!isTaskCounterDone(pCounter) && pThreadSystem->mRun)
+	{
+		if (assistCounterTask(pThreadSystem, pWorker, pCounter))
+			continue;
+
+		pThreadSystem->mSleepMutex.Acquire();
+		// Full barrier, pairs with pushTask and signalCounter
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumCounterWaiters, 1);
+		uint32_t generation = tfrg_atomic32_load_relaxed(&pThreadSystem->mCounterGeneration);
+		pThreadSystem->mSleepMutex.Release();
+
+		// Tasks pushed before the registration are found by this search, later ones bump the generation
+		if (!assistCounterTask(pThreadSystem, pWorker, pCounter))
+		{
+			pThreadSystem->mSleepMutex.Acquire();
+			while (!isTaskCounterDone(pCounter) && pThreadSystem->mRun &&
+				   tfrg_atomic32_load_relaxed(&pThreadSystem->mCounterGeneration) == generation)
+				pThreadSystem->mCounterCond.Wait(pThreadSystem->mSleepMutex);
+			pThreadSystem->mSleepMutex.Release();
+		}
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumCounterWaiters, -1);
+	}
+}
+
 bool isThreadSystemIdle(ThreadSystem* pThreadSystem)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	bool idle = (pThreadSystem->mBegin == pThreadSystem->mEnd && pThreadSystem->mNumIdleLoaders == pThreadSystem->mNumLoaders) || !pThreadSystem->mRun;
-	pThreadSystem->mQueueMutex.Release();
-	return idle;
+	return tfrg_atomic64_load_acquire(&pThreadSystem->mPendingTasks) == 0 || !pThreadSystem->mRun;
 }
 
 void waitThreadSystemIdle(ThreadSystem* pThreadSystem)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	while ((pThreadSystem->mBegin != pThreadSystem->mEnd || pThreadSystem->mNumIdleLoaders < pThreadSystem->mNumLoaders) && pThreadSystem->mRun)
-		pThreadSystem->mIdleCond.Wait(pThreadSystem->mQueueMutex);
-	pThreadSystem->mQueueMutex.Release();
+	pThreadSystem->mSleepMutex.Acquire();
+	while (tfrg_atomic64_load_acquire(&pThreadSystem->mPendingTasks) != 0 && pThreadSystem->mRun)
+		pThreadSystem->mIdleCond.Wait(pThreadSystem->mSleepMutex);
+	pThreadSystem->mSleepMutex.Release();
 }
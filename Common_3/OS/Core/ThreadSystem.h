@@ -23,6 +23,8 @@
  * under the License.
 */
 
+#include "Compiler.h"
+
 typedef void (*TaskFunc)(void* user, uintptr_t arg);
 
 template <class T, void (T::*callback)(size_t)>
@@ -39,14 +41,66 @@ static void memberTaskFunc0(void* userData, size_t)
 	(pThis->*callback)();
 }
 
+typedef void (*TaskRangeFunc)(void* user, uintptr_t begin, uintptr_t end);
+
+template <class T, void (T::*callback)(uintptr_t, uintptr_t)>
+static void memberRangeTaskFunc(void* userData, uintptr_t begin, uintptr_t end)
+{
+	T* pThis = static_cast<T*>(userData);
+	(pThis->*callback)(begin, end);
+}
+
 enum
 {
 	MAX_LOAD_THREADS = 16,
-	MAX_SYSTEM_TASKS = 128
+	// Requests one worker per available core (minus the calling thread)
+	THREAD_SYSTEM_ALL_CORES = 0xFFFFFFFF,
 };
 
 struct ThreadSystem;
+struct TaskContinuation;
+
+// Counts outstanding task indices. Tasks increment their signal counter when they are added and decrement it when
+// they finish, which lets a caller wait on a subgraph instead of the whole pool and lets tasks depend on each other.
+// Counters must be zero initialized (or initTaskCounter) and must outlive every task that references them.
+typedef struct TaskCounter
+{
+	volatile ALIGNAS(8) uint64_t mValue;
+	volatile ALIGNAS(4) uint32_t mLock;
+	TaskContinuation*            pContinuations;
+} TaskCounter;
+
+typedef struct ThreadSystemTaskDesc
+{
+	TaskFunc     pTask;
+	void*        pUser;
+	/// Task is invoked once per index in [mStart, mEnd)
+	uintptr_t    mStart;
+	uintptr_t    mEnd;
+	/// Optional. Incremented by (mEnd - mStart) when added, decremented after each index has run
+	TaskCounter* pSignalCounter;
+	/// Optional. Task is only queued once this counter reaches zero ("run after")
+	TaskCounter* pWaitCounter;
+} ThreadSystemTaskDesc;
 
+typedef struct ParallelForDesc
+{
+	TaskRangeFunc pFunc;
+	void*         pUser;
+	uintptr_t     mBegin;
+	uintptr_t     mEnd;
+	/// Smallest range handed to pFunc, 0 derives one from the range size and the thread count
+	uintptr_t     mGrainSize;
+	/// Optional. Reaches zero once the whole range has been processed
+	TaskCounter*  pSignalCounter;
+	/// Optional. The range is only processed once this counter reaches zero
+	TaskCounter*  pWaitCounter;
+} ParallelForDesc;
+
+// Each worker owns a lock-free work-stealing deque. Tasks added from a worker thread go to that worker's deque,
+// tasks added from any other thread are distributed round-robin over the workers' inboxes.
+// There is no limit on the number of queued tasks. The worker count is capped by the core count, pass
+// THREAD_SYSTEM_ALL_CORES to go past MAX_LOAD_THREADS on machines with more cores.
 void initThreadSystem(ThreadSystem** ppThreadSystem, uint32_t numRequestedThreads = MAX_LOAD_THREADS, int preferreCore = 0, bool migrateEnabled = true ,const char* threadName = "");
 
 void shutdownThreadSystem(ThreadSystem* pThreadSystem);
@@ -54,6 +108,13 @@ void shutdownThreadSystem(ThreadSystem* pThreadSystem);
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count);
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t start, uintptr_t end);
 void addThreadSystemTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t index = 0);
+void addThreadSystemTasks(ThreadSystem* pThreadSystem, const ThreadSystemTaskDesc* pDesc);
+
+/// Calls func over sub ranges of [begin, end) on the pool and the calling thread, returns once the whole range is done.
+/// Ranges are halved on demand whenever idle threads have nothing to steal, so no chunk count has to be picked by hand.
+void parallelFor(ThreadSystem* pThreadSystem, uintptr_t begin, uintptr_t end, uintptr_t grainSize, TaskRangeFunc func, void* user);
+/// Asynchronous parallelFor. pDesc has to stay valid until its signal counter (or the pool) is done
+void addThreadSystemParallelFor(ThreadSystem* pThreadSystem, const ParallelForDesc* pDesc);
 
 uint32_t getThreadSystemThreadCount(ThreadSystem* pThreadSystem);
 
@@ -61,5 +122,11 @@ bool assistThreadSystemTasks(ThreadSystem* pThreadSystem, uint32_t* pIds, size_t
 
 bool assistThreadSystem(ThreadSystem* pThreadSystem);
 
+void initTaskCounter(TaskCounter* pCounter);
+bool isTaskCounterDone(const TaskCounter* pCounter);
+/// Runs queued tasks signaling pCounter on the calling thread until pCounter reaches zero.
+/// Unrelated tasks are left to the workers, so a caller holding a lock never ends up running a task that needs it.
+void waitTaskCounter(ThreadSystem* pThreadSystem, TaskCounter* pCounter);
+
 bool isThreadSystemIdle(ThreadSystem* pThreadSystem);
 void waitThreadSystemIdle(ThreadSystem* pThreadSystem);
@@ -102,7 +102,10 @@ bool initFileSystem(FileSystemInitDesc* pDesc)
 	return true;
 }
 
+void exitAsyncFileIO();
+
 void exitFileSystem()
 {
+	exitAsyncFileIO();
 	gInitialized = false;
 }
@@ -24,8 +24,42 @@
 
 #include <errno.h>
 
+#if defined(_WINDOWS) || defined(XBOX)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__) && !defined(__ANDROID__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#if (defined(_WINDOWS) && !defined(XBOX)) || defined(__linux__) || defined(__APPLE__)
+#define FS_MEMORY_MAPPING 1
+#else
+#define FS_MEMORY_MAPPING 0
+#endif
+
+// IORING_FEAT_RW_CUR_POS arrived with IORING_OP_READ (Linux 5.6 headers)
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define FS_IO_URING 1
+#else
+#define FS_IO_URING 0
+#endif
+
 #include "../Interfaces/ILog.h"
+#include "../Interfaces/IThread.h"
 #include "../Interfaces/IMemory.h"
+#include "../Core/Atomics.h"
 
 bool PlatformOpenFile(ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut);
 
@@ -145,6 +179,93 @@ static bool MemoryStreamIsAtEnd(const FileStream* pStream)
 	return pStream->mMemory.mCursor == pStream->mSize;
 }
 /************************************************************************/
+// Mapped Stream Functions
+/************************************************************************/
+#if FS_MEMORY_MAPPING
+static bool MapFile(const char* filePath, void** ppData, size_t* pSize)
+{
+#if defined(_WINDOWS)
+	// Path utf-16 conversion
+	size_t filePathLen = strlen(filePath);
+	wchar_t* pathStr = (wchar_t*)alloca((filePathLen + 1) * sizeof(wchar_t));
+	size_t pathStrLength =
+		MultiByteToWideChar(CP_UTF8, 0, filePath, (int)filePathLen, pathStr, (int)filePathLen);
+	pathStr[pathStrLength] = 0;
+
+	HANDLE file = CreateFileW(pathStr, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	void* data = NULL;
+	LARGE_INTEGER fileSize = {};
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && (uint64_t)fileSize.QuadPart <= (uint64_t)SIZE_MAX)
+	{
+		// The view keeps the mapping alive, so both handles can be closed right away
+		HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping)
+		{
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+
+	if (!data)
+	{
+		return false;
+	}
+
+	*ppData = data;
+	*pSize = (size_t)fileSize.QuadPart;
+	return true;
+#else
+	int fd = open(filePath, O_RDONLY);
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	// The mapping keeps its own reference to the file
+	struct stat fileInfo = {};
+	void* data = MAP_FAILED;
+	if (fstat(fd, &fileInfo) == 0 && fileInfo.st_size > 0)
+	{
+		data = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	// Mapped files are usually read front to back in full, start read-ahead for all of it
+	madvise(data, (size_t)fileInfo.st_size, MADV_WILLNEED);
+
+	*ppData = data;
+	*pSize = (size_t)fileInfo.st_size;
+	return true;
+#endif
+}
+
+static bool MappedStreamClose(FileStream* pStream)
+{
+#if defined(_WINDOWS)
+	if (!UnmapViewOfFile(pStream->mMemory.pBuffer))
+#else
+	if (munmap(pStream->mMemory.pBuffer, (size_t)pStream->mSize) != 0)
+#endif
+	{
+		LOGF(LogLevel::eERROR, "Error unmapping memory-mapped FileStream");
+		return false;
+	}
+
+	return true;
+}
+#endif
+/************************************************************************/
 // File Stream Functions
 /************************************************************************/
 static bool FileStreamOpen(IFileSystem*, const ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut)
@@ -263,6 +384,22 @@ static IFileSystem gMemoryFileIO =
 	MemoryStreamIsAtEnd
 };
 
+#if FS_MEMORY_MAPPING
+// Read-only memory stream whose buffer is a file mapping
+static IFileSystem gMappedFileIO =
+{
+	NULL,
+	MappedStreamClose,
+	MemoryStreamRead,
+	MemoryStreamWrite,
+	MemoryStreamSeek,
+	MemoryStreamGetSeekPosition,
+	MemoryStreamGetSize,
+	MemoryStreamFlush,
+	MemoryStreamIsAtEnd
+};
+#endif
+
 static IFileSystem gSystemFileIO =
 {
 	FileStreamOpen,
@@ -305,6 +442,38 @@ bool fsOpenStreamFromPath(const ResourceDirectory resourceDir, const char* fileN
 	return io->Open(io, resourceDir, fileName, mode, pOut);
 }
 
+bool fsOpenStreamMapped(const ResourceDirectory resourceDir, const char* fileName, FileStream* pOut)
+{
+#if FS_MEMORY_MAPPING
+	// Custom IO and Android APK assets have no file on disk to map
+	const ResourceDirectoryInfo* dir = &gResourceDirectories[resourceDir];
+#if defined(__ANDROID__)
+	if (dir->pIO == pSystemFileIO && !dir->mBundled)
+#else
+	if (dir->pIO == pSystemFileIO)
+#endif
+	{
+		char filePath[FS_MAX_PATH] = {};
+		fsAppendPathComponent(dir->mPath, fileName, filePath);
+
+		void*  data = NULL;
+		size_t size = 0;
+		if (MapFile(filePath, &data, &size))
+		{
+			FileStream stream = {};
+			stream.mMemory.pBuffer = (uint8_t*)data;
+			stream.mSize = (ssize_t)size;
+			stream.mMode = FM_READ_BINARY;
+			stream.pIO = &gMappedFileIO;
+			*pOut = stream;
+			return true;
+		}
+	}
+#endif
+
+	return fsOpenStreamFromPath(resourceDir, fileName, FM_READ_BINARY, pOut);
+}
+
 /// Closes and invalidates the file stream.
 bool fsCloseStream(FileStream* pStream)
 {
@@ -353,6 +522,546 @@ bool fsStreamAtEnd(const FileStream* pStream)
 {
 	return pStream->pIO->IsAtEnd(pStream);
 }
+
+const void* fsGetStreamBuffer(const FileStream* pStream)
+{
+#if FS_MEMORY_MAPPING
+	if (pStream->pIO == &gMappedFileIO)
+	{
+		return pStream->mMemory.pBuffer;
+	}
+#endif
+
+	return pStream->pIO == &gMemoryFileIO ? pStream->mMemory.pBuffer : NULL;
+}
+/************************************************************************/
+// Asynchronous reads
+/************************************************************************/
+#define ASYNC_IO_THREAD_COUNT 4
+#define ASYNC_IO_RING_ENTRIES 256
+
+#if FS_IO_URING
+typedef struct IoUring
+{
+	int                  mFd;
+	uint32_t             mEntries;
+	uint32_t             mInFlight;
+	// Submission queue
+	void*                pSqRing;
+	size_t               mSqRingSize;
+	tfrg_atomic32_t*     pSqHead;
+	tfrg_atomic32_t*     pSqTail;
+	uint32_t             mSqMask;
+	uint32_t*            pSqArray;
+	struct io_uring_sqe* pSqes;
+	// Completion queue
+	void*                pCqRing;
+	size_t               mCqRingSize;
+	tfrg_atomic32_t*     pCqHead;
+	tfrg_atomic32_t*     pCqTail;
+	uint32_t             mCqMask;
+	struct io_uring_cqe* pCqes;
+} IoUring;
+#endif
+
+typedef struct AsyncFileIO
+{
+	Mutex             mMutex;
+	/// IO threads sleep on this until reads are queued
+	ConditionVariable mQueueCond;
+	/// fsWaitAsyncRead sleeps on this until any read completes
+	ConditionVariable mCompletionCond;
+	FileAsyncRead*    pQueueHead;
+	FileAsyncRead*    pQueueTail;
+	ThreadDesc        mThreadDesc;
+	ThreadHandle      mThreads[ASYNC_IO_THREAD_COUNT];
+	volatile bool     mRun;
+#if FS_IO_URING
+	IoUring           mRing;
+	ThreadDesc        mCompletionThreadDesc;
+	ThreadHandle      mCompletionThread;
+	/// Ring and completion thread exist
+	bool              mRingCreated;
+	/// Cleared when the kernel rejects IORING_OP_READ
+	bool              mRingReads;
+#endif
+} AsyncFileIO;
+
+static tfrg_atomicptr_t gAsyncFileIO = 0;
+static tfrg_atomic32_t  gAsyncFileIOLock = 0;
+
+static size_t PositionalRead(FILE* pFile, uint8_t* pBuffer, size_t size, ssize_t offset)
+{
+	size_t bytesRead = 0;
+#if defined(_WINDOWS) || defined(XBOX)
+	// Reading through the stream's own handle would move the file pointer stdio relies on
+	HANDLE file = ReOpenFile((HANDLE)_get_osfhandle(_fileno(pFile)), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0);
+	if (INVALID_HANDLE_VALUE == file)
+	{
+		LOGF(LogLevel::eWARNING, "Error reopening system FileStream for asynchronous read: %u", (uint32_t)GetLastError());
+		return 0;
+	}
+
+	while (bytesRead < size)
+	{
+		uint64_t position = (uint64_t)offset + bytesRead;
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)position;
+		overlapped.OffsetHigh = (DWORD)(position >> 32);
+		DWORD chunkRead = 0;
+		if (!ReadFile(file, pBuffer + bytesRead, (DWORD)min<size_t>(size - bytesRead, 1u << 30), &chunkRead, &overlapped) || !chunkRead)
+		{
+			break;
+		}
+		bytesRead += chunkRead;
+	}
+	CloseHandle(file);
+#else
+	int fd = fileno(pFile);
+	while (bytesRead < size)
+	{
+		ssize_t chunkRead = pread(fd, pBuffer + bytesRead, size - bytesRead, (off_t)(offset + bytesRead));
+		if (chunkRead < 0 && EINTR == errno)
+		{
+			continue;
+		}
+		if (chunkRead <= 0)
+		{
+			LOGF_IF(LogLevel::eWARNING, chunkRead < 0, "Error reading from system FileStream: %s", strerror(errno));
+			break;
+		}
+		bytesRead += chunkRead;
+	}
+#endif
+	return bytesRead;
+}
+
+static void CompleteAsyncRead(AsyncFileIO* pIO, FileAsyncRead* pRead)
+{
+	pRead->mBytesRead = pRead->mInternal.mProgress;
+	if (pRead->pCallback)
+	{
+		pRead->pCallback(pRead);
+	}
+
+	if (!pIO)
+	{
+		tfrg_atomic32_store_release(&pRead->mInternal.mCompleted, 1);
+		return;
+	}
+
+	// Owner may free pRead as soon as mCompleted is set, so this is the last access
+	pIO->mMutex.Acquire();
+	tfrg_atomic32_store_release(&pRead->mInternal.mCompleted, 1);
+	pIO->mMutex.Release();
+	pIO->mCompletionCond.WakeAll();
+}
+
+/// Hands the remaining part of a read to the IO threads. Expects pIO->mMutex to be held
+static void QueueAsyncRead(AsyncFileIO* pIO, FileAsyncRead* pRead)
+{
+	pRead->mInternal.pNext = NULL;
+	if (pIO->pQueueTail)
+	{
+		pIO->pQueueTail->mInternal.pNext = pRead;
+	}
+	else
+	{
+		pIO->pQueueHead = pRead;
+	}
+	pIO->pQueueTail = pRead;
+	pIO->mQueueCond.WakeOne();
+}
+
+static void AsyncIOThreadFunc(void* pData)
+{
+	AsyncFileIO* pIO = (AsyncFileIO*)pData;
+
+	pIO->mMutex.Acquire();
+	while (true)
+	{
+		while (pIO->mRun && !pIO->pQueueHead)
+		{
+			pIO->mQueueCond.Wait(pIO->mMutex);
+		}
+		if (!pIO->mRun)
+		{
+			break;
+		}
+
+		FileAsyncRead* pRead = pIO->pQueueHead;
+		pIO->pQueueHead = pRead->mInternal.pNext;
+		if (!pIO->pQueueHead)
+		{
+			pIO->pQueueTail = NULL;
+		}
+		pIO->mMutex.Release();
+
+		size_t progress = pRead->mInternal.mProgress;
+		pRead->mInternal.mProgress += PositionalRead(pRead->mInternal.pFile, pRead->mInternal.pBuffer + progress,
+			pRead->mInternal.mSize - progress, pRead->mInternal.mOffset + (ssize_t)progress);
+		CompleteAsyncRead(pIO, pRead);
+
+		pIO->mMutex.Acquire();
+	}
+	pIO->mMutex.Release();
+}
+
+#if FS_IO_URING
+static int IoUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+static bool InitIoUring(IoUring* pRing, uint32_t entries)
+{
+	struct io_uring_params params = {};
+	int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (fd < 0)
+	{
+		LOGF(LogLevel::eINFO, "io_uring unavailable (%s), asynchronous reads use IO threads", strerror(errno));
+		return false;
+	}
+
+	*pRing = {};
+	pRing->mFd = fd;
+	pRing->mEntries = params.sq_entries;
+	pRing->mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	pRing->mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	bool singleMap = false;
+#if defined(IORING_FEAT_SINGLE_MMAP)
+	singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap)
+	{
+		pRing->mSqRingSize = pRing->mCqRingSize = max(pRing->mSqRingSize, pRing->mCqRingSize);
+	}
+#endif
+
+	pRing->pSqRing = mmap(NULL, pRing->mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	pRing->pCqRing = singleMap ? pRing->pSqRing :
+		mmap(NULL, pRing->mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	pRing->pSqes = (struct io_uring_sqe*)mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+	if (MAP_FAILED == pRing->pSqRing || MAP_FAILED == pRing->pCqRing || MAP_FAILED == (void*)pRing->pSqes)
+	{
+		LOGF(LogLevel::eWARNING, "Failed to map io_uring queues: %s", strerror(errno));
+		if (MAP_FAILED != pRing->pSqRing)
+			munmap(pRing->pSqRing, pRing->mSqRingSize);
+		if (!singleMap && MAP_FAILED != pRing->pCqRing)
+			munmap(pRing->pCqRing, pRing->mCqRingSize);
+		if (MAP_FAILED != (void*)pRing->pSqes)
+			munmap(pRing->pSqes, params.sq_entries * sizeof(struct io_uring_sqe));
+		close(fd);
+		return false;
+	}
+
+	uint8_t* sq = (uint8_t*)pRing->pSqRing;
+	pRing->pSqHead = (tfrg_atomic32_t*)(sq + params.sq_off.head);
+	pRing->pSqTail = (tfrg_atomic32_t*)(sq + params.sq_off.tail);
+	pRing->mSqMask = *(uint32_t*)(sq + params.sq_off.ring_mask);
+	pRing->pSqArray = (uint32_t*)(sq + params.sq_off.array);
+
+	uint8_t* cq = (uint8_t*)pRing->pCqRing;
+	pRing->pCqHead = (tfrg_atomic32_t*)(cq + params.cq_off.head);
+	pRing->pCqTail = (tfrg_atomic32_t*)(cq + params.cq_off.tail);
+	pRing->mCqMask = *(uint32_t*)(cq + params.cq_off.ring_mask);
+	pRing->pCqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	return true;
+}
+
+static void ExitIoUring(IoUring* pRing)
+{
+	munmap(pRing->pSqes, pRing->mEntries * sizeof(struct io_uring_sqe));
+	if (pRing->pCqRing != pRing->pSqRing)
+		munmap(pRing->pCqRing, pRing->mCqRingSize);
+	munmap(pRing->pSqRing, pRing->mSqRingSize);
+	close(pRing->mFd);
+}
+
+/// Submits the remaining part of a read (pRead == NULL submits the shutdown marker). Expects pIO->mMutex to be held.
+/// Returns false if the ring is full or the submission failed, nothing is left in the ring in that case
+static bool SubmitIoUringRead(AsyncFileIO* pIO, FileAsyncRead* pRead)
+{
+	IoUring* pRing = &pIO->mRing;
+	uint32_t tail = *pRing->pSqTail;
+	// In flight reads are capped by the ring size so the completion queue can never overflow
+	if (pRing->mInFlight >= pRing->mEntries || tail - tfrg_atomic32_load_acquire(pRing->pSqHead) >= pRing->mEntries)
+	{
+		return false;
+	}
+
+	uint32_t index = tail & pRing->mSqMask;
+	struct io_uring_sqe* sqe = &pRing->pSqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	if (pRead)
+	{
+		size_t progress = pRead->mInternal.mProgress;
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = fileno(pRead->mInternal.pFile);
+		sqe->off = (uint64_t)(pRead->mInternal.mOffset + (ssize_t)progress);
+		sqe->addr = (uint64_t)(uintptr_t)(pRead->mInternal.pBuffer + progress);
+		sqe->len = (uint32_t)min<size_t>(pRead->mInternal.mSize - progress, 1u << 30);
+	}
+	else
+	{
+		sqe->opcode = IORING_OP_NOP;
+	}
+	sqe->user_data = (uint64_t)(uintptr_t)pRead;
+	pRing->pSqArray[index] = index;
+	tfrg_atomic32_store_release(pRing->pSqTail, tail + 1);
+	++pRing->mInFlight;
+
+	int res = 0;
+	do
+	{
+		res = IoUringEnter(pRing->mFd, 1, 0, 0);
+	} while (res < 0 && (EINTR == errno || EAGAIN == errno));
+	if (res < 0)
+	{
+		// The kernel did not consume the entry, take it back so the caller can fall back to the IO threads
+		tfrg_atomic32_store_release(pRing->pSqTail, tail);
+		--pRing->mInFlight;
+		if (EBUSY != errno && ENOMEM != errno)
+		{
+			LOGF(LogLevel::eWARNING, "io_uring_enter failed to submit a read, asynchronous reads use IO threads: %s", strerror(errno));
+			pIO->mRingReads = false;
+		}
+		return false;
+	}
+	return true;
+}
+
+static void IoUringCompletionThreadFunc(void* pData)
+{
+	AsyncFileIO* pIO = (AsyncFileIO*)pData;
+	IoUring* pRing = &pIO->mRing;
+	bool run = true;
+
+	while (run)
+	{
+		if (IoUringEnter(pRing->mFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && EINTR != errno)
+		{
+			LOGF(LogLevel::eERROR, "io_uring_enter failed to wait for completions: %s", strerror(errno));
+			break;
+		}
+
+		uint32_t head = *pRing->pCqHead;
+		uint32_t tail = tfrg_atomic32_load_acquire(pRing->pCqTail);
+		for (; head != tail; ++head)
+		{
+			struct io_uring_cqe* cqe = &pRing->pCqes[head & pRing->mCqMask];
+			FileAsyncRead* pRead = (FileAsyncRead*)(uintptr_t)cqe->user_data;
+			int32_t res = cqe->res;
+			tfrg_atomic32_store_release(pRing->pCqHead, head + 1);
+
+			pIO->mMutex.Acquire();
+			--pRing->mInFlight;
+			if (!pRead)
+			{
+				run = false;
+				pIO->mMutex.Release();
+				continue;
+			}
+
+			if ((-EINVAL == res || -EOPNOTSUPP == res) && !pRead->mInternal.mProgress)
+			{
+				// IORING_OP_READ needs Linux 5.6, older kernels reject it
+				LOGF(LogLevel::eINFO, "io_uring does not support reads on this kernel, asynchronous reads use IO threads");
+				pIO->mRingReads = false;
+				QueueAsyncRead(pIO, pRead);
+				pIO->mMutex.Release();
+				continue;
+			}
+
+			bool done = true;
+			if (-EINTR == res || -EAGAIN == res || res > 0)
+			{
+				pRead->mInternal.mProgress += res > 0 ? (size_t)res : 0;
+				// Short reads are resumed until the requested size or the end of the file is reached
+				if (pRead->mInternal.mProgress < pRead->mInternal.mSize)
+				{
+					done = false;
+					if (!SubmitIoUringRead(pIO, pRead))
+					{
+						QueueAsyncRead(pIO, pRead);
+					}
+				}
+			}
+			else if (res < 0)
+			{
+				LOGF(LogLevel::eWARNING, "Error reading from system FileStream: %s", strerror(-res));
+			}
+			pIO->mMutex.Release();
+
+			if (done)
+			{
+				CompleteAsyncRead(pIO, pRead);
+			}
+		}
+	}
+}
+#endif
+
+static AsyncFileIO* GetAsyncFileIO()
+{
+	AsyncFileIO* pIO = (AsyncFileIO*)tfrg_atomicptr_load_acquire(&gAsyncFileIO);
+	if (pIO)
+	{
+		return pIO;
+	}
+
+	// Created on first use so applications which never read asynchronously don't pay for the IO threads
+	while (tfrg_atomic32_cas_relaxed(&gAsyncFileIOLock, 0, 1) != 0)
+	{
+		Thread::Sleep(0);
+	}
+
+	pIO = (AsyncFileIO*)tfrg_atomicptr_load_acquire(&gAsyncFileIO);
+	if (!pIO)
+	{
+		pIO = tf_new(AsyncFileIO);
+		pIO->mMutex.Init();
+		pIO->mQueueCond.Init();
+		pIO->mCompletionCond.Init();
+		pIO->mRun = true;
+		pIO->mThreadDesc.pFunc = AsyncIOThreadFunc;
+		pIO->mThreadDesc.pData = pIO;
+		for (uint32_t i = 0; i < ASYNC_IO_THREAD_COUNT; ++i)
+		{
+			pIO->mThreads[i] = create_thread(&pIO->mThreadDesc);
+		}
+
+#if FS_IO_URING
+		pIO->mRingCreated = InitIoUring(&pIO->mRing, ASYNC_IO_RING_ENTRIES);
+		pIO->mRingReads = pIO->mRingCreated;
+		if (pIO->mRingCreated)
+		{
+			// The thread reads its desc after create_thread returns
+			pIO->mCompletionThreadDesc.pFunc = IoUringCompletionThreadFunc;
+			pIO->mCompletionThreadDesc.pData = pIO;
+			pIO->mCompletionThread = create_thread(&pIO->mCompletionThreadDesc);
+		}
+#endif
+
+		tfrg_atomicptr_store_release(&gAsyncFileIO, (uintptr_t)pIO);
+	}
+
+	tfrg_atomic32_store_release(&gAsyncFileIOLock, 0);
+	return pIO;
+}
+
+/// Called by the platform exitFileSystem. All asynchronous reads have to be completed at this point
+void exitAsyncFileIO()
+{
+	AsyncFileIO* pIO = (AsyncFileIO*)tfrg_atomicptr_load_acquire(&gAsyncFileIO);
+	if (!pIO)
+	{
+		return;
+	}
+
+#if FS_IO_URING
+	// The completion thread owns the ring until it receives the shutdown marker
+	if (pIO->mRingCreated)
+	{
+		pIO->mMutex.Acquire();
+		while (!SubmitIoUringRead(pIO, NULL))
+		{
+			pIO->mMutex.Release();
+			Thread::Sleep(1);
+			pIO->mMutex.Acquire();
+		}
+		pIO->mMutex.Release();
+		destroy_thread(pIO->mCompletionThread);
+		ExitIoUring(&pIO->mRing);
+	}
+#endif
+
+	pIO->mMutex.Acquire();
+	pIO->mRun = false;
+	pIO->mQueueCond.WakeAll();
+	pIO->mMutex.Release();
+	for (uint32_t i = 0; i < ASYNC_IO_THREAD_COUNT; ++i)
+	{
+		destroy_thread(pIO->mThreads[i]);
+	}
+
+	pIO->mCompletionCond.Destroy();
+	pIO->mQueueCond.Destroy();
+	pIO->mMutex.Destroy();
+	tf_delete(pIO);
+	tfrg_atomicptr_store_release(&gAsyncFileIO, 0);
+}
+
+bool fsReadFromStreamAsync(FileStream* pStream, void* pOutputBuffer, size_t bufferSizeInBytes, FileAsyncRead* pRead)
+{
+	ASSERT(pStream && pRead);
+	memset(&pRead->mInternal, 0, sizeof(pRead->mInternal));
+	pRead->mBytesRead = 0;
+
+	const bool systemFile = pStream->pIO == pSystemFileIO && (pStream->mMode & FM_READ) && (pStream->mMode & FM_BINARY);
+	const ssize_t offset = systemFile ? fsGetStreamSeekPosition(pStream) : -1;
+	if (offset < 0 || pStream->mSize < 0)
+	{
+		// No file descriptor to read from behind the stream's back (memory, zip, bundled assets)
+		pRead->mInternal.mProgress = fsReadFromStream(pStream, pOutputBuffer, bufferSizeInBytes);
+		CompleteAsyncRead(NULL, pRead);
+		return true;
+	}
+
+	// Same clamping and seek position update as a blocking read
+	const size_t size = (size_t)min<ssize_t>((ssize_t)bufferSizeInBytes, max<ssize_t>(pStream->mSize - offset, 0));
+	if (!fsSeekStream(pStream, SBO_START_OF_FILE, offset + (ssize_t)size))
+	{
+		return false;
+	}
+
+	pRead->mInternal.pFile = pStream->pFile;
+	pRead->mInternal.pBuffer = (uint8_t*)pOutputBuffer;
+	pRead->mInternal.mSize = size;
+	pRead->mInternal.mOffset = offset;
+	if (!size)
+	{
+		CompleteAsyncRead(NULL, pRead);
+		return true;
+	}
+
+	AsyncFileIO* pIO = GetAsyncFileIO();
+	pIO->mMutex.Acquire();
+#if FS_IO_URING
+	if (!pIO->mRingReads || !SubmitIoUringRead(pIO, pRead))
+#endif
+	{
+		QueueAsyncRead(pIO, pRead);
+	}
+	pIO->mMutex.Release();
+
+	return true;
+}
+
+bool fsIsAsyncReadCompleted(const FileAsyncRead* pRead)
+{
+	return tfrg_atomic32_load_acquire((tfrg_atomic32_t*)&pRead->mInternal.mCompleted) != 0;
+}
+
+size_t fsWaitAsyncRead(FileAsyncRead* pRead)
+{
+	if (!fsIsAsyncReadCompleted(pRead))
+	{
+		AsyncFileIO* pIO = (AsyncFileIO*)tfrg_atomicptr_load_acquire(&gAsyncFileIO);
+		ASSERT(pIO);
+		pIO->mMutex.Acquire();
+		while (!fsIsAsyncReadCompleted(pRead))
+		{
+			pIO->mCompletionCond.Wait(pIO->mMutex);
+		}
+		pIO->mMutex.Release();
+	}
+
+	return pRead->mBytesRead;
+}
 /************************************************************************/
 // Platform independent filename, extension functions
 /************************************************************************/
@@ -0,0 +1,714 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include <ctype.h>
+
+#include "PakFileSystem.h"
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "../../ThirdParty/OpenSource/zip/miniz.h"
+
+#include "../../ThirdParty/OpenSource/EASTL/string.h"
+#include "../../ThirdParty/OpenSource/EASTL/vector.h"
+#include "../../ThirdParty/OpenSource/EASTL/unordered_set.h"
+
+#include "../Core/Atomics.h"
+#include "../Core/ThreadSystem.h"
+#include "../Interfaces/ILog.h"
+#include "../Interfaces/IThread.h"
+#include "../Interfaces/IMemory.h"
+
+typedef struct PakArchive
+{
+	/// Memory mapped when possible, otherwise a regular stream shared by all entries
+	FileStream       mFile;
+	/// Whole archive when mFile is mapped
+	const uint8_t*   pData;
+	/// Points into the mapping or into pTocData
+	const PakBucket* pBuckets;
+	const PakEntry*  pEntries;
+	const PakChunk*  pChunks;
+	const char*      pNames;
+	void*            pTocData;
+	PakHeader        mHeader;
+	/// Guards mFile when it is not mapped
+	Mutex            mMutex;
+	/// Optional, decompresses reads spanning several chunks in parallel
+	ThreadSystem*    pThreadSystem;
+} PakArchive;
+
+typedef struct PakEntryStream
+{
+	PakArchive*     pArchive;
+	const PakEntry* pEntry;
+	uint64_t        mCursor;
+	/// Entry chunk currently held in pChunkData, PAK_INVALID_ENTRY if none
+	uint32_t        mCachedChunk;
+	uint8_t*        pChunkData;
+	/// Compressed chunk read from the archive when it is not mapped
+	uint8_t*        pStoredData;
+} PakEntryStream;
+
+static size_t PakArchiveRead(PakArchive* archive, uint64_t offset, void* pBuffer, size_t size)
+{
+	uint64_t archiveSize = (uint64_t)archive->mFile.mSize;
+	if (offset >= archiveSize)
+	{
+		return 0;
+	}
+	size = (size_t)min((uint64_t)size, archiveSize - offset);
+
+	if (archive->pData)
+	{
+		memcpy(pBuffer, archive->pData + offset, size);
+		return size;
+	}
+
+	MutexLock lock(archive->mMutex);
+	if (!fsSeekStream(&archive->mFile, SBO_START_OF_FILE, (ssize_t)offset))
+	{
+		return 0;
+	}
+	return fsReadFromStream(&archive->mFile, pBuffer, size);
+}
+
+static bool PakNameEquals(const char* a, const char* b, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		char ca = a[i] == '\\' ? '/' : (char)tolower(a[i]);
+		char cb = b[i] == '\\' ? '/' : (char)tolower(b[i]);
+		if (ca != cb)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static const PakEntry* PakFindEntry(const PakArchive* archive, const char* name)
+{
+	size_t length = strlen(name);
+	uint64_t hash = pakHashName(name, length);
+	uint32_t mask = archive->mHeader.mBucketCount - 1;
+
+	for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask)
+	{
+		const PakBucket* bucket = &archive->pBuckets[i];
+		if (bucket->mEntryIndex == PAK_INVALID_ENTRY)
+		{
+			return NULL;
+		}
+
+		const PakEntry* entry = &archive->pEntries[bucket->mEntryIndex];
+		if (bucket->mHash == hash && entry->mNameLength == length && PakNameEquals(archive->pNames + entry->mNameOffset, name, length))
+		{
+			return entry;
+		}
+	}
+}
+
+static uint32_t PakChunkSize(const PakEntry* entry, uint32_t chunk)
+{
+	return (uint32_t)min((uint64_t)PAK_CHUNK_SIZE, entry->mSize - (uint64_t)chunk * PAK_CHUNK_SIZE);
+}
+
+// Decompresses one chunk of the entry into `pOutput`, which has room for PakChunkSize bytes.
+// `pStoredData` (PAK_CHUNK_SIZE bytes) receives the compressed chunk when the archive is not mapped
+static bool PakDecodeChunk(PakArchive* archive, const PakEntry* entry, uint32_t chunk, uint8_t* pOutput, uint8_t* pStoredData)
+{
+	const PakChunk* info = &archive->pChunks[entry->mFirstChunk + chunk];
+	uint32_t size = PakChunkSize(entry, chunk);
+	// PakValidateToc guarantees this, the buffers are sized for it
+	ASSERT(info->mStoredSize <= size);
+
+	if (info->mStoredSize == size)
+	{
+		return PakArchiveRead(archive, info->mOffset, pOutput, size) == size;
+	}
+
+	const uint8_t* stored = archive->pData ? archive->pData + info->mOffset : NULL;
+	if (!stored)
+	{
+		if (PakArchiveRead(archive, info->mOffset, pStoredData, info->mStoredSize) != info->mStoredSize)
+		{
+			return false;
+		}
+		stored = pStoredData;
+	}
+
+	size_t decoded = tinfl_decompress_mem_to_mem(pOutput, size, stored, info->mStoredSize, TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+	if (decoded != size)
+	{
+		LOGF(LogLevel::eERROR, "Failed to decompress pak chunk %u", chunk);
+		return false;
+	}
+	return true;
+}
+
+typedef struct PakDecodeChunksTaskData
+{
+	PakArchive*     pArchive;
+	const PakEntry* pEntry;
+	uint32_t        mFirstChunk;
+	uint8_t*        pOutput;
+	tfrg_atomic32_t mFailed;
+} PakDecodeChunksTaskData;
+
+static void PakDecodeChunksTask(void* pUser, uintptr_t begin, uintptr_t end)
+{
+	PakDecodeChunksTaskData* data = (PakDecodeChunksTaskData*)pUser;
+	for (uintptr_t chunk = begin; chunk < end; ++chunk)
+	{
+		uint8_t* pOutput = data->pOutput + (chunk - data->mFirstChunk) * PAK_CHUNK_SIZE;
+		if (!PakDecodeChunk(data->pArchive, data->pEntry, (uint32_t)chunk, pOutput, NULL))
+		{
+			tfrg_atomic32_store_relaxed(&data->mFailed, 1);
+		}
+	}
+}
+/************************************************************************/
+// Pak Entry Stream Functions
+/************************************************************************/
+static bool PakEntryClose(FileStream* pFile)
+{
+	PakEntryStream* stream = (PakEntryStream*)pFile->pUser;
+	tf_free(stream->pChunkData);
+	tf_free(stream->pStoredData);
+	tf_free(stream);
+	return true;
+}
+
+static size_t PakEntryRead(FileStream* pFile, void* outputBuffer, size_t bufferSizeInBytes)
+{
+	PakEntryStream* stream = (PakEntryStream*)pFile->pUser;
+	const PakEntry* entry = stream->pEntry;
+	uint8_t* dst = (uint8_t*)outputBuffer;
+	size_t bytesToRead = (size_t)min((uint64_t)bufferSizeInBytes, entry->mSize - min(stream->mCursor, entry->mSize));
+	size_t bytesRead = 0;
+
+	if (!(entry->mFlags & PAK_ENTRY_FLAG_COMPRESSED))
+	{
+		bytesRead = PakArchiveRead(stream->pArchive, entry->mDataOffset + stream->mCursor, dst, bytesToRead);
+		stream->mCursor += bytesRead;
+		return bytesRead;
+	}
+
+	while (bytesRead < bytesToRead)
+	{
+		uint32_t chunk = (uint32_t)(stream->mCursor / PAK_CHUNK_SIZE);
+		size_t chunkOffset = (size_t)(stream->mCursor % PAK_CHUNK_SIZE);
+		size_t chunkSize = PakChunkSize(entry, chunk);
+		size_t size = min(chunkSize - chunkOffset, bytesToRead - bytesRead);
+
+		// Chunks are independent, so a read covering several whole chunks decompresses them in parallel.
+		// Only for mapped archives, reads of the shared file stream are serialized anyway
+		uint64_t readEnd = stream->mCursor + (bytesToRead - bytesRead);
+		uint32_t endChunk = (uint32_t)((readEnd == entry->mSize ? readEnd + PAK_CHUNK_SIZE - 1 : readEnd) / PAK_CHUNK_SIZE);
+		if (chunkOffset == 0 && stream->pArchive->pThreadSystem && stream->pArchive->pData && endChunk > chunk + 1)
+		{
+			PakDecodeChunksTaskData data = { stream->pArchive, entry, chunk, dst + bytesRead, 0 };
+			parallelFor(stream->pArchive->pThreadSystem, chunk, endChunk, 1, PakDecodeChunksTask, &data);
+			if (tfrg_atomic32_load_relaxed(&data.mFailed))
+			{
+				break;
+			}
+
+			size = (size_t)(min(readEnd, (uint64_t)endChunk * PAK_CHUNK_SIZE) - stream->mCursor);
+		}
+		else if (chunkOffset == 0 && size == chunkSize && chunk != stream->mCachedChunk)
+		{
+			// Whole chunk requested, decompress straight into the caller's buffer
+			if (!PakDecodeChunk(stream->pArchive, entry, chunk, dst + bytesRead, stream->pStoredData))
+			{
+				break;
+			}
+		}
+		else
+		{
+			if (chunk != stream->mCachedChunk)
+			{
+				stream->mCachedChunk = PAK_INVALID_ENTRY;
+				if (!PakDecodeChunk(stream->pArchive, entry, chunk, stream->pChunkData, stream->pStoredData))
+				{
+					break;
+				}
+				stream->mCachedChunk = chunk;
+			}
+			memcpy(dst + bytesRead, stream->pChunkData + chunkOffset, size);
+		}
+
+		bytesRead += size;
+		stream->mCursor += size;
+	}
+
+	return bytesRead;
+}
+
+static size_t PakEntryWrite(FileStream*, const void*, size_t)
+{
+	LOGF(LogLevel::eWARNING, "Attempting to write to read-only pak entry");
+	return 0;
+}
+
+static bool PakEntrySeek(FileStream* pFile, SeekBaseOffset baseOffset, ssize_t seekOffset)
+{
+	PakEntryStream* stream = (PakEntryStream*)pFile->pUser;
+	ssize_t newPosition = seekOffset;
+	switch (baseOffset)
+	{
+	case SBO_START_OF_FILE: break;
+	case SBO_CURRENT_POSITION: newPosition += (ssize_t)stream->mCursor; break;
+	case SBO_END_OF_FILE: newPosition += pFile->mSize; break;
+	}
+
+	if (newPosition < 0 || newPosition > pFile->mSize)
+	{
+		return false;
+	}
+
+	stream->mCursor = (uint64_t)newPosition;
+	return true;
+}
+
+static ssize_t PakEntryGetSeekPosition(const FileStream* pFile)
+{
+	return (ssize_t)((const PakEntryStream*)pFile->pUser)->mCursor;
+}
+
+static ssize_t PakEntryGetSize(const FileStream* pFile)
+{
+	return pFile->mSize;
+}
+
+static bool PakEntryFlush(FileStream*)
+{
+	// No-op.
+	return true;
+}
+
+static bool PakEntryIsAtEnd(const FileStream* pFile)
+{
+	return ((const PakEntryStream*)pFile->pUser)->mCursor >= (uint64_t)pFile->mSize;
+}
+
+static IFileSystem gPakEntryIO =
+{
+	NULL,
+	PakEntryClose,
+	PakEntryRead,
+	PakEntryWrite,
+	PakEntrySeek,
+	PakEntryGetSeekPosition,
+	PakEntryGetSize,
+	PakEntryFlush,
+	PakEntryIsAtEnd
+};
+/************************************************************************/
+// Pak File IO
+/************************************************************************/
+static bool PakOpen(IFileSystem* pIO, const ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut)
+{
+	if (mode & (FM_WRITE | FM_APPEND))
+	{
+		LOGF(LogLevel::eERROR, "Pak archives are read-only, cannot open %s with mode %u", fileName, mode);
+		return false;
+	}
+
+	PakArchive* archive = (PakArchive*)pIO->pUser;
+	char filePath[FS_MAX_PATH] = {};
+	fsAppendPathComponent(fsGetResourceDirectory(resourceDir), fileName, filePath);
+
+	// The table of contents is immutable, lookups need no lock
+	const PakEntry* entry = PakFindEntry(archive, filePath);
+	if (!entry)
+	{
+		LOGF(LogLevel::eINFO, "Error finding file %s for opening in pak", fileName);
+		return false;
+	}
+
+	if (!(entry->mFlags & PAK_ENTRY_FLAG_COMPRESSED) && archive->pData)
+	{
+		return fsOpenStreamFromMemory(archive->pData + entry->mDataOffset, (size_t)entry->mSize, mode, false, pOut);
+	}
+
+	PakEntryStream* stream = (PakEntryStream*)tf_calloc(1, sizeof(PakEntryStream));
+	stream->pArchive = archive;
+	stream->pEntry = entry;
+	stream->mCachedChunk = PAK_INVALID_ENTRY;
+	if (entry->mFlags & PAK_ENTRY_FLAG_COMPRESSED)
+	{
+		stream->pChunkData = (uint8_t*)tf_malloc(PAK_CHUNK_SIZE);
+		if (!archive->pData)
+		{
+			stream->pStoredData = (uint8_t*)tf_malloc(PAK_CHUNK_SIZE);
+		}
+	}
+
+	FileStream file = {};
+	file.pUser = stream;
+	file.mSize = (ssize_t)entry->mSize;
+	file.mMode = mode;
+	file.pIO = &gPakEntryIO;
+	*pOut = file;
+	return true;
+}
+
+static IFileSystem gPakFileIO =
+{
+	PakOpen
+};
+
+// Everything read from the archive is bounds checked here once, so reads can trust the table of contents
+static bool PakValidateToc(const PakArchive* archive)
+{
+	const PakHeader& header = archive->mHeader;
+	const uint64_t namesSize = header.mTocSize - ((uint64_t)header.mBucketCount * sizeof(PakBucket) +
+												  (uint64_t)header.mEntryCount * sizeof(PakEntry) + (uint64_t)header.mChunkCount * sizeof(PakChunk));
+	// Entry data lies between the header and the table of contents
+	const uint64_t dataBegin = sizeof(PakHeader);
+	const uint64_t dataEnd = header.mTocOffset;
+
+	for (uint32_t i = 0; i < header.mEntryCount; ++i)
+	{
+		const PakEntry& entry = archive->pEntries[i];
+		if (entry.mNameOffset > namesSize || entry.mNameLength > namesSize - entry.mNameOffset)
+		{
+			return false;
+		}
+		if (entry.mDataOffset < dataBegin || entry.mDataOffset > dataEnd || entry.mStoredSize > dataEnd - entry.mDataOffset)
+		{
+			return false;
+		}
+
+		if (!(entry.mFlags & PAK_ENTRY_FLAG_COMPRESSED))
+		{
+			// Stored entries are read (or mapped) directly
+			if (entry.mSize > entry.mStoredSize)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		uint64_t chunkCount = (entry.mSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE;
+		if (chunkCount > header.mChunkCount || entry.mFirstChunk > header.mChunkCount - chunkCount)
+		{
+			return false;
+		}
+		for (uint32_t c = 0; c < (uint32_t)chunkCount; ++c)
+		{
+			// A chunk which does not shrink is stored, so no chunk occupies more than its uncompressed size.
+			// This is tighter than the deflate bound and keeps PakDecodeChunk inside its PAK_CHUNK_SIZE buffers
+			const PakChunk& chunk = archive->pChunks[entry.mFirstChunk + c];
+			if (chunk.mStoredSize > PakChunkSize(&entry, c) || chunk.mOffset < entry.mDataOffset ||
+				chunk.mOffset - entry.mDataOffset > entry.mStoredSize ||
+				chunk.mStoredSize > entry.mStoredSize - (chunk.mOffset - entry.mDataOffset))
+			{
+				return false;
+			}
+		}
+	}
+	// Every entry is in at most one bucket. With more buckets than entries at least one bucket stays empty,
+	// which ends the probing of PakFindEntry for names that are not in the archive
+	uint32_t* pUsedEntries = (uint32_t*)tf_calloc((header.mEntryCount + 31) / 32 + 1, sizeof(uint32_t));
+	bool valid = true;
+	for (uint32_t i = 0; valid && i < header.mBucketCount; ++i)
+	{
+		const uint32_t entryIndex = archive->pBuckets[i].mEntryIndex;
+		if (entryIndex == PAK_INVALID_ENTRY)
+		{
+			continue;
+		}
+		valid = entryIndex < header.mEntryCount && !(pUsedEntries[entryIndex / 32] & (1u << (entryIndex % 32)));
+		if (valid)
+		{
+			pUsedEntries[entryIndex / 32] |= 1u << (entryIndex % 32);
+		}
+	}
+	tf_free(pUsedEntries);
+	return valid;
+}
+
+bool fsOpenPakFile(const ResourceDirectory resourceDir, const char* fileName, IFileSystem* pOut, ThreadSystem* pThreadSystem)
+{
+	PakArchive* archive = (PakArchive*)tf_calloc(1, sizeof(PakArchive));
+	archive->mMutex.Init();
+	archive->pThreadSystem = pThreadSystem;
+
+	bool success = fsOpenStreamMapped(resourceDir, fileName, &archive->mFile);
+	if (success)
+	{
+		archive->pData = (const uint8_t*)fsGetStreamBuffer(&archive->mFile);
+
+		PakHeader& header = archive->mHeader;
+		uint64_t archiveSize = (uint64_t)archive->mFile.mSize;
+		success = PakArchiveRead(archive, 0, &header, sizeof(header)) == sizeof(header) && header.mMagic == PAK_MAGIC &&
+				  header.mVersion == PAK_VERSION && header.mBucketCount && !(header.mBucketCount & (header.mBucketCount - 1)) &&
+				  header.mBucketCount > header.mEntryCount && header.mTocOffset <= archiveSize &&
+				  header.mTocSize <= archiveSize - header.mTocOffset &&
+				  header.mTocSize >= (uint64_t)header.mBucketCount * sizeof(PakBucket) + (uint64_t)header.mEntryCount * sizeof(PakEntry) +
+										 (uint64_t)header.mChunkCount * sizeof(PakChunk);
+	}
+
+	if (success)
+	{
+		const PakHeader& header = archive->mHeader;
+		const uint8_t* toc = archive->pData ? archive->pData + header.mTocOffset : NULL;
+		if (!toc)
+		{
+			archive->pTocData = tf_malloc((size_t)header.mTocSize);
+			success = PakArchiveRead(archive, header.mTocOffset, archive->pTocData, (size_t)header.mTocSize) == header.mTocSize;
+			toc = (const uint8_t*)archive->pTocData;
+		}
+
+		archive->pBuckets = (const PakBucket*)toc;
+		archive->pEntries = (const PakEntry*)(archive->pBuckets + header.mBucketCount);
+		archive->pChunks = (const PakChunk*)(archive->pEntries + header.mEntryCount);
+		archive->pNames = (const char*)(archive->pChunks + header.mChunkCount);
+		success = success && PakValidateToc(archive);
+	}
+
+	if (!success)
+	{
+		LOGF(LogLevel::eERROR, "Error creating file system from pak file at %s", fileName);
+		if (archive->mFile.pIO)
+		{
+			fsCloseStream(&archive->mFile);
+		}
+		tf_free(archive->pTocData);
+		archive->mMutex.Destroy();
+		tf_free(archive);
+		return false;
+	}
+
+	IFileSystem system = gPakFileIO;
+	system.pUser = archive;
+	*pOut = system;
+
+	return true;
+}
+
+bool fsClosePakFile(IFileSystem* pPak)
+{
+	PakArchive* archive = (PakArchive*)pPak->pUser;
+	fsCloseStream(&archive->mFile);
+	tf_free(archive->pTocData);
+	archive->mMutex.Destroy();
+	tf_free(archive);
+	return true;
+}
+
+static bool PakWritePadding(FileStream* pFile, uint64_t alignment)
+{
+	static const uint8_t zeros[PAK_DATA_ALIGNMENT] = {};
+	uint64_t position = (uint64_t)fsGetStreamSeekPosition(pFile);
+	size_t padding = (size_t)((alignment - position % alignment) % alignment);
+	return fsWriteToStream(pFile, zeros, padding) == padding;
+}
+
+bool fsCreatePakFile(const ResourceDirectory resourceDir, const char* fileName, const PakCreateDesc* pDesc)
+{
+	FileStream pak = {};
+	if (!fsOpenStreamFromPath(resourceDir, fileName, FM_WRITE_BINARY, &pak))
+	{
+		LOGF(LogLevel::eERROR, "Failed to create pak file %s.", fileName);
+		return false;
+	}
+
+	// Header gets written last, once the table of contents is known
+	PakHeader header = {};
+	fsWriteToStream(&pak, &header, sizeof(header));
+	PakWritePadding(&pak, PAK_DATA_ALIGNMENT);
+
+	eastl::vector<PakEntry> entries;
+	eastl::vector<PakChunk> chunks;
+	eastl::vector<uint64_t> hashes;
+	eastl::unordered_set<uint64_t> entryHashes;
+	eastl::string names;
+	eastl::vector<PakChunk> entryChunks;
+	uint8_t* compressed = (uint8_t*)tf_malloc(PAK_CHUNK_SIZE);
+	// miniz is built with MINIZ_NO_MALLOC, so the compressor state has to be provided
+	tdefl_compressor* pCompressor = (tdefl_compressor*)tf_malloc(sizeof(tdefl_compressor));
+	uint64_t totalSize = 0;
+	bool success = true;
+
+	for (uint32_t i = 0; i < pDesc->mFileCount; ++i)
+	{
+		const char* pFileName = pDesc->ppFileNames[i];
+		// Entry names are looked up case-insensitively with forward slashes
+		eastl::string name = pFileName;
+		for (char& c : name)
+		{
+			c = (c == '\\') ? '/' : c;
+		}
+
+		uint64_t hash = pakHashName(name.c_str(), name.size());
+		if (!entryHashes.insert(hash).second)
+		{
+			LOGF(LogLevel::eWARNING, "Skipping %s, a file with the same name was already packed.", pFileName);
+			continue;
+		}
+
+		FileStream file = {};
+		if (!fsOpenStreamFromPath(pDesc->mInputDir, pFileName, FM_READ_BINARY, &file))
+		{
+			LOGF(LogLevel::eERROR, "Failed to open %s.", pFileName);
+			success = false;
+			break;
+		}
+
+		uint64_t size = (uint64_t)fsGetStreamFileSize(&file);
+		uint8_t* data = (uint8_t*)tf_malloc((size_t)max(size, (uint64_t)1));
+		bool read = fsReadFromStream(&file, data, (size_t)size) == size;
+		fsCloseStream(&file);
+		if (!read)
+		{
+			LOGF(LogLevel::eERROR, "Failed to read %s.", pFileName);
+			tf_free(data);
+			success = false;
+			break;
+		}
+
+		PakWritePadding(&pak, PAK_DATA_ALIGNMENT);
+
+		PakEntry entry = {};
+		entry.mDataOffset = (uint64_t)fsGetStreamSeekPosition(&pak);
+		entry.mSize = size;
+		entry.mNameOffset = (uint32_t)names.size();
+		entry.mNameLength = (uint32_t)name.size();
+
+		// Deflate every chunk on its own, keeping it as is unless that saves space
+		entryChunks.clear();
+		uint64_t position = entry.mDataOffset;
+		for (uint64_t offset = 0; offset < size && !pDesc->mStoreOnly; offset += PAK_CHUNK_SIZE)
+		{
+			size_t chunkSize = (size_t)min(size - offset, (uint64_t)PAK_CHUNK_SIZE);
+			size_t inSize = chunkSize;
+			size_t compressedSize = chunkSize - 1;
+			tdefl_init(pCompressor, NULL, NULL, TDEFL_DEFAULT_MAX_PROBES);
+			if (tdefl_compress(pCompressor, data + offset, &inSize, compressed, &compressedSize, TDEFL_FINISH) != TDEFL_STATUS_DONE)
+			{
+				compressedSize = 0;
+			}
+
+			PakChunk chunk = {};
+			chunk.mOffset = position;
+			chunk.mStoredSize = compressedSize ? (uint32_t)compressedSize : (uint32_t)chunkSize;
+			if (compressedSize)
+			{
+				entry.mFlags |= PAK_ENTRY_FLAG_COMPRESSED;
+			}
+			fsWriteToStream(&pak, compressedSize ? compressed : data + offset, chunk.mStoredSize);
+			position += chunk.mStoredSize;
+			entryChunks.push_back(chunk);
+		}
+
+		// Without any compressed chunk the data is identical to the file, so the chunk table is not needed
+		if (!(entry.mFlags & PAK_ENTRY_FLAG_COMPRESSED))
+		{
+			fsSeekStream(&pak, SBO_START_OF_FILE, (ssize_t)entry.mDataOffset);
+			fsWriteToStream(&pak, data, (size_t)size);
+		}
+		else
+		{
+			entry.mFirstChunk = (uint32_t)chunks.size();
+			chunks.insert(chunks.end(), entryChunks.begin(), entryChunks.end());
+		}
+		tf_free(data);
+
+		entry.mStoredSize = (uint64_t)fsGetStreamSeekPosition(&pak) - entry.mDataOffset;
+		totalSize += size;
+
+		entries.push_back(entry);
+		hashes.push_back(hash);
+		names.append(name);
+		names.push_back('\0');
+
+		if (pDesc->mVerbose)
+		{
+			LOGF(LogLevel::eINFO, "Packed %s (%llu -> %llu bytes)", name.c_str(), (unsigned long long)entry.mSize, (unsigned long long)entry.mStoredSize);
+		}
+	}
+	tf_free(pCompressor);
+	tf_free(compressed);
+
+	if (!success)
+	{
+		fsCloseStream(&pak);
+		return false;
+	}
+
+	// Hash table with at most 50% load
+	uint32_t bucketCount = 1;
+	while (bucketCount < entries.size() * 2)
+	{
+		bucketCount <<= 1;
+	}
+
+	eastl::vector<PakBucket> buckets(bucketCount);
+	for (PakBucket& bucket : buckets)
+	{
+		bucket = {};
+		bucket.mEntryIndex = PAK_INVALID_ENTRY;
+	}
+	for (uint32_t i = 0; i < (uint32_t)entries.size(); ++i)
+	{
+		uint32_t slot = (uint32_t)hashes[i] & (bucketCount - 1);
+		while (buckets[slot].mEntryIndex != PAK_INVALID_ENTRY)
+		{
+			slot = (slot + 1) & (bucketCount - 1);
+		}
+		buckets[slot].mHash = hashes[i];
+		buckets[slot].mEntryIndex = i;
+	}
+
+	PakWritePadding(&pak, 16);
+	header.mMagic = PAK_MAGIC;
+	header.mVersion = PAK_VERSION;
+	header.mEntryCount = (uint32_t)entries.size();
+	header.mBucketCount = bucketCount;
+	header.mChunkCount = (uint32_t)chunks.size();
+	header.mTocOffset = (uint64_t)fsGetStreamSeekPosition(&pak);
+
+	fsWriteToStream(&pak, buckets.data(), buckets.size() * sizeof(PakBucket));
+	fsWriteToStream(&pak, entries.data(), entries.size() * sizeof(PakEntry));
+	fsWriteToStream(&pak, chunks.data(), chunks.size() * sizeof(PakChunk));
+	fsWriteToStream(&pak, names.data(), names.size());
+	header.mTocSize = (uint64_t)fsGetStreamSeekPosition(&pak) - header.mTocOffset;
+
+	fsSeekStream(&pak, SBO_START_OF_FILE, 0);
+	success = fsWriteToStream(&pak, &header, sizeof(header)) == sizeof(header);
+	fsSeekStream(&pak, SBO_END_OF_FILE, 0);
+	uint64_t pakSize = (uint64_t)fsGetStreamSeekPosition(&pak);
+	fsCloseStream(&pak);
+
+	if (pDesc->mVerbose)
+	{
+		LOGF(LogLevel::eINFO, "Wrote %s: %u files, %llu bytes (%llu bytes uncompressed)", fileName, header.mEntryCount,
+			 (unsigned long long)pakSize, (unsigned long long)totalSize);
+	}
+
+	return success;
+}
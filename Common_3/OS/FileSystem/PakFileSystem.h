@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../Interfaces/IFileSystem.h"
+
+struct ThreadSystem;
+
+/************************************************************************/
+// MARK: - Pak file format
+/************************************************************************/
+// Layout (little endian):
+//   PakHeader, padded to PAK_DATA_ALIGNMENT
+//   Entry data, every entry starts at a multiple of PAK_DATA_ALIGNMENT
+//   Table of contents at mTocOffset: PakBucket[mBucketCount], PakEntry[mEntryCount], PakChunk[mChunkCount], names
+//
+// Entries are split into PAK_CHUNK_SIZE chunks that are deflated independently, so any chunk can be
+// decompressed on its own and in parallel with the others. Chunks that do not shrink are stored as is.
+// Entries without any compressed chunk are stored contiguously and can be read (or mapped) directly.
+#define PAK_MAGIC 0x4B504654 // "TFPK"
+#define PAK_VERSION 1
+#define PAK_CHUNK_SIZE (64 * 1024)
+#define PAK_DATA_ALIGNMENT 4096
+#define PAK_INVALID_ENTRY 0xFFFFFFFF
+
+typedef enum PakEntryFlags
+{
+	PAK_ENTRY_FLAG_NONE = 0,
+	PAK_ENTRY_FLAG_COMPRESSED = 1 << 0,
+} PakEntryFlags;
+
+typedef struct PakHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint32_t mEntryCount;
+	/// Power of two, at least twice mEntryCount
+	uint32_t mBucketCount;
+	uint32_t mChunkCount;
+	uint32_t mReserved;
+	uint64_t mTocOffset;
+	uint64_t mTocSize;
+} PakHeader;
+
+/// Open addressing hash table slot, probed linearly
+typedef struct PakBucket
+{
+	uint64_t mHash;
+	uint32_t mEntryIndex;
+	uint32_t mReserved;
+} PakBucket;
+
+typedef struct PakEntry
+{
+	uint64_t mDataOffset;
+	uint64_t mSize;
+	/// Bytes the entry occupies in the archive
+	uint64_t mStoredSize;
+	/// First of (mSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE chunks, only valid with PAK_ENTRY_FLAG_COMPRESSED
+	uint32_t mFirstChunk;
+	uint32_t mFlags;
+	/// Offset of the name in the name block at the end of the table of contents
+	uint32_t mNameOffset;
+	uint32_t mNameLength;
+} PakEntry;
+
+typedef struct PakChunk
+{
+	uint64_t mOffset;
+	/// Equal to the uncompressed chunk size when the chunk is stored
+	uint32_t mStoredSize;
+	uint32_t mReserved;
+} PakChunk;
+
+COMPILE_ASSERT(sizeof(PakHeader) == 40);
+COMPILE_ASSERT(sizeof(PakBucket) == 16);
+COMPILE_ASSERT(sizeof(PakEntry) == 40);
+COMPILE_ASSERT(sizeof(PakChunk) == 16);
+
+/// Names are hashed case-insensitively with forward slashes, matching how zip entries are looked up
+static inline uint64_t pakHashName(const char* name, size_t length)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < length; ++i)
+	{
+		char c = name[i];
+		c = (c == '\\') ? '/' : ((c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c);
+		hash = (hash ^ (uint8_t)c) * 0x100000001b3ull;
+	}
+	return hash;
+}
+/************************************************************************/
+// MARK: - Pak file system
+/************************************************************************/
+/// Mounts a pak archive as a read-only file system. Resource directories set on it resolve names the same way
+/// as for zip archives: fsGetResourceDirectory(dir) + "/" + fileName.
+/// The archive is memory mapped when possible: stored entries are then returned as memory streams pointing into
+/// the mapping (see fsGetStreamBuffer). Requires the miniz implementation from zip.cpp.
+/// With pThreadSystem, reads spanning several compressed chunks of a mapped archive decompress them in parallel
+/// on the pool and the reading thread.
+bool fsOpenPakFile(const ResourceDirectory resourceDir, const char* fileName, IFileSystem* pOut, ThreadSystem* pThreadSystem = NULL);
+
+/// Streams opened from the archive must be closed before this
+bool fsClosePakFile(IFileSystem* pPak);
+
+typedef struct PakCreateDesc
+{
+	/// Files are read from here. Entry names are the file names with forward slashes
+	ResourceDirectory mInputDir;
+	const char**      ppFileNames;
+	uint32_t          mFileCount;
+	/// Stores every chunk uncompressed
+	bool              mStoreOnly;
+	/// Logs every packed file
+	bool              mVerbose;
+} PakCreateDesc;
+
+/// Writes a pak archive holding the files of pDesc. A file whose name matches an earlier one is skipped.
+/// Used by the AssetPipeline -pak command. Requires the miniz implementation from zip.cpp.
+bool fsCreatePakFile(const ResourceDirectory resourceDir, const char* fileName, const PakCreateDesc* pDesc);
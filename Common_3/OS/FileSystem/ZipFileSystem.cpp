@@ -23,23 +23,365 @@
 //*/
 
 #include "../../ThirdParty/OpenSource/zip/zip.h"
+#define MINIZ_HEADER_FILE_ONLY
+#include "../../ThirdParty/OpenSource/zip/miniz.h"
 
 #include "../Interfaces/ILog.h"
+#include "../Interfaces/IThread.h"
 #include "../Interfaces/IMemory.h"
 
-static bool ZipOpen(IFileSystem* pIO, const ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut)
+// Local file header layout, the central directory does not store the size of its name and extra field
+#define ZIP_LOCAL_HEADER_SIGNATURE 0x04034b50
+#define ZIP_LOCAL_HEADER_SIZE 30
+#define ZIP_LOCAL_HEADER_NAME_LEN_OFS 26
+#define ZIP_LOCAL_HEADER_EXTRA_LEN_OFS 28
+
+#define ZIP_METHOD_STORED 0
+#define ZIP_METHOD_DEFLATED 8
+
+static inline uint32_t ZipReadLE16(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8); }
+static inline uint32_t ZipReadLE32(const uint8_t* p) { return ZipReadLE16(p) | (ZipReadLE16(p + 2) << 16); }
+
+// Compressed bytes fetched per read when the archive is not memory mapped
+#define ZIP_INPUT_BUFFER_SIZE (64 * 1024)
+// Uncompressed distance between inflate checkpoints. Each one costs ~44KB (decompressor state and dictionary)
+#define ZIP_CHECKPOINT_INTERVAL (4 * 1024 * 1024)
+
+typedef struct ZipArchive
 {
-	// #TODO: Write to zip
+	mz_zip_archive mArchive;
+	/// Memory mapped when possible, otherwise a regular stream shared by all entries
+	FileStream     mFile;
+	/// Whole archive when mFile is mapped
+	const uint8_t* pData;
+	/// Guards the central directory lookups and mFile when it is not mapped
+	Mutex          mMutex;
+	/// Archives opened for writing or appending keep using the zip library
+	zip_t*         pZip;
+} ZipArchive;
 
-	zip_t* zip = (zip_t*)pIO->pUser;
-	char filePath[FS_MAX_PATH] = {};
-	fsAppendPathComponent(fsGetResourceDirectory(resourceDir), fileName, filePath);
+/// Inflate state at a known uncompressed offset. Restoring one resumes decompression from there
+typedef struct ZipCheckpoint
+{
+	uint64_t           mOutputOffset;
+	uint64_t           mInputOffset;
+	size_t             mDictOffset;
+	tinfl_decompressor mInflator;
+	uint8_t            mDict[TINFL_LZ_DICT_SIZE];
+} ZipCheckpoint;
+
+typedef struct ZipEntryStream
+{
+	ZipArchive*        pArchive;
+	/// Archive offset of the compressed data
+	uint64_t           mDataOffset;
+	uint64_t           mCompressedSize;
+	uint64_t           mCursor;
+	/// Uncompressed entry, only when the archive is not mapped. Read straight from the archive
+	bool               mStored;
+
+	// Inflate state
+	tinfl_decompressor mInflator;
+	uint64_t           mInputOffset;
+	/// Uncompressed offset of the first pending byte
+	uint64_t           mOutputOffset;
+	/// Inflated bytes not consumed yet, at mDict[mPendingOffset]
+	size_t             mPendingOffset;
+	size_t             mPendingSize;
+	size_t             mDictOffset;
+	bool               mFailed;
+	uint8_t            mDict[TINFL_LZ_DICT_SIZE];
+
+	// Compressed data window, only used when the archive is not mapped
+	uint64_t           mInputBufferOffset;
+	size_t             mInputBufferSize;
+	uint8_t*           pInputBuffer;
+
+	// Seek index, sorted by mOutputOffset
+	ZipCheckpoint**    ppCheckpoints;
+	uint32_t           mCheckpointCount;
+} ZipEntryStream;
+
+static void* ZipAlloc(void* opaque, size_t items, size_t size) { return tf_calloc(items, size); }
+static void  ZipFree(void* opaque, void* address) { tf_free(address); }
+static void* ZipRealloc(void* opaque, void* address, size_t items, size_t size) { return tf_realloc(address, items * size); }
+
+static size_t ZipArchiveRead(void* pOpaque, mz_uint64 offset, void* pBuffer, size_t size)
+{
+	ZipArchive* archive = (ZipArchive*)pOpaque;
+	uint64_t archiveSize = (uint64_t)archive->mFile.mSize;
+	if (offset >= archiveSize)
+	{
+		return 0;
+	}
+	size = (size_t)min((uint64_t)size, archiveSize - (uint64_t)offset);
+
+	if (archive->pData)
+	{
+		memcpy(pBuffer, archive->pData + offset, size);
+		return size;
+	}
+
+	MutexLock lock(archive->mMutex);
+	if (!fsSeekStream(&archive->mFile, SBO_START_OF_FILE, (ssize_t)offset))
+	{
+		return 0;
+	}
+	return fsReadFromStream(&archive->mFile, pBuffer, size);
+}
+/************************************************************************/
+// Zip Entry Stream Functions
+/************************************************************************/
+static void ZipEntryReset(ZipEntryStream* entry)
+{
+	tinfl_init(&entry->mInflator);
+	entry->mInputOffset = 0;
+	entry->mOutputOffset = 0;
+	entry->mPendingOffset = 0;
+	entry->mPendingSize = 0;
+	entry->mDictOffset = 0;
+	entry->mFailed = false;
+}
+
+static void ZipEntryAddCheckpoint(ZipEntryStream* entry)
+{
+	uint64_t last = entry->mCheckpointCount ? entry->ppCheckpoints[entry->mCheckpointCount - 1]->mOutputOffset : 0;
+	if (entry->mOutputOffset < last + ZIP_CHECKPOINT_INTERVAL)
+	{
+		return;
+	}
+
+	ZipCheckpoint* checkpoint = (ZipCheckpoint*)tf_malloc(sizeof(ZipCheckpoint));
+	checkpoint->mOutputOffset = entry->mOutputOffset;
+	checkpoint->mInputOffset = entry->mInputOffset;
+	checkpoint->mDictOffset = entry->mDictOffset;
+	checkpoint->mInflator = entry->mInflator;
+	memcpy(checkpoint->mDict, entry->mDict, sizeof(entry->mDict));
+
+	entry->ppCheckpoints = (ZipCheckpoint**)tf_realloc(entry->ppCheckpoints, (entry->mCheckpointCount + 1) * sizeof(ZipCheckpoint*));
+	entry->ppCheckpoints[entry->mCheckpointCount++] = checkpoint;
+}
+
+// Moves the inflate state to the closest known point at or before `offset`, unless inflating forward from the
+// current state gets there sooner
+static void ZipEntrySeekInflate(ZipEntryStream* entry, uint64_t offset)
+{
+	const ZipCheckpoint* best = NULL;
+	for (uint32_t i = 0; i < entry->mCheckpointCount && entry->ppCheckpoints[i]->mOutputOffset <= offset; ++i)
+	{
+		best = entry->ppCheckpoints[i];
+	}
+
+	if (offset >= entry->mOutputOffset && (!best || best->mOutputOffset <= entry->mOutputOffset + entry->mPendingSize))
+	{
+		return;
+	}
+
+	if (!best)
+	{
+		ZipEntryReset(entry);
+		return;
+	}
+
+	entry->mInflator = best->mInflator;
+	memcpy(entry->mDict, best->mDict, sizeof(entry->mDict));
+	entry->mInputOffset = best->mInputOffset;
+	entry->mOutputOffset = best->mOutputOffset;
+	entry->mDictOffset = best->mDictOffset;
+	entry->mPendingOffset = 0;
+	entry->mPendingSize = 0;
+	entry->mFailed = false;
+}
+
+// Inflates the next run of bytes into the dictionary. Pending output has to be consumed first
+static bool ZipEntryInflate(ZipEntryStream* entry)
+{
+	ASSERT(!entry->mPendingSize);
+	if (entry->mFailed)
+	{
+		return false;
+	}
+
+	ZipEntryAddCheckpoint(entry);
+
+	// Without a mapping the input comes in windows, tinfl may use up a whole window without producing any output.
+	// Keep feeding it until there is output, the stream is done or it fails
+	size_t outputSize = 0;
+	while (!outputSize && !entry->mFailed)
+	{
+		const uint8_t* input = NULL;
+		size_t inputSize = 0;
+		uint64_t remainingInput = entry->mCompressedSize - entry->mInputOffset;
+		if (entry->pArchive->pData)
+		{
+			input = entry->pArchive->pData + entry->mDataOffset + entry->mInputOffset;
+			inputSize = (size_t)remainingInput;
+		}
+		else
+		{
+			uint64_t bufferEnd = entry->mInputBufferOffset + entry->mInputBufferSize;
+			if (entry->mInputOffset < entry->mInputBufferOffset || entry->mInputOffset >= bufferEnd)
+			{
+				size_t size = (size_t)min(remainingInput, (uint64_t)ZIP_INPUT_BUFFER_SIZE);
+				entry->mInputBufferOffset = entry->mInputOffset;
+				entry->mInputBufferSize = ZipArchiveRead(entry->pArchive, entry->mDataOffset + entry->mInputOffset, entry->pInputBuffer, size);
+				bufferEnd = entry->mInputBufferOffset + entry->mInputBufferSize;
+			}
+			input = entry->pInputBuffer + (entry->mInputOffset - entry->mInputBufferOffset);
+			inputSize = (size_t)(bufferEnd - entry->mInputOffset);
+		}
+
+		outputSize = TINFL_LZ_DICT_SIZE - entry->mDictOffset;
+		const mz_uint32 flags = inputSize < remainingInput ? TINFL_FLAG_HAS_MORE_INPUT : 0;
+		tinfl_status status = tinfl_decompress(&entry->mInflator, input, &inputSize, entry->mDict, entry->mDict + entry->mDictOffset, &outputSize, flags);
+		entry->mInputOffset += inputSize;
+
+		if (status < TINFL_STATUS_DONE || (!outputSize && !inputSize))
+		{
+			LOGF(LogLevel::eERROR, "Error %i inflating zip entry", (int)status);
+			entry->mFailed = true;
+		}
+		else if (status == TINFL_STATUS_DONE)
+		{
+			break;
+		}
+	}
+
+	entry->mPendingOffset = entry->mDictOffset;
+	entry->mPendingSize = outputSize;
+	entry->mDictOffset = (entry->mDictOffset + outputSize) & (TINFL_LZ_DICT_SIZE - 1);
+
+	return outputSize > 0;
+}
+
+static bool ZipEntryClose(FileStream* pFile)
+{
+	ZipEntryStream* entry = (ZipEntryStream*)pFile->pUser;
+	for (uint32_t i = 0; i < entry->mCheckpointCount; ++i)
+	{
+		tf_free(entry->ppCheckpoints[i]);
+	}
+	tf_free(entry->ppCheckpoints);
+	tf_free(entry->pInputBuffer);
+	tf_free(entry);
+	return true;
+}
+
+static size_t ZipEntryRead(FileStream* pFile, void* outputBuffer, size_t bufferSizeInBytes)
+{
+	ZipEntryStream* entry = (ZipEntryStream*)pFile->pUser;
+	uint8_t* dst = (uint8_t*)outputBuffer;
+	size_t bytesToRead = (size_t)min((uint64_t)bufferSizeInBytes, (uint64_t)pFile->mSize - min(entry->mCursor, (uint64_t)pFile->mSize));
+	size_t bytesRead = 0;
+
+	if (entry->mStored)
+	{
+		bytesRead = ZipArchiveRead(entry->pArchive, entry->mDataOffset + entry->mCursor, dst, bytesToRead);
+		entry->mCursor += bytesRead;
+		return bytesRead;
+	}
+
+	ZipEntrySeekInflate(entry, entry->mCursor);
+
+	while (bytesRead < bytesToRead)
+	{
+		uint64_t pendingEnd = entry->mOutputOffset + entry->mPendingSize;
+		if (entry->mCursor >= pendingEnd)
+		{
+			// Everything pending lies before the cursor, drop it and inflate more
+			entry->mOutputOffset = pendingEnd;
+			entry->mPendingSize = 0;
+			if (!ZipEntryInflate(entry))
+			{
+				break;
+			}
+			continue;
+		}
+
+		size_t skip = (size_t)(entry->mCursor - entry->mOutputOffset);
+		size_t size = min(entry->mPendingSize - skip, bytesToRead - bytesRead);
+		memcpy(dst + bytesRead, entry->mDict + entry->mPendingOffset + skip, size);
+		bytesRead += size;
+		entry->mCursor += size;
+	}
+
+	return bytesRead;
+}
+
+static size_t ZipEntryWrite(FileStream*, const void*, size_t)
+{
+	LOGF(LogLevel::eWARNING, "Attempting to write to read-only zip entry");
+	return 0;
+}
+
+static bool ZipEntrySeek(FileStream* pFile, SeekBaseOffset baseOffset, ssize_t seekOffset)
+{
+	ZipEntryStream* entry = (ZipEntryStream*)pFile->pUser;
+	ssize_t newPosition = seekOffset;
+	switch (baseOffset)
+	{
+	case SBO_START_OF_FILE: break;
+	case SBO_CURRENT_POSITION: newPosition += (ssize_t)entry->mCursor; break;
+	case SBO_END_OF_FILE: newPosition += pFile->mSize; break;
+	}
+
+	if (newPosition < 0 || newPosition > pFile->mSize)
+	{
+		return false;
+	}
+
+	// Inflating is deferred to the next read
+	entry->mCursor = (uint64_t)newPosition;
+	return true;
+}
+
+static ssize_t ZipEntryGetSeekPosition(const FileStream* pFile)
+{
+	return (ssize_t)((const ZipEntryStream*)pFile->pUser)->mCursor;
+}
+
+static ssize_t ZipEntryGetSize(const FileStream* pFile)
+{
+	return pFile->mSize;
+}
+
+static bool ZipEntryFlush(FileStream*)
+{
+	// No-op.
+	return true;
+}
+
+static bool ZipEntryIsAtEnd(const FileStream* pFile)
+{
+	return ((const ZipEntryStream*)pFile->pUser)->mCursor >= (uint64_t)pFile->mSize;
+}
+
+static IFileSystem gZipEntryIO =
+{
+	NULL,
+	ZipEntryClose,
+	ZipEntryRead,
+	ZipEntryWrite,
+	ZipEntrySeek,
+	ZipEntryGetSeekPosition,
+	ZipEntryGetSize,
+	ZipEntryFlush,
+	ZipEntryIsAtEnd
+};
+/************************************************************************/
+// Zip File IO
+/************************************************************************/
+static bool ZipOpenWritable(ZipArchive* archive, const char* filePath, const char* fileName, FileMode mode, FileStream* pOut)
+{
+	// #TODO: Write to zip
+	MutexLock lock(archive->mMutex);
+	zip_t* zip = archive->pZip;
 
 	int error = zip_entry_open(zip, filePath);
 	if (error)
 	{
 		LOGF(LogLevel::eINFO, "Error %i finding file %s for opening in zip: %s", error, fileName, fileName);
-		return NULL;
+		return false;
 	}
 
 	// Extract the contents of the zip entry
@@ -53,8 +395,86 @@ static bool ZipOpen(IFileSystem* pIO, const ResourceDirectory resourceDir, const
 	return fsOpenStreamFromMemory(uncompressed, uncompressedSize, mode, true, pOut);
 }
 
-// #NOTE - Only one function needed for zip file IO as we unzip the zip entry when it is opened and treat it as memory buffer
-// More will be needed if we want to support zip write
+// Entries are opened without extracting them. Stored entries of a mapped archive are served from the mapping,
+// anything else is read (and inflated) incrementally as the stream is read
+static bool ZipOpen(IFileSystem* pIO, const ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut)
+{
+	ZipArchive* archive = (ZipArchive*)pIO->pUser;
+	char filePath[FS_MAX_PATH] = {};
+	fsAppendPathComponent(fsGetResourceDirectory(resourceDir), fileName, filePath);
+
+	// Zip entry names always use forward slashes
+	for (char* c = filePath; *c; ++c)
+	{
+		if (*c == '\\')
+		{
+			*c = '/';
+		}
+	}
+
+	if (archive->pZip)
+	{
+		return ZipOpenWritable(archive, filePath, fileName, mode, pOut);
+	}
+
+	mz_zip_archive_file_stat stat = {};
+	{
+		MutexLock lock(archive->mMutex);
+		int index = mz_zip_reader_locate_file(&archive->mArchive, filePath, NULL, 0);
+		if (index < 0 || !mz_zip_reader_file_stat(&archive->mArchive, (mz_uint)index, &stat))
+		{
+			LOGF(LogLevel::eINFO, "Error finding file %s for opening in zip", fileName);
+			return false;
+		}
+	}
+
+	if ((stat.m_bit_flag & 1) || (stat.m_method != ZIP_METHOD_STORED && stat.m_method != ZIP_METHOD_DEFLATED))
+	{
+		LOGF(LogLevel::eERROR, "Zip entry %s is encrypted or uses unsupported compression method %u", fileName, (uint32_t)stat.m_method);
+		return false;
+	}
+
+	uint8_t header[ZIP_LOCAL_HEADER_SIZE] = {};
+	if (ZipArchiveRead(archive, stat.m_local_header_ofs, header, sizeof(header)) != sizeof(header) ||
+		ZipReadLE32(header) != ZIP_LOCAL_HEADER_SIGNATURE)
+	{
+		LOGF(LogLevel::eERROR, "Invalid local header for zip entry %s", fileName);
+		return false;
+	}
+
+	uint64_t dataOffset = stat.m_local_header_ofs + ZIP_LOCAL_HEADER_SIZE + ZipReadLE16(header + ZIP_LOCAL_HEADER_NAME_LEN_OFS) +
+						  ZipReadLE16(header + ZIP_LOCAL_HEADER_EXTRA_LEN_OFS);
+	if (dataOffset + stat.m_comp_size > (uint64_t)archive->mFile.mSize)
+	{
+		LOGF(LogLevel::eERROR, "Zip entry %s extends past the end of the archive", fileName);
+		return false;
+	}
+
+	if (stat.m_method == ZIP_METHOD_STORED && archive->pData)
+	{
+		return fsOpenStreamFromMemory(archive->pData + dataOffset, (size_t)stat.m_uncomp_size, mode, false, pOut);
+	}
+
+	ZipEntryStream* entry = (ZipEntryStream*)tf_calloc(1, sizeof(ZipEntryStream));
+	entry->pArchive = archive;
+	entry->mDataOffset = dataOffset;
+	entry->mCompressedSize = stat.m_comp_size;
+	ZipEntryReset(entry);
+	entry->mStored = stat.m_method == ZIP_METHOD_STORED;
+	if (!archive->pData && !entry->mStored)
+	{
+		entry->pInputBuffer = (uint8_t*)tf_malloc(ZIP_INPUT_BUFFER_SIZE);
+	}
+
+	FileStream stream = {};
+	stream.pUser = entry;
+	stream.mSize = (ssize_t)stat.m_uncomp_size;
+	stream.mMode = mode;
+	stream.pIO = &gZipEntryIO;
+	*pOut = stream;
+	return true;
+}
+
 static IFileSystem gZipFileIO =
 {
 	ZipOpen
@@ -62,38 +482,57 @@ static IFileSystem gZipFileIO =
 
 bool fsOpenZipFile(const ResourceDirectory resourceDir, const char* fileName, FileMode mode, IFileSystem* pOut)
 {
-	char zipMode = 0;
+	ZipArchive* archive = (ZipArchive*)tf_calloc(1, sizeof(ZipArchive));
+	archive->mMutex.Init();
 
-	if (mode & FM_WRITE)
+	if (mode & (FM_WRITE | FM_APPEND))
 	{
-		zipMode = 'w';
+		archive->pZip = zip_open(resourceDir, fileName, ZIP_DEFAULT_COMPRESSION_LEVEL, (mode & FM_WRITE) ? 'w' : 'a');
 	}
-	else if (mode & FM_READ)
+	else if (fsOpenStreamMapped(resourceDir, fileName, &archive->mFile))
 	{
-		zipMode = 'r';
-	}
-	else
-	{
-		zipMode = 'a';
+		archive->pData = (const uint8_t*)fsGetStreamBuffer(&archive->mFile);
+		archive->mArchive.m_pAlloc = ZipAlloc;
+		archive->mArchive.m_pFree = ZipFree;
+		archive->mArchive.m_pRealloc = ZipRealloc;
+		archive->mArchive.m_pRead = ZipArchiveRead;
+		archive->mArchive.m_pIO_opaque = archive;
+		if (!mz_zip_reader_init(&archive->mArchive, (mz_uint64)archive->mFile.mSize, 0))
+		{
+			fsCloseStream(&archive->mFile);
+			archive->mFile = {};
+		}
 	}
 
-	zip_t* zipFile = zip_open(resourceDir, fileName, ZIP_DEFAULT_COMPRESSION_LEVEL, zipMode);
-
-	if (!zipFile)
+	if (!archive->pZip && !archive->mFile.pIO)
 	{
 		LOGF(LogLevel::eERROR, "Error creating file system from zip file at %s", fileName);
+		archive->mMutex.Destroy();
+		tf_free(archive);
 		return false;
 	}
 
 	IFileSystem system = gZipFileIO;
-	system.pUser = zipFile;
+	system.pUser = archive;
 	*pOut = system;
 
 	return true;
 }
 
+/// Streams opened from the archive must be closed before this
 bool fsCloseZipFile(IFileSystem* pZip)
 {
-	zip_close((zip_t*)pZip->pUser);
+	ZipArchive* archive = (ZipArchive*)pZip->pUser;
+	if (archive->pZip)
+	{
+		zip_close(archive->pZip);
+	}
+	else
+	{
+		mz_zip_reader_end(&archive->mArchive);
+		fsCloseStream(&archive->mFile);
+	}
+	archive->mMutex.Destroy();
+	tf_free(archive);
 	return true;
 }
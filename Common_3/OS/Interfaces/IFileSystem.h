@@ -148,6 +148,32 @@ typedef struct FileStream
 	FileMode          mMode;
 } FileStream;
 
+typedef struct FileAsyncRead FileAsyncRead;
+
+/// Invoked on an IO thread once an asynchronous read finished
+typedef void (*FileAsyncReadCallback)(FileAsyncRead* pRead);
+
+/// State of one asynchronous read. Has to stay valid until the read completed
+typedef struct FileAsyncRead
+{
+	/// Optional
+	FileAsyncReadCallback pCallback;
+	void*                 pUserData;
+	/// Valid once the read completed, same value fsReadFromStream would have returned
+	size_t                mBytesRead;
+
+	struct
+	{
+		FILE*             pFile;
+		uint8_t*          pBuffer;
+		size_t            mSize;
+		size_t            mProgress;
+		ssize_t           mOffset;
+		FileAsyncRead*    pNext;
+		volatile uint32_t mCompleted;
+	} mInternal;
+} FileAsyncRead;
+
 typedef struct FileSystemInitDesc
 {
 	const char* pAppName;
@@ -191,6 +217,11 @@ bool fsOpenStreamFromPath(const ResourceDirectory resourceDir, const char* fileN
 /// Opens a memory buffer as a FileStream, returning a stream that must be closed with `fsCloseStream`.
 bool fsOpenStreamFromMemory(const void* buffer, size_t bufferSize, FileMode mode, bool owner, FileStream* pOut);
 
+/// Opens a file for binary reading by mapping it into memory instead of reading it through a FILE.
+/// Pages are loaded on first access and shared with the OS file cache, so large files cost no heap allocation.
+/// Falls back to fsOpenStreamFromPath where the file cannot be mapped (Android assets, custom IO, empty files).
+bool fsOpenStreamMapped(const ResourceDirectory resourceDir, const char* fileName, FileStream* pOut);
+
 /// Closes and invalidates the file stream.
 bool fsCloseStream(FileStream* stream);
 
@@ -215,6 +246,23 @@ bool fsFlushStream(FileStream* stream);
 
 /// Returns whether the current seek position is at the end of the file stream.
 bool fsStreamAtEnd(const FileStream* stream);
+
+/// Returns the whole content of a memory or memory-mapped stream, valid until the stream is closed.
+/// Returns NULL for any other stream. Independent of the seek position.
+const void* fsGetStreamBuffer(const FileStream* stream);
+
+/// Queues a read of at most `bufferSizeInBytes` bytes from the current seek position and returns immediately.
+/// The seek position advances right away as it would for fsReadFromStream, so consecutive calls read consecutive ranges.
+/// Binary system file streams are read by io_uring on Linux (when the kernel supports it) or by a pool of IO threads.
+/// Any other stream (memory, zip, bundled assets) is read before this returns and completes immediately.
+/// The stream and `outputBuffer` have to stay valid until the read completed.
+bool fsReadFromStreamAsync(FileStream* stream, void* outputBuffer, size_t bufferSizeInBytes, FileAsyncRead* pRead);
+
+/// Returns whether the read finished, in which case pRead->mBytesRead is valid and pRead can be reused.
+bool fsIsAsyncReadCompleted(const FileAsyncRead* pRead);
+
+/// Blocks until the read finished and returns the number of bytes read.
+size_t fsWaitAsyncRead(FileAsyncRead* pRead);
 /************************************************************************/
 // MARK: - Minor filename manipulation
 /************************************************************************/
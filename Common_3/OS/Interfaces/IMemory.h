@@ -41,6 +41,75 @@ void* tf_calloc_memalign_internal(size_t count, size_t align, size_t size, const
 void* tf_realloc_internal(void* ptr, size_t size, const char *f, int l, const char *sf);
 void  tf_free_internal(void* ptr, const char *f, int l, const char *sf);
 
+//--------------------------------------------------------------------------------------------
+// Allocation statistics (opt-in with USE_MEMORY_STATS, ignored when USE_MEMORY_TRACKING is defined)
+// Without them the functions below are no-ops and the stats read as zero.
+// Allocations are tagged by the path of the allocating source file, unless the thread sets a tag
+// with MEMORY_TAG_SCOPE. Live bytes, peak bytes and allocation rates are kept per tag and published
+// to the profiler counters ("Memory/<tag>/...") by flipProfiler.
+//--------------------------------------------------------------------------------------------
+typedef enum MemoryTag
+{
+	MEMORY_TAG_OTHER = 0,
+	MEMORY_TAG_OS,
+	MEMORY_TAG_RENDERER,
+	MEMORY_TAG_RESOURCE_LOADER,
+	MEMORY_TAG_ANIMATION,
+	MEMORY_TAG_UI,
+	MEMORY_TAG_LUA,
+	MEMORY_TAG_COUNT,
+	/// Tag allocations by the path of the allocating source file
+	MEMORY_TAG_AUTO = MEMORY_TAG_COUNT,
+} MemoryTag;
+
+typedef struct MemoryTagStats
+{
+	uint64_t mLiveBytes;
+	/// Highest mLiveBytes seen by tf_memory_update_stats or a sampled allocation
+	uint64_t mPeakBytes;
+	/// 0 when the tag has no budget
+	uint64_t mBudgetBytes;
+	uint64_t mAllocationCount;
+	/// Measured between the last two tf_memory_update_stats calls
+	float    mAllocationsPerSecond;
+	float    mAllocatedBytesPerSecond;
+} MemoryTagStats;
+
+/// Call site of sampled allocations, byte counts are estimates
+typedef struct MemorySampledSite
+{
+	const char* pFile;
+	const char* pFunction;
+	int         mLine;
+	MemoryTag   mTag;
+	uint64_t    mLiveBytes;
+	uint64_t    mAllocatedBytes;
+} MemorySampledSite;
+
+/// False when the build does not collect allocation statistics
+bool        tf_memory_stats_enabled();
+const char* tf_memory_get_tag_name(MemoryTag tag);
+/// Tag used by the allocations of the calling thread, returns the previous one
+MemoryTag   tf_memory_set_thread_tag(MemoryTag tag);
+/// tf_memory_update_stats warns once each time the live bytes of the tag go over the budget. 0 removes the budget
+void        tf_memory_set_budget(MemoryTag tag, uint64_t budgetBytes);
+/// Refreshes peaks and rates, checks the budgets. Call once per frame from one thread, flipProfiler does it
+void        tf_memory_update_stats();
+void        tf_memory_get_stats(MemoryTag tag, MemoryTagStats* pOutStats);
+/// Fills pOutSites with the sites holding the most live bytes, MEMORY_TAG_AUTO returns all tags. Returns the count written
+uint32_t    tf_memory_get_sampled_sites(MemoryTag tag, MemorySampledSite* pOutSites, uint32_t maxCount);
+
+struct MemoryTagScope
+{
+	MemoryTagScope(MemoryTag tag) : mPrevious(tf_memory_set_thread_tag(tag)) {}
+	~MemoryTagScope() { tf_memory_set_thread_tag(mPrevious); }
+	MemoryTag mPrevious;
+};
+
+#define MEMORY_TAG_PASTE0(a, b) a ## b
+#define MEMORY_TAG_PASTE(a, b) MEMORY_TAG_PASTE0(a, b)
+#define MEMORY_TAG_SCOPE(tag) MemoryTagScope MEMORY_TAG_PASTE(memoryTagScope, __LINE__)(tag)
+
 template <typename T, typename... Args>
 static T* tf_placement_new(void* ptr, Args&&... args)
 {
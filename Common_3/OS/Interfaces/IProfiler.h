@@ -68,9 +68,32 @@ void setAggregateFrames(uint32_t nFrames);
 // Dump profile data to "profile-(date).html" of recorded frames, until a maximum amount of frames
 void dumpProfileData(Renderer* pRenderer, const char* appName = "" , uint32_t nMaxFrames = 64);
 
-// Dump benchmark data to "benchmark-(data).txt" of recorded frames
+// Dump profile data to "(appName)Trace-(date).json" of recorded frames, until a maximum amount of frames.
+// Chrome Trace Event format: cpu scopes per thread, gpu timers, labels, counters and frames, loaded by chrome://tracing and ui.perfetto.dev
+void dumpProfileTrace(const char* appName = "", uint32_t nMaxFrames = 64);
+
+// Stream every profiled frame to pFileName in RD_LOG in the same format as dumpProfileTrace, until endProfileTraceCapture.
+// For captures longer than the frame history of the profiler. Returns false if a capture is running or the file can't be opened
+bool beginProfileTraceCapture(const char* pFileName);
+
+// Finish the trace file, exitProfiler calls it
+void endProfileTraceCapture();
+
+// Start recording the time of every cpu / gpu timer, the frame time and the counters of each frame for dumpBenchmarkData
+void beginBenchmark();
+
+// Stop recording and release the recorded frames, exitProfiler calls it
+void endBenchmark();
+
+// Dump the frames recorded since beginBenchmark to "(appName)Benchmark-(date).json", ".csv" and "-frames.csv" in RD_LOG.
+// The json holds the average, min, max and percentiles of every timer and counter, and frame time histograms.
+// The csv holds the same statistics with one row per timer, "-frames.csv" holds the times of each frame.
 void dumpBenchmarkData(Renderer* pRenderer, IApp::Settings* pSettings, const char* appName = "");
 
+// Compare two ".csv" files written by dumpBenchmarkData, both in RD_LOG. Logs every timer whose median or 95th percentile
+// grew by more than fThresholdPercent and fMinDifferenceMs. Returns the number of regressions, UINT32_MAX if a file can't be read
+uint32_t compareBenchmarkData(const char* pBaselineFileName, const char* pFileName, float fThresholdPercent = 5.0f, float fMinDifferenceMs = 0.05f);
+
 
 //------ Profiler UI Widget --------//
 
@@ -841,7 +841,8 @@ int LinuxMain(int argc, char** argv, IApp* app)
 	pApp = app;
 
 	//Used for automated testing, if enabled app will exit after 120 frames
-#ifdef AUTOMATED_TESTING
+	//The null renderer has no window to close, so it exits the same way
+#if defined(AUTOMATED_TESTING) || defined(NULL_RENDERER)
 	uint32_t       testingFrameCount = 0;
 	const uint32_t testingDesiredFrameCount = 120;
 #endif
@@ -849,6 +850,19 @@ int LinuxMain(int argc, char** argv, IApp* app)
 	IApp::Settings* pSettings = &pApp->mSettings;
 	Timer           deltaTimer;
 
+#if defined(NULL_RENDERER)
+	// Run headless: no X display or window is needed to drive the null backend
+	if (pSettings->mWidth == -1 || pSettings->mHeight == -1)
+	{
+		pSettings->mWidth = 1920;
+		pSettings->mHeight = 1080;
+	}
+
+	gWindow.windowedRect = { 0, 0, (int)pSettings->mWidth, (int)pSettings->mHeight };
+	gWindow.fullscreenRect = gWindow.windowedRect;
+	gWindow.clientRect = gWindow.windowedRect;
+	gWindow.fullScreen = false;
+#else
 	gDefaultDisplay = XOpenDisplay(NULL);
     ASSERT(gDefaultDisplay);
 
@@ -878,6 +892,7 @@ int LinuxMain(int argc, char** argv, IApp* app)
 
 	pSettings->mWidth = gWindow.fullScreen ? getRectWidth(gWindow.fullscreenRect) : getRectWidth(gWindow.windowedRect);
 	pSettings->mHeight = gWindow.fullScreen ? getRectHeight(gWindow.fullscreenRect) : getRectHeight(gWindow.windowedRect);
+#endif
 	pApp->pWindow = &gWindow;
 
 	if (!pApp->Init())
@@ -897,7 +912,9 @@ int LinuxMain(int argc, char** argv, IApp* app)
 		if (deltaTime > 0.15f)
 			deltaTime = 0.05f;
 
+#if !defined(NULL_RENDERER)
 		gQuit = handleMessages(&gWindow);
+#endif
 
 		pApp->Update(deltaTime);
 		pApp->Draw();
@@ -909,8 +926,8 @@ int LinuxMain(int argc, char** argv, IApp* app)
 			pApp->Load();
 			pApp->mSettings.mResetGraphics = false;
 		}
-#ifdef AUTOMATED_TESTING
-		//used in automated tests only.
+#if defined(AUTOMATED_TESTING) || defined(NULL_RENDERER)
+		//used in automated tests and headless runs only.
 		testingFrameCount++;
 		if (testingFrameCount >= testingDesiredFrameCount)
             gQuit = true;
@@ -918,13 +935,17 @@ int LinuxMain(int argc, char** argv, IApp* app)
 	}
 
     pApp->mSettings.mQuit = true;
+#if !defined(NULL_RENDERER)
     restoreResolutions();
+#endif
 
 	pApp->Unload();
 
+#if !defined(NULL_RENDERER)
     closeWindow(&gWindow);
     destroyMonitorInfo();
     XCloseDisplay(gDefaultDisplay);
+#endif
 
 	pApp->Exit();
 	
@@ -84,7 +84,10 @@ bool initFileSystem(FileSystemInitDesc* pDesc)
 	return true;
 }
 
+void exitAsyncFileIO();
+
 void exitFileSystem(void)
 {
+	exitAsyncFileIO();
 	gInitialized = false;
 }
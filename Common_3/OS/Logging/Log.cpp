@@ -26,6 +26,8 @@
 #include "../Interfaces/ILog.h"
 #include "../Interfaces/IFileSystem.h"
 #include "../Interfaces/IOperatingSystem.h"
+#include "../Interfaces/ITime.h"
+#include "../Core/Atomics.h"
 #include "../../ThirdParty/OpenSource/EASTL/unordered_map.h"
 
 #include "../Interfaces/IMemory.h"
@@ -34,11 +36,202 @@
 #define LOG_LEVEL_SIZE 6
 #define LOG_MESSAGE_OFFSET (LOG_PREAMBLE_SIZE + LOG_LEVEL_SIZE)
 
+#define LOG_ASYNC_DEFAULT_BUFFER_SIZE (64 * 1024)
+#define LOG_ASYNC_MIN_BUFFER_SIZE (8 * 1024)
+#define LOG_ASYNC_DEFAULT_FLUSH_INTERVAL_MS 10
+
+#define LOG_BINARY_MAGIC 0x474C4654 // "TFLG"
+#define LOG_BINARY_VERSION 1
+#define LOG_BINARY_BUFFER_SIZE (64 * 1024)
+#define LOG_BINARY_CALIBRATION_INTERVAL_USEC 1000000
+
 static Log* pLogger = NULL;
 
 thread_local char Log::Buffer[MAX_BUFFER + 2];
 bool Log::sConsoleLogging = true;
 
+// Asynchronous logging
+enum LogRecordKind
+{
+	LOG_RECORD_PADDING = 0,
+	LOG_RECORD_MESSAGE,
+	LOG_RECORD_RAW,
+	LOG_RECORD_RAW_ERROR,
+};
+
+// Records are 8 byte aligned, a padding record only has the first 8 bytes
+typedef struct LogRecord
+{
+	uint32_t    mSize;
+	uint16_t    mKind;
+	uint16_t    mIndentation;
+	uint32_t    mLevel;
+	int32_t     mLine;
+	/// logGetTick when the message was logged
+	uint64_t    mTick;
+	const char* pFile;
+	/// Set for deferred formatting, the encoded arguments follow. Otherwise the formatted text follows
+	const char* pFormat;
+} LogRecord;
+
+// Single producer (the owning thread), single consumer (the writer thread) ring buffer
+typedef struct LogThreadBuffer
+{
+	tfrg_atomic64_t  mWritePos;
+	uint8_t          mPadding0[64 - sizeof(tfrg_atomic64_t)];
+	tfrg_atomic64_t  mReadPos;
+	uint8_t          mPadding1[64 - sizeof(tfrg_atomic64_t)];
+	tfrg_atomic64_t  mDroppedCount;
+	uint64_t         mReportedDroppedCount;
+	tfrg_atomic32_t  mOrphaned;
+	uint32_t         mSize;
+	uint8_t*         pData;
+	LogThreadBuffer* pNext;
+	uint32_t         mThreadIndex;
+	/// The binary log already has the thread name
+	bool             mBinaryDefined;
+	char             mThreadName[MAX_THREAD_NAME_LENGTH + 1];
+} LogThreadBuffer;
+
+// Binary log layout, native endianness:
+//   LogBinaryHeader
+//   records, each starting with a LogBinaryRecordType byte followed by the fields listed below
+enum LogBinaryRecordType
+{
+	/// uint32 thread index, uint16 name length, name
+	LOG_BINARY_THREAD = 1,
+	/// uint32 format id, uint16 record kind, int32 line, uint16 file length, file, uint32 format length, format
+	LOG_BINARY_FORMAT,
+	/// uint32 format id, uint32 thread index, uint32 level, uint16 indentation, uint64 tick, uint32 args size, args
+	LOG_BINARY_MESSAGE,
+	/// Same as LOG_BINARY_MESSAGE with the formatted text (null terminated) instead of the args
+	LOG_BINARY_TEXT,
+	/// uint64 tick, int64 getUSec at that tick
+	LOG_BINARY_CALIBRATION,
+	/// uint32 thread index, uint64 dropped message count
+	LOG_BINARY_DROPPED,
+};
+
+typedef struct LogBinaryHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	/// time() and getUSec() at the start tick
+	int64_t  mStartTime;
+	int64_t  mStartUSec;
+	uint64_t mStartTick;
+} LogBinaryHeader;
+
+// Messages logged from the same format string at the same place share their format id.
+// The format is keyed on its text, the same address may hold a different string later on
+typedef struct LogFormatKey
+{
+	uint64_t    mFormatHash;
+	const char* pFile;
+	int32_t     mLine;
+	uint32_t    mKind;
+
+	bool operator==(const LogFormatKey& other) const
+	{
+		return mFormatHash == other.mFormatHash && pFile == other.pFile && mLine == other.mLine && mKind == other.mKind;
+	}
+} LogFormatKey;
+
+struct LogFormatKeyHash
+{
+	size_t operator()(const LogFormatKey& key) const
+	{
+		return (size_t)((key.mFormatHash * 31 + (uintptr_t)key.pFile) * 31 + (uint32_t)key.mLine * 4 + key.mKind);
+	}
+};
+
+static uint64_t logHashFormat(const char* format)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (; *format; ++format)
+		hash = (hash ^ (uint8_t)*format) * 0x100000001b3ull;
+	return hash;
+}
+
+typedef struct LogAsync
+{
+	LogAsyncDesc      mDesc;
+	Mutex             mMutex;
+	ConditionVariable mWakeCond;
+	ThreadDesc        mThreadDesc;
+	ThreadHandle      mThread;
+	/// Registered buffers, guarded by mMutex
+	LogThreadBuffer*  pBuffers;
+	tfrg_atomic64_t   mDroppedCount;
+	tfrg_atomic64_t   mFlushRequest;
+	tfrg_atomic64_t   mFlushCompleted;
+	tfrg_atomic32_t   mExit;
+	uint32_t          mNextThreadIndex;
+
+	/// Converts ticks to wall clock time, the writer thread refines the tick rate as time goes on
+	int64_t           mStartTime;
+	int64_t           mStartUSec;
+	uint64_t          mStartTick;
+	int64_t           mCalibrationUSec;
+	uint64_t          mCalibrationTick;
+
+	/// Binary log, only touched by the writer thread
+	FileStream        mBinaryFile;
+	uint8_t*          pBinaryData;
+	uint32_t          mBinarySize;
+	int64_t           mBinaryCalibrationUSec;
+	eastl::unordered_map<LogFormatKey, uint32_t, LogFormatKeyHash> mFormatIds;
+} LogAsync;
+
+// Set by EnableAsync once the LogAsync is complete, loaded once per message
+static tfrg_atomicptr_t gAsyncLog = 0;
+static tfrg_atomic32_t gAsyncLogGeneration = 0;
+
+static inline LogAsync* getAsyncLog()
+{
+	return (LogAsync*)tfrg_atomicptr_load_acquire(&gAsyncLog);
+}
+
+// The buffer stays registered after the thread exits until the writer thread drained it
+struct LogThreadBufferHandle
+{
+	~LogThreadBufferHandle()
+	{
+		if (pBuffer && mGeneration == tfrg_atomic32_load_acquire(&gAsyncLogGeneration))
+			tfrg_atomic32_store_release(&pBuffer->mOrphaned, 1);
+	}
+
+	LogThreadBuffer* pBuffer;
+	uint32_t         mGeneration;
+};
+
+static thread_local LogThreadBufferHandle tLogThreadBuffer;
+
+// Cheapest monotonic tick of the platform, converted to time by the writer thread and the binary log decoder
+static inline uint64_t logGetTick()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+	uint64_t tick;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(tick));
+	return tick;
+#else
+	return (uint64_t)getUSec();
+#endif
+}
+
+static const eastl::pair<uint32_t, const char*> logLevelPrefixes[] =
+{
+	eastl::pair<uint32_t, const char*>{ LogLevel::eWARNING, "WARN| " },
+	eastl::pair<uint32_t, const char*>{ LogLevel::eINFO, "INFO| " },
+	eastl::pair<uint32_t, const char*>{ LogLevel::eDEBUG, " DBG| " },
+	eastl::pair<uint32_t, const char*>{ LogLevel::eERROR, " ERR| " }
+};
+
 eastl::string GetTimeStamp()
 {
 	time_t sysTime;
@@ -66,7 +259,9 @@ void log_write(void * user_data, const char* message)
     ASSERT(fh);
     
     fsWriteToStream(fh, message, strlen(message));
-    fsFlushStream(fh);
+    // The async writer thread flushes once per batch
+    if (!getAsyncLog())
+        fsFlushStream(fh);
 }
 
 // Close callback
@@ -99,6 +294,7 @@ void Log::Init(const char* appName, LogLevel level /* = LogLevel::eALL */)
 
 void Log::Exit()
 {
+	DisableAsync();
 	pLogger->mLogMutex.Destroy();
 	tf_delete(pLogger);
 	pLogger = NULL;
@@ -206,26 +402,14 @@ typedef char LogStr[LOG_LEVEL_SIZE+1];
 
 void Log::Write(uint32_t level, const char * filename, int line_number, const char* message, ...)
 {
-	static eastl::pair<uint32_t, const char*> logLevelPrefixes[] =
-	{
-		eastl::pair<uint32_t, const char*>{ LogLevel::eWARNING, "WARN| " },
-		eastl::pair<uint32_t, const char*>{ LogLevel::eINFO, "INFO| " },
-		eastl::pair<uint32_t, const char*>{ LogLevel::eDEBUG, " DBG| " },
-		eastl::pair<uint32_t, const char*>{ LogLevel::eERROR, " ERR| " }
-	};
-
-	uint32_t log_levels[LEVELS_LOG];
-	uint32_t log_level_count = 0;
-
-	// Check flags
-	for (uint32_t i = 0; i < sizeof(logLevelPrefixes) / sizeof(logLevelPrefixes[0]); ++i)
+	va_list args;
+	va_start(args, message);
+	LogAsync* pAsync = getAsyncLog();
+	if (pAsync)
 	{
-		eastl::pair<uint32_t, const char*>& it = logLevelPrefixes[i];
-		if (it.first & level)
-		{
-			log_levels[log_level_count] = i;
-			++log_level_count;
-		}
+		WriteAsync(pAsync, LOG_RECORD_MESSAGE, level, filename, line_number, message, args);
+		va_end(args);
+		return;
 	}
 
 	uint32_t preable_end = WritePreamble(Buffer, LOG_PREAMBLE_SIZE, filename, line_number);
@@ -235,8 +419,6 @@ void Log::Write(uint32_t level, const char * filename, int line_number, const ch
 	memset(Buffer+preable_end, ' ', indentation);
 
 	uint32_t offset = preable_end + LOG_LEVEL_SIZE + indentation;
-	va_list args;
-	va_start(args, message);
 	offset += vsnprintf(Buffer + offset, MAX_BUFFER - offset, message, args);
 	va_end(args);
 
@@ -244,29 +426,48 @@ void Log::Write(uint32_t level, const char * filename, int line_number, const ch
 	Buffer[offset] = '\n';
 	Buffer[offset + 1] = 0;
 
+	WriteMessage(level, Buffer, preable_end);
+}
+
+void Log::WriteMessage(uint32_t level, char * buffer, uint32_t preable_end)
+{
+	uint32_t log_levels[LEVELS_LOG];
+	uint32_t log_level_count = 0;
+
+	// Check flags
+	for (uint32_t i = 0; i < sizeof(logLevelPrefixes) / sizeof(logLevelPrefixes[0]); ++i)
+	{
+		const eastl::pair<uint32_t, const char*>& it = logLevelPrefixes[i];
+		if (it.first & level)
+		{
+			log_levels[log_level_count] = i;
+			++log_level_count;
+		}
+	}
+
 	// Log for each flag
 	for (uint32_t i = 0; i < log_level_count; ++i)
 	{
-		strncpy(Buffer + preable_end, logLevelPrefixes[log_levels[i]].second, LOG_LEVEL_SIZE);
+		strncpy(buffer + preable_end, logLevelPrefixes[log_levels[i]].second, LOG_LEVEL_SIZE);
 
 		if (sConsoleLogging)
 		{
 			if (pLogger->mQuietMode)
 			{
 				if (level & LogLevel::eERROR)
-					_PrintUnicode(Buffer, true);
+					_PrintUnicode(buffer, true);
 			}
 			else
 			{
-				_PrintUnicode(Buffer, level & LogLevel::eERROR);
+				_PrintUnicode(buffer, level & LogLevel::eERROR);
 			}
 		}
 
 		MutexLock lock{ pLogger->mLogMutex };
 		for (LogCallback & callback : pLogger->mCallbacks)
 		{
-			if (callback.mLevel & log_levels[i])
-				callback.mCallback(callback.mUserData, Buffer);
+			if (callback.mLevel & logLevelPrefixes[log_levels[i]].first)
+				callback.mCallback(callback.mUserData, buffer);
 		}
 	}
 }
@@ -275,25 +476,38 @@ void Log::WriteRaw(uint32_t level, bool error, const char* message, ...)
 {
 	va_list args;
 	va_start(args, message);
+	LogAsync* pAsync = getAsyncLog();
+	if (pAsync)
+	{
+		WriteAsync(pAsync, error ? LOG_RECORD_RAW_ERROR : LOG_RECORD_RAW, level, NULL, 0, message, args);
+		va_end(args);
+		return;
+	}
+
 	vsnprintf(Buffer, MAX_BUFFER, message, args);
 	va_end(args);
 
+	WriteRawMessage(level, error, Buffer);
+}
+
+void Log::WriteRawMessage(uint32_t level, bool error, const char * buffer)
+{
 	if (sConsoleLogging)
 	{
 		if (pLogger->mQuietMode)
 		{
 			if (error)
-				_PrintUnicode(Buffer, true);
+				_PrintUnicode(buffer, true);
 		}
 		else
-			_PrintUnicode(Buffer, error);
+			_PrintUnicode(buffer, error);
 	}
 
 	MutexLock lock{ pLogger->mLogMutex };
 	for (LogCallback & callback : pLogger->mCallbacks)
 	{
 		if (callback.mLevel & level)
-			callback.mCallback(callback.mUserData, Buffer);
+			callback.mCallback(callback.mUserData, buffer);
 	}
 }
 
@@ -318,24 +532,38 @@ void Log::AddInitialLogFile(const char* appName)
     AddFile(exeFileName, FM_WRITE_BINARY_ALLOW_READ, LogLevel::eALL);
 }
 
+static void logLocalTime(int64_t timestamp, tm* pTimeInfo)
+{
+	time_t t = (time_t)timestamp;
+#if defined(_WINDOWS) || defined(XBOX)
+	localtime_s(pTimeInfo, &t);
+#elif defined(ORBIS) || defined(PROSPERO)
+	localtime_s(&t, pTimeInfo);
+#elif defined(NX64)
+	t = getTimeSinceStart();
+	localtime_r(&t, pTimeInfo);
+#else
+	localtime_r(&t, pTimeInfo);
+#endif
+}
+
 uint32_t Log::WritePreamble(char * buffer, uint32_t buffer_size, const char * file, int line)
+{
+	char thread_name[MAX_THREAD_NAME_LENGTH + 1] = { 0 };
+	if (pLogger->mRecordThreadName)
+		Thread::GetCurrentThreadName(thread_name, MAX_THREAD_NAME_LENGTH + 1);
+
+	return WritePreamble(buffer, buffer_size, pLogger->mRecordTimestamp ? (int64_t)time(NULL) : 0, thread_name, file, line);
+}
+
+uint32_t Log::WritePreamble(char * buffer, uint32_t buffer_size, int64_t timestamp, const char * thread_name, const char * file, int line)
 {
 	uint32_t pos = 0;
 	// Date and time
 	if (pLogger->mRecordTimestamp && pos < buffer_size)
 	{
-		time_t  t = time(NULL);
 		tm time_info;
-	#if defined(_WINDOWS) || defined(XBOX)
-		localtime_s(&time_info, &t);
-	#elif defined(ORBIS) || defined(PROSPERO)
-		localtime_s(&t, &time_info);
-	#elif defined(NX64)
-		t = getTimeSinceStart();
-		localtime_r(&t, &time_info);
-	#else
-		localtime_r(&t, &time_info);
-	#endif
+		logLocalTime(timestamp, &time_info);
 		pos += snprintf(buffer + pos, buffer_size - pos, "%04d-%02d-%02d %02d:%02d:%02d ",
 			1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday,
 			time_info.tm_hour, time_info.tm_min, time_info.tm_sec);
@@ -343,8 +571,6 @@ uint32_t Log::WritePreamble(char * buffer, uint32_t buffer_size, const char * fi
 
 	if (pLogger->mRecordThreadName && pos < buffer_size)
 	{
-		char thread_name[MAX_THREAD_NAME_LENGTH + 1] = { 0 };
-		Thread::GetCurrentThreadName(thread_name, MAX_THREAD_NAME_LENGTH + 1);
 		pos += snprintf(buffer + pos, buffer_size - pos, "[%-15s]", thread_name[0] == 0 ? "NoName" : thread_name);
 	}
 
@@ -391,3 +617,988 @@ Log::~Log()
 	
 	mCallbacks.clear();
 }
+
+// Conversion specification arguments, '*' width and precision are read as int
+enum LogArgType
+{
+	LOG_ARG_NONE = 0,
+	LOG_ARG_INT,
+	LOG_ARG_LONG,
+	LOG_ARG_LONG_LONG,
+	LOG_ARG_SIZE,
+	LOG_ARG_INTMAX,
+	LOG_ARG_PTRDIFF,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_LONG_DOUBLE,
+	LOG_ARG_STRING,
+	LOG_ARG_POINTER,
+	LOG_ARG_UNSUPPORTED,
+};
+
+typedef struct LogFormatSpec
+{
+	const char* pBegin;
+	uint32_t    mLength;
+	uint32_t    mStarCount;
+	LogArgType  mType;
+} LogFormatSpec;
+
+// Parses the conversion specification at format (pointing to '%'), returns the character after it
+static const char* parseFormatSpec(const char* format, LogFormatSpec* pSpec)
+{
+	const char* c = format + 1;
+	pSpec->pBegin = format;
+	pSpec->mStarCount = 0;
+	pSpec->mType = LOG_ARG_UNSUPPORTED;
+
+	while (*c && strchr("-+ #0", *c))
+		++c;
+	for (int field = 0; field < 2; ++field)
+	{
+		if (field == 1)
+		{
+			if (*c != '.')
+				break;
+			++c;
+		}
+		if (*c == '*')
+		{
+			++pSpec->mStarCount;
+			++c;
+		}
+		while (*c >= '0' && *c <= '9')
+			++c;
+	}
+
+	// Length modifiers
+	int longCount = 0;
+	char modifier = 0;
+	while (*c && strchr("hlLjzt", *c))
+	{
+		if (*c == 'l')
+			++longCount;
+		modifier = *c;
+		++c;
+	}
+
+	switch (*c)
+	{
+	case '%':
+		pSpec->mType = modifier || pSpec->mStarCount || c != format + 1 ? LOG_ARG_UNSUPPORTED : LOG_ARG_NONE;
+		break;
+	case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+		if (modifier == 'j')
+			pSpec->mType = LOG_ARG_INTMAX;
+		else if (modifier == 'z')
+			pSpec->mType = LOG_ARG_SIZE;
+		else if (modifier == 't')
+			pSpec->mType = LOG_ARG_PTRDIFF;
+		else if (longCount == 1)
+			pSpec->mType = LOG_ARG_LONG;
+		else if (longCount == 2)
+			pSpec->mType = LOG_ARG_LONG_LONG;
+		else if (modifier != 'L')
+			pSpec->mType = LOG_ARG_INT;
+		break;
+	case 'c':
+		if (!modifier)
+			pSpec->mType = LOG_ARG_INT;
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		pSpec->mType = modifier == 'L' ? LOG_ARG_LONG_DOUBLE : LOG_ARG_DOUBLE;
+		break;
+	case 's':
+		if (!modifier)
+			pSpec->mType = LOG_ARG_STRING;
+		break;
+	case 'p':
+		if (!modifier)
+			pSpec->mType = LOG_ARG_POINTER;
+		break;
+	default:
+		break;
+	}
+
+	if (*c)
+		++c;
+	pSpec->mLength = (uint32_t)(c - format);
+	return c;
+}
+
+static bool encodeArg(uint8_t* pArgs, uint32_t capacity, uint32_t* pOffset, const void* pValue, uint32_t size)
+{
+	const uint32_t alignedSize = (size + 7) & ~7u;
+	if (*pOffset + alignedSize > capacity)
+		return false;
+	memcpy(pArgs + *pOffset, pValue, size);
+	*pOffset += alignedSize;
+	return true;
+}
+
+// Stores the arguments of format, returns false when it uses an unsupported conversion or does not fit
+static bool encodeDeferredArgs(uint8_t* pArgs, uint32_t capacity, uint32_t* pSize, const char* format, va_list args)
+{
+	uint32_t offset = 0;
+	for (const char* c = format; *c;)
+	{
+		if (*c != '%')
+		{
+			++c;
+			continue;
+		}
+
+		LogFormatSpec spec;
+		c = parseFormatSpec(c, &spec);
+		if (spec.mType == LOG_ARG_UNSUPPORTED)
+			return false;
+
+		for (uint32_t i = 0; i < spec.mStarCount; ++i)
+		{
+			int64_t value = va_arg(args, int);
+			if (!encodeArg(pArgs, capacity, &offset, &value, sizeof(value)))
+				return false;
+		}
+
+		bool success = true;
+		switch (spec.mType)
+		{
+		case LOG_ARG_NONE:
+			break;
+		case LOG_ARG_INT: { int64_t value = va_arg(args, int); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_LONG: { int64_t value = va_arg(args, long); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_LONG_LONG: { int64_t value = va_arg(args, long long); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_SIZE: { int64_t value = (int64_t)va_arg(args, size_t); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_INTMAX: { int64_t value = (int64_t)va_arg(args, intmax_t); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_PTRDIFF: { int64_t value = (int64_t)va_arg(args, ptrdiff_t); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_DOUBLE: { double value = va_arg(args, double); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_LONG_DOUBLE: { long double value = va_arg(args, long double); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_POINTER: { void* value = va_arg(args, void*); success = encodeArg(pArgs, capacity, &offset, &value, sizeof(value)); break; }
+		case LOG_ARG_STRING:
+		{
+			const char* value = va_arg(args, const char*);
+			if (!value)
+				value = "(null)";
+			uint64_t length = strlen(value);
+			success = encodeArg(pArgs, capacity, &offset, &length, sizeof(length)) &&
+					  encodeArg(pArgs, capacity, &offset, value, (uint32_t)length + 1);
+			break;
+		}
+		default:
+			return false;
+		}
+
+		if (!success)
+			return false;
+	}
+
+	*pSize = offset;
+	return true;
+}
+
+template<typename T>
+static int formatArg(char* buffer, size_t size, const char* spec, const int* stars, uint32_t starCount, T value)
+{
+	switch (starCount)
+	{
+	case 0: return snprintf(buffer, size, spec, value);
+	case 1: return snprintf(buffer, size, spec, stars[0], value);
+	default: return snprintf(buffer, size, spec, stars[0], stars[1], value);
+	}
+}
+
+// Formats a deferred message with the arguments stored by encodeDeferredArgs, stops at the first argument past argsSize
+static uint32_t formatDeferred(char* buffer, uint32_t size, const char* format, const uint8_t* pArgs, uint32_t argsSize)
+{
+	uint32_t pos = 0;
+	uint32_t argOffset = 0;
+	char     spec[64];
+	for (const char* c = format; *c && pos + 1 < size;)
+	{
+		if (*c != '%')
+		{
+			buffer[pos++] = *c++;
+			continue;
+		}
+
+		LogFormatSpec formatSpec;
+		c = parseFormatSpec(c, &formatSpec);
+		if (formatSpec.mType == LOG_ARG_NONE)
+		{
+			buffer[pos++] = '%';
+			continue;
+		}
+
+		const uint32_t specLength = min(formatSpec.mLength, (uint32_t)sizeof(spec) - 1);
+		memcpy(spec, formatSpec.pBegin, specLength);
+		spec[specLength] = 0;
+
+		const uint32_t argSize = formatSpec.mStarCount * (uint32_t)sizeof(int64_t) +
+			(formatSpec.mType == LOG_ARG_LONG_DOUBLE ? (uint32_t)((sizeof(long double) + 7) & ~7u) : (uint32_t)sizeof(int64_t));
+		if (formatSpec.mType == LOG_ARG_UNSUPPORTED || argOffset + argSize > argsSize)
+			break;
+
+		int stars[2] = {};
+		for (uint32_t i = 0; i < formatSpec.mStarCount; ++i)
+		{
+			int64_t value;
+			memcpy(&value, pArgs + argOffset, sizeof(value));
+			argOffset += sizeof(value);
+			stars[i] = (int)value;
+		}
+
+		char*    out = buffer + pos;
+		size_t   remaining = size - pos;
+		int      written = 0;
+		int64_t  intValue = 0;
+		if (formatSpec.mType != LOG_ARG_STRING && formatSpec.mType != LOG_ARG_LONG_DOUBLE && formatSpec.mType != LOG_ARG_DOUBLE)
+			memcpy(&intValue, pArgs + argOffset, sizeof(intValue));
+
+		switch (formatSpec.mType)
+		{
+		case LOG_ARG_INT: written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (int)intValue); break;
+		case LOG_ARG_LONG: written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (long)intValue); break;
+		case LOG_ARG_LONG_LONG: written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (long long)intValue); break;
+		case LOG_ARG_SIZE: written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (size_t)intValue); break;
+		case LOG_ARG_INTMAX: written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (intmax_t)intValue); break;
+		case LOG_ARG_PTRDIFF: written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (ptrdiff_t)intValue); break;
+		case LOG_ARG_POINTER: written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (void*)(uintptr_t)intValue); break;
+		case LOG_ARG_DOUBLE:
+		{
+			double value;
+			memcpy(&value, pArgs + argOffset, sizeof(value));
+			written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, value);
+			break;
+		}
+		case LOG_ARG_LONG_DOUBLE:
+		{
+			long double value;
+			memcpy(&value, pArgs + argOffset, sizeof(value));
+			written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, value);
+			argOffset += (sizeof(long double) + 7) & ~7u;
+			break;
+		}
+		case LOG_ARG_STRING:
+		{
+			uint64_t length;
+			memcpy(&length, pArgs + argOffset, sizeof(length));
+			argOffset += sizeof(length);
+			if (length >= argsSize - argOffset || pArgs[argOffset + length] != 0)
+			{
+				argOffset = argsSize;
+				break;
+			}
+			written = formatArg(out, remaining, spec, stars, formatSpec.mStarCount, (const char*)(pArgs + argOffset));
+			argOffset += ((uint32_t)length + 1 + 7) & ~7u;
+			break;
+		}
+		default:
+			break;
+		}
+
+		if (formatSpec.mType != LOG_ARG_STRING && formatSpec.mType != LOG_ARG_LONG_DOUBLE)
+			argOffset += sizeof(int64_t);
+		if (written > 0)
+			pos += min((uint32_t)written, (uint32_t)remaining - 1);
+	}
+
+	return pos;
+}
+
+static uint32_t nextPowerOfTwo(uint32_t value)
+{
+	uint32_t result = 1;
+	while (result < value)
+		result <<= 1;
+	return result;
+}
+
+void Log::EnableAsync(const LogAsyncDesc* pDesc)
+{
+	ASSERT(pLogger && pDesc);
+	if (getAsyncLog())
+		DisableAsync();
+
+	LogAsync* pAsync = tf_new(LogAsync);
+	pAsync->mDesc = *pDesc;
+	// Any record, including a deferred one, is at most MAX_BUFFER bytes after its header
+	pAsync->mDesc.mThreadBufferSize = nextPowerOfTwo(
+		max(pDesc->mThreadBufferSize ? pDesc->mThreadBufferSize : (uint32_t)LOG_ASYNC_DEFAULT_BUFFER_SIZE, (uint32_t)LOG_ASYNC_MIN_BUFFER_SIZE));
+	if (!pAsync->mDesc.mFlushIntervalMs)
+		pAsync->mDesc.mFlushIntervalMs = LOG_ASYNC_DEFAULT_FLUSH_INTERVAL_MS;
+	pAsync->mStartTick = logGetTick();
+	pAsync->mStartUSec = getUSec();
+	pAsync->mStartTime = (int64_t)time(NULL);
+	pAsync->mCalibrationTick = pAsync->mStartTick;
+	pAsync->mCalibrationUSec = pAsync->mStartUSec;
+
+	if (pDesc->pBinaryFileName)
+	{
+		if (fsOpenStreamFromPath(RD_LOG, pDesc->pBinaryFileName, FM_WRITE_BINARY, &pAsync->mBinaryFile))
+		{
+			// Binary records only hold the arguments
+			pAsync->mDesc.mDeferredFormatting = true;
+			pAsync->pBinaryData = (uint8_t*)tf_malloc(LOG_BINARY_BUFFER_SIZE);
+			pAsync->mBinarySize = 0;
+			pAsync->mBinaryCalibrationUSec = pAsync->mStartUSec;
+
+			LogBinaryHeader header = {};
+			header.mMagic = LOG_BINARY_MAGIC;
+			header.mVersion = LOG_BINARY_VERSION;
+			header.mStartTime = pAsync->mStartTime;
+			header.mStartUSec = pAsync->mStartUSec;
+			header.mStartTick = pAsync->mStartTick;
+			fsWriteToStream(&pAsync->mBinaryFile, &header, sizeof(header));
+		}
+		else
+		{
+			pAsync->mDesc.pBinaryFileName = NULL;
+			Write(LogLevel::eERROR, __FILE__, __LINE__, "Failed to create binary log file %s", pDesc->pBinaryFileName);
+		}
+	}
+	pAsync->mDesc.mBinaryOnly = pAsync->mDesc.mBinaryOnly && pAsync->pBinaryData;
+
+	pAsync->mMutex.Init();
+	pAsync->mWakeCond.Init();
+	pAsync->pBuffers = NULL;
+	pAsync->mDroppedCount = 0;
+	pAsync->mFlushRequest = 0;
+	pAsync->mFlushCompleted = 0;
+	pAsync->mExit = 0;
+	pAsync->mNextThreadIndex = 0;
+	pAsync->mThreadDesc.pFunc = AsyncWriterThread;
+	pAsync->mThreadDesc.pData = pAsync;
+	pAsync->mThread = create_thread(&pAsync->mThreadDesc);
+
+	tfrg_atomicptr_store_release(&gAsyncLog, (uintptr_t)pAsync);
+}
+
+void Log::DisableAsync()
+{
+	LogAsync* pAsync = getAsyncLog();
+	if (!pAsync)
+		return;
+
+	// Messages logged from now on are written right away, the writer thread drains everything before exiting
+	tfrg_atomicptr_store_release(&gAsyncLog, 0);
+	tfrg_atomic32_store_release(&pAsync->mExit, 1);
+	pAsync->mWakeCond.WakeOne();
+	join_thread(pAsync->mThread);
+
+	// Invalidates the buffers still referenced by live threads, they allocate a new one if async logging is enabled again
+	tfrg_atomic32_add_relaxed(&gAsyncLogGeneration, 1);
+	for (LogThreadBuffer* pBuffer = pAsync->pBuffers; pBuffer;)
+	{
+		LogThreadBuffer* pNext = pBuffer->pNext;
+		tf_free(pBuffer->pData);
+		tf_free(pBuffer);
+		pBuffer = pNext;
+	}
+
+	if (pAsync->pBinaryData)
+	{
+		fsCloseStream(&pAsync->mBinaryFile);
+		tf_free(pAsync->pBinaryData);
+	}
+
+	pAsync->mWakeCond.Destroy();
+	pAsync->mMutex.Destroy();
+	tf_delete(pAsync);
+}
+
+void Log::Flush()
+{
+	LogAsync* pAsync = getAsyncLog();
+	if (!pAsync)
+	{
+		MutexLock lock{ pLogger->mLogMutex };
+		for (LogCallback & callback : pLogger->mCallbacks)
+		{
+			if (callback.mFlush)
+				callback.mFlush(callback.mUserData);
+		}
+		return;
+	}
+
+	const uint64_t ticket = tfrg_atomic64_add_relaxed(&pAsync->mFlushRequest, 1) + 1;
+	while (tfrg_atomic64_load_acquire(&pAsync->mFlushCompleted) < ticket)
+	{
+		pAsync->mWakeCond.WakeOne();
+		Thread::Sleep(1);
+	}
+}
+
+uint64_t Log::GetDroppedMessageCount()
+{
+	LogAsync* pAsync = getAsyncLog();
+	return pAsync ? tfrg_atomic64_load_relaxed(&pAsync->mDroppedCount) : 0;
+}
+
+void Log::WriteAsync(LogAsync* pAsync, uint32_t kind, uint32_t level, const char * file, int line, const char * format, va_list args)
+{
+	LogThreadBuffer* pBuffer = tLogThreadBuffer.pBuffer;
+	const uint32_t   generation = tfrg_atomic32_load_acquire(&gAsyncLogGeneration);
+	if (!pBuffer || tLogThreadBuffer.mGeneration != generation)
+	{
+		pBuffer = (LogThreadBuffer*)tf_calloc(1, sizeof(LogThreadBuffer));
+		pBuffer->mSize = pAsync->mDesc.mThreadBufferSize;
+		pBuffer->pData = (uint8_t*)tf_malloc(pBuffer->mSize);
+		// Captured once, the name is not looked up for every message
+		Thread::GetCurrentThreadName(pBuffer->mThreadName, MAX_THREAD_NAME_LENGTH + 1);
+		tLogThreadBuffer.pBuffer = pBuffer;
+		tLogThreadBuffer.mGeneration = generation;
+
+		MutexLock lock{ pAsync->mMutex };
+		pBuffer->mThreadIndex = pAsync->mNextThreadIndex++;
+		pBuffer->pNext = pAsync->pBuffers;
+		pAsync->pBuffers = pBuffer;
+	}
+
+	// The message (or the encoded arguments) goes to the thread local buffer first to know its size
+	LogRecord record = {};
+	record.mKind = (uint16_t)kind;
+	record.mIndentation = (uint16_t)pLogger->mIndentation;
+	record.mLevel = level;
+	record.mLine = line;
+	record.mTick = logGetTick();
+	record.pFile = file;
+
+	uint32_t payloadSize = 0;
+	if (pAsync->mDesc.mDeferredFormatting)
+	{
+		va_list deferredArgs;
+		va_copy(deferredArgs, args);
+		if (encodeDeferredArgs((uint8_t*)Buffer, MAX_BUFFER, &payloadSize, format, deferredArgs))
+			record.pFormat = format;
+		va_end(deferredArgs);
+	}
+	if (!record.pFormat)
+	{
+		int length = vsnprintf(Buffer, MAX_BUFFER, format, args);
+		payloadSize = (uint32_t)min(max(length, 0), (int)MAX_BUFFER - 1) + 1;
+		Buffer[payloadSize - 1] = 0;
+	}
+
+	record.mSize = (uint32_t)((sizeof(LogRecord) + payloadSize + 7) & ~7u);
+
+	const uint64_t mask = pBuffer->mSize - 1;
+	uint64_t       writePos = tfrg_atomic64_load_relaxed(&pBuffer->mWritePos);
+	// Records never wrap around, the end of the buffer is skipped with a padding record
+	const uint64_t contiguous = pBuffer->mSize - (writePos & mask);
+	const uint64_t required = record.mSize + (contiguous < record.mSize ? contiguous : 0);
+	while (writePos + required - tfrg_atomic64_load_acquire(&pBuffer->mReadPos) > pBuffer->mSize)
+	{
+		if (pAsync->mDesc.mOverflowPolicy == LOG_OVERFLOW_DROP)
+		{
+			tfrg_atomic64_add_relaxed(&pBuffer->mDroppedCount, 1);
+			tfrg_atomic64_add_relaxed(&pAsync->mDroppedCount, 1);
+			pAsync->mWakeCond.WakeOne();
+			return;
+		}
+
+		pAsync->mWakeCond.WakeOne();
+		Thread::Sleep(0);
+	}
+
+	if (contiguous < record.mSize)
+	{
+		LogRecord padding = {};
+		padding.mSize = (uint32_t)contiguous;
+		padding.mKind = LOG_RECORD_PADDING;
+		memcpy(pBuffer->pData + (writePos & mask), &padding, sizeof(uint64_t));
+		writePos += contiguous;
+	}
+
+	uint8_t* pDst = pBuffer->pData + (writePos & mask);
+	memcpy(pDst, &record, sizeof(record));
+	memcpy(pDst + sizeof(record), Buffer, payloadSize);
+	writePos += record.mSize;
+	tfrg_atomic64_store_release(&pBuffer->mWritePos, writePos);
+
+	// The writer thread otherwise picks the message up at the next flush interval
+	if (writePos - tfrg_atomic64_load_relaxed(&pBuffer->mReadPos) > pBuffer->mSize / 2 || (level & LogLevel::eERROR))
+		pAsync->mWakeCond.WakeOne();
+}
+
+static void binaryFlush(LogAsync* pAsync)
+{
+	fsWriteToStream(&pAsync->mBinaryFile, pAsync->pBinaryData, pAsync->mBinarySize);
+	pAsync->mBinarySize = 0;
+}
+
+static void binaryWrite(LogAsync* pAsync, const void* pData, uint32_t size)
+{
+	if (pAsync->mBinarySize + size > LOG_BINARY_BUFFER_SIZE)
+	{
+		binaryFlush(pAsync);
+		if (size > LOG_BINARY_BUFFER_SIZE)
+		{
+			fsWriteToStream(&pAsync->mBinaryFile, pData, size);
+			return;
+		}
+	}
+
+	memcpy(pAsync->pBinaryData + pAsync->mBinarySize, pData, size);
+	pAsync->mBinarySize += size;
+}
+
+template<typename T>
+static void binaryWriteValue(LogAsync* pAsync, T value)
+{
+	binaryWrite(pAsync, &value, sizeof(value));
+}
+
+static void binaryWriteCalibration(LogAsync* pAsync)
+{
+	binaryWriteValue<uint8_t>(pAsync, LOG_BINARY_CALIBRATION);
+	binaryWriteValue<uint64_t>(pAsync, pAsync->mCalibrationTick);
+	binaryWriteValue<int64_t>(pAsync, pAsync->mCalibrationUSec);
+	pAsync->mBinaryCalibrationUSec = pAsync->mCalibrationUSec;
+}
+
+static void binaryWriteRecord(LogAsync* pAsync, LogThreadBuffer* pBuffer, const LogRecord& record, const char* pPayload)
+{
+	if (!pBuffer->mBinaryDefined)
+	{
+		const uint16_t nameLength = (uint16_t)strlen(pBuffer->mThreadName);
+		binaryWriteValue<uint8_t>(pAsync, LOG_BINARY_THREAD);
+		binaryWriteValue<uint32_t>(pAsync, pBuffer->mThreadIndex);
+		binaryWriteValue<uint16_t>(pAsync, nameLength);
+		binaryWrite(pAsync, pBuffer->mThreadName, nameLength);
+		pBuffer->mBinaryDefined = true;
+	}
+
+	// Text records still intern their file and line, with the format string they were formatted from
+	const char*  format = record.pFormat ? record.pFormat : "";
+	LogFormatKey key = { logHashFormat(format), record.pFile, record.mLine, record.mKind };
+	eastl::pair<eastl::unordered_map<LogFormatKey, uint32_t, LogFormatKeyHash>::iterator, bool> it =
+		pAsync->mFormatIds.insert(eastl::make_pair(key, (uint32_t)pAsync->mFormatIds.size()));
+	if (it.second)
+	{
+		const char*    file = record.pFile ? get_filename(record.pFile) : "";
+		const uint16_t fileLength = (uint16_t)strlen(file);
+		const uint32_t formatLength = (uint32_t)strlen(format);
+		binaryWriteValue<uint8_t>(pAsync, LOG_BINARY_FORMAT);
+		binaryWriteValue<uint32_t>(pAsync, it.first->second);
+		binaryWriteValue<uint16_t>(pAsync, record.mKind);
+		binaryWriteValue<int32_t>(pAsync, record.mLine);
+		binaryWriteValue<uint16_t>(pAsync, fileLength);
+		binaryWrite(pAsync, file, fileLength);
+		binaryWriteValue<uint32_t>(pAsync, formatLength);
+		binaryWrite(pAsync, format, formatLength);
+	}
+
+	const uint32_t payloadSize = record.mSize - (uint32_t)sizeof(LogRecord);
+	const uint32_t argsSize = record.pFormat ? payloadSize : (uint32_t)strnlen(pPayload, payloadSize) + 1;
+	binaryWriteValue<uint8_t>(pAsync, record.pFormat ? LOG_BINARY_MESSAGE : LOG_BINARY_TEXT);
+	binaryWriteValue<uint32_t>(pAsync, it.first->second);
+	binaryWriteValue<uint32_t>(pAsync, pBuffer->mThreadIndex);
+	binaryWriteValue<uint32_t>(pAsync, record.mLevel);
+	binaryWriteValue<uint16_t>(pAsync, record.mIndentation);
+	binaryWriteValue<uint64_t>(pAsync, record.mTick);
+	binaryWriteValue<uint32_t>(pAsync, argsSize);
+	binaryWrite(pAsync, pPayload, argsSize);
+}
+
+// Wall clock time of a tick, interpolated from the ticks and microseconds seen at the start and the last calibration
+static int64_t logTickToTime(const LogAsync* pAsync, uint64_t tick)
+{
+	double usec = (double)pAsync->mCalibrationUSec;
+	if (pAsync->mCalibrationTick > pAsync->mStartTick)
+	{
+		const double usecPerTick = (double)(pAsync->mCalibrationUSec - pAsync->mStartUSec) / (double)(pAsync->mCalibrationTick - pAsync->mStartTick);
+		usec += ((double)tick - (double)pAsync->mCalibrationTick) * usecPerTick;
+	}
+	return pAsync->mStartTime + (int64_t)((usec - (double)pAsync->mStartUSec) / 1000000.0);
+}
+
+void Log::AsyncWriterThread(void * pData)
+{
+	LogAsync* pAsync = (LogAsync*)pData;
+	Thread::SetCurrentThreadName("LogWriter");
+
+	for (;;)
+	{
+		const bool     exit = tfrg_atomic32_load_acquire(&pAsync->mExit) != 0;
+		const uint64_t flushRequest = tfrg_atomic64_load_acquire(&pAsync->mFlushRequest);
+		uint32_t       messageCount = 0;
+		const bool     writeText = !pAsync->mDesc.mBinaryOnly;
+
+		pAsync->mCalibrationTick = logGetTick();
+		pAsync->mCalibrationUSec = getUSec();
+		if (pAsync->pBinaryData && pAsync->mCalibrationUSec - pAsync->mBinaryCalibrationUSec >= LOG_BINARY_CALIBRATION_INTERVAL_USEC)
+			binaryWriteCalibration(pAsync);
+
+		{
+			MutexLock lock{ pAsync->mMutex };
+			LogThreadBuffer** ppBuffer = &pAsync->pBuffers;
+			while (*ppBuffer)
+			{
+				LogThreadBuffer* pBuffer = *ppBuffer;
+				const bool       orphaned = tfrg_atomic32_load_acquire(&pBuffer->mOrphaned) != 0;
+				const uint64_t   mask = pBuffer->mSize - 1;
+				const uint64_t   writePos = tfrg_atomic64_load_acquire(&pBuffer->mWritePos);
+				uint64_t         readPos = tfrg_atomic64_load_relaxed(&pBuffer->mReadPos);
+				while (readPos < writePos)
+				{
+					LogRecord record;
+					const uint8_t* pSrc = pBuffer->pData + (readPos & mask);
+					memcpy(&record, pSrc, sizeof(uint64_t));
+					if (record.mKind != LOG_RECORD_PADDING)
+					{
+						memcpy(&record, pSrc, sizeof(record));
+						const char*    pPayload = (const char*)(pSrc + sizeof(record));
+						const uint32_t payloadSize = record.mSize - (uint32_t)sizeof(record);
+						if (pAsync->pBinaryData)
+						{
+							binaryWriteRecord(pAsync, pBuffer, record, pPayload);
+						}
+
+						if (writeText && record.mKind == LOG_RECORD_MESSAGE)
+						{
+							uint32_t preambleEnd = WritePreamble(Buffer, LOG_PREAMBLE_SIZE, logTickToTime(pAsync, record.mTick), pBuffer->mThreadName, record.pFile, record.mLine);
+							uint32_t indentation = record.mIndentation * INDENTATION_SIZE_LOG;
+							memset(Buffer + preambleEnd, ' ', indentation);
+							uint32_t offset = preambleEnd + LOG_LEVEL_SIZE + indentation;
+							if (record.pFormat)
+								offset += formatDeferred(Buffer + offset, MAX_BUFFER - offset, record.pFormat, (const uint8_t*)pPayload, payloadSize);
+							else
+								offset += (uint32_t)strlen(strncpy(Buffer + offset, pPayload, MAX_BUFFER - offset));
+							offset = min(offset, (uint32_t)MAX_BUFFER);
+							Buffer[offset] = '\n';
+							Buffer[offset + 1] = 0;
+							WriteMessage(record.mLevel, Buffer, preambleEnd);
+						}
+						else if (writeText)
+						{
+							if (record.pFormat)
+								Buffer[formatDeferred(Buffer, MAX_BUFFER, record.pFormat, (const uint8_t*)pPayload, payloadSize)] = 0;
+							else
+								strncpy(Buffer, pPayload, MAX_BUFFER);
+							WriteRawMessage(record.mLevel, record.mKind == LOG_RECORD_RAW_ERROR, Buffer);
+						}
+						++messageCount;
+					}
+
+					readPos += record.mSize;
+					tfrg_atomic64_store_release(&pBuffer->mReadPos, readPos);
+				}
+
+				const uint64_t droppedCount = tfrg_atomic64_load_relaxed(&pBuffer->mDroppedCount);
+				if (droppedCount != pBuffer->mReportedDroppedCount)
+				{
+					if (pAsync->pBinaryData)
+					{
+						binaryWriteValue<uint8_t>(pAsync, LOG_BINARY_DROPPED);
+						binaryWriteValue<uint32_t>(pAsync, pBuffer->mThreadIndex);
+						binaryWriteValue<uint64_t>(pAsync, droppedCount - pBuffer->mReportedDroppedCount);
+					}
+					if (writeText)
+					{
+						uint32_t preambleEnd = WritePreamble(Buffer, LOG_PREAMBLE_SIZE, (int64_t)time(NULL), pBuffer->mThreadName, __FILE__, __LINE__);
+						snprintf(Buffer + preambleEnd + LOG_LEVEL_SIZE, MAX_BUFFER - preambleEnd - LOG_LEVEL_SIZE,
+							"%llu log messages of this thread were dropped, its log buffer (%u bytes) was full\n",
+							(unsigned long long)(droppedCount - pBuffer->mReportedDroppedCount), pBuffer->mSize);
+						WriteMessage(LogLevel::eWARNING, Buffer, preambleEnd);
+					}
+					pBuffer->mReportedDroppedCount = droppedCount;
+					++messageCount;
+				}
+
+				// The owning thread exited before its last message was read
+				if (orphaned && readPos == tfrg_atomic64_load_acquire(&pBuffer->mWritePos))
+				{
+					*ppBuffer = pBuffer->pNext;
+					tf_free(pBuffer->pData);
+					tf_free(pBuffer);
+					continue;
+				}
+
+				ppBuffer = &pBuffer->pNext;
+			}
+		}
+
+		if (messageCount && pAsync->pBinaryData)
+		{
+			binaryFlush(pAsync);
+			fsFlushStream(&pAsync->mBinaryFile);
+		}
+
+		if (messageCount && writeText)
+		{
+			MutexLock lock{ pLogger->mLogMutex };
+			for (LogCallback & callback : pLogger->mCallbacks)
+			{
+				if (callback.mFlush)
+					callback.mFlush(callback.mUserData);
+			}
+		}
+
+		tfrg_atomic64_store_release(&pAsync->mFlushCompleted, flushRequest);
+
+		if (!messageCount)
+		{
+			if (exit)
+			{
+				// The decoder interpolates the time of the last messages from the final calibration
+				if (pAsync->pBinaryData)
+				{
+					binaryWriteCalibration(pAsync);
+					binaryFlush(pAsync);
+				}
+				break;
+			}
+
+			MutexLock lock{ pAsync->mMutex };
+			pAsync->mWakeCond.Wait(pAsync->mMutex, pAsync->mDesc.mFlushIntervalMs);
+		}
+	}
+}
+
+typedef struct LogBinaryReader
+{
+	const uint8_t* pData;
+	size_t         mSize;
+	size_t         mOffset;
+	bool           mValid;
+} LogBinaryReader;
+
+template<typename T>
+static T binaryRead(LogBinaryReader* pReader)
+{
+	T value = {};
+	if (!pReader->mValid || pReader->mOffset + sizeof(T) > pReader->mSize)
+	{
+		pReader->mValid = false;
+		return value;
+	}
+	memcpy(&value, pReader->pData + pReader->mOffset, sizeof(T));
+	pReader->mOffset += sizeof(T);
+	return value;
+}
+
+static const uint8_t* binaryReadBytes(LogBinaryReader* pReader, size_t size)
+{
+	if (!pReader->mValid || pReader->mOffset + size > pReader->mSize)
+	{
+		pReader->mValid = false;
+		return NULL;
+	}
+	const uint8_t* pBytes = pReader->pData + pReader->mOffset;
+	pReader->mOffset += size;
+	return pBytes;
+}
+
+typedef struct LogBinaryFormat
+{
+	eastl::string mFile;
+	eastl::string mFormat;
+	int32_t       mLine;
+	uint16_t      mKind;
+} LogBinaryFormat;
+
+typedef struct LogCalibrationPoint
+{
+	uint64_t mTick;
+	int64_t  mUSec;
+} LogCalibrationPoint;
+
+// Microseconds (getUSec) of a tick, interpolated between the surrounding calibration points
+static double logTickToUSec(const eastl::vector<LogCalibrationPoint>& points, uint64_t tick)
+{
+	if (points.size() < 2)
+		return (double)points[0].mUSec;
+
+	size_t first = 0;
+	size_t last = points.size() - 1;
+	while (last - first > 1)
+	{
+		const size_t middle = (first + last) / 2;
+		if (points[middle].mTick <= tick)
+			first = middle;
+		else
+			last = middle;
+	}
+
+	const LogCalibrationPoint& a = points[first];
+	const LogCalibrationPoint& b = points[last];
+	if (b.mTick == a.mTick)
+		return (double)a.mUSec;
+	return (double)a.mUSec + ((double)tick - (double)a.mTick) * (double)(b.mUSec - a.mUSec) / (double)(b.mTick - a.mTick);
+}
+
+bool Log::DecodeBinaryFile(ResourceDirectory inputDir, const char* inputFile, ResourceDirectory outputDir, const char* outputFile)
+{
+	FileStream input = {};
+	if (!fsOpenStreamFromPath(inputDir, inputFile, FM_READ_BINARY, &input))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open binary log %s", inputFile);
+		return false;
+	}
+
+	const ssize_t fileSize = fsGetStreamFileSize(&input);
+	uint8_t*      pData = (uint8_t*)tf_malloc(fileSize > 0 ? (size_t)fileSize : 1);
+	const bool    read = fileSize > 0 && fsReadFromStream(&input, pData, (size_t)fileSize) == (size_t)fileSize;
+	fsCloseStream(&input);
+
+	LogBinaryHeader header = {};
+	if (read && (size_t)fileSize >= sizeof(header))
+		memcpy(&header, pData, sizeof(header));
+	if (header.mMagic != LOG_BINARY_MAGIC || header.mVersion != LOG_BINARY_VERSION)
+	{
+		LOGF(LogLevel::eERROR, "%s is not a binary log", inputFile);
+		tf_free(pData);
+		return false;
+	}
+
+	FileStream output = {};
+	if (!fsOpenStreamFromPath(outputDir, outputFile, FM_WRITE_BINARY, &output))
+	{
+		LOGF(LogLevel::eERROR, "Failed to create %s", outputFile);
+		tf_free(pData);
+		return false;
+	}
+
+	const char* columns = "date       time            [thread name/id ]                   file:line    v |\n";
+	fsWriteToStream(&output, columns, strlen(columns));
+
+	eastl::vector<LogCalibrationPoint> calibration;
+	eastl::vector<LogBinaryFormat>     formats;
+	eastl::vector<eastl::string>       threadNames;
+	LogCalibrationPoint                start = { header.mStartTick, header.mStartUSec };
+	calibration.push_back(start);
+
+	char   line[MAX_BUFFER + 128];
+	size_t messageCount = 0;
+	bool   truncated = false;
+	// The first pass only collects the calibration points, which come after the messages they apply to
+	for (uint32_t pass = 0; pass < 2; ++pass)
+	{
+		LogBinaryReader reader = { pData, (size_t)fileSize, sizeof(header), true };
+		while (reader.mOffset < reader.mSize)
+		{
+			const uint8_t type = binaryRead<uint8_t>(&reader);
+			if (type == LOG_BINARY_THREAD)
+			{
+				const uint32_t index = binaryRead<uint32_t>(&reader);
+				const uint16_t length = binaryRead<uint16_t>(&reader);
+				const char*    name = (const char*)binaryReadBytes(&reader, length);
+				if (reader.mValid && pass == 1)
+				{
+					if (index >= threadNames.size())
+						threadNames.resize(index + 1);
+					threadNames[index].assign(name, length);
+				}
+			}
+			else if (type == LOG_BINARY_FORMAT)
+			{
+				LogBinaryFormat format;
+				const uint32_t  id = binaryRead<uint32_t>(&reader);
+				format.mKind = binaryRead<uint16_t>(&reader);
+				format.mLine = binaryRead<int32_t>(&reader);
+				const uint16_t fileLength = binaryRead<uint16_t>(&reader);
+				const char*    file = (const char*)binaryReadBytes(&reader, fileLength);
+				const uint32_t formatLength = binaryRead<uint32_t>(&reader);
+				const char*    formatString = (const char*)binaryReadBytes(&reader, formatLength);
+				if (reader.mValid && pass == 1)
+				{
+					format.mFile.assign(file, fileLength);
+					format.mFormat.assign(formatString, formatLength);
+					if (id >= formats.size())
+						formats.resize(id + 1);
+					formats[id] = format;
+				}
+			}
+			else if (type == LOG_BINARY_MESSAGE || type == LOG_BINARY_TEXT)
+			{
+				const uint32_t formatId = binaryRead<uint32_t>(&reader);
+				const uint32_t threadIndex = binaryRead<uint32_t>(&reader);
+				const uint32_t level = binaryRead<uint32_t>(&reader);
+				const uint16_t indentation = binaryRead<uint16_t>(&reader);
+				const uint64_t tick = binaryRead<uint64_t>(&reader);
+				const uint32_t argsSize = binaryRead<uint32_t>(&reader);
+				const uint8_t* pArgs = binaryReadBytes(&reader, argsSize);
+				if (!reader.mValid || pass == 0)
+				{
+					// Calibration pass
+				}
+				else if (formatId >= formats.size() || threadIndex >= threadNames.size())
+				{
+					reader.mValid = false;
+				}
+				else
+				{
+					const LogBinaryFormat& format = formats[formatId];
+					char                   message[MAX_BUFFER + 1];
+					if (type == LOG_BINARY_MESSAGE)
+						message[formatDeferred(message, MAX_BUFFER, format.mFormat.c_str(), pArgs, argsSize)] = 0;
+					else
+					{
+						const uint32_t length = argsSize ? (uint32_t)strnlen((const char*)pArgs, min(argsSize, (uint32_t)MAX_BUFFER)) : 0;
+						memcpy(message, pArgs, length);
+						message[length] = 0;
+					}
+
+					if (format.mKind != LOG_RECORD_MESSAGE)
+						fsWriteToStream(&output, message, strlen(message));
+					else
+					{
+						// Same columns as the text log, so decoded logs can be compared with it
+						const double  usec = logTickToUSec(calibration, tick) - (double)header.mStartUSec;
+						const int64_t seconds = header.mStartTime + (int64_t)(max(usec, 0.0) / 1000000.0);
+						tm            timeInfo;
+						logLocalTime(seconds, &timeInfo);
+						const char* threadName = threadNames[threadIndex].empty() ? "NoName" : threadNames[threadIndex].c_str();
+
+						for (uint32_t i = 0; i < sizeof(logLevelPrefixes) / sizeof(logLevelPrefixes[0]); ++i)
+						{
+							if (!(logLevelPrefixes[i].first & level))
+								continue;
+							int length = snprintf(line, sizeof(line), "%04d-%02d-%02d %02d:%02d:%02d [%-15s] %22.*s:%-5d %s%*s%s\n",
+								1900 + timeInfo.tm_year, 1 + timeInfo.tm_mon, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec, threadName, FILENAME_NAME_LENGTH_LOG, format.mFile.c_str(), format.mLine, logLevelPrefixes[i].second,
+								(int)(indentation * INDENTATION_SIZE_LOG), "", message);
+							fsWriteToStream(&output, line, (size_t)min(max(length, 0), (int)sizeof(line) - 1));
+						}
+					}
+					++messageCount;
+				}
+			}
+			else if (type == LOG_BINARY_CALIBRATION)
+			{
+				LogCalibrationPoint point;
+				point.mTick = binaryRead<uint64_t>(&reader);
+				point.mUSec = binaryRead<int64_t>(&reader);
+				if (reader.mValid && pass == 0)
+					calibration.push_back(point);
+			}
+			else if (type == LOG_BINARY_DROPPED)
+			{
+				const uint32_t threadIndex = binaryRead<uint32_t>(&reader);
+				const uint64_t count = binaryRead<uint64_t>(&reader);
+				if (reader.mValid && pass == 1)
+				{
+					int length = snprintf(line, sizeof(line), "%llu log messages of thread %s were dropped\n", (unsigned long long)count,
+						threadIndex < threadNames.size() ? threadNames[threadIndex].c_str() : "NoName");
+					fsWriteToStream(&output, line, (size_t)min(max(length, 0), (int)sizeof(line) - 1));
+				}
+			}
+			else
+			{
+				reader.mValid = false;
+			}
+
+			// A log cut short by a crash still decodes up to its last complete record
+			if (!reader.mValid)
+			{
+				truncated = true;
+				break;
+			}
+		}
+	}
+
+	fsCloseStream(&output);
+	tf_free(pData);
+
+	LOGF(truncated ? LogLevel::eWARNING : LogLevel::eINFO, "Decoded %llu messages from %s%s", (unsigned long long)messageCount, inputFile,
+		truncated ? ", the end of the file is damaged" : "");
+	return true;
+}
@@ -66,6 +66,36 @@ typedef void(*log_callback_t)(void * user_data, const char* message);
 typedef void(*log_close_t)(void * user_data);
 typedef void(*log_flush_t)(void * user_data);
 
+/// What a logging thread does when its asynchronous log buffer is full
+enum LogOverflowPolicy
+{
+	/// The message is dropped and counted, the writer thread reports the loss in the log
+	LOG_OVERFLOW_DROP = 0,
+	/// The thread waits until the writer thread made room
+	LOG_OVERFLOW_BLOCK,
+};
+
+typedef struct LogAsyncDesc
+{
+	/// Size of the ring buffer of each logging thread, rounded up to a power of two. 0 picks the default (64 KB)
+	uint32_t          mThreadBufferSize;
+	/// The writer thread drains the buffers at least this often, or when one of them is half full. 0 picks 10 ms
+	uint32_t          mFlushIntervalMs;
+	LogOverflowPolicy mOverflowPolicy;
+	/// Messages only store the format string pointer and the arguments (strings are copied), the writer thread formats them.
+	/// Format strings have to outlive the log, as string literals do: log runtime text as a "%s" argument.
+	/// Messages using %n, %ls or %lc are formatted right away.
+	bool              mDeferredFormatting;
+	/// Also writes every message to this file in RD_LOG, in a compact binary form: format strings and thread names are
+	/// stored once, messages only store their arguments and a CPU tick. Implies mDeferredFormatting.
+	/// Log::DecodeBinaryFile (or AssetPipelineCmd -decodelog) turns it back into a text log.
+	const char*       pBinaryFileName;
+	/// Skips the text formatting, console and callbacks, only the binary file is written
+	bool              mBinaryOnly;
+} LogAsyncDesc;
+
+struct LogAsync;
+
 /// Logging subsystem.
 class Log
 {
@@ -107,9 +137,33 @@ public:
 	static void Write(uint32_t level, const char * filename, int line_number, const char* message, ...);
 	static void WriteRaw(uint32_t level, bool error, const char* message, ...);
 
+	/// Asynchronous logging.
+	/// - Write and WriteRaw only append the message to a lock-free ring buffer owned by the calling thread.
+	/// - A writer thread drains the buffers, formats the messages and calls the console and the callbacks,
+	///   file callbacks get flushed once per drained batch instead of once per message.
+	/// - Messages of one thread keep their order, messages of different threads may be written out of order.
+	/// - Enable and disable while no other thread logs: DisableAsync (and Exit) free the buffers of the logging
+	///   threads without waiting for them, a thread inside Write or WriteRaw at that time would write to freed memory.
+	///   Threads only logging afterwards are fine, they write right away. Everything still buffered gets written.
+	static void EnableAsync(const LogAsyncDesc* pDesc);
+	static void DisableAsync();
+	/// Returns once all messages logged by any thread before the call were passed to the callbacks
+	static void Flush();
+	/// Messages lost to full buffers with LOG_OVERFLOW_DROP since EnableAsync
+	static uint64_t GetDroppedMessageCount();
+	/// Converts a binary log written with LogAsyncDesc::pBinaryFileName to a text log. Decodes as much as possible
+	/// of files cut short by a crash.
+	static bool DecodeBinaryFile(ResourceDirectory inputDir, const char* inputFile, ResourceDirectory outputDir, const char* outputFile);
+
 private:
 	static void AddInitialLogFile(const char* appName);
 	static uint32_t WritePreamble(char * buffer, uint32_t buffer_size, const char * file, int line);
+	static uint32_t WritePreamble(char * buffer, uint32_t buffer_size, int64_t time, const char * thread_name, const char * file, int line);
+	/// Passes a message formatted after the preamble to the console and the callbacks, once per level flag
+	static void WriteMessage(uint32_t level, char * buffer, uint32_t preamble_end);
+	static void WriteRawMessage(uint32_t level, bool error, const char * buffer);
+	static void WriteAsync(LogAsync* pAsync, uint32_t kind, uint32_t level, const char * file, int line, const char * format, va_list args);
+	static void AsyncWriterThread(void * pData);
 	static bool CallbackExists(const char * id);
 
 	// Singleton
@@ -28,8 +28,23 @@
 
 #include "../../ThirdParty/OpenSource/EASTL/EABase/eabase.h"
 
+#include "../Core/Atomics.h"
+#include "../Interfaces/ILog.h"
+#include "../Interfaces/ITime.h"
+
 #include <stdlib.h>
 #include <memory.h>
+#include <ctype.h>
+
+// Only for the declarations, the allocation functions are defined below under their own names
+#define IMEMORY_FROM_HEADER
+#include "../Interfaces/IMemory.h"
+#undef tf_malloc
+#undef tf_memalign
+#undef tf_calloc
+#undef tf_calloc_memalign
+#undef tf_realloc
+#undef tf_free
 
 #define ALIGN_TO(size, alignment) (size + alignment - 1) & ~(alignment - 1)
 #define MIN_ALLOC_ALIGNMENT EA_PLATFORM_MIN_MALLOC_ALIGNMENT
@@ -46,6 +61,32 @@
 #define MTUNER_FREE(_handle, _ptr)
 #endif
 
+// Allocation statistics add a header and counter updates to every allocation, so they are opt-in:
+// define USE_MEMORY_STATS in development builds. The memory tracker takes precedence when both are defined.
+#if defined(USE_MEMORY_STATS) && !defined(USE_MEMORY_TRACKING)
+#define MEMORY_STATS_ENABLED 1
+#else
+#define MEMORY_STATS_ENABLED 0
+#endif
+
+static const char* gMemoryTagNames[MEMORY_TAG_COUNT] =
+{
+	"Other",
+	"OS",
+	"Renderer",
+	"ResourceLoader",
+	"Animation",
+	"UI",
+	"Lua",
+};
+
+bool tf_memory_stats_enabled() { return MEMORY_STATS_ENABLED != 0; }
+
+const char* tf_memory_get_tag_name(MemoryTag tag)
+{
+	return tag < MEMORY_TAG_COUNT ? gMemoryTagNames[tag] : "Auto";
+}
+
 #if defined(USE_MEMORY_TRACKING)
 
 #define _CRT_SECURE_NO_WARNINGS 1
@@ -209,6 +250,472 @@ void tf_free(void* ptr)
 #endif
 }
 
+
+#if MEMORY_STATS_ENABLED
+/************************************************************************/
+// Allocation statistics
+// Every allocation gets a MemoryHeader in front of it, holding the size and the tag, so frees can be
+// attributed without a lookup. Counters are per thread and only written by their thread, readers sum them.
+// Roughly one allocation per MEMORY_SAMPLE_INTERVAL bytes records its call site.
+/************************************************************************/
+#define MEMORY_HEADER_SIZE 16
+#define MEMORY_SAMPLE_INTERVAL (512 * 1024)
+#define MEMORY_SITE_COUNT 4096
+#define MEMORY_SITE_MAX_PROBES 32
+#define MEMORY_FILE_TAG_CACHE_SIZE 1024
+
+typedef struct MemoryHeader
+{
+	uint64_t mSize;
+	/// Distance from the start of the system allocation
+	uint32_t mOffset;
+	/// Index + 1 of the call site in gMemorySites when the allocation was sampled
+	uint16_t mSite;
+	uint8_t  mTag;
+	/// MemoryHeaderFlags
+	uint8_t  mFlags;
+} MemoryHeader;
+
+typedef enum MemoryHeaderFlags
+{
+	/// Allocated with tf_memalign, tf_realloc would not keep the alignment
+	MEMORY_HEADER_FLAG_ALIGNED = 1 << 0,
+} MemoryHeaderFlags;
+
+COMPILE_ASSERT(sizeof(MemoryHeader) == MEMORY_HEADER_SIZE);
+
+typedef struct MemoryTagCounters
+{
+	tfrg_atomic64_t mAllocatedBytes;
+	tfrg_atomic64_t mFreedBytes;
+	tfrg_atomic64_t mAllocations;
+	tfrg_atomic64_t mFrees;
+} MemoryTagCounters;
+
+typedef struct MemoryThreadStats
+{
+	MemoryTagCounters  mTags[MEMORY_TAG_COUNT];
+	MemoryThreadStats* pNext;
+	/// Cleared when the thread exits, the next new thread reuses the counters
+	tfrg_atomic32_t    mInUse;
+} MemoryThreadStats;
+
+typedef struct MemorySite
+{
+	tfrg_atomic64_t mKey;
+	tfrg_atomic32_t mReady;
+	uint32_t        mTag;
+	const char*     pFile;
+	const char*     pFunction;
+	int32_t         mLine;
+	tfrg_atomic64_t mLiveBytes;
+	tfrg_atomic64_t mAllocatedBytes;
+} MemorySite;
+
+typedef struct MemoryFileTag
+{
+	const char* volatile pFile;
+	/// Tag + 1, 0 until written
+	tfrg_atomic32_t      mTag;
+} MemoryFileTag;
+
+static tfrg_atomicptr_t  gMemoryThreadStatsHead = 0;
+/// Used by atomic adds for allocations during thread exit, after the thread released its counters
+static MemoryThreadStats gMemorySharedStats = {};
+static MemorySite        gMemorySites[MEMORY_SITE_COUNT] = {};
+static MemoryFileTag     gMemoryFileTags[MEMORY_FILE_TAG_CACHE_SIZE] = {};
+static tfrg_atomic64_t   gMemoryPeakBytes[MEMORY_TAG_COUNT] = {};
+static tfrg_atomic64_t   gMemoryBudgetBytes[MEMORY_TAG_COUNT] = {};
+
+// Only touched by tf_memory_update_stats
+static int64_t           gMemoryLastUpdateUSec = 0;
+static uint64_t          gMemoryLastAllocations[MEMORY_TAG_COUNT] = {};
+static uint64_t          gMemoryLastAllocatedBytes[MEMORY_TAG_COUNT] = {};
+static float             gMemoryAllocationsPerSecond[MEMORY_TAG_COUNT] = {};
+static float             gMemoryAllocatedBytesPerSecond[MEMORY_TAG_COUNT] = {};
+static bool              gMemoryOverBudget[MEMORY_TAG_COUNT] = {};
+
+static thread_local MemoryThreadStats* tMemoryThreadStats = NULL;
+static thread_local uint32_t           tMemoryTag = MEMORY_TAG_AUTO;
+static thread_local int64_t            tMemorySampleCountdown = MEMORY_SAMPLE_INTERVAL;
+static thread_local uint32_t           tMemoryRandom = 0x9E3779B9;
+
+struct MemoryThreadStatsHandle
+{
+	MemoryThreadStats* pStats;
+
+	~MemoryThreadStatsHandle()
+	{
+		if (pStats)
+		{
+			tMemoryThreadStats = &gMemorySharedStats;
+			tfrg_atomic32_store_release(&pStats->mInUse, 0);
+		}
+	}
+};
+
+static thread_local MemoryThreadStatsHandle tMemoryThreadStatsHandle;
+
+static MemoryThreadStats* memGetThreadStats()
+{
+	MemoryThreadStats* pStats = tMemoryThreadStats;
+	if (pStats)
+		return pStats;
+
+	for (pStats = (MemoryThreadStats*)tfrg_atomicptr_load_acquire(&gMemoryThreadStatsHead); pStats; pStats = pStats->pNext)
+	{
+		if (0 == tfrg_atomic32_load_relaxed(&pStats->mInUse) && 0 == tfrg_atomic32_cas_relaxed(&pStats->mInUse, 0, 1))
+			break;
+	}
+
+	if (!pStats)
+	{
+		pStats = (MemoryThreadStats*)tf_calloc_memalign(1, 64, sizeof(MemoryThreadStats));
+		if (!pStats)
+			return &gMemorySharedStats;
+		pStats->mInUse = 1;
+		uintptr_t head;
+		do
+		{
+			head = tfrg_atomicptr_load_relaxed(&gMemoryThreadStatsHead);
+			pStats->pNext = (MemoryThreadStats*)head;
+			tfrg_memorybarrier_release();
+		} while ((uintptr_t)tfrg_atomicptr_cas_relaxed(&gMemoryThreadStatsHead, head, (uintptr_t)pStats) != head);
+	}
+
+	tMemoryThreadStats = pStats;
+	tMemoryThreadStatsHandle.pStats = pStats;
+	return pStats;
+}
+
+static void memAddCounter(MemoryThreadStats* pStats, tfrg_atomic64_t* pCounter, uint64_t value)
+{
+	if (pStats == &gMemorySharedStats)
+		tfrg_atomic64_add_relaxed(pCounter, value);
+	else
+		*pCounter = *pCounter + value;
+}
+
+static MemoryTag memClassifyFile(const char* pFile)
+{
+	char path[FS_MAX_PATH];
+	uint32_t length = 0;
+	for (const char* c = pFile; *c && length < sizeof(path) - 1; ++c)
+		path[length++] = *c == '\\' ? '/' : (char)tolower((unsigned char)*c);
+	path[length] = 0;
+
+	if (strstr(path, "resourceloader"))
+		return MEMORY_TAG_RESOURCE_LOADER;
+	if (strstr(path, "/renderer/"))
+		return MEMORY_TAG_RENDERER;
+	if (strstr(path, "/animation/") || strstr(path, "/ozz"))
+		return MEMORY_TAG_ANIMATION;
+	if (strstr(path, "/ui/") || strstr(path, "/text/") || strstr(path, "fontstash") || strstr(path, "imgui"))
+		return MEMORY_TAG_UI;
+	if (strstr(path, "/lua"))
+		return MEMORY_TAG_LUA;
+	if (strstr(path, "/os/"))
+		return MEMORY_TAG_OS;
+	return MEMORY_TAG_OTHER;
+}
+
+static uint32_t memGetTag(const char* pFile)
+{
+	if (tMemoryTag != MEMORY_TAG_AUTO)
+		return tMemoryTag;
+	if (!pFile)
+		return MEMORY_TAG_OTHER;
+
+	// __FILE__ is a string literal, its address identifies the file
+	const uintptr_t hash = ((uintptr_t)pFile >> 3) * (uintptr_t)2654435761u;
+	for (uint32_t probe = 0; probe < 8; ++probe)
+	{
+		MemoryFileTag* pEntry = &gMemoryFileTags[(hash + probe) & (MEMORY_FILE_TAG_CACHE_SIZE - 1)];
+		const char* pEntryFile = pEntry->pFile;
+		if (pEntryFile == pFile)
+		{
+			const uint32_t tag = tfrg_atomic32_load_acquire(&pEntry->mTag);
+			if (tag)
+				return tag - 1;
+			break;
+		}
+		if (!pEntryFile)
+		{
+			const uint32_t tag = memClassifyFile(pFile);
+			if (0 == tfrg_atomicptr_cas_relaxed((tfrg_atomicptr_t*)&pEntry->pFile, 0, (uintptr_t)pFile))
+				tfrg_atomic32_store_release(&pEntry->mTag, tag + 1);
+			return tag;
+		}
+	}
+	return memClassifyFile(pFile);
+}
+
+static uint64_t memSampleWeight(uint64_t size)
+{
+	// Allocations smaller than the interval are sampled with a probability of size / interval
+	return size > MEMORY_SAMPLE_INTERVAL ? size : MEMORY_SAMPLE_INTERVAL;
+}
+
+static uint32_t memGetSite(const char* f, int l, const char* sf, uint32_t tag)
+{
+	const uint64_t key = (((uint64_t)(uintptr_t)f * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)(uint32_t)l << 8) ^ tag) | 1;
+	for (uint32_t probe = 0; probe < MEMORY_SITE_MAX_PROBES; ++probe)
+	{
+		const uint32_t index = ((uint32_t)(key >> 32) + probe) & (MEMORY_SITE_COUNT - 1);
+		MemorySite*    pSite = &gMemorySites[index];
+		uint64_t       current = tfrg_atomic64_load_relaxed(&pSite->mKey);
+		if (!current)
+		{
+			current = tfrg_atomic64_cas_relaxed(&pSite->mKey, 0, key);
+			if (!current)
+			{
+				pSite->pFile = f;
+				pSite->pFunction = sf;
+				pSite->mLine = l;
+				pSite->mTag = tag;
+				tfrg_atomic32_store_release(&pSite->mReady, 1);
+				return index + 1;
+			}
+		}
+		if (current == key)
+			return index + 1;
+	}
+	return 0;
+}
+
+static uint64_t memGetLiveBytes(uint32_t tag, uint64_t* pAllocations, uint64_t* pAllocatedBytes)
+{
+	uint64_t allocatedBytes = gMemorySharedStats.mTags[tag].mAllocatedBytes;
+	uint64_t freedBytes = gMemorySharedStats.mTags[tag].mFreedBytes;
+	uint64_t allocations = gMemorySharedStats.mTags[tag].mAllocations;
+	for (MemoryThreadStats* pStats = (MemoryThreadStats*)tfrg_atomicptr_load_acquire(&gMemoryThreadStatsHead); pStats; pStats = pStats->pNext)
+	{
+		allocatedBytes += pStats->mTags[tag].mAllocatedBytes;
+		freedBytes += pStats->mTags[tag].mFreedBytes;
+		allocations += pStats->mTags[tag].mAllocations;
+	}
+	if (pAllocations)
+		*pAllocations = allocations;
+	if (pAllocatedBytes)
+		*pAllocatedBytes = allocatedBytes;
+	// Counters of different threads are read at slightly different times
+	return allocatedBytes > freedBytes ? allocatedBytes - freedBytes : 0;
+}
+
+// Fills the header of a new system allocation and counts it
+static void* memStatsRecord(uint8_t* pBase, size_t headerSize, uint32_t flags, size_t size, const char* f, int l, const char* sf)
+{
+	const uint32_t     tag = memGetTag(f);
+	MemoryThreadStats* pStats = memGetThreadStats();
+	memAddCounter(pStats, &pStats->mTags[tag].mAllocatedBytes, size);
+	memAddCounter(pStats, &pStats->mTags[tag].mAllocations, 1);
+
+	MemoryHeader* pHeader = (MemoryHeader*)(pBase + headerSize) - 1;
+	pHeader->mSize = size;
+	pHeader->mOffset = (uint32_t)headerSize;
+	pHeader->mSite = 0;
+	pHeader->mTag = (uint8_t)tag;
+	pHeader->mFlags = (uint8_t)flags;
+
+	int64_t countdown = tMemorySampleCountdown - (int64_t)size;
+	if (countdown <= 0)
+	{
+		const uint32_t site = memGetSite(f, l, sf, tag);
+		if (site)
+		{
+			const uint64_t weight = memSampleWeight(size);
+			tfrg_atomic64_add_relaxed(&gMemorySites[site - 1].mLiveBytes, weight);
+			tfrg_atomic64_add_relaxed(&gMemorySites[site - 1].mAllocatedBytes, weight);
+			pHeader->mSite = (uint16_t)site;
+		}
+		tfrg_atomic64_max_relaxed(&gMemoryPeakBytes[tag], memGetLiveBytes(tag, NULL, NULL));
+
+		// Jitter the interval so allocation patterns with a fixed period do not always hit the same site
+		uint32_t random = tMemoryRandom;
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		tMemoryRandom = random;
+		countdown = MEMORY_SAMPLE_INTERVAL / 2 + (int64_t)(random % MEMORY_SAMPLE_INTERVAL);
+	}
+	tMemorySampleCountdown = countdown;
+
+	return pBase + headerSize;
+}
+
+static void memStatsRelease(const MemoryHeader* pHeader)
+{
+	MemoryThreadStats* pStats = memGetThreadStats();
+	memAddCounter(pStats, &pStats->mTags[pHeader->mTag].mFreedBytes, pHeader->mSize);
+	memAddCounter(pStats, &pStats->mTags[pHeader->mTag].mFrees, 1);
+	if (pHeader->mSite)
+		tfrg_atomic64_add_relaxed(&gMemorySites[pHeader->mSite - 1].mLiveBytes, (uint64_t)0 - memSampleWeight(pHeader->mSize));
+}
+
+static void* memStatsAlloc(size_t align, size_t size, bool zero, const char* f, int l, const char* sf)
+{
+	const size_t   headerSize = align > MEMORY_HEADER_SIZE ? align : MEMORY_HEADER_SIZE;
+	const uint32_t flags = align > MIN_ALLOC_ALIGNMENT ? MEMORY_HEADER_FLAG_ALIGNED : 0;
+	uint8_t*       pBase = (uint8_t*)(flags ? tf_memalign(align, size + headerSize) : tf_malloc(size + headerSize));
+	if (!pBase)
+		return NULL;
+	if (zero)
+		memset(pBase + headerSize, 0, size);
+	return memStatsRecord(pBase, headerSize, flags, size, f, l, sf);
+}
+
+static void memStatsFree(void* ptr)
+{
+	if (!ptr)
+		return;
+
+	const MemoryHeader* pHeader = (const MemoryHeader*)ptr - 1;
+	memStatsRelease(pHeader);
+	tf_free((uint8_t*)ptr - pHeader->mOffset);
+}
+
+static void* memStatsRealloc(void* ptr, size_t size, const char* f, int l, const char* sf)
+{
+	if (!ptr)
+		return memStatsAlloc(MIN_ALLOC_ALIGNMENT, size, false, f, l, sf);
+
+	const MemoryHeader header = *((const MemoryHeader*)ptr - 1);
+	if (!(header.mFlags & MEMORY_HEADER_FLAG_ALIGNED))
+	{
+		uint8_t* pBase = (uint8_t*)tf_realloc((uint8_t*)ptr - header.mOffset, size + header.mOffset);
+		if (!pBase)
+			return NULL;
+		memStatsRelease(&header);
+		return memStatsRecord(pBase, header.mOffset, header.mFlags, size, f, l, sf);
+	}
+
+	void* pNew = memStatsAlloc(header.mOffset, size, false, f, l, sf);
+	if (pNew)
+	{
+		memcpy(pNew, ptr, (size_t)(header.mSize < size ? header.mSize : size));
+		memStatsFree(ptr);
+	}
+	return pNew;
+}
+
+MemoryTag tf_memory_set_thread_tag(MemoryTag tag)
+{
+	const MemoryTag previous = (MemoryTag)tMemoryTag;
+	tMemoryTag = tag;
+	return previous;
+}
+
+void tf_memory_set_budget(MemoryTag tag, uint64_t budgetBytes)
+{
+	if (tag < MEMORY_TAG_COUNT)
+		tfrg_atomic64_store_relaxed(&gMemoryBudgetBytes[tag], budgetBytes);
+}
+
+void tf_memory_update_stats()
+{
+	const int64_t now = getUSec();
+	const double  seconds = gMemoryLastUpdateUSec ? (double)(now - gMemoryLastUpdateUSec) / 1000000.0 : 0.0;
+	gMemoryLastUpdateUSec = now;
+
+	for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; ++tag)
+	{
+		uint64_t       allocations = 0;
+		uint64_t       allocatedBytes = 0;
+		const uint64_t liveBytes = memGetLiveBytes(tag, &allocations, &allocatedBytes);
+		tfrg_atomic64_max_relaxed(&gMemoryPeakBytes[tag], liveBytes);
+
+		if (seconds > 0.0)
+		{
+			gMemoryAllocationsPerSecond[tag] = (float)((double)(allocations - gMemoryLastAllocations[tag]) / seconds);
+			gMemoryAllocatedBytesPerSecond[tag] = (float)((double)(allocatedBytes - gMemoryLastAllocatedBytes[tag]) / seconds);
+		}
+		gMemoryLastAllocations[tag] = allocations;
+		gMemoryLastAllocatedBytes[tag] = allocatedBytes;
+
+		const uint64_t budget = tfrg_atomic64_load_relaxed(&gMemoryBudgetBytes[tag]);
+		const bool     overBudget = budget && liveBytes > budget;
+		if (overBudget && !gMemoryOverBudget[tag])
+		{
+			LOGF(LogLevel::eWARNING, "Memory budget of %s exceeded: %llu KB live, budget %llu KB", gMemoryTagNames[tag],
+				(unsigned long long)(liveBytes / 1024), (unsigned long long)(budget / 1024));
+
+			MemorySampledSite sites[3];
+			const uint32_t    siteCount = tf_memory_get_sampled_sites((MemoryTag)tag, sites, 3);
+			for (uint32_t i = 0; i < siteCount; ++i)
+			{
+				LOGF(LogLevel::eWARNING, "    ~%llu KB live from %s:%d (%s)", (unsigned long long)(sites[i].mLiveBytes / 1024), sites[i].pFile,
+					sites[i].mLine, sites[i].pFunction);
+			}
+		}
+		gMemoryOverBudget[tag] = overBudget;
+	}
+}
+
+void tf_memory_get_stats(MemoryTag tag, MemoryTagStats* pOutStats)
+{
+	memset(pOutStats, 0, sizeof(*pOutStats));
+	if (tag >= MEMORY_TAG_COUNT)
+		return;
+
+	pOutStats->mLiveBytes = memGetLiveBytes(tag, &pOutStats->mAllocationCount, NULL);
+	pOutStats->mPeakBytes = tfrg_atomic64_load_relaxed(&gMemoryPeakBytes[tag]);
+	pOutStats->mPeakBytes = pOutStats->mPeakBytes > pOutStats->mLiveBytes ? pOutStats->mPeakBytes : pOutStats->mLiveBytes;
+	pOutStats->mBudgetBytes = tfrg_atomic64_load_relaxed(&gMemoryBudgetBytes[tag]);
+	pOutStats->mAllocationsPerSecond = gMemoryAllocationsPerSecond[tag];
+	pOutStats->mAllocatedBytesPerSecond = gMemoryAllocatedBytesPerSecond[tag];
+}
+
+uint32_t tf_memory_get_sampled_sites(MemoryTag tag, MemorySampledSite* pOutSites, uint32_t maxCount)
+{
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < MEMORY_SITE_COUNT && maxCount; ++i)
+	{
+		const MemorySite* pSite = &gMemorySites[i];
+		if (!tfrg_atomic32_load_acquire((tfrg_atomic32_t*)&pSite->mReady) || (tag != MEMORY_TAG_AUTO && pSite->mTag != (uint32_t)tag))
+			continue;
+
+		MemorySampledSite site;
+		site.pFile = pSite->pFile;
+		site.pFunction = pSite->pFunction;
+		site.mLine = pSite->mLine;
+		site.mTag = (MemoryTag)pSite->mTag;
+		// Frees can be counted before the matching sampled allocation on another thread
+		const int64_t liveBytes = (int64_t)pSite->mLiveBytes;
+		site.mLiveBytes = liveBytes > 0 ? (uint64_t)liveBytes : 0;
+		site.mAllocatedBytes = pSite->mAllocatedBytes;
+
+		// Keep the maxCount sites with the most live bytes, sorted
+		uint32_t position = count < maxCount ? count++ : maxCount;
+		while (position > 0 && pOutSites[position - 1].mLiveBytes < site.mLiveBytes)
+		{
+			if (position < maxCount)
+				pOutSites[position] = pOutSites[position - 1];
+			--position;
+		}
+		if (position < maxCount)
+			pOutSites[position] = site;
+	}
+	return count;
+}
+
+void* tf_malloc_internal(size_t size, const char *f, int l, const char *sf) { return memStatsAlloc(MIN_ALLOC_ALIGNMENT, size, false, f, l, sf); }
+
+void* tf_memalign_internal(size_t align, size_t size, const char *f, int l, const char *sf) { return memStatsAlloc(align, size, false, f, l, sf); }
+
+void* tf_calloc_internal(size_t count, size_t size, const char *f, int l, const char *sf) { return memStatsAlloc(MIN_ALLOC_ALIGNMENT, count * size, true, f, l, sf); }
+
+void* tf_calloc_memalign_internal(size_t count, size_t align, size_t size, const char *f, int l, const char *sf)
+{
+	size_t alignedArrayElementSize = ALIGN_TO(size, align);
+	return memStatsAlloc(align, count * alignedArrayElementSize, true, f, l, sf);
+}
+
+void* tf_realloc_internal(void* ptr, size_t size, const char *f, int l, const char *sf) { return memStatsRealloc(ptr, size, f, l, sf); }
+
+void tf_free_internal(void* ptr, const char *f, int l, const char *sf) { memStatsFree(ptr); }
+
+#else // MEMORY_STATS_ENABLED
+
 void* tf_malloc_internal(size_t size, const char *f, int l, const char *sf) { return tf_malloc(size); }
 
 void* tf_memalign_internal(size_t align, size_t size, const char *f, int l, const char *sf) { return tf_memalign(align, size); }
@@ -221,4 +728,18 @@ void* tf_realloc_internal(void* ptr, size_t size, const char *f, int l, const ch
 
 void tf_free_internal(void* ptr, const char *f, int l, const char *sf) { tf_free(ptr); }
 
+#endif // MEMORY_STATS_ENABLED
+
 #endif // defined(USE_MEMORY_TRACKING) || defined(USE_MTUNER)
+
+#if !MEMORY_STATS_ENABLED
+MemoryTag tf_memory_set_thread_tag(MemoryTag tag) { return MEMORY_TAG_AUTO; }
+
+void tf_memory_set_budget(MemoryTag tag, uint64_t budgetBytes) {}
+
+void tf_memory_update_stats() {}
+
+void tf_memory_get_stats(MemoryTag tag, MemoryTagStats* pOutStats) { memset(pOutStats, 0, sizeof(*pOutStats)); }
+
+uint32_t tf_memory_get_sampled_sites(MemoryTag tag, MemorySampledSite* pOutSites, uint32_t maxCount) { return 0; }
+#endif
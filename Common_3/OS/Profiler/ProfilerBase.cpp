@@ -24,11 +24,19 @@
 
 #include "ProfilerBase.h"
 #if 0 == PROFILE_ENABLED
+#include "../Interfaces/IMemory.h"
+
 void initProfiler(Renderer* pRenderer, Queue** ppQueue, const char** ppProfilerNames, ProfileToken* pProfileTokens, uint32_t nGpuProfilerCount) {}
 void exitProfiler() {}
-void flipProfiler() {}
+void flipProfiler() { tf_memory_update_stats(); }
 void dumpProfileData(Renderer* pRenderer, const char* appName, uint32_t nMaxFrames) {}
 void dumpBenchmarkData(Renderer* pRenderer, IApp::Settings* pSettings, const char* appName) {}
+void beginBenchmark() {}
+void dumpProfileTrace(const char* appName, uint32_t nMaxFrames) {}
+bool beginProfileTraceCapture(const char* pFileName) { return false; }
+void endProfileTraceCapture() {}
+void endBenchmark() {}
+uint32_t compareBenchmarkData(const char* pBaselineFileName, const char* pFileName, float fThresholdPercent, float fMinDifferenceMs) { return 0; }
 void setAggregateFrames(uint32_t nFrames) {}
 float getCpuProfileTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
 float getCpuProfileAvgTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
@@ -82,6 +90,8 @@ int64_t ProfileGetTick()
 //EASTL Includes
 #include "../../ThirdParty/OpenSource/EASTL/sort.h"
 #include "../../ThirdParty/OpenSource/EASTL/algorithm.h"
+#include "../../ThirdParty/OpenSource/EASTL/vector.h"
+#include "../../ThirdParty/OpenSource/EASTL/string.h"
 
 #if PROFILE_WEBSERVER
 
@@ -297,6 +307,8 @@ void exitCpuProfiler()
 void exitProfiler()
 {
 #if PROFILE_ENABLED
+    endBenchmark();
+    endProfileTraceCapture();
     exitCpuProfiler();
 
 #if GPU_PROFILER_SUPPORTED
@@ -820,7 +832,7 @@ uint64_t ProfileAllocateLabel(const char* pName)
 			pLabelBuffer = static_cast<char *>(tf_malloc(PROFILE_LABEL_BUFFER_SIZE + PROFILE_LABEL_MAX_LEN));
 			memset(pLabelBuffer, 0, PROFILE_LABEL_BUFFER_SIZE + PROFILE_LABEL_MAX_LEN);
 			S.nMemUsage += PROFILE_LABEL_BUFFER_SIZE + PROFILE_LABEL_MAX_LEN;
-			tfrg_atomic64_store_release(&S.LabelBuffer, *pLabelBuffer);
+			tfrg_atomic64_store_release(&S.LabelBuffer, (uint64_t)(uintptr_t)pLabelBuffer);
 		}
 	}
 
@@ -1026,6 +1038,8 @@ void ProfileGetRange(uint32_t nPut, uint32_t nGet, uint32_t nRange[2][2])
 }
 
 void ProfileDumpToFile(Renderer* pRenderer);
+void ProfileBenchmarkRecordFrame();
+void ProfileTraceStreamFrame(uint32_t nFrame);
 
 void ProfileFlipCpu()
 {
@@ -1328,6 +1342,8 @@ void ProfileFlipCpu()
 					}
 				}
 			}
+			ProfileBenchmarkRecordFrame();
+			ProfileTraceStreamFrame(S.nFrameCurrent);
 			for (uint32_t i = 0; i < PROFILE_MAX_GRAPHS; ++i)
 			{
 				if (S.Graph[i].nToken != PROFILE_INVALID_TOKEN)
@@ -1463,10 +1479,61 @@ void ProfileFlipCpu()
 		S.nActiveBars = nNewActiveBars;
 }
 
+// Publishes the allocation statistics of every memory tag as "Memory/<tag>/..." counters
+static void ProfileUpdateMemoryCounters()
+{
+	enum
+	{
+		MEMORY_COUNTER_LIVE,
+		MEMORY_COUNTER_PEAK,
+		MEMORY_COUNTER_ALLOCATIONS_PER_SECOND,
+		MEMORY_COUNTER_BYTES_PER_SECOND,
+		MEMORY_COUNTER_COUNT,
+	};
+	static const char* pCounterNames[MEMORY_COUNTER_COUNT] = { "Live", "Peak", "Allocations per second", "Allocated per second" };
+	static ProfileToken counterTokens[MEMORY_TAG_COUNT][MEMORY_COUNTER_COUNT] = {};
+	static bool counterTokensInitialized = false;
+
+	// No counters for builds without allocation statistics, they would stay at zero
+	if (!tf_memory_stats_enabled())
+		return;
+
+	tf_memory_update_stats();
+
+	if (!counterTokensInitialized)
+	{
+		for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; ++tag)
+		{
+			for (uint32_t counter = 0; counter < MEMORY_COUNTER_COUNT; ++counter)
+			{
+				char name[PROFILE_NAME_MAX_LEN * 2];
+				snprintf(name, sizeof(name), "Memory/%s/%s", tf_memory_get_tag_name((MemoryTag)tag), pCounterNames[counter]);
+				counterTokens[tag][counter] = ProfileGetCounterToken(name);
+				if (counter != MEMORY_COUNTER_ALLOCATIONS_PER_SECOND)
+					ProfileCounterConfig(name, PROFILE_COUNTER_FORMAT_BYTES, 0, PROFILE_COUNTER_FLAG_NONE);
+			}
+		}
+		counterTokensInitialized = true;
+	}
+
+	for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; ++tag)
+	{
+		MemoryTagStats stats;
+		tf_memory_get_stats((MemoryTag)tag, &stats);
+		ProfileCounterSet(counterTokens[tag][MEMORY_COUNTER_LIVE], (int64_t)stats.mLiveBytes);
+		ProfileCounterSet(counterTokens[tag][MEMORY_COUNTER_PEAK], (int64_t)stats.mPeakBytes);
+		ProfileCounterSet(counterTokens[tag][MEMORY_COUNTER_ALLOCATIONS_PER_SECOND], (int64_t)stats.mAllocationsPerSecond);
+		ProfileCounterSet(counterTokens[tag][MEMORY_COUNTER_BYTES_PER_SECOND], (int64_t)stats.mAllocatedBytesPerSecond);
+		// The budget shows as the limit of the live counter
+		ProfileCounterSetLimit(counterTokens[tag][MEMORY_COUNTER_LIVE], (int64_t)stats.mBudgetBytes);
+	}
+}
+
 void flipProfiler()
 {
     PROFILER_SET_CPU_SCOPE("Profile", "ProfileFlip", 0x3355ee);
 
+	ProfileUpdateMemoryCounters();
 	ProfileFlipCpu();
 }
 
@@ -2561,6 +2628,8 @@ void ProfileDumpToFile(Renderer* pRenderer)
 			ProfileDumpHtml(ProfileWriteFile, &fh, S.nDumpFrames, 0, pRenderer);
 		else if (S.eDumpType == ProfileDumpTypeCsv)
 			ProfileDumpCsv(ProfileWriteFile, &fh, S.nDumpFrames);
+		else if (S.eDumpType == ProfileDumpTypeTrace)
+			ProfileDumpTrace(ProfileWriteFile, &fh, S.nDumpFrames);
 
         fsCloseStream(&fh);
 	}
@@ -2582,59 +2651,772 @@ void dumpProfileData(Renderer* pRenderer, const char* appName, uint32_t nMaxFram
     }
 }
 
+/************************************************************************/
+// Benchmark recording
+/************************************************************************/
+#define PROFILE_BENCHMARK_HISTOGRAM_BUCKET_MS 0.5f
+#define PROFILE_BENCHMARK_HISTOGRAM_MAX_BUCKETS 200
+
+// Per frame samples of every timer and counter, recorded by ProfileFlipCpu between beginBenchmark and endBenchmark.
+// Timers and counters added during the run start recording from the frame they appear in.
+struct ProfileBenchmark
+{
+	eastl::vector<float> FrameTimes;
+	eastl::vector<float> TimerSamples[PROFILE_MAX_TIMERS];
+	uint32_t nTimerFirstFrame[PROFILE_MAX_TIMERS];
+	uint64_t nTimerCalls[PROFILE_MAX_TIMERS];
+	eastl::vector<int64_t> CounterSamples[PROFILE_MAX_COUNTERS];
+	uint32_t nCounterFirstFrame[PROFILE_MAX_COUNTERS];
+};
+
+struct ProfileBenchmarkStats
+{
+	float fAverage;
+	float fMin;
+	float fMax;
+	float fP50;
+	float fP90;
+	float fP95;
+	float fP99;
+};
+
+static ProfileBenchmark* g_pProfileBenchmark = NULL;
+
+static float ProfileBenchmarkTimerToMs(uint32_t nTimer)
+{
+	Profile & S = g_Profile;
+	const ProfileGroupInfo& Group = S.GroupInfo[S.TimerInfo[nTimer].nGroupIndex];
+	if (Group.Type != ProfileTokenTypeGpu)
+		return ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu());
+	uint64_t nTicksPerSecond = getGpuProfileTicksPerSecond(Group.nGpuProfileToken);
+	return nTicksPerSecond ? ProfileTickToMsMultiplier(nTicksPerSecond) : 0.f;
+}
+
+// Called from ProfileFlipCpu with the profile mutex held, once S.Frame holds the timers of the frame that just completed.
+// Gpu timers keep the value of their last resolved query.
+void ProfileBenchmarkRecordFrame()
+{
+	ProfileBenchmark* pBenchmark = g_pProfileBenchmark;
+	// No time elapsed until the profiler went through PROFILE_GPU_FRAME_DELAY frames
+	if (!pBenchmark || !g_Profile.nFlipTicks)
+		return;
+
+	Profile & S = g_Profile;
+	const uint32_t nFrame = (uint32_t)pBenchmark->FrameTimes.size();
+	pBenchmark->FrameTimes.push_back(S.nFlipTicks * ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu()));
+	for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+	{
+		if (pBenchmark->TimerSamples[i].empty())
+			pBenchmark->nTimerFirstFrame[i] = nFrame;
+		pBenchmark->TimerSamples[i].push_back(S.Frame[i].nTicks * ProfileBenchmarkTimerToMs(i));
+		pBenchmark->nTimerCalls[i] += S.Frame[i].nCount;
+	}
+	for (uint32_t i = 0; i < S.nNumCounters; ++i)
+	{
+		if (pBenchmark->CounterSamples[i].empty())
+			pBenchmark->nCounterFirstFrame[i] = nFrame;
+		pBenchmark->CounterSamples[i].push_back((int64_t)tfrg_atomic64_load_relaxed(&S.Counters[i]));
+	}
+}
+
+void beginBenchmark()
+{
+	MutexLock lock(ProfileMutex());
+	if (g_pProfileBenchmark)
+		return;
+	g_pProfileBenchmark = tf_new(ProfileBenchmark);
+	memset(g_pProfileBenchmark->nTimerCalls, 0, sizeof(g_pProfileBenchmark->nTimerCalls));
+}
+
+void endBenchmark()
+{
+	MutexLock lock(ProfileMutex());
+	tf_delete(g_pProfileBenchmark);
+	g_pProfileBenchmark = NULL;
+}
+
+// Nearest rank percentiles, pSorted is sorted in ascending order
+static float ProfileBenchmarkPercentile(const float* pSorted, uint32_t nCount, float fPercentile)
+{
+	uint32_t nRank = (uint32_t)ceilf(fPercentile * 0.01f * nCount);
+	return pSorted[ProfileClamp(nRank, 1u, nCount) - 1];
+}
+
+static void ProfileBenchmarkCalcStats(const float* pSamples, uint32_t nCount, eastl::vector<float>& Sorted, ProfileBenchmarkStats* pOut)
+{
+	memset(pOut, 0, sizeof(*pOut));
+	if (!nCount)
+		return;
+
+	Sorted.assign(pSamples, pSamples + nCount);
+	eastl::sort(Sorted.begin(), Sorted.end());
+	double fSum = 0.0;
+	for (uint32_t i = 0; i < nCount; ++i)
+		fSum += Sorted[i];
+	pOut->fAverage = (float)(fSum / nCount);
+	pOut->fMin = Sorted[0];
+	pOut->fMax = Sorted[nCount - 1];
+	pOut->fP50 = ProfileBenchmarkPercentile(Sorted.data(), nCount, 50.f);
+	pOut->fP90 = ProfileBenchmarkPercentile(Sorted.data(), nCount, 90.f);
+	pOut->fP95 = ProfileBenchmarkPercentile(Sorted.data(), nCount, 95.f);
+	pOut->fP99 = ProfileBenchmarkPercentile(Sorted.data(), nCount, 99.f);
+}
+
+static void ProfileGetCounterPath(uint32_t nCounter, char* pOut, size_t nSize)
+{
+	Profile & S = g_Profile;
+	int nNodes[32];
+	int nDepth = 0;
+	for (int nNode = (int)nCounter; nNode >= 0 && nDepth < 32; nNode = S.CounterInfo[nNode].nParent)
+		nNodes[nDepth++] = nNode;
+
+	size_t nOffset = 0;
+	pOut[0] = '\0';
+	while (nDepth-- > 0 && nOffset + 1 < nSize)
+		nOffset += snprintf(pOut + nOffset, nSize - nOffset, "%s%s", S.CounterInfo[nNodes[nDepth]].pName, nDepth ? "/" : "");
+}
+
+// Names are written as json strings and quoted csv fields
+static void ProfilePrintJsonString(ProfileWriteCallback CB, void* Handle, const char* pString)
+{
+	CB(Handle, 1, "\"");
+	for (const char* pChar = pString; *pChar; ++pChar)
+	{
+		if (*pChar == '"' || *pChar == '\\')
+			ProfilePrintf(CB, Handle, "\\%c", *pChar);
+		else if ((unsigned char)*pChar < 0x20)
+			ProfilePrintf(CB, Handle, "\\u%04x", (unsigned char)*pChar);
+		else
+			CB(Handle, 1, pChar);
+	}
+	CB(Handle, 1, "\"");
+}
+
+static void ProfileBenchmarkPrintCsvString(ProfileWriteCallback CB, void* Handle, const char* pString)
+{
+	CB(Handle, 1, "\"");
+	for (const char* pChar = pString; *pChar; ++pChar)
+	{
+		if (*pChar == '"')
+			CB(Handle, 1, "\"");
+		CB(Handle, 1, pChar);
+	}
+	CB(Handle, 1, "\"");
+}
+
+static void ProfileBenchmarkPrintJsonStats(ProfileWriteCallback CB, void* Handle, const ProfileBenchmarkStats& Stats)
+{
+	ProfilePrintf(CB, Handle, "\"Average\": %.4f, \"Min\": %.4f, \"Max\": %.4f, \"P50\": %.4f, \"P90\": %.4f, \"P95\": %.4f, \"P99\": %.4f",
+		Stats.fAverage, Stats.fMin, Stats.fMax, Stats.fP50, Stats.fP90, Stats.fP95, Stats.fP99);
+}
+
+static void ProfileBenchmarkPrintCsvRow(ProfileWriteCallback CB, void* Handle, const char* pType, const char* pGroup, const char* pName, const ProfileBenchmarkStats& Stats)
+{
+	ProfilePrintf(CB, Handle, "%s,", pType);
+	ProfileBenchmarkPrintCsvString(CB, Handle, pGroup);
+	CB(Handle, 1, ",");
+	ProfileBenchmarkPrintCsvString(CB, Handle, pName);
+	ProfilePrintf(CB, Handle, ",%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", Stats.fAverage, Stats.fMin, Stats.fMax, Stats.fP50, Stats.fP90, Stats.fP95, Stats.fP99);
+}
+
+static void ProfileBenchmarkPrintJsonHistogram(ProfileWriteCallback CB, void* Handle, const float* pSamples, uint32_t nCount, float fMax)
+{
+	uint32_t Buckets[PROFILE_BENCHMARK_HISTOGRAM_MAX_BUCKETS] = {};
+	uint32_t nBuckets = ProfileClamp((uint32_t)(fMax / PROFILE_BENCHMARK_HISTOGRAM_BUCKET_MS) + 1, 1u, (uint32_t)PROFILE_BENCHMARK_HISTOGRAM_MAX_BUCKETS);
+	for (uint32_t i = 0; i < nCount; ++i)
+		Buckets[ProfileMin((uint32_t)(pSamples[i] / PROFILE_BENCHMARK_HISTOGRAM_BUCKET_MS), nBuckets - 1)]++;
+
+	// The last bucket also holds every sample above it
+	ProfilePrintf(CB, Handle, "\"Histogram\": { \"BucketMs\": %.2f, \"Counts\": [", PROFILE_BENCHMARK_HISTOGRAM_BUCKET_MS);
+	for (uint32_t i = 0; i < nBuckets; ++i)
+		ProfilePrintf(CB, Handle, "%s%u", i ? ", " : "", Buckets[i]);
+	ProfilePrintf(CB, Handle, "] }");
+}
+
+static bool ProfileBenchmarkIsGpuRoot(uint32_t nTimer)
+{
+	Profile & S = g_Profile;
+	const ProfileGroupInfo& Group = S.GroupInfo[S.TimerInfo[nTimer].nGroupIndex];
+	return Group.Type == ProfileTokenTypeGpu && strcmp(S.TimerInfo[nTimer].pName, Group.pName) == 0;
+}
+
+static void ProfileBenchmarkDumpJson(ProfileWriteCallback CB, void* Handle, Renderer* pRenderer, IApp::Settings* pSettings)
+{
+	Profile & S = g_Profile;
+	ProfileBenchmark* pBenchmark = g_pProfileBenchmark;
+	eastl::vector<float> Sorted;
+	ProfileBenchmarkStats Stats;
+	const uint32_t nFrames = (uint32_t)pBenchmark->FrameTimes.size();
+
+	ProfilePrintf(CB, Handle, "{\n");
+	ProfilePrintf(CB, Handle, "\"Application\": ");
+	ProfilePrintJsonString(CB, Handle, pRenderer && pRenderer->pName ? pRenderer->pName : "");
+	ProfilePrintf(CB, Handle, ",\n\"Width\": %d,\n\"Height\": %d,\n", pSettings ? pSettings->mWidth : 0, pSettings ? pSettings->mHeight : 0);
+	if (pRenderer && pRenderer->pActiveGpuSettings)
+	{
+		const GPUVendorPreset& Preset = pRenderer->pActiveGpuSettings->mGpuVendorPreset;
+		ProfilePrintf(CB, Handle, "\"GpuName\": ");
+		ProfilePrintJsonString(CB, Handle, Preset.mGpuName);
+		ProfilePrintf(CB, Handle, ",\n\"VendorID\": ");
+		ProfilePrintJsonString(CB, Handle, Preset.mVendorId);
+		ProfilePrintf(CB, Handle, ",\n\"ModelID\": ");
+		ProfilePrintJsonString(CB, Handle, Preset.mModelId);
+		ProfilePrintf(CB, Handle, ",\n");
+	}
+	ProfilePrintf(CB, Handle, "\"Frames\": %u,\n", nFrames);
+
+	ProfileBenchmarkCalcStats(pBenchmark->FrameTimes.data(), nFrames, Sorted, &Stats);
+	ProfilePrintf(CB, Handle, "\"FrameTime\": { ");
+	ProfileBenchmarkPrintJsonStats(CB, Handle, Stats);
+	ProfilePrintf(CB, Handle, ", ");
+	ProfileBenchmarkPrintJsonHistogram(CB, Handle, pBenchmark->FrameTimes.data(), nFrames, Stats.fMax);
+	ProfilePrintf(CB, Handle, " },\n");
+
+	ProfilePrintf(CB, Handle, "\"Timers\": [\n");
+	for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+	{
+		const eastl::vector<float>& Samples = pBenchmark->TimerSamples[i];
+		const bool bGpu = S.GroupInfo[S.TimerInfo[i].nGroupIndex].Type == ProfileTokenTypeGpu;
+		ProfileBenchmarkCalcStats(Samples.data(), (uint32_t)Samples.size(), Sorted, &Stats);
+		ProfilePrintf(CB, Handle, "%s{ \"Type\": \"%s\", \"Group\": ", i ? ",\n" : "", bGpu ? "Gpu" : "Cpu");
+		ProfilePrintJsonString(CB, Handle, S.GroupInfo[S.TimerInfo[i].nGroupIndex].pName);
+		ProfilePrintf(CB, Handle, ", \"Name\": ");
+		ProfilePrintJsonString(CB, Handle, S.TimerInfo[i].pName);
+		ProfilePrintf(CB, Handle, ", \"Frames\": %u, ", (uint32_t)Samples.size());
+		ProfileBenchmarkPrintJsonStats(CB, Handle, Stats);
+		if (!bGpu)
+			ProfilePrintf(CB, Handle, ", \"CallsPerFrame\": %.2f", Samples.empty() ? 0.f : (float)pBenchmark->nTimerCalls[i] / Samples.size());
+		if (ProfileBenchmarkIsGpuRoot(i))
+		{
+			ProfilePrintf(CB, Handle, ", ");
+			ProfileBenchmarkPrintJsonHistogram(CB, Handle, Samples.data(), (uint32_t)Samples.size(), Stats.fMax);
+		}
+		ProfilePrintf(CB, Handle, " }");
+	}
+	ProfilePrintf(CB, Handle, "\n],\n");
+
+	ProfilePrintf(CB, Handle, "\"Counters\": [\n");
+	bool bFirstCounter = true;
+	for (uint32_t i = 0; i < S.nNumCounters; ++i)
+	{
+		// Counters with children only group the names
+		if (S.CounterInfo[i].nFirstChild >= 0)
+			continue;
+		const eastl::vector<int64_t>& Samples = pBenchmark->CounterSamples[i];
+		int64_t nMin = 0, nMax = 0, nLast = 0;
+		double fSum = 0.0;
+		for (size_t j = 0; j < Samples.size(); ++j)
+		{
+			nMin = j ? ProfileMin(nMin, Samples[j]) : Samples[j];
+			nMax = j ? ProfileMax(nMax, Samples[j]) : Samples[j];
+			fSum += (double)Samples[j];
+			nLast = Samples[j];
+		}
+		char Name[PROFILE_MAX_COUNTER_NAME_CHARS];
+		ProfileGetCounterPath(i, Name, sizeof(Name));
+		ProfilePrintf(CB, Handle, "%s{ \"Name\": ", bFirstCounter ? "" : ",\n");
+		bFirstCounter = false;
+		ProfilePrintJsonString(CB, Handle, Name);
+		ProfilePrintf(CB, Handle, ", \"Frames\": %u, \"Average\": %.2f, \"Min\": %lld, \"Max\": %lld, \"Last\": %lld }", (uint32_t)Samples.size(),
+			Samples.empty() ? 0.0 : fSum / Samples.size(), (long long)nMin, (long long)nMax, (long long)nLast);
+	}
+	ProfilePrintf(CB, Handle, "\n]\n}\n");
+}
+
+// One row per frame time, timer and counter. This is the file compareBenchmarkData reads
+static void ProfileBenchmarkDumpCsv(ProfileWriteCallback CB, void* Handle)
+{
+	Profile & S = g_Profile;
+	ProfileBenchmark* pBenchmark = g_pProfileBenchmark;
+	eastl::vector<float> Sorted;
+	eastl::vector<float> CounterSamples;
+	ProfileBenchmarkStats Stats;
+
+	ProfilePrintf(CB, Handle, "type,group,name,average,min,max,p50,p90,p95,p99\n");
+	ProfileBenchmarkCalcStats(pBenchmark->FrameTimes.data(), (uint32_t)pBenchmark->FrameTimes.size(), Sorted, &Stats);
+	ProfileBenchmarkPrintCsvRow(CB, Handle, "frame", "", "FrameTime", Stats);
+	for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+	{
+		const eastl::vector<float>& Samples = pBenchmark->TimerSamples[i];
+		const ProfileGroupInfo& Group = S.GroupInfo[S.TimerInfo[i].nGroupIndex];
+		ProfileBenchmarkCalcStats(Samples.data(), (uint32_t)Samples.size(), Sorted, &Stats);
+		ProfileBenchmarkPrintCsvRow(CB, Handle, Group.Type == ProfileTokenTypeGpu ? "gpu" : "cpu", Group.pName, S.TimerInfo[i].pName, Stats);
+	}
+	for (uint32_t i = 0; i < S.nNumCounters; ++i)
+	{
+		if (S.CounterInfo[i].nFirstChild >= 0)
+			continue;
+		const eastl::vector<int64_t>& Samples = pBenchmark->CounterSamples[i];
+		CounterSamples.resize(Samples.size());
+		for (size_t j = 0; j < Samples.size(); ++j)
+			CounterSamples[j] = (float)Samples[j];
+		char Name[PROFILE_MAX_COUNTER_NAME_CHARS];
+		ProfileGetCounterPath(i, Name, sizeof(Name));
+		ProfileBenchmarkCalcStats(CounterSamples.data(), (uint32_t)CounterSamples.size(), Sorted, &Stats);
+		ProfileBenchmarkPrintCsvRow(CB, Handle, "counter", "", Name, Stats);
+	}
+}
+
+// Frame time and the time of every timer for each recorded frame, empty where a timer did not exist yet
+static void ProfileBenchmarkDumpFramesCsv(ProfileWriteCallback CB, void* Handle)
+{
+	Profile & S = g_Profile;
+	ProfileBenchmark* pBenchmark = g_pProfileBenchmark;
+
+	ProfilePrintf(CB, Handle, "frame,FrameTime");
+	for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+	{
+		char Name[PROFILE_NAME_MAX_LEN * 2 + 2];
+		snprintf(Name, sizeof(Name), "%s/%s", S.GroupInfo[S.TimerInfo[i].nGroupIndex].pName, S.TimerInfo[i].pName);
+		CB(Handle, 1, ",");
+		ProfileBenchmarkPrintCsvString(CB, Handle, Name);
+	}
+	ProfilePrintf(CB, Handle, "\n");
+
+	for (uint32_t nFrame = 0; nFrame < (uint32_t)pBenchmark->FrameTimes.size(); ++nFrame)
+	{
+		ProfilePrintf(CB, Handle, "%u,%.4f", nFrame, pBenchmark->FrameTimes[nFrame]);
+		for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+		{
+			const eastl::vector<float>& Samples = pBenchmark->TimerSamples[i];
+			const uint32_t nFirstFrame = pBenchmark->nTimerFirstFrame[i];
+			if (nFrame >= nFirstFrame && nFrame - nFirstFrame < Samples.size())
+				ProfilePrintf(CB, Handle, ",%.4f", Samples[nFrame - nFirstFrame]);
+			else
+				CB(Handle, 1, ",");
+		}
+		ProfilePrintf(CB, Handle, "\n");
+	}
+}
+
 void dumpBenchmarkData(Renderer* pRenderer, IApp::Settings* pSettings, const char* appName)
 {
-    //time_t t = time(0);
-    //eastl::string tempName = eastl::string().sprintf("%s", appName) + eastl::string(R"(Benchmark-%Y-%m-%d-%H.%M.%S.txt)");
-    //char name[128] = {};
-    //strftime(name, sizeof(name), tempName.c_str(), localtime(&t));
-    //FileStream* statsFile = fsOpenFile(RD_LOG, name, FM_WRITE);
-    //if (statsFile)
-    //{
-    //    fsPrintToStream(statsFile, "{\n");
-
-    //    fsPrintToStream(statsFile, "\"Application\": \"%s\", \n", pRenderer->pName);
-    //    fsPrintToStream(statsFile, "\"Width\": %d, \n", pSettings->mWidth);
-    //    fsPrintToStream(statsFile, "\"Height\": %d, \n\n", pSettings->mHeight);
-    //    fsPrintToStream(statsFile, "\"GpuName\": \"%s\", \n", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mGpuName);
-    //    fsPrintToStream(statsFile, "\"VendorID\": \"%s\", \n", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mVendorId);
-    //    fsPrintToStream(statsFile, "\"ModelID\": \"%s\", \n\n", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mModelId);
-    //    const Profile& S = *ProfileGet();
-    //    for (uint32_t groupIndex = 0; groupIndex < S.nGroupCount; ++groupIndex)
-    //    {
-    //        if (S.GroupInfo[groupIndex].Type != ProfileTokenTypeGpu)
-    //            continue;
-
-    //        for (uint32_t timerIndex = 0; timerIndex < S.nTotalTimers; ++timerIndex)
-    //        {
-    //            if (strcmp(S.TimerInfo[timerIndex].pName, S.GroupInfo[groupIndex].pName) == 0)
-    //            {
-    //                fsPrintToStream(statsFile, "\"%s\": { \n", S.GroupInfo[groupIndex].pName);
-    //                float fToMs = ProfileTickToMsMultiplier(getGpuProfileTicksPerSecond(S.GroupInfo[groupIndex].nGpuProfileToken));
-    //                uint32_t nAggregateFrames = S.nAggregateFrames ? S.nAggregateFrames : 1;
-    //                uint32_t nAggregateCount = S.Aggregate[timerIndex].nCount ? S.Aggregate[timerIndex].nCount : 1;
-    //                float fAverage = fToMs * (S.Aggregate[timerIndex].nTicks / nAggregateFrames);
-    //                float fMax = fToMs * (S.AggregateMax[timerIndex]);
-    //                float fMin = fToMs * (S.AggregateMin[timerIndex]);
-    //                fsPrintToStream(statsFile, "\"Average\": %0.4f, \n", fAverage);
-    //                fsPrintToStream(statsFile, "\"Min\": %0.4f, \n", fMin);
-    //                fsPrintToStream(statsFile, "\"Max\": %0.4f, \n", fMax);
-    //                fsPrintToStream(statsFile, "\"Frames\": %d \n", nAggregateCount);
-    //                fsPrintToStream(statsFile, "}, \n\n");
-    //                break;
-    //            }
-    //        }
-    //    }
-    //    fsPrintToStream(statsFile, "\"Cpu\": { \n");
-    //    fsPrintToStream(statsFile, "\"Average\": %0.4f, \n", getCpuAvgFrameTime());
-    //    fsPrintToStream(statsFile, "\"Min\": %0.4f, \n", getCpuMinFrameTime());
-    //    fsPrintToStream(statsFile, "\"Max\": %0.4f, \n", getCpuMaxFrameTime());
-    //    fsPrintToStream(statsFile, "\"Frames\": %d \n", S.nAggregateFrames);
-    //    fsPrintToStream(statsFile, "} \n");
-    //    fsPrintToStream(statsFile, "}");
-
-    //    fsCloseStream(statsFile);
-    //}
+	MutexLock lock(ProfileMutex());
+	if (!g_pProfileBenchmark)
+	{
+		LOGF(LogLevel::eWARNING, "dumpBenchmarkData: no frames recorded, call beginBenchmark first");
+		return;
+	}
+
+	time_t t = time(0);
+	char timeString[64] = {};
+	strftime(timeString, sizeof(timeString), "%Y-%m-%d-%H.%M.%S", localtime(&t));
+
+	const char* pExtensions[] = { ".json", ".csv", "-frames.csv" };
+	for (uint32_t i = 0; i < sizeof(pExtensions) / sizeof(pExtensions[0]); ++i)
+	{
+		char name[256] = {};
+		snprintf(name, sizeof(name), "%sBenchmark-%s%s", appName, timeString, pExtensions[i]);
+		FileStream fh = {};
+		if (!fsOpenStreamFromPath(RD_LOG, name, FM_WRITE, &fh))
+		{
+			LOGF(LogLevel::eERROR, "dumpBenchmarkData: could not open %s", name);
+			continue;
+		}
+		if (i == 0)
+			ProfileBenchmarkDumpJson(ProfileWriteFile, &fh, pRenderer, pSettings);
+		else if (i == 1)
+			ProfileBenchmarkDumpCsv(ProfileWriteFile, &fh);
+		else
+			ProfileBenchmarkDumpFramesCsv(ProfileWriteFile, &fh);
+		fsCloseStream(&fh);
+		LOGF(LogLevel::eINFO, "Benchmark data written to %s", name);
+	}
+}
+
+struct ProfileBenchmarkCsvRow
+{
+	eastl::string Key;
+	float fAverage;
+	float fP50;
+	float fP95;
+};
+
+// Reads the rows written by ProfileBenchmarkDumpCsv, the key of a row is "type,group,name"
+static bool ProfileBenchmarkReadCsv(const char* pFileName, eastl::vector<ProfileBenchmarkCsvRow>& Rows)
+{
+	FileStream fh = {};
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_READ, &fh))
+	{
+		LOGF(LogLevel::eERROR, "compareBenchmarkData: could not open %s", pFileName);
+		return false;
+	}
+	eastl::string Data;
+	Data.resize((size_t)ProfileMax(fsGetStreamFileSize(&fh), (ssize_t)0));
+	Data.resize(fsReadFromStream(&fh, Data.begin(), Data.size()));
+	fsCloseStream(&fh);
+
+	const char* pLine = Data.c_str();
+	pLine = strchr(pLine, '\n'); // header
+	while (pLine && *++pLine)
+	{
+		// type, quoted group, quoted name, then the stats
+		eastl::string Fields[3];
+		const char* pChar = pLine;
+		for (uint32_t nField = 0; nField < 3; ++nField)
+		{
+			if (*pChar == '"')
+			{
+				for (++pChar; *pChar && !(pChar[0] == '"' && pChar[1] != '"'); ++pChar)
+				{
+					if (*pChar == '"')
+						++pChar;
+					Fields[nField].push_back(*pChar);
+				}
+				if (*pChar)
+					++pChar;
+			}
+			else
+			{
+				for (; *pChar && *pChar != ',' && *pChar != '\n'; ++pChar)
+					Fields[nField].push_back(*pChar);
+			}
+			if (*pChar == ',')
+				++pChar;
+		}
+
+		float fValues[7] = {};
+		if (sscanf(pChar, "%f,%f,%f,%f,%f,%f,%f", &fValues[0], &fValues[1], &fValues[2], &fValues[3], &fValues[4], &fValues[5], &fValues[6]) == 7)
+		{
+			ProfileBenchmarkCsvRow Row = {};
+			Row.Key = Fields[0] + "," + Fields[1] + "," + Fields[2];
+			Row.fAverage = fValues[0];
+			Row.fP50 = fValues[3];
+			Row.fP95 = fValues[5];
+			Rows.push_back(Row);
+		}
+		pLine = strchr(pChar, '\n');
+	}
+	return true;
+}
+
+uint32_t compareBenchmarkData(const char* pBaselineFileName, const char* pFileName, float fThresholdPercent, float fMinDifferenceMs)
+{
+	eastl::vector<ProfileBenchmarkCsvRow> Baseline;
+	eastl::vector<ProfileBenchmarkCsvRow> Current;
+	if (!ProfileBenchmarkReadCsv(pBaselineFileName, Baseline) || !ProfileBenchmarkReadCsv(pFileName, Current))
+		return UINT32_MAX;
+
+	uint32_t nRegressions = 0;
+	for (const ProfileBenchmarkCsvRow& Row : Current)
+	{
+		// Counters are not times, they are only reported in the files
+		if (strncmp(Row.Key.c_str(), "counter,", 8) == 0)
+			continue;
+
+		const ProfileBenchmarkCsvRow* pBase = NULL;
+		for (const ProfileBenchmarkCsvRow& BaseRow : Baseline)
+		{
+			if (BaseRow.Key == Row.Key)
+			{
+				pBase = &BaseRow;
+				break;
+			}
+		}
+		if (!pBase)
+			continue;
+
+		// The median is robust to the odd hitch, the 95th percentile catches timers that got spikier
+		const float fLimit = 1.f + fThresholdPercent * 0.01f;
+		const bool bMedian = Row.fP50 > pBase->fP50 * fLimit && Row.fP50 - pBase->fP50 > fMinDifferenceMs;
+		const bool bP95 = Row.fP95 > pBase->fP95 * fLimit && Row.fP95 - pBase->fP95 > fMinDifferenceMs;
+		if (bMedian || bP95)
+		{
+			LOGF(LogLevel::eWARNING, "Benchmark regression %s: median %.3f ms -> %.3f ms, p95 %.3f ms -> %.3f ms", Row.Key.c_str(), pBase->fP50,
+				Row.fP50, pBase->fP95, Row.fP95);
+			++nRegressions;
+		}
+	}
+	LOGF(nRegressions ? LogLevel::eWARNING : LogLevel::eINFO, "compareBenchmarkData: %u regressions between %s and %s", nRegressions,
+		pBaselineFileName, pFileName);
+	return nRegressions;
+}
+
+/************************************************************************/
+// Chrome trace export
+/************************************************************************/
+// Trace Event Format (JSON array), loaded by chrome://tracing and ui.perfetto.dev. The closing bracket is optional in
+// this format, so a capture cut short by a crash still loads.
+// Cpu thread logs are written to process 1, gpu logs to process 2, with the log index as thread id. Thread 0 of process 1
+// holds one slice per frame. Gpu ticks are aligned to the cpu timeline once, at the first frame holding gpu events.
+#define PROFILE_TRACE_PID_CPU 1
+#define PROFILE_TRACE_PID_GPU 2
+#define PROFILE_TRACE_STREAM_BUFFER_SIZE (1 << 20)
+
+struct ProfileTraceState
+{
+	ProfileWriteCallback* CB;
+	void* Handle;
+	int64_t nBaseTickCpu;
+	double fCpuTicksToUs;
+	int64_t nBaseTickGpu[PROFILE_MAX_THREADS];
+	double fGpuBaseUs[PROFILE_MAX_THREADS];
+	/// Raw tick of the last enter / leave of each log, labels are placed there
+	int64_t nLastTick[PROFILE_MAX_THREADS];
+	uint32_t nDepth[PROFILE_MAX_THREADS];
+	bool bGpuBaseSet[PROFILE_MAX_THREADS];
+	bool bThreadNamed[PROFILE_MAX_THREADS];
+	double fLastUs;
+};
+
+struct ProfileTraceStream
+{
+	FileStream File;
+	ProfileTraceState State;
+	eastl::vector<char> Buffer;
+	uint64_t nFrameCount;
+};
+
+static ProfileTraceStream* g_pProfileTraceStream = NULL;
+
+static double ProfileTraceTimeUs(ProfileTraceState* pState, uint32_t nLog, int64_t nTick)
+{
+	ProfileThreadLog* pLog = g_Profile.Pool[nLog];
+	if (!pLog->nGpu)
+		return ProfileLogTickDifference(pState->nBaseTickCpu, nTick) * pState->fCpuTicksToUs;
+
+	uint64_t nTicksPerSecond = getGpuProfileTicksPerSecond(pLog->nGpuToken);
+	double fGpuTicksToUs = nTicksPerSecond ? 1e6 / (double)nTicksPerSecond : 0.0;
+	return pState->fGpuBaseUs[nLog] + ProfileLogTickDifference(pState->nBaseTickGpu[nLog], nTick) * fGpuTicksToUs;
+}
+
+static void ProfileTracePrintEvent(ProfileTraceState* pState, char cPhase, uint32_t nPid, uint32_t nTid, double fUs, const char* pName, const char* pCategory)
+{
+	ProfilePrintf(pState->CB, pState->Handle, "{\"ph\":\"%c\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f", cPhase, nPid, nTid, fUs);
+	if (pName)
+	{
+		ProfilePrintString(pState->CB, pState->Handle, ",\"name\":");
+		ProfilePrintJsonString(pState->CB, pState->Handle, pName);
+	}
+	if (pCategory)
+	{
+		ProfilePrintString(pState->CB, pState->Handle, ",\"cat\":");
+		ProfilePrintJsonString(pState->CB, pState->Handle, pCategory);
+	}
+	if (cPhase == 'i')
+		ProfilePrintString(pState->CB, pState->Handle, ",\"s\":\"t\"");
+	ProfilePrintString(pState->CB, pState->Handle, "},\n");
+}
+
+static void ProfileTracePrintMetadata(ProfileTraceState* pState, const char* pType, uint32_t nPid, uint32_t nTid, const char* pName)
+{
+	ProfilePrintf(pState->CB, pState->Handle, "{\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"name\":\"%s\",\"args\":{\"name\":", nPid, nTid, pType);
+	ProfilePrintJsonString(pState->CB, pState->Handle, pName);
+	ProfilePrintString(pState->CB, pState->Handle, "}},\n");
+}
+
+// Frames from before the profiler started all begin at the tick of initProfiler
+static bool ProfileTraceFrameRecorded(uint32_t nFrame)
+{
+	const uint32_t nFrameNext = (nFrame + 1) % PROFILE_MAX_FRAME_HISTORY;
+	return g_Profile.Frames[nFrameNext].nFrameStartCpu > g_Profile.Frames[nFrame].nFrameStartCpu;
+}
+
+static void ProfileTraceBegin(ProfileTraceState* pState, ProfileWriteCallback CB, void* Handle, int64_t nBaseTickCpu)
+{
+	memset(pState, 0, sizeof(*pState));
+	pState->CB = CB;
+	pState->Handle = Handle;
+	pState->nBaseTickCpu = nBaseTickCpu;
+	pState->fCpuTicksToUs = 1e6 / (double)ProfileTicksPerSecondCpu();
+
+	ProfilePrintString(CB, Handle, "[\n");
+	ProfileTracePrintMetadata(pState, "process_name", PROFILE_TRACE_PID_CPU, 0, "CPU");
+	ProfileTracePrintMetadata(pState, "process_name", PROFILE_TRACE_PID_GPU, 0, "GPU");
+	ProfileTracePrintMetadata(pState, "thread_name", PROFILE_TRACE_PID_CPU, 0, "Frames");
+}
+
+// Writes the log entries of every thread between the start of nFrame and the start of the next frame.
+// Counters have no history, so their current value is written, only set bCounters for the newest frame written
+static void ProfileTraceWriteFrame(ProfileTraceState* pState, uint32_t nFrame, uint64_t nFrameNumber, bool bCounters)
+{
+	Profile & S = g_Profile;
+	const uint32_t nFrameNext = (nFrame + 1) % PROFILE_MAX_FRAME_HISTORY;
+	const double fFrameStartUs = ProfileLogTickDifference(pState->nBaseTickCpu, S.Frames[nFrame].nFrameStartCpu) * pState->fCpuTicksToUs;
+	const double fFrameEndUs = ProfileLogTickDifference(pState->nBaseTickCpu, S.Frames[nFrameNext].nFrameStartCpu) * pState->fCpuTicksToUs;
+
+	ProfilePrintf(pState->CB, pState->Handle, "{\"ph\":\"X\",\"pid\":%u,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"Frame %llu\"},\n",
+		PROFILE_TRACE_PID_CPU, fFrameStartUs, fFrameEndUs - fFrameStartUs, (unsigned long long)nFrameNumber);
+
+	for (uint32_t i = 0; bCounters && i < S.nNumCounters; ++i)
+	{
+		if (S.CounterInfo[i].nFirstChild >= 0)
+			continue;
+		char Name[PROFILE_MAX_COUNTER_NAME_CHARS];
+		ProfileGetCounterPath(i, Name, sizeof(Name));
+		ProfilePrintf(pState->CB, pState->Handle, "{\"ph\":\"C\",\"pid\":%u,\"tid\":0,\"ts\":%.3f,\"name\":", PROFILE_TRACE_PID_CPU, fFrameStartUs);
+		ProfilePrintJsonString(pState->CB, pState->Handle, Name);
+		ProfilePrintf(pState->CB, pState->Handle, ",\"args\":{\"value\":%lld}},\n", (long long)tfrg_atomic64_load_relaxed(&S.Counters[i]));
+	}
+
+	for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+	{
+		ProfileThreadLog* pLog = S.Pool[j];
+		if (!pLog || !pLog->Log)
+			continue;
+
+		const uint32_t nPid = pLog->nGpu ? PROFILE_TRACE_PID_GPU : PROFILE_TRACE_PID_CPU;
+		const uint32_t nTid = j + 1;
+		const uint32_t nLogStart = S.Frames[nFrame].nLogStart[j];
+		const uint32_t nLogEnd = S.Frames[nFrameNext].nLogStart[j];
+		for (uint32_t k = nLogStart; k != nLogEnd; k = (k + 1) % PROFILE_BUFFER_SIZE)
+		{
+			const ProfileLogEntry LE = pLog->Log[k];
+			const uint64_t nType = ProfileLogType(LE);
+			if (nType != P_LOG_ENTER && nType != P_LOG_LEAVE && nType != P_LOG_LABEL && nType != P_LOG_LABEL_LITERAL)
+				continue;
+
+			if (!pState->bThreadNamed[j])
+			{
+				ProfileTracePrintMetadata(pState, "thread_name", nPid, nTid, pLog->ThreadName[0] ? pLog->ThreadName : "Thread");
+				pState->bThreadNamed[j] = true;
+			}
+			if (pLog->nGpu && !pState->bGpuBaseSet[j] && nType == P_LOG_ENTER)
+			{
+				pState->nBaseTickGpu[j] = ProfileLogGetTick(LE);
+				pState->fGpuBaseUs[j] = fFrameStartUs;
+				pState->bGpuBaseSet[j] = true;
+			}
+			if (pLog->nGpu && !pState->bGpuBaseSet[j])
+				continue;
+
+			if (nType == P_LOG_LABEL || nType == P_LOG_LABEL_LITERAL)
+			{
+				const char* pLabel = ProfileGetLabel((uint32_t)nType, ProfileLogGetTick(LE));
+				if (pLabel)
+					ProfileTracePrintEvent(pState, 'i', nPid, nTid, ProfileTraceTimeUs(pState, j, pState->nLastTick[j]), pLabel, "Label");
+				continue;
+			}
+
+			const double fUs = ProfileTraceTimeUs(pState, j, ProfileLogGetTick(LE));
+			pState->nLastTick[j] = ProfileLogGetTick(LE);
+			pState->fLastUs = ProfileMax(pState->fLastUs, fUs);
+			if (nType == P_LOG_ENTER)
+			{
+				const ProfileTimerInfo& Timer = S.TimerInfo[ProfileLogTimerIndex(LE)];
+				ProfileTracePrintEvent(pState, 'B', nPid, nTid, fUs, Timer.pName, S.GroupInfo[Timer.nGroupIndex].pName);
+				pState->nDepth[j]++;
+			}
+			else if (pState->nDepth[j])
+			{
+				// Scopes entered before the first exported frame have no begin event
+				ProfileTracePrintEvent(pState, 'E', nPid, nTid, fUs, NULL, NULL);
+				pState->nDepth[j]--;
+			}
+		}
+	}
+	pState->fLastUs = ProfileMax(pState->fLastUs, fFrameEndUs);
+}
+
+static void ProfileTraceEnd(ProfileTraceState* pState)
+{
+	// Close the scopes still open at the end of the capture
+	for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+	{
+		ProfileThreadLog* pLog = g_Profile.Pool[j];
+		for (; pState->nDepth[j]; --pState->nDepth[j])
+			ProfileTracePrintEvent(pState, 'E', pLog && pLog->nGpu ? PROFILE_TRACE_PID_GPU : PROFILE_TRACE_PID_CPU, j + 1, pState->fLastUs, NULL, NULL);
+	}
+	ProfilePrintf(pState->CB, pState->Handle, "{\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"name\":\"process_sort_index\",\"args\":{\"sort_index\":0}}\n]\n", PROFILE_TRACE_PID_CPU);
+}
+
+void ProfileDumpTrace(ProfileWriteCallback CB, void* Handle, int nMaxFrames)
+{
+	Profile & S = g_Profile;
+	uint32_t nNumFrames = (PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 3); //leave a few to not overwrite
+	nNumFrames = ProfileMin(nNumFrames, (uint32_t)ProfileMax(nMaxFrames, 1));
+	uint32_t nFirstFrame = (S.nFrameCurrent + PROFILE_MAX_FRAME_HISTORY - nNumFrames) % PROFILE_MAX_FRAME_HISTORY;
+	while (nNumFrames > 1 && !ProfileTraceFrameRecorded(nFirstFrame))
+	{
+		nFirstFrame = (nFirstFrame + 1) % PROFILE_MAX_FRAME_HISTORY;
+		--nNumFrames;
+	}
+
+	ProfileTraceState* pState = (ProfileTraceState*)tf_malloc(sizeof(ProfileTraceState));
+	ProfileTraceBegin(pState, CB, Handle, S.Frames[nFirstFrame].nFrameStartCpu);
+	for (uint32_t i = 0; i < nNumFrames; ++i)
+	{
+		const uint32_t nFrame = (nFirstFrame + i) % PROFILE_MAX_FRAME_HISTORY;
+		ProfileTraceWriteFrame(pState, nFrame, (uint64_t)S.nFrameCurrentIndex - nNumFrames + i, i == nNumFrames - 1);
+	}
+	ProfileTraceEnd(pState);
+	tf_free(pState);
+}
+
+void dumpProfileTrace(const char* appName, uint32_t nMaxFrames)
+{
+	MutexLock lock(ProfileMutex());
+	time_t t = time(0);
+	eastl::string tempName = eastl::string().sprintf("%s", appName) + eastl::string(R"(Trace-%Y-%m-%d-%H.%M.%S.json)");
+	char name[128] = {};
+	strftime(name, sizeof(name), tempName.c_str(), localtime(&t));
+	FileStream fh = {};
+	if (fsOpenStreamFromPath(RD_LOG, name, FM_WRITE, &fh))
+	{
+		ProfileDumpTrace(ProfileWriteFile, &fh, nMaxFrames);
+		fsCloseStream(&fh);
+	}
+}
+
+static void ProfileTraceStreamFlush(ProfileTraceStream* pStream)
+{
+	if (!pStream->Buffer.empty())
+		fsWriteToStream(&pStream->File, pStream->Buffer.data(), pStream->Buffer.size());
+	pStream->Buffer.clear();
+}
+
+static void ProfileTraceStreamWrite(void* Handle, size_t nSize, const char* pData)
+{
+	ProfileTraceStream* pStream = (ProfileTraceStream*)Handle;
+	pStream->Buffer.insert(pStream->Buffer.end(), pData, pData + nSize);
+	if (pStream->Buffer.size() >= PROFILE_TRACE_STREAM_BUFFER_SIZE)
+		ProfileTraceStreamFlush(pStream);
+}
+
+// Called from ProfileFlipCpu with the profile mutex held, once the logs of nFrame are complete
+void ProfileTraceStreamFrame(uint32_t nFrame)
+{
+	ProfileTraceStream* pStream = g_pProfileTraceStream;
+	if (!pStream || !ProfileTraceFrameRecorded(nFrame))
+		return;
+
+	if (!pStream->nFrameCount)
+		ProfileTraceBegin(&pStream->State, ProfileTraceStreamWrite, pStream, g_Profile.Frames[nFrame].nFrameStartCpu);
+	ProfileTraceWriteFrame(&pStream->State, nFrame, pStream->nFrameCount++, true);
+}
+
+bool beginProfileTraceCapture(const char* pFileName)
+{
+	MutexLock lock(ProfileMutex());
+	if (g_pProfileTraceStream)
+		return false;
+
+	ProfileTraceStream* pStream = tf_new(ProfileTraceStream);
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_WRITE_BINARY, &pStream->File))
+	{
+		LOGF(LogLevel::eERROR, "beginProfileTraceCapture: could not open %s", pFileName);
+		tf_delete(pStream);
+		return false;
+	}
+	pStream->Buffer.reserve(PROFILE_TRACE_STREAM_BUFFER_SIZE + 4096);
+	g_pProfileTraceStream = pStream;
+	return true;
+}
+
+void endProfileTraceCapture()
+{
+	MutexLock lock(ProfileMutex());
+	ProfileTraceStream* pStream = g_pProfileTraceStream;
+	if (!pStream)
+		return;
+
+	if (pStream->nFrameCount)
+		ProfileTraceEnd(&pStream->State);
+	ProfileTraceStreamFlush(pStream);
+	fsCloseStream(&pStream->File);
+	LOGF(LogLevel::eINFO, "Profile trace capture ended after %llu frames", (unsigned long long)pStream->nFrameCount);
+	tf_delete(pStream);
+	g_pProfileTraceStream = NULL;
 }
 
 #if PROFILE_WEBSERVER
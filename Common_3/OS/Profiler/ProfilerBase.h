@@ -332,7 +332,8 @@ enum ProfileTokenType
 enum ProfileDumpType
 {
 	ProfileDumpTypeHtml,
-	ProfileDumpTypeCsv
+	ProfileDumpTypeCsv,
+	ProfileDumpTypeTrace
 };
 
 #ifdef __GNUC__
@@ -404,6 +405,7 @@ PROFILE_API void ProfileDumpFile(const char* pPath, ProfileDumpType eType, uint3
 
 typedef void ProfileWriteCallback(void* Handle, size_t size, const char* pData);
 PROFILE_API void ProfileDumpHtml(ProfileWriteCallback CB, void* Handle, int nMaxFrames, const char* pHost, Renderer* pRenderer);
+PROFILE_API void ProfileDumpTrace(ProfileWriteCallback CB, void* Handle, int nMaxFrames);
 
 PROFILE_API int ProfileFormatCounter(int eFormat, int64_t nCounter, char* pOut, uint32_t nBufferSize);
 
@@ -539,7 +539,7 @@ void initWindowClass()
 					FORMAT_MESSAGE_IGNORE_INSERTS, NULL, errorMessageID,
 					MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&messageBuffer, 0, NULL);
 				eastl::string message(messageBuffer, size);
-				LOGF(eERROR, message.c_str());
+				LOGF(eERROR, "%s", message.c_str());
 				return;
 			}
 			else
@@ -105,8 +105,11 @@ bool initFileSystem(FileSystemInitDesc* pDesc)
 	return true;
 }
 
+void exitAsyncFileIO();
+
 void exitFileSystem(void)
 {
+	exitAsyncFileIO();
 	gInitialized = false;
 }
 #endif
@@ -705,8 +705,13 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 		sub = { pSrcBuffer->pCpuMappedAddress, 0, 0 };
 	}
 
+	D3D11_BOX box = { pSubresourceDesc->mRegionX, pSubresourceDesc->mRegionY, 0,
+		pSubresourceDesc->mRegionX + pSubresourceDesc->mRegionWidth, pSubresourceDesc->mRegionY + pSubresourceDesc->mRegionHeight,
+		max(1u, (uint32_t)pTexture->mDepth >> pSubresourceDesc->mMipLevel) };
+	const bool region = pSubresourceDesc->mRegionWidth && pSubresourceDesc->mRegionHeight;
+
 	pContext->UpdateSubresource(
-		pTexture->pDxResource, subresource, NULL, (uint8_t*)sub.pData + pSubresourceDesc->mSrcOffset,
+		pTexture->pDxResource, subresource, region ? &box : NULL, (uint8_t*)sub.pData + pSubresourceDesc->mSrcOffset,
 		pSubresourceDesc->mRowPitch, pSubresourceDesc->mSlicePitch);
 
 	if (!pSrcBuffer->pCpuMappedAddress)
@@ -1897,7 +1902,7 @@ void compileShader(
 		ASSERT(msg);
 		memcpy(msg, error_msgs->GetBufferPointer(), error_msgs->GetBufferSize());
 		eastl::string error = eastl::string(fileName) + " " + msg;
-		LOGF(eERROR, error.c_str());
+		LOGF(eERROR, "%s", error.c_str());
 		SAFE_FREE(msg);
 	}
 	ASSERT(SUCCEEDED(hres));
@@ -3015,12 +3020,16 @@ void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipelin
 	*ppPipeline = pPipeline;
 }
 
+extern void recordPipeline(const PipelineDesc* pDesc);
+
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
 	ASSERT(pRenderer);
 	ASSERT(ppPipeline);
 	ASSERT(pDesc);
 
+	recordPipeline(pDesc);
+
 	switch (pDesc->mType)
 	{
 		case(PIPELINE_TYPE_COMPUTE):
@@ -3192,7 +3201,7 @@ void updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDe
 	if (!(descriptor))																					\
 	{																									\
 		eastl::string msg = __FUNCTION__ + eastl::string(" : ") + eastl::string().sprintf(__VA_ARGS__);	\
-		LOGF(LogLevel::eERROR, msg.c_str());															\
+		LOGF(LogLevel::eERROR, "%s", msg.c_str());														\
 		_FailedAssert(__FILE__, __LINE__, msg.c_str());													\
 		continue;																						\
 	}
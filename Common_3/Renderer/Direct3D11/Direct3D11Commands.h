@@ -247,6 +247,10 @@ struct SubresourceDataDesc
 	uint64_t mSrcOffset;
 	uint32_t mMipLevel;
 	uint32_t mArrayLayer;
+	uint32_t mRegionX;
+	uint32_t mRegionY;
+	uint32_t mRegionWidth;
+	uint32_t mRegionHeight;
 	uint32_t mRowPitch;
 	uint32_t mSlicePitch;
 };
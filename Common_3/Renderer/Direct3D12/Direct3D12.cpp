@@ -4174,7 +4174,7 @@ void updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDe
 	if (!(descriptor))																					\
 	{																									\
 		eastl::string msg = __FUNCTION__ + eastl::string(" : ") + eastl::string().sprintf(__VA_ARGS__);	\
-		LOGF(LogLevel::eERROR, msg.c_str());															\
+		LOGF(LogLevel::eERROR, "%s", msg.c_str());														\
 		_FailedAssert(__FILE__, __LINE__, msg.c_str());													\
 		continue;																						\
 	}
@@ -4855,8 +4855,12 @@ void addComputePipeline(Renderer* pRenderer, const PipelineDesc* pMainDesc, Pipe
 	*ppPipeline = pPipeline;
 }
 
+extern void recordPipeline(const PipelineDesc* pDesc);
+
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
+	recordPipeline(pDesc);
+
 	switch (pDesc->mType)
 	{
 		case (PIPELINE_TYPE_COMPUTE):
@@ -5435,6 +5439,10 @@ typedef struct SubresourceDataDesc
 	uint64_t                           mSrcOffset;
 	uint32_t                           mMipLevel;
 	uint32_t                           mArrayLayer;
+	uint32_t                           mRegionX;
+	uint32_t                           mRegionY;
+	uint32_t                           mRegionWidth;
+	uint32_t                           mRegionHeight;
 } SubresourceDataDesc;
 
 void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pDesc)
@@ -5446,15 +5454,29 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 	D3D12_TEXTURE_COPY_LOCATION dst = {};
 	src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
 	src.pResource = pSrcBuffer->pDxResource;
-	pCmd->pRenderer->pDxDevice->GetCopyableFootprints(&resourceDesc, subresource, 1, pDesc->mSrcOffset, &src.PlacedFootprint, NULL, NULL, NULL);
+	if (pDesc->mRegionWidth && pDesc->mRegionHeight)
+	{
+		// Footprint of the region alone, which is how the resource loader stages it
+		D3D12_RESOURCE_DESC regionDesc = resourceDesc;
+		regionDesc.Width = pDesc->mRegionWidth;
+		regionDesc.Height = pDesc->mRegionHeight;
+		regionDesc.DepthOrArraySize = (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+			? (UINT16)max(1u, (uint32_t)resourceDesc.DepthOrArraySize >> pDesc->mMipLevel) : 1;
+		regionDesc.MipLevels = 1;
+		pCmd->pRenderer->pDxDevice->GetCopyableFootprints(&regionDesc, 0, 1, pDesc->mSrcOffset, &src.PlacedFootprint, NULL, NULL, NULL);
+	}
+	else
+	{
+		pCmd->pRenderer->pDxDevice->GetCopyableFootprints(&resourceDesc, subresource, 1, pDesc->mSrcOffset, &src.PlacedFootprint, NULL, NULL, NULL);
+	}
 	src.PlacedFootprint.Offset = pDesc->mSrcOffset;
 	dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
 	dst.pResource = pTexture->pDxResource;
 	dst.SubresourceIndex = subresource;
 #if defined(XBOX)
-	pCmd->mDma.pDxCmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, NULL);
+	pCmd->mDma.pDxCmdList->CopyTextureRegion(&dst, pDesc->mRegionX, pDesc->mRegionY, 0, &src, NULL);
 #else
-	pCmd->pDxCmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, NULL);
+	pCmd->pDxCmdList->CopyTextureRegion(&dst, pDesc->mRegionX, pDesc->mRegionY, 0, &src, NULL);
 #endif
 }
 
@@ -182,6 +182,7 @@ typedef enum RendererApi
 	RENDERER_API_ORBIS,
 	RENDERER_API_PROSPERO,
 	RENDERER_API_GLES,
+	RENDERER_API_NULL,
 } RendererApi;
 
 typedef enum LogType
@@ -782,6 +783,10 @@ typedef struct QueryPool
 	uint32_t          mType;
 	uint32_t          mCount;
 #endif
+#if defined(NULL_RENDERER)
+	QueryType         mType;
+	uint32_t          mCount;
+#endif
 } QueryPool;
 
 #if defined (VULKAN)
@@ -899,6 +904,10 @@ typedef struct DEFINE_ALIGNED(Buffer, 64)
 	GLuint							 mBuffer;
 	GLenum							 mTarget;
 	void*                            pGLCpuMappedAddress;
+#endif
+#if defined(NULL_RENDERER)
+	/// System memory backing buffers which are not RESOURCE_MEMORY_USAGE_GPU_ONLY
+	void*                            pNullMemory;
 #endif
 	uint64_t                         mSize : 32;
 	uint64_t                         mDescriptors : 20;
@@ -1094,6 +1103,10 @@ typedef struct DEFINE_ALIGNED(Texture, 64)
 	GLenum						 mGlFormat;
 	GLenum						 mInternalFormat;
 	GLenum						 mType;
+#endif
+#if defined(NULL_RENDERER)
+	/// Memory the texture would occupy on a device, all mips, slices and samples included
+	uint64_t                     mAllocationSize;
 #endif
 	VirtualTexture*              pSvt;
 	/// Current state of the buffer
@@ -1570,6 +1583,10 @@ typedef struct DEFINE_ALIGNED(DescriptorSet, 64)
 	OrbisDescriptorSet            mStruct;
 #elif defined(PROSPERO)
 	ProsperoDescriptorSet         mStruct;
+#elif defined(NULL_RENDERER)
+	const RootSignature*          pRootSignature;
+	uint32_t                      mMaxSets;
+	uint8_t                       mUpdateFrequency;
 #endif
 } DescriptorSet;
 
@@ -1610,6 +1627,50 @@ typedef enum MarkerType
 	MARKER_TYPE_IN_OUT = 0x3,
 } MarkerType;
 
+#if defined(NULL_RENDERER)
+/// Work recorded into a command buffer of the null renderer. Nothing is executed, so these counts (together with
+/// the CPU time spent recording) are what a headless benchmark measures
+typedef struct NullCommandStats
+{
+	/// Every cmd* call, including state setting and debug markers
+	uint64_t mCommandCount;
+	uint64_t mDrawCount;
+	uint64_t mDispatchCount;
+	uint64_t mExecuteIndirectCount;
+	/// Vertices or indices times instances of all direct draws
+	uint64_t mVertexCount;
+	uint64_t mPipelineBindCount;
+	uint64_t mDescriptorSetBindCount;
+	uint64_t mPushConstantCount;
+	uint64_t mVertexBufferBindCount;
+	uint64_t mRenderTargetBindCount;
+	uint64_t mBarrierCount;
+	/// Buffer and texture copies recorded by the resource loader
+	uint64_t mCopyCount;
+	uint64_t mCopySize;
+} NullCommandStats;
+
+typedef struct NullRendererStats
+{
+	/// Sum of all command buffers submitted since initRenderer or the last resetNullRendererStats
+	NullCommandStats mSubmitted;
+	uint64_t         mSubmitCount;
+	uint64_t         mPresentCount;
+	uint64_t         mDescriptorUpdateCount;
+	/// Live resources
+	uint32_t         mBufferCount;
+	uint32_t         mTextureCount;
+	uint32_t         mRenderTargetCount;
+	uint32_t         mShaderCount;
+	uint32_t         mPipelineCount;
+	uint32_t         mDescriptorSetCount;
+	uint64_t         mBufferMemory;
+	uint64_t         mTextureMemory;
+	/// Highest mBufferMemory + mTextureMemory seen since initRenderer or the last resetNullRendererStats
+	uint64_t         mPeakMemory;
+} NullRendererStats;
+#endif
+
 typedef struct DEFINE_ALIGNED(Cmd, 64)
 {
 #if defined(DIRECT3D12)
@@ -1682,6 +1743,10 @@ typedef struct DEFINE_ALIGNED(Cmd, 64)
 #endif
 #if defined(GLES)
 	CmdPool*                     pCmdPool;
+#endif
+#if defined(NULL_RENDERER)
+	/// Reset by beginCmd, added to the renderer stats by queueSubmit
+	NullCommandStats             mStats;
 #endif
 	Renderer*                    pRenderer;
 	Queue*                       pQueue;
@@ -1730,7 +1795,7 @@ typedef struct Fence
 #if defined(PROSPERO)
 	ProsperoFence        mStruct;
 #endif
-#if defined(GLES)
+#if defined(GLES) || defined(NULL_RENDERER)
 	uint32_t             mSubmitted : 1;
 #endif
 } Fence;
@@ -1772,7 +1837,7 @@ typedef struct Semaphore
 	uint32_t             mPadA;
 	uint64_t             mPadB;
 #endif
-#if defined(GLES)
+#if defined(GLES) || defined(NULL_RENDERER)
 	uint32_t             mSignaled : 1;
 #endif
 #if defined(ORBIS)
@@ -1839,6 +1904,11 @@ typedef struct Queue
 	uint32_t             mType : 3;
 	uint32_t             mNodeIndex : 4;
 #endif
+#if defined(NULL_RENDERER)
+	Renderer*            pRenderer;
+	uint32_t             mType : 3;
+	uint32_t             mNodeIndex : 4;
+#endif
 } Queue;
 
 typedef struct ShaderMacro
@@ -2174,6 +2244,9 @@ typedef struct DEFINE_ALIGNED(Pipeline, 64)
 	PipelineType				mType;
 	GLenum					    mGlPrimitiveTopology;
 #endif
+#if defined(NULL_RENDERER)
+	PipelineType                mType;
+#endif
 } Pipeline;
 #if defined(DIRECT3D11) || defined(ORBIS)
 // Requires more cache lines due to no concept of an encapsulated pipeline state object
@@ -2317,6 +2390,11 @@ typedef struct SwapChain
 	uint32_t                 mImageIndex : 3;
 	uint32_t                 mEnableVsync : 1;
 #endif
+#if defined(NULL_RENDERER)
+	uint32_t                 mImageCount : 3;
+	uint32_t                 mImageIndex : 3;
+	uint32_t                 mEnableVsync : 1;
+#endif
 } SwapChain;
 
 typedef enum ShaderTarget
@@ -2542,6 +2620,9 @@ typedef struct DEFINE_ALIGNED(Renderer, 64)
 #if defined(GLES)
 	GLContext						pContext;
 	GLConfig						pConfig;
+#endif
+#if defined(NULL_RENDERER)
+	struct NullDevice*              pNullDevice;
 #endif
 	struct NullDescriptors*         pNullDescriptors;
 	char*                           pName;
@@ -2596,6 +2677,10 @@ typedef struct CommandSignature
 	IndirectArgumentType    mDrawType;
 	uint32_t                mStride;
 #endif
+#if defined(NULL_RENDERER)
+	IndirectArgumentType    mDrawType;
+	uint32_t                mStride;
+#endif
 } CommandSignature;
 
 typedef struct DescriptorSetDesc
@@ -2768,6 +2853,14 @@ API_INTERFACE void FORGE_CALLCONV setBufferName(Renderer* pRenderer, Buffer* pBu
 API_INTERFACE void FORGE_CALLCONV setTextureName(Renderer* pRenderer, Texture* pTexture, const char* pName);
 API_INTERFACE void FORGE_CALLCONV setRenderTargetName(Renderer* pRenderer, RenderTarget* pRenderTarget, const char* pName);
 API_INTERFACE void FORGE_CALLCONV setPipelineName(Renderer* pRenderer, Pipeline* pPipeline, const char* pName);
+#if defined(NULL_RENDERER)
+/************************************************************************/
+// Null Renderer Stats Interface
+/************************************************************************/
+API_INTERFACE void FORGE_CALLCONV getNullRendererStats(Renderer* pRenderer, NullRendererStats* pStats);
+/// Clears the submitted work counters and resets the peak memory to the current usage
+API_INTERFACE void FORGE_CALLCONV resetNullRendererStats(Renderer* pRenderer);
+#endif
 /************************************************************************/
 /************************************************************************/
 // clang-format on
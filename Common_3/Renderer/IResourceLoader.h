@@ -55,6 +55,19 @@ typedef enum TextureContainerType
 	TEXTURE_CONTAINER_SVT,
 } TextureContainerType;
 
+/// Order in which the resource loader decodes and uploads texture and geometry loads.
+/// Higher priorities overtake lower ones that are still waiting, loads of equal priority keep their submission order.
+/// The token of a load completes once the load and everything queued before it of the same or a higher priority has,
+/// so combining tokens of different priorities only waits for the higher priority loads.
+typedef enum LoadPriority
+{
+	/// Background streaming
+	LOAD_PRIORITY_LOW = -1,
+	LOAD_PRIORITY_NORMAL = 0,
+	/// Assets that are visible or about to become visible
+	LOAD_PRIORITY_HIGH = 1,
+} LoadPriority;
+
 // MARK: - Resource Loading
 
 typedef struct BufferLoadDesc
@@ -79,6 +92,8 @@ typedef struct TextureLoadDesc
 	TextureCreationFlags mCreationFlag;
 	/// The texture file format (dds/ktx/...)
 	TextureContainerType mContainer;
+	/// Order relative to other pending texture and geometry loads
+	LoadPriority         mPriority;
 } TextureLoadDesc;
 
 typedef struct Geometry
@@ -151,6 +166,8 @@ typedef struct GeometryLoadDesc
 	uint32_t          mNodeIndex;
 	/// Specifies how to arrange the vertex data loaded from the file into GPU memory
 	VertexLayout*     pVertexLayout;
+	/// Order relative to other pending texture and geometry loads
+	LoadPriority      mPriority;
 } GeometryLoadDesc;
 
 typedef struct VirtualTexturePageInfo
@@ -190,6 +207,13 @@ typedef struct TextureUpdateDesc
 	Texture*              pTexture;
 	uint32_t              mMipLevel;
 	uint32_t              mArrayLayer;
+	/// Optional 2D region of the subresource to update, in texels (block aligned for compressed formats)
+	/// The whole subresource is updated if mRegionWidth or mRegionHeight is zero
+	/// Only the region gets staged, so the strides and row count below then describe the region
+	uint32_t              mRegionX;
+	uint32_t              mRegionY;
+	uint32_t              mRegionWidth;
+	uint32_t              mRegionHeight;
 
 	/// To be filled by the caller
 	/// Example:
@@ -250,6 +274,31 @@ typedef struct ShaderLoadDesc
 	ShaderTarget        mTarget;
 } ShaderLoadDesc;
 
+typedef struct ShaderCacheStats
+{
+	uint32_t mHitCount;
+	uint32_t mMissCount;
+	/// Stages found in a shader library, these skip the cache
+	uint32_t mLibraryHitCount;
+} ShaderCacheStats;
+
+typedef struct ShaderLibraryLoadDesc
+{
+	/// Relative to RD_SHADER_BINARIES
+	const char* pFileName;
+} ShaderLibraryLoadDesc;
+
+typedef struct ShaderLibrarySaveDesc
+{
+	/// Relative to RD_SHADER_BINARIES
+	const char*           pFileName;
+	/// Every permutation the application loads through addShader / addShaders
+	const ShaderLoadDesc* pShaders;
+	uint32_t              mShaderCount;
+} ShaderLibrarySaveDesc;
+
+typedef struct ShaderLibrary ShaderLibrary;
+
 typedef struct PipelineCacheLoadDesc
 {
 	const char*         pFileName;
@@ -261,6 +310,28 @@ typedef struct PipelineCacheSaveDesc
 	const char*         pFileName;
 } PipelineCacheSaveDesc;
 
+typedef struct AsyncPipeline AsyncPipeline;
+
+typedef struct PipelineRecordDesc
+{
+	/// Relative to RD_PIPELINE_CACHE
+	const char*     pFileName;
+	/// Root signatures are saved as their index in this array, pass the same array in the same order to replayPipelines.
+	/// Pipelines using other root signatures are not saved
+	RootSignature** ppRootSignatures;
+	uint32_t        mRootSignatureCount;
+} PipelineRecordDesc;
+
+typedef struct PipelineReplayDesc
+{
+	/// Relative to RD_PIPELINE_CACHE
+	const char*     pFileName;
+	RootSignature** ppRootSignatures;
+	uint32_t        mRootSignatureCount;
+	/// Cache filled by the replayed pipelines, save it with savePipelineCache. Can be NULL to only warm up the driver cache
+	PipelineCache*  pCache;
+} PipelineReplayDesc;
+
 typedef uint64_t SyncToken;
 
 typedef struct ResourceLoaderDesc
@@ -268,6 +339,9 @@ typedef struct ResourceLoaderDesc
 	uint64_t mBufferSize;
 	uint32_t mBufferCount;
 	bool     mSingleThreaded;
+	/// Worker threads reading and decoding texture / geometry files ahead of the copy thread.
+	/// 0 decodes on the copy thread itself. Ignored when mSingleThreaded is set
+	uint32_t mDecodeThreadCount;
 } ResourceLoaderDesc;
 
 extern ResourceLoaderDesc gDefaultResourceLoaderDesc;
@@ -315,13 +389,59 @@ void waitForAllResourceLoads();
 /// A SyncToken is an array of monotonically increasing integers.
 /// getLastTokenCompleted() returns the last value for which
 /// isTokenCompleted(token) is guaranteed to return true.
+/// Tokens of texture / geometry loads above it can complete ahead of older loads of a lower LoadPriority.
 SyncToken getLastTokenCompleted();
 bool isTokenCompleted(const SyncToken* token);
 void waitForToken(const SyncToken* token);
 
-/// Either loads the cached shader bytecode or compiles the shader to create new bytecode depending on whether source is newer than binary
+/// Either loads the cached shader bytecode or compiles the shader to create new bytecode.
+/// Binaries are looked up by a hash of the source with its includes, the macros, the API and the compiler
 void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** pShader);
+/// Same as addShader for several shaders at once. Stages missing from the cache are compiled in parallel on the
+/// resource loader decode threads (ResourceLoaderDesc::mDecodeThreadCount) when the shader compiler allows it.
+/// ppShaders[i] is NULL if pDescs[i] failed to load
+void addShaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, Shader** ppShaders);
+/// Shader stages loaded from the binary cache and compiled since startup
+void getShaderCacheStats(ShaderCacheStats* pOutStats);
+
+/// Shader libraries pack the byte code of many shader permutations into one file that is memory mapped at runtime.
+/// addShader / addShaders look stages up in every added library first, by a hash of the ShaderStageLoadDesc,
+/// the builtin shader defines and the target, without reading the shader sources.
+/// Stages missing from the libraries go through the binary cache as usual. Debug builds also hash the sources of every
+/// stage found in a library and load it through the binary cache instead when the sources are present and changed
+/// since the library was built.
+/// Libraries must not be added or removed while other threads are loading shaders.
+void addShaderLibrary(Renderer* pRenderer, const ShaderLibraryLoadDesc* pDesc, ShaderLibrary** ppLibrary);
+void removeShaderLibrary(Renderer* pRenderer, ShaderLibrary* pLibrary);
+/// Compiles (or loads from the binary cache) every stage of the given shader permutations and writes them into one
+/// shader library. Meant for an offline build step that runs the application's permutation list against a renderer
+/// of the target API, see Common_3/Tools/ShaderLibraryBuilder. Returns false if a stage failed to compile or the file
+/// could not be written
+bool saveShaderLibrary(Renderer* pRenderer, const ShaderLibrarySaveDesc* pDesc);
 
 /// Save/Load pipeline cache from disk
 void addPipelineCache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, PipelineCache** ppPipelineCache);
 void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, PipelineCacheSaveDesc* pDesc);
+
+/// Creates the pipeline on the resource loader decode threads (ResourceLoaderDesc::mDecodeThreadCount) so that
+/// draw threads do not stall on pipeline compilation. The desc is copied, its pointers can go out of scope.
+/// Raytracing pipelines, pipelines with extensions and renderers that can not create pipelines in parallel
+/// create the pipeline before returning.
+void      addPipelineAsync(Renderer* pRenderer, const PipelineDesc* pDesc, AsyncPipeline** ppAsyncPipeline);
+/// Returns NULL until the pipeline is ready, the caller can skip the draw or use a fallback pipeline meanwhile
+Pipeline* getAsyncPipeline(AsyncPipeline* pAsyncPipeline);
+/// Blocks until the pipeline is ready. Returns NULL if the pipeline failed to compile
+Pipeline* waitForAsyncPipeline(AsyncPipeline* pAsyncPipeline);
+/// Waits for the pipeline and removes it
+void      removeAsyncPipeline(Renderer* pRenderer, AsyncPipeline* pAsyncPipeline);
+
+/// Records the shaders loaded with addShader / addShaders and the pipelines created with addPipeline / addPipelineAsync
+/// until endPipelineRecording, which writes them to a file that replayPipelines uses to warm up the pipeline cache on
+/// the next run, e.g. during a loading screen or on first launch of a new build. Shaders are not recorded on iOS.
+void     beginPipelineRecording();
+/// Call before removing the recorded root signatures. Returns false if the file could not be written
+bool     endPipelineRecording(const PipelineRecordDesc* pDesc);
+/// Loads the recorded shaders and creates every recorded pipeline in parallel on the resource loader decode threads.
+/// The pipelines are removed right away, compiling them only fills pDesc->pCache and the driver caches.
+/// Returns the number of pipelines created
+uint32_t replayPipelines(Renderer* pRenderer, const PipelineReplayDesc* pDesc);
@@ -3336,11 +3336,14 @@ void addComputePipelineImpl(Renderer* pRenderer, const ComputePipelineDesc* pDes
 extern void addRaytracingPipeline(const RaytracingPipelineDesc* pDesc, Pipeline** ppPipeline);
 extern void removeRaytracingPipeline(RaytracingPipeline* pPipeline);
 #endif
+extern void recordPipeline(const PipelineDesc* pDesc);
     
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
     ASSERT(pRenderer);
     ASSERT(pRenderer->pDevice != nil);
+
+    recordPipeline(pDesc);
     
     switch (pDesc->mType)
     {
@@ -4296,16 +4299,22 @@ typedef struct SubresourceDataDesc
 	uint64_t mSrcOffset;
 	uint32_t mMipLevel;
 	uint32_t mArrayLayer;
+	uint32_t mRegionX;
+	uint32_t mRegionY;
+	uint32_t mRegionWidth;
+	uint32_t mRegionHeight;
 	uint32_t mRowPitch;
 	uint32_t mSlicePitch;
 } SubresourceDataDesc;
 
 void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pIntermediate, const SubresourceDataDesc* pSubresourceDesc)
 {
+	const bool region = pSubresourceDesc->mRegionWidth && pSubresourceDesc->mRegionHeight;
 	MTLSize sourceSize = MTLSizeMake(
-			max(1, pTexture->mWidth >> pSubresourceDesc->mMipLevel),
-			max(1, pTexture->mHeight >> pSubresourceDesc->mMipLevel),
+			region ? pSubresourceDesc->mRegionWidth : max(1, pTexture->mWidth >> pSubresourceDesc->mMipLevel),
+			region ? pSubresourceDesc->mRegionHeight : max(1, pTexture->mHeight >> pSubresourceDesc->mMipLevel),
 			max(1, pTexture->mDepth >> pSubresourceDesc->mMipLevel));
+	MTLOrigin destinationOrigin = MTLOriginMake(pSubresourceDesc->mRegionX, pSubresourceDesc->mRegionY, 0);
 	
 #ifdef TARGET_IOS
     uint64_t formatNamespace = (TinyImageFormat_Code((TinyImageFormat)pTexture->mFormat) & ((1 << TinyImageFormat_NAMESPACE_REQUIRED_BITS) - 1));
@@ -4314,8 +4323,8 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pIntermediate, c
 	// PVRTC - replaceRegion is the most straightforward method
 	if (isPvrtc)
 	{
-		MTLRegion region = MTLRegionMake3D(0, 0, 0, sourceSize.width, sourceSize.height, sourceSize.depth);
-		[pTexture->mtlTexture replaceRegion:region mipmapLevel:pSubresourceDesc->mMipLevel withBytes:(uint8_t*)pIntermediate->pCpuMappedAddress + pSubresourceDesc->mSrcOffset bytesPerRow:0];
+		MTLRegion pvrtcRegion = MTLRegionMake3D(destinationOrigin.x, destinationOrigin.y, 0, sourceSize.width, sourceSize.height, sourceSize.depth);
+		[pTexture->mtlTexture replaceRegion:pvrtcRegion mipmapLevel:pSubresourceDesc->mMipLevel withBytes:(uint8_t*)pIntermediate->pCpuMappedAddress + pSubresourceDesc->mSrcOffset bytesPerRow:0];
 		return;
 	}
 #endif
@@ -4335,7 +4344,7 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pIntermediate, c
 							   toTexture:pTexture->mtlTexture
 						destinationSlice:pSubresourceDesc->mArrayLayer
 						destinationLevel:pSubresourceDesc->mMipLevel
-					   destinationOrigin:MTLOriginMake(0, 0, 0)
+					   destinationOrigin:destinationOrigin
 								 options:MTLBlitOptionNone];
 }
 
@@ -0,0 +1,1381 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Headless renderer without a device.
+// Resources are allocated and tracked like on a real backend (CPU accessible buffers get system memory so the
+// resource loader and the middleware can write to them), command buffers only count what gets recorded and all
+// synchronization primitives complete immediately. This makes the CPU side of an application (command recording,
+// descriptor updates, resource loading) measurable on machines without a GPU.
+
+#if defined(NULL_RENDERER)
+#define RENDERER_IMPLEMENTATION
+
+#include "../IRenderer.h"
+#include "../IShaderReflection.h"
+#include "../../OS/Interfaces/ILog.h"
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
+
+#include "../../OS/Interfaces/IMemory.h"
+
+#define SAFE_FREE(p_var)       \
+	if (p_var)                 \
+	{                          \
+		tf_free((void*)p_var); \
+	}
+
+/************************************************************************/
+// Internal structures
+/************************************************************************/
+typedef struct NullDevice
+{
+	Mutex             mStatsMutex;
+	NullRendererStats mStats;
+} NullDevice;
+
+typedef struct SubresourceDataDesc
+{
+	uint64_t mSrcOffset;
+	uint32_t mMipLevel;
+	uint32_t mArrayLayer;
+	uint32_t mRegionX;
+	uint32_t mRegionY;
+	uint32_t mRegionWidth;
+	uint32_t mRegionHeight;
+} SubresourceDataDesc;
+
+/************************************************************************/
+// Internal util functions
+/************************************************************************/
+static uint64_t util_get_surface_size(TinyImageFormat format, uint32_t width, uint32_t height, uint32_t depth)
+{
+	const uint64_t blocksX = (width + TinyImageFormat_WidthOfBlock(format) - 1) / TinyImageFormat_WidthOfBlock(format);
+	const uint64_t blocksY = (height + TinyImageFormat_HeightOfBlock(format) - 1) / TinyImageFormat_HeightOfBlock(format);
+	const uint64_t blocksZ = (depth + TinyImageFormat_DepthOfBlock(format) - 1) / TinyImageFormat_DepthOfBlock(format);
+	return blocksX * blocksY * blocksZ * (TinyImageFormat_BitSizeOfBlock(format) / 8);
+}
+
+static uint64_t util_get_texture_size(const TextureDesc* pDesc)
+{
+	uint64_t size = 0;
+	for (uint32_t mip = 0; mip < pDesc->mMipLevels; ++mip)
+	{
+		size += util_get_surface_size(pDesc->mFormat,
+			max(1u, pDesc->mWidth >> mip), max(1u, pDesc->mHeight >> mip), max(1u, pDesc->mDepth >> mip));
+	}
+	return size * pDesc->mArraySize * max(1u, (uint32_t)pDesc->mSampleCount);
+}
+
+static void util_track_resource(Renderer* pRenderer, uint32_t* pCount, uint64_t* pMemory, int32_t count, int64_t size)
+{
+	NullDevice* pDevice = pRenderer->pNullDevice;
+	MutexLock   lock(pDevice->mStatsMutex);
+	*pCount += count;
+	if (pMemory)
+	{
+		*pMemory += size;
+		pDevice->mStats.mPeakMemory =
+			max(pDevice->mStats.mPeakMemory, pDevice->mStats.mBufferMemory + pDevice->mStats.mTextureMemory);
+	}
+}
+
+static void util_add_command_stats(NullCommandStats* pDst, const NullCommandStats* pSrc)
+{
+	const uint64_t* src = (const uint64_t*)pSrc;
+	uint64_t*       dst = (uint64_t*)pDst;
+	for (uint32_t i = 0; i < sizeof(NullCommandStats) / sizeof(uint64_t); ++i)
+	{
+		dst[i] += src[i];
+	}
+}
+
+/************************************************************************/
+// Functions not exposed in IRenderer but still need to be exported in dll
+/************************************************************************/
+// clang-format off
+API_INTERFACE void FORGE_CALLCONV addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** pp_buffer);
+API_INTERFACE void FORGE_CALLCONV removeBuffer(Renderer* pRenderer, Buffer* pBuffer);
+API_INTERFACE void FORGE_CALLCONV addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture);
+API_INTERFACE void FORGE_CALLCONV removeTexture(Renderer* pRenderer, Texture* pTexture);
+API_INTERFACE void FORGE_CALLCONV mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
+API_INTERFACE void FORGE_CALLCONV unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+API_INTERFACE void FORGE_CALLCONV cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size);
+API_INTERFACE void FORGE_CALLCONV cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pSubresourceDesc);
+API_INTERFACE void FORGE_CALLCONV null_compileShader(Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
+	bool enablePrimitiveId, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint);
+// clang-format on
+/************************************************************************/
+// Internal init functions
+/************************************************************************/
+static void addDevice(Renderer* pRenderer)
+{
+	pRenderer->pNullDevice = (NullDevice*)tf_calloc(1, sizeof(NullDevice));
+	ASSERT(pRenderer->pNullDevice);
+	pRenderer->pNullDevice->mStatsMutex.Init();
+
+	pRenderer->pActiveGpuSettings = (GPUSettings*)tf_calloc(1, sizeof(GPUSettings));
+	ASSERT(pRenderer->pActiveGpuSettings);
+
+	// Report the most permissive limits of the real backends so applications take their full featured paths
+	GPUSettings* pSettings = pRenderer->pActiveGpuSettings;
+	pSettings->mUniformBufferAlignment = 256;
+	pSettings->mUploadBufferTextureAlignment = 512;
+	pSettings->mUploadBufferTextureRowAlignment = 256;
+	pSettings->mMaxVertexInputBindings = MAX_VERTEX_BINDINGS;
+	pSettings->mMaxRootSignatureDWORDS = 64;
+	pSettings->mWaveLaneCount = 32;
+	pSettings->mWaveOpsSupportFlags = WAVE_OPS_SUPPORT_FLAG_ALL;
+	pSettings->mMultiDrawIndirect = 1;
+	pSettings->mROVsSupported = 1;
+	pSettings->mTessellationSupported = 1;
+	pSettings->mGeometryShaderSupported = 1;
+
+	GPUVendorPreset& gpuVendorPreset = pSettings->mGpuVendorPreset;
+	strcpy(gpuVendorPreset.mVendorId, "0x0000");
+	strcpy(gpuVendorPreset.mModelId, "0x0000");
+	strcpy(gpuVendorPreset.mRevisionId, "0x00");
+	strcpy(gpuVendorPreset.mGpuName, "Null Renderer");
+	strcpy(gpuVendorPreset.mGpuDriverVersion, "0");
+	gpuVendorPreset.mPresetLevel = GPU_PRESET_ULTRA;
+
+	pRenderer->pCapBits = (GPUCapBits*)tf_calloc(1, sizeof(GPUCapBits));
+	ASSERT(pRenderer->pCapBits);
+	memset(pRenderer->pCapBits, 1, sizeof(GPUCapBits));
+
+	pRenderer->mLinkedNodeCount = 1;
+	pRenderer->mGpuMode = GPU_MODE_SINGLE;
+}
+
+static void removeDevice(Renderer* pRenderer)
+{
+	NullRendererStats& stats = pRenderer->pNullDevice->mStats;
+	if (stats.mBufferCount || stats.mTextureCount || stats.mRenderTargetCount || stats.mShaderCount || stats.mPipelineCount ||
+		stats.mDescriptorSetCount)
+	{
+		LOGF(LogLevel::eWARNING,
+			"Null renderer removed with live resources: %u buffers, %u textures, %u render targets, %u shaders, %u pipelines, %u descriptor sets",
+			stats.mBufferCount, stats.mTextureCount, stats.mRenderTargetCount, stats.mShaderCount, stats.mPipelineCount,
+			stats.mDescriptorSetCount);
+	}
+
+	pRenderer->pNullDevice->mStatsMutex.Destroy();
+	SAFE_FREE(pRenderer->pNullDevice);
+	SAFE_FREE(pRenderer->pCapBits);
+	SAFE_FREE(pRenderer->pActiveGpuSettings);
+}
+/************************************************************************/
+// Renderer Init Remove
+/************************************************************************/
+void initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppRenderer)
+{
+	ASSERT(ppRenderer);
+	ASSERT(pDesc);
+
+	Renderer* pRenderer = (Renderer*)tf_calloc_memalign(1, alignof(Renderer), sizeof(Renderer));
+	ASSERT(pRenderer);
+
+	LOGF(LogLevel::eINFO, "Using Null renderer");
+
+	pRenderer->mGpuMode = pDesc->mGpuMode;
+	pRenderer->mShaderTarget = pDesc->mShaderTarget;
+	pRenderer->mEnableGpuBasedValidation = pDesc->mEnableGPUBasedValidation;
+	pRenderer->mApi = RENDERER_API_NULL;
+
+	pRenderer->pName = (char*)tf_calloc(strlen(appName) + 1, sizeof(char));
+	strcpy(pRenderer->pName, appName);
+
+	addDevice(pRenderer);
+
+	// Renderer is good!
+	*ppRenderer = pRenderer;
+}
+
+void removeRenderer(Renderer* pRenderer)
+{
+	ASSERT(pRenderer);
+
+	removeDevice(pRenderer);
+
+	SAFE_FREE(pRenderer->pName);
+	SAFE_FREE(pRenderer);
+}
+/************************************************************************/
+// Resource Creation Functions
+/************************************************************************/
+void addFence(Renderer* pRenderer, Fence** ppFence)
+{
+	ASSERT(pRenderer);
+	ASSERT(ppFence);
+
+	Fence* pFence = (Fence*)tf_calloc(1, sizeof(Fence));
+	ASSERT(pFence);
+
+	*ppFence = pFence;
+}
+
+void removeFence(Renderer* pRenderer, Fence* pFence)
+{
+	ASSERT(pRenderer);
+	ASSERT(pFence);
+
+	SAFE_FREE(pFence);
+}
+
+void addSemaphore(Renderer* pRenderer, Semaphore** ppSemaphore)
+{
+	ASSERT(pRenderer);
+	ASSERT(ppSemaphore);
+
+	Semaphore* pSemaphore = (Semaphore*)tf_calloc(1, sizeof(Semaphore));
+	ASSERT(pSemaphore);
+
+	*ppSemaphore = pSemaphore;
+}
+
+void removeSemaphore(Renderer* pRenderer, Semaphore* pSemaphore)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSemaphore);
+
+	SAFE_FREE(pSemaphore);
+}
+
+void addQueue(Renderer* pRenderer, QueueDesc* pDesc, Queue** ppQueue)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppQueue);
+
+	Queue* pQueue = (Queue*)tf_calloc(1, sizeof(Queue));
+	ASSERT(pQueue);
+
+	pQueue->pRenderer = pRenderer;
+	pQueue->mType = pDesc->mType;
+	pQueue->mNodeIndex = pDesc->mNodeIndex;
+
+	*ppQueue = pQueue;
+}
+
+void removeQueue(Renderer* pRenderer, Queue* pQueue)
+{
+	ASSERT(pRenderer);
+	ASSERT(pQueue);
+
+	SAFE_FREE(pQueue);
+}
+
+void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppSwapChain);
+	ASSERT(pDesc->mImageCount <= MAX_SWAPCHAIN_IMAGES);
+
+	SwapChain* pSwapChain = (SwapChain*)tf_calloc(1, sizeof(SwapChain) + pDesc->mImageCount * sizeof(RenderTarget*));
+	ASSERT(pSwapChain);
+
+	pSwapChain->ppRenderTargets = (RenderTarget**)(pSwapChain + 1);
+
+	// The window handle is ignored, back buffers are plain render targets
+	RenderTargetDesc descColor = {};
+	descColor.mWidth = pDesc->mWidth;
+	descColor.mHeight = pDesc->mHeight;
+	descColor.mDepth = 1;
+	descColor.mArraySize = 1;
+	descColor.mFormat = pDesc->mColorFormat;
+	descColor.mClearValue = pDesc->mColorClearValue;
+	descColor.mSampleCount = SAMPLE_COUNT_1;
+	descColor.mSampleQuality = 0;
+	descColor.mStartState = RESOURCE_STATE_PRESENT;
+	descColor.mFlags |= TEXTURE_CREATION_FLAG_ALLOW_DISPLAY_TARGET;
+
+	for (uint32_t i = 0; i < pDesc->mImageCount; ++i)
+	{
+		addRenderTarget(pRenderer, &descColor, &pSwapChain->ppRenderTargets[i]);
+	}
+
+	pSwapChain->mImageCount = pDesc->mImageCount;
+	pSwapChain->mImageIndex = 0;
+	pSwapChain->mEnableVsync = pDesc->mEnableVsync;
+
+	*ppSwapChain = pSwapChain;
+}
+
+void removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSwapChain);
+
+	for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+	{
+		removeRenderTarget(pRenderer, pSwapChain->ppRenderTargets[i]);
+	}
+
+	SAFE_FREE(pSwapChain);
+}
+/************************************************************************/
+// Command Pool Functions
+/************************************************************************/
+void addCmdPool(Renderer* pRenderer, const CmdPoolDesc* pDesc, CmdPool** ppCmdPool)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppCmdPool);
+
+	CmdPool* pCmdPool = (CmdPool*)tf_calloc(1, sizeof(CmdPool));
+	ASSERT(pCmdPool);
+
+	pCmdPool->pQueue = pDesc->pQueue;
+
+	*ppCmdPool = pCmdPool;
+}
+
+void removeCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
+{
+	ASSERT(pRenderer);
+	ASSERT(pCmdPool);
+
+	SAFE_FREE(pCmdPool);
+}
+
+void addCmd(Renderer* pRenderer, const CmdDesc* pDesc, Cmd** ppCmd)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc->pPool);
+	ASSERT(ppCmd);
+
+	Cmd* pCmd = (Cmd*)tf_calloc_memalign(1, alignof(Cmd), sizeof(Cmd));
+	ASSERT(pCmd);
+
+	pCmd->pRenderer = pRenderer;
+	pCmd->pQueue = pDesc->pPool->pQueue;
+
+	*ppCmd = pCmd;
+}
+
+void removeCmd(Renderer* pRenderer, Cmd* pCmd)
+{
+	ASSERT(pRenderer);
+	ASSERT(pCmd);
+
+	SAFE_FREE(pCmd);
+}
+
+void addCmd_n(Renderer* pRenderer, const CmdDesc* pDesc, uint32_t cmdCount, Cmd*** pppCmd)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(cmdCount);
+	ASSERT(pppCmd);
+
+	Cmd** ppCmds = (Cmd**)tf_calloc(cmdCount, sizeof(Cmd*));
+	ASSERT(ppCmds);
+
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		::addCmd(pRenderer, pDesc, &ppCmds[i]);
+	}
+
+	*pppCmd = ppCmds;
+}
+
+void removeCmd_n(Renderer* pRenderer, uint32_t cmdCount, Cmd** ppCmds)
+{
+	ASSERT(ppCmds);
+
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		removeCmd(pRenderer, ppCmds[i]);
+	}
+
+	SAFE_FREE(ppCmds);
+}
+/************************************************************************/
+// All buffer, texture loading handled by resource system -> IResourceLoader.
+/************************************************************************/
+void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppRenderTarget);
+
+	const bool isDepth = TinyImageFormat_IsDepthOnly(pDesc->mFormat) || TinyImageFormat_IsDepthAndStencil(pDesc->mFormat);
+	ASSERT(!((isDepth) && (pDesc->mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE)) && "Cannot use depth stencil as UAV");
+
+	RenderTarget* pRenderTarget = (RenderTarget*)tf_calloc_memalign(1, alignof(RenderTarget), sizeof(RenderTarget));
+	ASSERT(pRenderTarget);
+
+	TextureDesc textureDesc = {};
+	textureDesc.mFlags = pDesc->mFlags;
+	textureDesc.mWidth = pDesc->mWidth;
+	textureDesc.mHeight = pDesc->mHeight;
+	textureDesc.mDepth = max(1u, pDesc->mDepth);
+	textureDesc.mArraySize = max(1u, pDesc->mArraySize);
+	textureDesc.mMipLevels = max(1u, pDesc->mMipLevels);
+	textureDesc.mSampleCount = pDesc->mSampleCount;
+	textureDesc.mSampleQuality = pDesc->mSampleQuality;
+	textureDesc.mFormat = pDesc->mFormat;
+	textureDesc.mClearValue = pDesc->mClearValue;
+	textureDesc.mStartState = pDesc->mStartState;
+	textureDesc.mDescriptors = pDesc->mDescriptors;
+	textureDesc.pName = pDesc->pName;
+	textureDesc.mNodeIndex = pDesc->mNodeIndex;
+	addTexture(pRenderer, &textureDesc, &pRenderTarget->pTexture);
+
+	pRenderTarget->mWidth = pDesc->mWidth;
+	pRenderTarget->mHeight = pDesc->mHeight;
+	pRenderTarget->mArraySize = textureDesc.mArraySize;
+	pRenderTarget->mDepth = textureDesc.mDepth;
+	pRenderTarget->mMipLevels = textureDesc.mMipLevels;
+	pRenderTarget->mSampleCount = pDesc->mSampleCount;
+	pRenderTarget->mSampleQuality = pDesc->mSampleQuality;
+	pRenderTarget->mFormat = pDesc->mFormat;
+	pRenderTarget->mClearValue = pDesc->mClearValue;
+	pRenderTarget->mDescriptors = pDesc->mDescriptors;
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mRenderTargetCount, NULL, 1, 0);
+
+	*ppRenderTarget = pRenderTarget;
+}
+
+void removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
+{
+	ASSERT(pRenderer);
+	ASSERT(pRenderTarget);
+
+	removeTexture(pRenderer, pRenderTarget->pTexture);
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mRenderTargetCount, NULL, -1, 0);
+
+	SAFE_FREE(pRenderTarget);
+}
+
+void addSampler(Renderer* pRenderer, const SamplerDesc* pDesc, Sampler** ppSampler)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppSampler);
+
+	Sampler* pSampler = (Sampler*)tf_calloc_memalign(1, alignof(Sampler), sizeof(Sampler));
+	ASSERT(pSampler);
+
+	*ppSampler = pSampler;
+}
+
+void removeSampler(Renderer* pRenderer, Sampler* pSampler)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSampler);
+
+	SAFE_FREE(pSampler);
+}
+/************************************************************************/
+// Shader Functions
+/************************************************************************/
+void null_compileShader(
+	Renderer* pRenderer, ShaderTarget shaderTarget, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
+	bool, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint)
+{
+	ASSERT(code);
+	ASSERT(codeSize > 0);
+	ASSERT(pOut);
+
+	// There is no compiler, the preprocessed source is passed on as "bytecode"
+	pOut->pByteCode = tf_malloc(codeSize);
+	memcpy(pOut->pByteCode, code, codeSize);
+	pOut->mByteCodeSize = codeSize;
+}
+
+void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->mStages);
+	ASSERT(ppShaderProgram);
+
+	Shader* pShaderProgram = (Shader*)tf_calloc(1, sizeof(Shader) + sizeof(PipelineReflection));
+	ASSERT(pShaderProgram);
+
+	pShaderProgram->mStages = pDesc->mStages;
+	// Without reflection the thread group size is unknown, one keeps dispatch size calculations well defined
+	pShaderProgram->mNumThreadsPerGroup[0] = 1;
+	pShaderProgram->mNumThreadsPerGroup[1] = 1;
+	pShaderProgram->mNumThreadsPerGroup[2] = 1;
+	pShaderProgram->pReflection = (PipelineReflection*)(pShaderProgram + 1);
+	pShaderProgram->pReflection->mShaderStages = pDesc->mStages;
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mShaderCount, NULL, 1, 0);
+
+	*ppShaderProgram = pShaderProgram;
+}
+
+void removeShader(Renderer* pRenderer, Shader* pShaderProgram)
+{
+	ASSERT(pRenderer);
+	ASSERT(pShaderProgram);
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mShaderCount, NULL, -1, 0);
+
+	SAFE_FREE(pShaderProgram);
+}
+/************************************************************************/
+// Buffer Functions
+/************************************************************************/
+void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->mSize > 0);
+	ASSERT(ppBuffer);
+
+	Buffer* pBuffer = (Buffer*)tf_calloc_memalign(1, alignof(Buffer), sizeof(Buffer));
+	ASSERT(pBuffer);
+
+	uint64_t allocationSize = pDesc->mSize;
+	if (pDesc->mDescriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+	{
+		allocationSize = round_up_64(allocationSize, pRenderer->pActiveGpuSettings->mUniformBufferAlignment);
+	}
+
+	if (pDesc->mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY)
+	{
+		pBuffer->pNullMemory = tf_memalign(max(16u, pDesc->mAlignment), (size_t)allocationSize);
+		ASSERT(pBuffer->pNullMemory);
+		if (pDesc->mFlags & BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT)
+		{
+			pBuffer->pCpuMappedAddress = pBuffer->pNullMemory;
+		}
+	}
+
+	pBuffer->mSize = (uint32_t)pDesc->mSize;
+	pBuffer->mMemoryUsage = pDesc->mMemoryUsage;
+	pBuffer->mNodeIndex = pDesc->mNodeIndex;
+	pBuffer->mDescriptors = pDesc->mDescriptors;
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mBufferCount, &pRenderer->pNullDevice->mStats.mBufferMemory, 1,
+		(int64_t)allocationSize);
+
+	*ppBuffer = pBuffer;
+}
+
+void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+	ASSERT(pRenderer);
+	ASSERT(pBuffer);
+
+	uint64_t allocationSize = pBuffer->mSize;
+	if (pBuffer->mDescriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+	{
+		allocationSize = round_up_64(allocationSize, pRenderer->pActiveGpuSettings->mUniformBufferAlignment);
+	}
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mBufferCount, &pRenderer->pNullDevice->mStats.mBufferMemory, -1,
+		-(int64_t)allocationSize);
+
+	SAFE_FREE(pBuffer->pNullMemory);
+	SAFE_FREE(pBuffer);
+}
+
+void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange)
+{
+	ASSERT(pBuffer);
+	ASSERT(pBuffer->mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY && "Trying to map non-cpu accessible resource");
+
+	pBuffer->pCpuMappedAddress = pBuffer->pNullMemory;
+}
+
+void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+	ASSERT(pBuffer);
+	ASSERT(pBuffer->mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY && "Trying to unmap non-cpu accessible resource");
+
+	pBuffer->pCpuMappedAddress = NULL;
+}
+/************************************************************************/
+// Texture Functions
+/************************************************************************/
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
+	ASSERT(ppTexture);
+
+	if (pDesc->mSampleCount > SAMPLE_COUNT_1 && pDesc->mMipLevels > 1)
+	{
+		LOGF(LogLevel::eERROR, "Multi-Sampled textures cannot have mip maps");
+		ASSERT(false);
+		return;
+	}
+
+	Texture* pTexture = (Texture*)tf_calloc_memalign(1, alignof(Texture), sizeof(Texture));
+	ASSERT(pTexture);
+
+	pTexture->mAllocationSize = util_get_texture_size(pDesc);
+	pTexture->mNodeIndex = pDesc->mNodeIndex;
+	pTexture->mMipLevels = pDesc->mMipLevels;
+	pTexture->mWidth = pDesc->mWidth;
+	pTexture->mHeight = pDesc->mHeight;
+	pTexture->mDepth = pDesc->mDepth;
+	pTexture->mArraySizeMinusOne = pDesc->mArraySize - 1;
+	pTexture->mFormat = pDesc->mFormat;
+	pTexture->mUav = (pDesc->mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE) ? 1 : 0;
+	pTexture->mOwnsImage = pDesc->pNativeHandle ? 0 : 1;
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mTextureCount, &pRenderer->pNullDevice->mStats.mTextureMemory, 1,
+		(int64_t)pTexture->mAllocationSize);
+
+	*ppTexture = pTexture;
+}
+
+void removeTexture(Renderer* pRenderer, Texture* pTexture)
+{
+	ASSERT(pRenderer);
+	ASSERT(pTexture);
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mTextureCount, &pRenderer->pNullDevice->mStats.mTextureMemory, -1,
+		-(int64_t)pTexture->mAllocationSize);
+
+	SAFE_FREE(pTexture);
+}
+/************************************************************************/
+// Pipeline Functions
+/************************************************************************/
+void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatureDesc, RootSignature** ppRootSignature)
+{
+	ASSERT(pRenderer);
+	ASSERT(pRootSignatureDesc);
+	ASSERT(ppRootSignature);
+
+	// Shaders carry no reflection, so the layout is empty and descriptors are never looked up by name
+	RootSignature* pRootSignature = (RootSignature*)tf_calloc_memalign(1, alignof(RootSignature), sizeof(RootSignature));
+	ASSERT(pRootSignature);
+
+	pRootSignature->mPipelineType = PIPELINE_TYPE_GRAPHICS;
+	for (uint32_t i = 0; i < pRootSignatureDesc->mShaderCount; ++i)
+	{
+		if (pRootSignatureDesc->ppShaders[i]->mStages & SHADER_STAGE_COMP)
+			pRootSignature->mPipelineType = PIPELINE_TYPE_COMPUTE;
+		else if (pRootSignatureDesc->ppShaders[i]->mStages & SHADER_STAGE_RAYTRACING)
+			pRootSignature->mPipelineType = PIPELINE_TYPE_RAYTRACING;
+	}
+
+	*ppRootSignature = pRootSignature;
+}
+
+void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
+{
+	ASSERT(pRenderer);
+	ASSERT(pRootSignature);
+
+	SAFE_FREE(pRootSignature);
+}
+
+extern void recordPipeline(const PipelineDesc* pDesc);
+
+void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppPipeline);
+
+	recordPipeline(pDesc);
+
+	Pipeline* pPipeline = (Pipeline*)tf_calloc_memalign(1, alignof(Pipeline), sizeof(Pipeline));
+	ASSERT(pPipeline);
+
+	pPipeline->mType = pDesc->mType;
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mPipelineCount, NULL, 1, 0);
+
+	*ppPipeline = pPipeline;
+}
+
+void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
+{
+	ASSERT(pRenderer);
+	ASSERT(pPipeline);
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mPipelineCount, NULL, -1, 0);
+
+	SAFE_FREE(pPipeline);
+}
+
+void addPipelineCache(Renderer* pRenderer, const PipelineCacheDesc* pDesc, PipelineCache** ppPipelineCache)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppPipelineCache);
+
+	PipelineCache* pPipelineCache = (PipelineCache*)tf_calloc(1, sizeof(PipelineCache));
+	ASSERT(pPipelineCache);
+
+	*ppPipelineCache = pPipelineCache;
+}
+
+void removePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache)
+{
+	ASSERT(pRenderer);
+	ASSERT(pPipelineCache);
+
+	SAFE_FREE(pPipelineCache);
+}
+
+void getPipelineCacheData(Renderer* pRenderer, PipelineCache* pPipelineCache, size_t* pSize, void* pData)
+{
+	ASSERT(pSize);
+
+	*pSize = 0;
+}
+/************************************************************************/
+// Descriptor Set Implementation
+/************************************************************************/
+void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppDescriptorSet);
+
+	DescriptorSet* pDescriptorSet = (DescriptorSet*)tf_calloc_memalign(1, alignof(DescriptorSet), sizeof(DescriptorSet));
+	ASSERT(pDescriptorSet);
+
+	pDescriptorSet->pRootSignature = pDesc->pRootSignature;
+	pDescriptorSet->mMaxSets = pDesc->mMaxSets;
+	pDescriptorSet->mUpdateFrequency = (uint8_t)pDesc->mUpdateFrequency;
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mDescriptorSetCount, NULL, 1, 0);
+
+	*ppDescriptorSet = pDescriptorSet;
+}
+
+void removeDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDescriptorSet);
+
+	util_track_resource(pRenderer, &pRenderer->pNullDevice->mStats.mDescriptorSetCount, NULL, -1, 0);
+
+	SAFE_FREE(pDescriptorSet);
+}
+
+void updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDescriptorSet, uint32_t count, const DescriptorData* pParams)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDescriptorSet);
+	ASSERT(index < pDescriptorSet->mMaxSets);
+	ASSERT(!count || pParams);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		ASSERT((pParams[i].pName || pParams[i].mIndex != (uint32_t)-1) && "Descriptor needs a name or an index");
+		ASSERT((pParams[i].ppTextures || pParams[i].mExtractBuffer) && "Descriptor has no resources");
+	}
+
+	NullDevice* pDevice = pRenderer->pNullDevice;
+	MutexLock   lock(pDevice->mStatsMutex);
+	pDevice->mStats.mDescriptorUpdateCount += count;
+}
+/************************************************************************/
+// Command buffer Functions
+/************************************************************************/
+void resetCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
+{
+	ASSERT(pRenderer);
+	ASSERT(pCmdPool);
+}
+
+void beginCmd(Cmd* pCmd)
+{
+	ASSERT(pCmd);
+
+	pCmd->mStats = {};
+}
+
+void endCmd(Cmd* pCmd)
+{
+	ASSERT(pCmd);
+}
+
+void cmdBindRenderTargets(
+	Cmd* pCmd, uint32_t renderTargetCount, RenderTarget** ppRenderTargets, RenderTarget* pDepthStencil, const LoadActionsDesc* pLoadActions,
+	uint32_t* pColorArraySlices, uint32_t* pColorMipSlices, uint32_t depthArraySlice, uint32_t depthMipSlice)
+{
+	ASSERT(pCmd);
+	ASSERT(!renderTargetCount || ppRenderTargets);
+
+	++pCmd->mStats.mCommandCount;
+	pCmd->mStats.mRenderTargetBindCount += renderTargetCount + (pDepthStencil ? 1 : 0);
+}
+
+void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, float minDepth, float maxDepth)
+{
+	ASSERT(pCmd);
+	ASSERT(width > 0.0f && height > 0.0f);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdSetStencilReferenceValue(Cmd* pCmd, uint32_t val)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
+{
+	ASSERT(pCmd);
+	ASSERT(pPipeline);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mPipelineBindCount;
+}
+
+void cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorSet)
+{
+	ASSERT(pCmd);
+	ASSERT(pDescriptorSet);
+	ASSERT(index < pDescriptorSet->mMaxSets);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mDescriptorSetBindCount;
+}
+
+void cmdBindPushConstants(Cmd* pCmd, RootSignature* pRootSignature, const char* pName, const void* pConstants)
+{
+	ASSERT(pCmd);
+	ASSERT(pRootSignature);
+	ASSERT(pName);
+	ASSERT(pConstants);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mPushConstantCount;
+}
+
+void cmdBindPushConstantsByIndex(Cmd* pCmd, RootSignature* pRootSignature, uint32_t paramIndex, const void* pConstants)
+{
+	ASSERT(pCmd);
+	ASSERT(pRootSignature);
+	ASSERT(pConstants);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mPushConstantCount;
+}
+
+void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer, uint32_t indexType, uint64_t offset)
+{
+	ASSERT(pCmd);
+	ASSERT(pBuffer);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdBindVertexBuffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers, const uint32_t* pStrides, const uint64_t* pOffsets)
+{
+	ASSERT(pCmd);
+	ASSERT(bufferCount);
+	ASSERT(ppBuffers);
+
+	++pCmd->mStats.mCommandCount;
+	pCmd->mStats.mVertexBufferBindCount += bufferCount;
+}
+
+void cmdDraw(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mDrawCount;
+	pCmd->mStats.mVertexCount += vertexCount;
+}
+
+void cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex, uint32_t instanceCount, uint32_t firstInstance)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mDrawCount;
+	pCmd->mStats.mVertexCount += (uint64_t)vertexCount * instanceCount;
+}
+
+void cmdDrawIndexed(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t firstVertex)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mDrawCount;
+	pCmd->mStats.mVertexCount += indexCount;
+}
+
+void cmdDrawIndexedInstanced(
+	Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mDrawCount;
+	pCmd->mStats.mVertexCount += (uint64_t)indexCount * instanceCount;
+}
+
+void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mDispatchCount;
+}
+
+void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size)
+{
+	ASSERT(pCmd);
+	ASSERT(pBuffer);
+	ASSERT(pSrcBuffer);
+	ASSERT(pSrcBuffer->pNullMemory);
+	ASSERT(srcOffset + size <= pSrcBuffer->mSize);
+	ASSERT(dstOffset + size <= pBuffer->mSize);
+
+	// Readback and CPU visible destinations have memory, keep their contents correct
+	if (pBuffer->pNullMemory)
+	{
+		memcpy((uint8_t*)pBuffer->pNullMemory + dstOffset, (uint8_t*)pSrcBuffer->pNullMemory + srcOffset, (size_t)size);
+	}
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mCopyCount;
+	pCmd->mStats.mCopySize += size;
+}
+
+void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pSubresourceDesc)
+{
+	ASSERT(pCmd);
+	ASSERT(pTexture);
+	ASSERT(pSrcBuffer);
+	ASSERT(pSubresourceDesc);
+	ASSERT(pSubresourceDesc->mMipLevel < pTexture->mMipLevels);
+
+	const uint32_t mip = pSubresourceDesc->mMipLevel;
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mCopyCount;
+	const bool region = pSubresourceDesc->mRegionWidth && pSubresourceDesc->mRegionHeight;
+	pCmd->mStats.mCopySize += util_get_surface_size((TinyImageFormat)pTexture->mFormat,
+		region ? pSubresourceDesc->mRegionWidth : max(1u, (uint32_t)pTexture->mWidth >> mip),
+		region ? pSubresourceDesc->mRegionHeight : max(1u, (uint32_t)pTexture->mHeight >> mip), max(1u, (uint32_t)pTexture->mDepth >> mip));
+}
+/************************************************************************/
+// Transition Commands
+/************************************************************************/
+void cmdResourceBarrier(
+	Cmd* pCmd, uint32_t numBufferBarriers, BufferBarrier* pBufferBarriers, uint32_t numTextureBarriers, TextureBarrier* pTextureBarriers,
+	uint32_t numRtBarriers, RenderTargetBarrier* pRtBarriers)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+	pCmd->mStats.mBarrierCount += numBufferBarriers + numTextureBarriers + numRtBarriers;
+}
+/************************************************************************/
+// Virtual Textures
+/************************************************************************/
+void cmdUpdateVirtualTexture(Cmd* pCmd, Texture* pTexture)
+{
+	ASSERT(pCmd);
+	ASSERT(pTexture);
+
+	++pCmd->mStats.mCommandCount;
+}
+/************************************************************************/
+// Queue Fence Semaphore Functions
+/************************************************************************/
+void acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSignalSemaphore, Fence* pFence, uint32_t* pSwapChainImageIndex)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSwapChain);
+	ASSERT(pSwapChainImageIndex);
+
+	pSwapChain->mImageIndex = (pSwapChain->mImageIndex + 1) % pSwapChain->mImageCount;
+	*pSwapChainImageIndex = pSwapChain->mImageIndex;
+
+	if (pSignalSemaphore)
+	{
+		pSignalSemaphore->mSignaled = true;
+	}
+	if (pFence)
+	{
+		pFence->mSubmitted = true;
+	}
+}
+
+void queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc)
+{
+	ASSERT(pQueue);
+	ASSERT(pDesc);
+	ASSERT(pDesc->mCmdCount > 0);
+	ASSERT(pDesc->ppCmds);
+
+	for (uint32_t i = 0; i < pDesc->mWaitSemaphoreCount; ++i)
+	{
+		pDesc->ppWaitSemaphores[i]->mSignaled = false;
+	}
+	for (uint32_t i = 0; i < pDesc->mSignalSemaphoreCount; ++i)
+	{
+		pDesc->ppSignalSemaphores[i]->mSignaled = true;
+	}
+	// Nothing executes, the work is complete as soon as it is submitted
+	if (pDesc->pSignalFence)
+	{
+		pDesc->pSignalFence->mSubmitted = true;
+	}
+
+	NullDevice* pDevice = pQueue->pRenderer->pNullDevice;
+	MutexLock   lock(pDevice->mStatsMutex);
+	for (uint32_t i = 0; i < pDesc->mCmdCount; ++i)
+	{
+		util_add_command_stats(&pDevice->mStats.mSubmitted, &pDesc->ppCmds[i]->mStats);
+	}
+	++pDevice->mStats.mSubmitCount;
+}
+
+PresentStatus queuePresent(Queue* pQueue, const QueuePresentDesc* pDesc)
+{
+	ASSERT(pQueue);
+	ASSERT(pDesc);
+
+	for (uint32_t i = 0; i < pDesc->mWaitSemaphoreCount; ++i)
+	{
+		pDesc->ppWaitSemaphores[i]->mSignaled = false;
+	}
+
+	NullDevice* pDevice = pQueue->pRenderer->pNullDevice;
+	MutexLock   lock(pDevice->mStatsMutex);
+	++pDevice->mStats.mPresentCount;
+
+	return PRESENT_STATUS_SUCCESS;
+}
+
+void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus)
+{
+	ASSERT(pFence);
+	ASSERT(pFenceStatus);
+
+	*pFenceStatus = pFence->mSubmitted ? FENCE_STATUS_COMPLETE : FENCE_STATUS_NOTSUBMITTED;
+	pFence->mSubmitted = false;
+}
+
+void waitForFences(Renderer* pRenderer, uint32_t fenceCount, Fence** ppFences)
+{
+	ASSERT(pRenderer);
+	ASSERT(fenceCount);
+	ASSERT(ppFences);
+
+	for (uint32_t i = 0; i < fenceCount; ++i)
+	{
+		ppFences[i]->mSubmitted = false;
+	}
+}
+
+void waitQueueIdle(Queue* pQueue)
+{
+	ASSERT(pQueue);
+}
+
+void toggleVSync(Renderer* pRenderer, SwapChain** ppSwapChain)
+{
+	ASSERT(ppSwapChain && *ppSwapChain);
+
+	(*ppSwapChain)->mEnableVsync = !(*ppSwapChain)->mEnableVsync;
+}
+/************************************************************************/
+// Utility functions
+/************************************************************************/
+TinyImageFormat getRecommendedSwapchainFormat(bool hintHDR)
+{
+	return hintHDR ? TinyImageFormat_R10G10B10A2_UNORM : TinyImageFormat_B8G8R8A8_UNORM;
+}
+/************************************************************************/
+// Indirect Draw functions
+/************************************************************************/
+void addIndirectCommandSignature(Renderer* pRenderer, const CommandSignatureDesc* pDesc, CommandSignature** ppCommandSignature)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->mIndirectArgCount);
+	ASSERT(ppCommandSignature);
+
+	CommandSignature* pCommandSignature = (CommandSignature*)tf_calloc(1, sizeof(CommandSignature));
+	ASSERT(pCommandSignature);
+
+	uint32_t stride = 0;
+	for (uint32_t i = 0; i < pDesc->mIndirectArgCount; ++i)
+	{
+		switch (pDesc->pArgDescs[i].mType)
+		{
+		case INDIRECT_DRAW:
+			pCommandSignature->mDrawType = INDIRECT_DRAW;
+			stride += sizeof(IndirectDrawArguments);
+			break;
+		case INDIRECT_DRAW_INDEX:
+			pCommandSignature->mDrawType = INDIRECT_DRAW_INDEX;
+			stride += sizeof(IndirectDrawIndexArguments);
+			break;
+		case INDIRECT_DISPATCH:
+			pCommandSignature->mDrawType = INDIRECT_DISPATCH;
+			stride += sizeof(IndirectDispatchArguments);
+			break;
+		default:
+			// Root constants, descriptor tables and buffer bindings
+			stride += sizeof(uint32_t);
+			break;
+		}
+	}
+
+	pCommandSignature->mStride = pDesc->mPacked ? stride : round_up(stride, 16);
+
+	*ppCommandSignature = pCommandSignature;
+}
+
+void removeIndirectCommandSignature(Renderer* pRenderer, CommandSignature* pCommandSignature)
+{
+	ASSERT(pRenderer);
+	ASSERT(pCommandSignature);
+
+	SAFE_FREE(pCommandSignature);
+}
+
+void cmdExecuteIndirect(
+	Cmd* pCmd, CommandSignature* pCommandSignature, uint maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset,
+	Buffer* pCounterBuffer, uint64_t counterBufferOffset)
+{
+	ASSERT(pCmd);
+	ASSERT(pCommandSignature);
+	ASSERT(pIndirectBuffer);
+
+	++pCmd->mStats.mCommandCount;
+	++pCmd->mStats.mExecuteIndirectCount;
+}
+/************************************************************************/
+// GPU Query Implementation
+/************************************************************************/
+void getTimestampFrequency(Queue* pQueue, double* pFrequency)
+{
+	ASSERT(pQueue);
+	ASSERT(pFrequency);
+
+	// Resolved timestamps are all zero, any non zero frequency yields zero GPU time
+	*pFrequency = 1000000.0;
+}
+
+void addQueryPool(Renderer* pRenderer, const QueryPoolDesc* pDesc, QueryPool** ppQueryPool)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppQueryPool);
+
+	QueryPool* pQueryPool = (QueryPool*)tf_calloc(1, sizeof(QueryPool));
+	ASSERT(pQueryPool);
+
+	pQueryPool->mType = pDesc->mType;
+	pQueryPool->mCount = pDesc->mQueryCount;
+
+	*ppQueryPool = pQueryPool;
+}
+
+void removeQueryPool(Renderer* pRenderer, QueryPool* pQueryPool)
+{
+	ASSERT(pRenderer);
+	ASSERT(pQueryPool);
+
+	SAFE_FREE(pQueryPool);
+}
+
+void cmdResetQueryPool(Cmd* pCmd, QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount)
+{
+	ASSERT(pCmd);
+	ASSERT(pQueryPool);
+	ASSERT(startQuery + queryCount <= pQueryPool->mCount);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdBeginQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
+{
+	ASSERT(pCmd);
+	ASSERT(pQueryPool);
+	ASSERT(pQuery && pQuery->mIndex < pQueryPool->mCount);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdEndQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
+{
+	ASSERT(pCmd);
+	ASSERT(pQueryPool);
+	ASSERT(pQuery && pQuery->mIndex < pQueryPool->mCount);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPool, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount)
+{
+	ASSERT(pCmd);
+	ASSERT(pQueryPool);
+	ASSERT(pReadbackBuffer);
+	ASSERT(startQuery + queryCount <= pQueryPool->mCount);
+
+	const uint64_t offset = startQuery * sizeof(uint64_t);
+	const uint64_t size = queryCount * sizeof(uint64_t);
+	if (pReadbackBuffer->pNullMemory && offset + size <= pReadbackBuffer->mSize)
+	{
+		memset((uint8_t*)pReadbackBuffer->pNullMemory + offset, 0, (size_t)size);
+	}
+
+	++pCmd->mStats.mCommandCount;
+}
+/************************************************************************/
+// Memory Stats Implementation
+/************************************************************************/
+void calculateMemoryStats(Renderer* pRenderer, char** stats)
+{
+	ASSERT(pRenderer);
+	ASSERT(stats);
+
+	NullRendererStats current = {};
+	getNullRendererStats(pRenderer, &current);
+
+	const char* format =
+		"{\n"
+		"  \"Total\": { \"Bytes\": %llu, \"PeakBytes\": %llu },\n"
+		"  \"Buffers\": { \"Count\": %u, \"Bytes\": %llu },\n"
+		"  \"Textures\": { \"Count\": %u, \"Bytes\": %llu, \"RenderTargets\": %u }\n"
+		"}\n";
+	const unsigned long long total = current.mBufferMemory + current.mTextureMemory;
+	const int length = snprintf(NULL, 0, format, total, (unsigned long long)current.mPeakMemory, current.mBufferCount,
+		(unsigned long long)current.mBufferMemory, current.mTextureCount, (unsigned long long)current.mTextureMemory,
+		current.mRenderTargetCount);
+
+	*stats = (char*)tf_malloc(length + 1);
+	snprintf(*stats, length + 1, format, total, (unsigned long long)current.mPeakMemory, current.mBufferCount,
+		(unsigned long long)current.mBufferMemory, current.mTextureCount, (unsigned long long)current.mTextureMemory,
+		current.mRenderTargetCount);
+}
+
+void calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* totalAllocatedBytes)
+{
+	ASSERT(pRenderer);
+	ASSERT(usedBytes);
+	ASSERT(totalAllocatedBytes);
+
+	NullRendererStats current = {};
+	getNullRendererStats(pRenderer, &current);
+
+	// Every resource is its own allocation, there are no partially used heaps
+	*usedBytes = current.mBufferMemory + current.mTextureMemory;
+	*totalAllocatedBytes = *usedBytes;
+}
+
+void freeMemoryStats(Renderer* pRenderer, char* stats)
+{
+	tf_free(stats);
+}
+/************************************************************************/
+// Debug Marker Implementation
+/************************************************************************/
+void cmdBeginDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+	ASSERT(pCmd);
+	ASSERT(pName);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdEndDebugMarker(Cmd* pCmd)
+{
+	ASSERT(pCmd);
+
+	++pCmd->mStats.mCommandCount;
+}
+
+void cmdAddDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+	ASSERT(pCmd);
+	ASSERT(pName);
+
+	++pCmd->mStats.mCommandCount;
+}
+/************************************************************************/
+// Resource Debug Naming Interface
+/************************************************************************/
+void setBufferName(Renderer* pRenderer, Buffer* pBuffer, const char* pName)
+{
+	ASSERT(pRenderer);
+	ASSERT(pBuffer);
+	ASSERT(pName);
+}
+
+void setTextureName(Renderer* pRenderer, Texture* pTexture, const char* pName)
+{
+	ASSERT(pRenderer);
+	ASSERT(pTexture);
+	ASSERT(pName);
+}
+
+void setRenderTargetName(Renderer* pRenderer, RenderTarget* pRenderTarget, const char* pName)
+{
+	setTextureName(pRenderer, pRenderTarget->pTexture, pName);
+}
+
+void setPipelineName(Renderer* pRenderer, Pipeline* pPipeline, const char* pName)
+{
+	ASSERT(pRenderer);
+	ASSERT(pPipeline);
+	ASSERT(pName);
+}
+/************************************************************************/
+// Null Renderer Stats Interface
+/************************************************************************/
+void getNullRendererStats(Renderer* pRenderer, NullRendererStats* pStats)
+{
+	ASSERT(pRenderer);
+	ASSERT(pStats);
+
+	NullDevice* pDevice = pRenderer->pNullDevice;
+	MutexLock   lock(pDevice->mStatsMutex);
+	*pStats = pDevice->mStats;
+}
+
+void resetNullRendererStats(Renderer* pRenderer)
+{
+	ASSERT(pRenderer);
+
+	NullDevice* pDevice = pRenderer->pNullDevice;
+	MutexLock   lock(pDevice->mStatsMutex);
+	pDevice->mStats.mSubmitted = {};
+	pDevice->mStats.mSubmitCount = 0;
+	pDevice->mStats.mPresentCount = 0;
+	pDevice->mStats.mDescriptorUpdateCount = 0;
+	pDevice->mStats.mPeakMemory = pDevice->mStats.mBufferMemory + pDevice->mStats.mTextureMemory;
+}
+#endif
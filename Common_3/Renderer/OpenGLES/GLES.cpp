@@ -1898,12 +1898,16 @@ void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipelin
 	*ppPipeline = pPipeline;
 }
 
+extern void recordPipeline(const PipelineDesc* pDesc);
+
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
 	ASSERT(pRenderer);
 	ASSERT(ppPipeline);
 	ASSERT(pDesc);
 
+	recordPipeline(pDesc);
+
 	if (pDesc->mType != PIPELINE_TYPE_GRAPHICS)
 	{
 		LOGF(LogLevel::eERROR, "Pipeline {%u} not supported on OpenGL ES 2.0", pDesc->mType);
@@ -2059,7 +2063,7 @@ void updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDe
 	if (!(descriptor))																					\
 	{																									\
 		eastl::string msg = __FUNCTION__ + eastl::string(" : ") + eastl::string().sprintf(__VA_ARGS__);	\
-		LOGF(LogLevel::eERROR, msg.c_str());															\
+		LOGF(LogLevel::eERROR, "%s", msg.c_str());														\
 		_FailedAssert(__FILE__, __LINE__, msg.c_str());													\
 		continue;																						\
 	}
@@ -2665,6 +2669,10 @@ typedef struct SubresourceDataDesc
 	uint64_t mSrcOffset;
 	uint32_t mMipLevel;
 	uint32_t mArrayLayer;
+	uint32_t mRegionX;
+	uint32_t mRegionY;
+	uint32_t mRegionWidth;
+	uint32_t mRegionHeight;
 } SubresourceDataDesc;
 
 void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pSubresourceDesc)
@@ -2694,7 +2702,23 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 	}
 
 	CHECK_GLRESULT(glBindTexture(pTexture->mTarget, pTexture->mTexture));
-	if (pTexture->mType == GL_NONE) // Compressed image
+	if (pSubresourceDesc->mRegionWidth && pSubresourceDesc->mRegionHeight)
+	{
+		// Staged rows are padded to GL_UNPACK_ALIGNMENT like full updates
+		uint8_t* pData = (uint8_t*)pSrcBuffer->pCpuMappedAddress + pSubresourceDesc->mSrcOffset;
+		if (pTexture->mType == GL_NONE)
+		{
+			GLsizei imageByteSize = util_get_compressed_texture_size(pTexture->mInternalFormat, pSubresourceDesc->mRegionWidth, pSubresourceDesc->mRegionHeight);
+			CHECK_GLRESULT(glCompressedTexSubImage2D(target, pSubresourceDesc->mMipLevel, pSubresourceDesc->mRegionX, pSubresourceDesc->mRegionY,
+				pSubresourceDesc->mRegionWidth, pSubresourceDesc->mRegionHeight, pTexture->mInternalFormat, imageByteSize, pData));
+		}
+		else
+		{
+			CHECK_GLRESULT(glTexSubImage2D(target, pSubresourceDesc->mMipLevel, pSubresourceDesc->mRegionX, pSubresourceDesc->mRegionY,
+				pSubresourceDesc->mRegionWidth, pSubresourceDesc->mRegionHeight, pTexture->mGlFormat, pTexture->mType, pData));
+		}
+	}
+	else if (pTexture->mType == GL_NONE) // Compressed image
 	{
 		GLsizei imageByteSize = util_get_compressed_texture_size(pTexture->mInternalFormat, width, height);
 		CHECK_GLRESULT(glCompressedTexImage2D(target, pSubresourceDesc->mMipLevel, pTexture->mInternalFormat,
@@ -38,6 +38,7 @@
 #include "IRenderer.h"
 #include "IResourceLoader.h"
 #include "../OS/Interfaces/ILog.h"
+#include "../OS/Interfaces/ITime.h"
 #include "../OS/Interfaces/IThread.h"
 
 #if defined(__ANDROID__) && defined(VULKAN)
@@ -50,6 +51,12 @@
 
 #include "../OS/Core/TextureContainers.h"
 
+#include "../OS/Core/ThreadSystem.h"
+
+#include "../ThirdParty/OpenSource/EASTL/deque.h"
+#include "../ThirdParty/OpenSource/EASTL/sort.h"
+#include "../ThirdParty/OpenSource/EASTL/unordered_map.h"
+
 #include "../OS/Interfaces/IMemory.h"
 
 #ifdef NX64
@@ -61,6 +68,11 @@ struct SubresourceDataDesc
 	uint64_t                           mSrcOffset;
 	uint32_t                           mMipLevel;
 	uint32_t                           mArrayLayer;
+	/// Region of the subresource to update, the whole subresource if mRegionWidth is zero
+	uint32_t                           mRegionX;
+	uint32_t                           mRegionY;
+	uint32_t                           mRegionWidth;
+	uint32_t                           mRegionHeight;
 #if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
 	uint32_t                           mRowPitch;
 	uint32_t                           mSlicePitch;
@@ -99,7 +111,11 @@ extern void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffe
 
 #define MAX_FRAMES 3U
 
-ResourceLoaderDesc gDefaultResourceLoaderDesc = { 8ull << 20, 2 };
+#define LOAD_PRIORITY_LEVELS (LOAD_PRIORITY_HIGH - LOAD_PRIORITY_LOW + 1)
+// Token priority of buffer / texture updates and barriers, nothing completes ahead of them
+#define LOAD_PRIORITY_ORDERED (LOAD_PRIORITY_HIGH + 1)
+
+ResourceLoaderDesc gDefaultResourceLoaderDesc = { 8ull << 20, 2, false, 4 };
 /************************************************************************/
 // Surface Utils
 /************************************************************************/
@@ -318,6 +334,11 @@ typedef struct TextureUpdateDescInternal
 	uint32_t          mMipLevels;
 	uint32_t          mBaseArrayLayer;
 	uint32_t          mLayerCount;
+	/// Only used by updates coming from beginUpdateResource, see TextureUpdateDesc::mRegionX
+	uint32_t          mRegionX;
+	uint32_t          mRegionY;
+	uint32_t          mRegionWidth;
+	uint32_t          mRegionHeight;
 	PreMipStepFn      pPreMipFunc;
 	bool              mMipsAfterSlice;
 } TextureUpdateDescInternal;
@@ -365,18 +386,47 @@ typedef enum UploadFunctionResult
 	UPLOAD_FUNCTION_RESULT_INVALID_REQUEST
 } UploadFunctionResult;
 
+typedef enum DecodeResult
+{
+	/// Not decoded yet, the copy thread decodes the request itself
+	DECODE_RESULT_NONE = 0,
+	DECODE_RESULT_SUCCESS,
+	DECODE_RESULT_FAILED,
+	/// Container creates its GPU resources while parsing (Xbox DDS, GNF, SVT) and has to be loaded on the copy thread
+	DECODE_RESULT_UNSUPPORTED,
+} DecodeResult;
+
+/// Texture file parsed (and transcoded) into memory, ready for addTexture + updateTexture
+typedef struct DecodedTexture
+{
+	TextureDesc               mDesc;
+	TextureUpdateDescInternal mUpdateDesc;
+} DecodedTexture;
+
+/// Parsed gltf with all its buffers loaded
+typedef struct DecodedGeometry
+{
+	cgltf_data* pData;
+	/// Backs the json and glb chunks cgltf points into
+	FileStream  mFile;
+	/// Mapped .bin files backing cgltf buffers, indexed like data->buffers
+	FileStream* pBufferFiles;
+} DecodedGeometry;
+
 struct UpdateRequest
 {
 	UpdateRequest(const BufferUpdateDesc& buffer) :           mType(UPDATE_REQUEST_UPDATE_BUFFER), bufUpdateDesc(buffer) {}
-	UpdateRequest(const TextureLoadDesc& texture) :           mType(UPDATE_REQUEST_LOAD_TEXTURE), texLoadDesc(texture) {}
+	UpdateRequest(const TextureLoadDesc& texture) :           mType(UPDATE_REQUEST_LOAD_TEXTURE), mPriority(texture.mPriority), texLoadDesc(texture) {}
 	UpdateRequest(const TextureUpdateDescInternal& texture) : mType(UPDATE_REQUEST_UPDATE_TEXTURE), texUpdateDesc(texture) {}
-	UpdateRequest(const GeometryLoadDesc& geom) :             mType(UPDATE_REQUEST_LOAD_GEOMETRY), geomLoadDesc(geom) {}
+	UpdateRequest(const GeometryLoadDesc& geom) :             mType(UPDATE_REQUEST_LOAD_GEOMETRY), mPriority(geom.mPriority), geomLoadDesc(geom) {}
 	UpdateRequest(const BufferBarrier& barrier) :             mType(UPDATE_REQUEST_BUFFER_BARRIER), bufferBarrier(barrier) {}
 	UpdateRequest(const TextureBarrier& barrier) :            mType(UPDATE_REQUEST_TEXTURE_BARRIER), textureBarrier(barrier) {}
 
 	UpdateRequestType             mType = UPDATE_REQUEST_INVALID;
 	uint64_t                      mWaitIndex = 0;
 	Buffer*                       pUploadBuffer = NULL;
+	LoadPriority                  mPriority = LOAD_PRIORITY_NORMAL;
+	DecodeResult                  mDecodeResult = DECODE_RESULT_NONE;
 	union
 	{
 		BufferUpdateDesc          bufUpdateDesc;
@@ -386,8 +436,22 @@ struct UpdateRequest
 		BufferBarrier             bufferBarrier;
 		TextureBarrier            textureBarrier;
 	};
+	// Output of the decode stage for texture / geometry loads
+	union
+	{
+		DecodedTexture            mDecodedTexture;
+		DecodedGeometry           mDecodedGeometry;
+	};
+};
+
+struct TokenState
+{
+	SyncToken mToken;
+	int32_t   mPriority;
 };
 
+static bool operator<(const TokenState& a, SyncToken b) { return a.mToken < b; }
+
 struct ResourceLoader
 {
 	Renderer*                    pRenderer;
@@ -404,10 +468,22 @@ struct ResourceLoader
 	ConditionVariable            mTokenCond;
 	eastl::vector<UpdateRequest> mRequestQueue[MAX_LINKED_GPUS];
 
+	// Texture and geometry loads go through the decode workers first (file reads, container parsing, transcoding)
+	// and reach the copy thread once decoded. Both stages are bucketed by priority, FIFO inside a bucket.
+	ThreadSystem*                pDecodeThreadSystem;
+	eastl::deque<UpdateRequest>  mDecodeQueue[LOAD_PRIORITY_LEVELS];
+	eastl::vector<UpdateRequest> mDecodedQueue[MAX_LINKED_GPUS][LOAD_PRIORITY_LEVELS];
+
+	// Every token up to mTokenCompleted has completed. Above it loads can complete ahead of older loads of a lower
+	// priority, which is tracked per token in the sorted lists below (guarded by mTokenMutex, see isTokenCompleted)
 	tfrg_atomic64_t              mTokenCompleted;
 	tfrg_atomic64_t              mTokenCounter;
+	eastl::vector<TokenState>    mPendingTokens;
+	eastl::vector<TokenState>    mCompletedTokens;
 
-	SyncToken                    mCurrentTokenState[MAX_FRAMES];
+	// Tokens of the requests recorded into each copy set, signaled once the set's fence has passed.
+	// Only accessed by the copy thread
+	eastl::vector<SyncToken>     mSubmittedTokens[MAX_FRAMES];
 
 	CopyEngine                   pCopyEngines[MAX_LINKED_GPUS];
 	uint32_t                     mNextSet;
@@ -648,6 +724,9 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 
 	ASSERT(pCopyEngine->pQueue->mNodeIndex == texUpdateDesc.pTexture->mNodeIndex);
 
+	// Region updates keep the texels outside of the region
+	const bool regionUpdate = texUpdateDesc.mRegionWidth && texUpdateDesc.mRegionHeight;
+
 	const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
 	const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
 	const uint64_t requiredSize = util_get_surface_size(fmt, texture->mWidth, texture->mHeight, texture->mDepth,
@@ -657,7 +736,7 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 		texUpdateDesc.mBaseArrayLayer, texUpdateDesc.mLayerCount);
 
 #if defined(VULKAN)
-	TextureBarrier barrier = { texture, RESOURCE_STATE_UNDEFINED, RESOURCE_STATE_COPY_DEST };
+	TextureBarrier barrier = { texture, regionUpdate ? RESOURCE_STATE_SHADER_RESOURCE : RESOURCE_STATE_UNDEFINED, RESOURCE_STATE_COPY_DEST };
 	cmdResourceBarrier(cmd, 0, NULL, 1, &barrier, 0, NULL);
 #endif
 
@@ -713,8 +792,8 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 				uint32_t mip = texUpdateDesc.mMipsAfterSlice ? j : i;
 				uint32_t layer = texUpdateDesc.mMipsAfterSlice ? i : j;
 
-				uint32_t w = MIP_REDUCE(texture->mWidth, mip);
-				uint32_t h = MIP_REDUCE(texture->mHeight, mip);
+				uint32_t w = regionUpdate ? texUpdateDesc.mRegionWidth : MIP_REDUCE(texture->mWidth, mip);
+				uint32_t h = regionUpdate ? texUpdateDesc.mRegionHeight : MIP_REDUCE(texture->mHeight, mip);
 				uint32_t d = MIP_REDUCE(texture->mDepth, mip);
 
 				uint32_t numBytes = 0;
@@ -753,6 +832,13 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 				subresourceDesc.mArrayLayer = layer;
 				subresourceDesc.mMipLevel = mip;
 				subresourceDesc.mSrcOffset = upload.mOffset + offset;
+				if (regionUpdate)
+				{
+					subresourceDesc.mRegionX = texUpdateDesc.mRegionX;
+					subresourceDesc.mRegionY = texUpdateDesc.mRegionY;
+					subresourceDesc.mRegionWidth = w;
+					subresourceDesc.mRegionHeight = h;
+				}
 #if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
 				subresourceDesc.mRowPitch = subRowPitch;
 				subresourceDesc.mSlicePitch = subSlicePitch;
@@ -776,121 +862,157 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 	return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
-static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const UpdateRequest& pTextureUpdate)
-{
-	const TextureLoadDesc* pTextureDesc = &pTextureUpdate.texLoadDesc;
+static const char* gTextureContainerExtensions[] = { NULL, "dds", "ktx", "gnf", "basis", "svt" };
 
-	if (pTextureDesc->pFileName)
+static TextureContainerType getTextureContainer(TextureContainerType container)
+{
+	if (TEXTURE_CONTAINER_DEFAULT == container)
 	{
-		FileStream stream = {};
-		char fileName[FS_MAX_PATH] = {};
-		bool success = false;
-
-		TextureUpdateDescInternal updateDesc = {};
-		TextureContainerType container = pTextureDesc->mContainer;
-		static const char* extensions[] = { NULL, "dds", "ktx", "gnf", "basis", "svt" };
-
-		if (TEXTURE_CONTAINER_DEFAULT == container)
-		{
 #if defined(TARGET_IOS) || defined(__ANDROID__) || defined(NX64)
-			container = TEXTURE_CONTAINER_KTX;
+		container = TEXTURE_CONTAINER_KTX;
 #elif defined(_WINDOWS) || defined(XBOX) || defined(__APPLE__) || defined(__linux__)
-			container = TEXTURE_CONTAINER_DDS;
+		container = TEXTURE_CONTAINER_DDS;
 #elif defined(ORBIS) || defined(PROSPERO)
-			container = TEXTURE_CONTAINER_GNF;
+		container = TEXTURE_CONTAINER_GNF;
 #endif
-		}
+	}
 
-		TextureDesc textureDesc = {};
-		textureDesc.pName = pTextureDesc->pFileName;
+	return container;
+}
 
-		// Validate that we have found the file format now
-		ASSERT(container != TEXTURE_CONTAINER_DEFAULT);
-		if (TEXTURE_CONTAINER_DEFAULT == container)
-		{
-			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-		}
+// Maps or reads the texture file into memory and parses its container without touching any GPU state
+// so this can run on the decode workers
+static DecodeResult decodeTexture(const TextureLoadDesc* pTextureDesc, DecodedTexture* pDecoded)
+{
+	TextureContainerType container = getTextureContainer(pTextureDesc->mContainer);
+
+	// Validate that we have found the file format now
+	ASSERT(container != TEXTURE_CONTAINER_DEFAULT);
+	if (!pTextureDesc->pFileName || TEXTURE_CONTAINER_DEFAULT == container)
+	{
+		return DECODE_RESULT_FAILED;
+	}
+
+	char fileName[FS_MAX_PATH] = {};
+	fsAppendPathExtension(pTextureDesc->pFileName, gTextureContainerExtensions[container], fileName);
+
+	FileStream stream = {};
+	bool success = false;
+	bool inMemory = false;
 
-		fsAppendPathExtension(pTextureDesc->pFileName, extensions[container], fileName);
+	TextureDesc& textureDesc = pDecoded->mDesc;
+	TextureUpdateDescInternal& updateDesc = pDecoded->mUpdateDesc;
+	textureDesc = {};
+	updateDesc = {};
+	textureDesc.pName = pTextureDesc->pFileName;
 
-		switch (container)
+	switch (container)
+	{
+#if !defined(XBOX)
+	case TEXTURE_CONTAINER_DDS:
+	{
+		success = fsOpenStreamMapped(RD_TEXTURES, fileName, &stream);
+		if (success)
 		{
-		case TEXTURE_CONTAINER_DDS:
+			success = loadDDSTextureDesc(&stream, &textureDesc);
+		}
+		break;
+	}
+#endif
+	case TEXTURE_CONTAINER_KTX:
+	{
+		success = fsOpenStreamMapped(RD_TEXTURES, fileName, &stream);
+		if (success)
 		{
-#if defined(XBOX)
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
-			uint32_t res = 1;
-			if (success)
-			{
-				extern uint32_t loadXDDSTexture(Renderer* pRenderer, FileStream* stream, const char* name, TextureCreationFlags flags, Texture** ppTexture);
-				res = loadXDDSTexture(pRenderer, &stream, fileName, pTextureDesc->mCreationFlag, pTextureDesc->ppTexture);
-				fsCloseStream(&stream);
-			}
-
-			return res ? UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : UPLOAD_FUNCTION_RESULT_COMPLETED;
-#else
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
-			if (success)
+			success = loadKTXTextureDesc(&stream, &textureDesc);
+			updateDesc.mMipsAfterSlice = true;
+			// KTX stores mip size before the mip data
+			// This function gets called to skip the mip size so we read the mip data
+			updateDesc.pPreMipFunc = [](FileStream* pStream, uint32_t)
 			{
-				success = loadDDSTextureDesc(&stream, &textureDesc);
-			}
-#endif
-			break;
+				uint32_t mipSize = 0;
+				fsReadFromStream(pStream, &mipSize, sizeof(mipSize));
+			};
 		}
-		case TEXTURE_CONTAINER_KTX:
+		break;
+	}
+	case TEXTURE_CONTAINER_BASIS:
+	{
+		void* data = NULL;
+		uint32_t dataSize = 0;
+		success = fsOpenStreamMapped(RD_TEXTURES, fileName, &stream);
+		if (success)
 		{
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
+			success = loadBASISTextureDesc(&stream, &textureDesc, &data, &dataSize);
 			if (success)
 			{
-				success = loadKTXTextureDesc(&stream, &textureDesc);
-				updateDesc.mMipsAfterSlice = true;
-				// KTX stores mip size before the mip data
-				// This function gets called to skip the mip size so we read the mip data
-				updateDesc.pPreMipFunc = [](FileStream* pStream, uint32_t)
-				{
-					uint32_t mipSize = 0;
-					fsReadFromStream(pStream, &mipSize, sizeof(mipSize));
-				};
+				fsCloseStream(&stream);
+				fsOpenStreamFromMemory(data, dataSize, FM_READ_BINARY, true, &stream);
+				inMemory = true;
 			}
-			break;
 		}
-		case TEXTURE_CONTAINER_BASIS:
+		break;
+	}
+	default:
+		return DECODE_RESULT_UNSUPPORTED;
+	}
+
+	if (!success)
+	{
+		if (stream.pIO)
 		{
-			void* data = NULL;
-			uint32_t dataSize = 0;
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
-			if (success)
-			{
-				success = loadBASISTextureDesc(&stream, &textureDesc, &data, &dataSize);
-				if (success)
-				{
-					fsCloseStream(&stream);
-					fsOpenStreamFromMemory(data, dataSize, FM_READ_BINARY, true, &stream);
-				}
-			}
-			break;
+			fsCloseStream(&stream);
 		}
-		case TEXTURE_CONTAINER_GNF:
+		return DECODE_RESULT_FAILED;
+	}
+
+	// Pull the remaining texel data into memory so the copy thread only has to copy it into the staging buffer
+	// A mapped file already is, its pages get read ahead by the OS while the request waits for the copy thread
+	if (!inMemory && !fsGetStreamBuffer(&stream))
+	{
+		ssize_t dataSize = fsGetStreamFileSize(&stream) - fsGetStreamSeekPosition(&stream);
+		void* data = tf_malloc(dataSize);
+		ssize_t bytesRead = fsReadFromStream(&stream, data, dataSize);
+		fsCloseStream(&stream);
+		if (bytesRead != dataSize)
 		{
-#if defined(ORBIS) || defined(PROSPERO)
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
-			uint32_t res = 1;
-			if (success)
-			{
-				extern uint32_t loadGnfTexture(Renderer* pRenderer, FileStream* stream, const char* name, TextureCreationFlags flags, Texture** ppTexture);
-				res = loadGnfTexture(pRenderer, &stream, fileName, pTextureDesc->mCreationFlag, pTextureDesc->ppTexture);
-				fsCloseStream(&stream);
-			}
+			tf_free(data);
+			return DECODE_RESULT_FAILED;
+		}
+		fsOpenStreamFromMemory(data, dataSize, FM_READ_BINARY, true, &stream);
+	}
 
-			return res ? UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : UPLOAD_FUNCTION_RESULT_COMPLETED;
-#endif
+	updateDesc.mStream = stream;
+	updateDesc.mBaseMipLevel = 0;
+	updateDesc.mMipLevels = textureDesc.mMipLevels;
+	updateDesc.mBaseArrayLayer = 0;
+	updateDesc.mLayerCount = textureDesc.mArraySize;
+
+	return DECODE_RESULT_SUCCESS;
+}
+
+static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pTextureUpdate)
+{
+	const TextureLoadDesc* pTextureDesc = &pTextureUpdate.texLoadDesc;
+
+	if (pTextureDesc->pFileName)
+	{
+		// Decode here unless one of the decode workers already did
+		if (DECODE_RESULT_NONE == pTextureUpdate.mDecodeResult)
+		{
+			pTextureUpdate.mDecodeResult = decodeTexture(pTextureDesc, &pTextureUpdate.mDecodedTexture);
 		}
-		default:
-			break;
+
+		if (DECODE_RESULT_FAILED == pTextureUpdate.mDecodeResult)
+		{
+			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 		}
 
-		if (success)
+		if (DECODE_RESULT_SUCCESS == pTextureUpdate.mDecodeResult)
 		{
+			TextureDesc& textureDesc = pTextureUpdate.mDecodedTexture.mDesc;
+			TextureUpdateDescInternal& updateDesc = pTextureUpdate.mDecodedTexture.mUpdateDesc;
+
 			textureDesc.mStartState = RESOURCE_STATE_COMMON;
 			textureDesc.mFlags |= pTextureDesc->mCreationFlag;
 			textureDesc.mNodeIndex = pTextureDesc->mNodeIndex;
@@ -900,24 +1022,59 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 #endif
 			addTexture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
 
-			updateDesc.mStream = stream;
 			updateDesc.pTexture = *pTextureDesc->ppTexture;
-			updateDesc.mBaseMipLevel = 0;
-			updateDesc.mMipLevels = textureDesc.mMipLevels;
-			updateDesc.mBaseArrayLayer = 0;
-			updateDesc.mLayerCount = textureDesc.mArraySize;
 
 			return updateTexture(pRenderer, pCopyEngine, activeSet, updateDesc);
 		}
+
+		char fileName[FS_MAX_PATH] = {};
+		TextureContainerType container = getTextureContainer(pTextureDesc->mContainer);
+		fsAppendPathExtension(pTextureDesc->pFileName, gTextureContainerExtensions[container], fileName);
+
+#if defined(XBOX)
+		if (TEXTURE_CONTAINER_DDS == container)
+		{
+			FileStream stream = {};
+			bool success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
+			uint32_t res = 1;
+			if (success)
+			{
+				extern uint32_t loadXDDSTexture(Renderer* pRenderer, FileStream* stream, const char* name, TextureCreationFlags flags, Texture** ppTexture);
+				res = loadXDDSTexture(pRenderer, &stream, fileName, pTextureDesc->mCreationFlag, pTextureDesc->ppTexture);
+				fsCloseStream(&stream);
+			}
+
+			return res ? UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : UPLOAD_FUNCTION_RESULT_COMPLETED;
+		}
+#endif
+#if defined(ORBIS) || defined(PROSPERO)
+		if (TEXTURE_CONTAINER_GNF == container)
+		{
+			FileStream stream = {};
+			bool success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream);
+			uint32_t res = 1;
+			if (success)
+			{
+				extern uint32_t loadGnfTexture(Renderer* pRenderer, FileStream* stream, const char* name, TextureCreationFlags flags, Texture** ppTexture);
+				res = loadGnfTexture(pRenderer, &stream, fileName, pTextureDesc->mCreationFlag, pTextureDesc->ppTexture);
+				fsCloseStream(&stream);
+			}
+
+			return res ? UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : UPLOAD_FUNCTION_RESULT_COMPLETED;
+		}
+#endif
 		/************************************************************************/
 		// Sparse Tetxtures
 		/************************************************************************/
 #if defined(DIRECT3D12) || defined(VULKAN)
 		if (TEXTURE_CONTAINER_SVT == container)
 		{
+			FileStream stream = {};
 			if (fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, &stream))
 			{
-				success = loadSVTTextureDesc(&stream, &textureDesc);
+				TextureDesc textureDesc = {};
+				textureDesc.pName = pTextureDesc->pFileName;
+				bool success = loadSVTTextureDesc(&stream, &textureDesc);
 				if (success)
 				{
 					ssize_t dataSize = fsGetStreamFileSize(&stream) - fsGetStreamSeekPosition(&stream);
@@ -1037,43 +1194,74 @@ static UploadFunctionResult updateBuffer(Renderer* pRenderer, CopyEngine* pCopyE
 	return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
-static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pGeometryLoad)
+static void releaseDecodedGeometry(DecodedGeometry* pDecoded)
 {
-	GeometryLoadDesc* pDesc = &pGeometryLoad.geomLoadDesc;
+	cgltf_data* data = pDecoded->pData;
+
+	// Mapped buffers belong to their file, not to cgltf
+	for (uint32_t i = 0; i < data->buffers_count; ++i)
+	{
+		if (pDecoded->pBufferFiles[i].pIO)
+		{
+			data->buffers[i].data = NULL;
+			fsCloseStream(&pDecoded->pBufferFiles[i]);
+		}
+	}
+	tf_free(pDecoded->pBufferFiles);
+
+	cgltf_free(data);
+	fsCloseStream(&pDecoded->mFile);
+	*pDecoded = {};
+}
 
+// Reads and parses the gltf file including its buffers so the copy thread only has to build the vertex / index data
+static DecodeResult decodeGeometry(const GeometryLoadDesc* pDesc, DecodedGeometry* pDecoded)
+{
 	char iext[FS_MAX_PATH] = { 0 };
 	fsGetPathExtension(pDesc->pFileName, iext);
 
 	// Geometry in gltf container
 	if (iext[0] != 0 && (stricmp(iext, "gltf") == 0 || stricmp(iext, "glb") == 0))
 	{
+		// cgltf parses straight from the mapping and keeps pointing into it, so the stream stays open until the geometry is built
 		FileStream file = {};
-		if (!fsOpenStreamFromPath(RD_MESHES, pDesc->pFileName, FM_READ_BINARY, &file))
+		if (!fsOpenStreamMapped(RD_MESHES, pDesc->pFileName, &file))
 		{
 			LOGF(eERROR, "Failed to open gltf file %s", pDesc->pFileName);
 			ASSERT(false);
-			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+			return DECODE_RESULT_FAILED;
 		}
 
 		ssize_t fileSize = fsGetStreamFileSize(&file);
-		void* fileData = tf_malloc(fileSize);
-		cgltf_result result = cgltf_result_invalid_gltf;
-
-		fsReadFromStream(&file, fileData, fileSize);
+		const void* fileData = fsGetStreamBuffer(&file);
+		if (!fileData)
+		{
+			void* fileCopy = tf_malloc(fileSize);
+			size_t bytesRead = fsReadFromStream(&file, fileCopy, fileSize);
+			fsCloseStream(&file);
+			if (bytesRead != (size_t)fileSize)
+			{
+				LOGF(eERROR, "Failed to read gltf file %s", pDesc->pFileName);
+				ASSERT(false);
+				tf_free(fileCopy);
+				return DECODE_RESULT_FAILED;
+			}
+			fsOpenStreamFromMemory(fileCopy, fileSize, FM_READ_BINARY, true, &file);
+			fileData = fileCopy;
+		}
 
 		cgltf_options options = {};
 		cgltf_data* data = NULL;
 		options.memory_alloc = [](void* user, cgltf_size size) { return tf_malloc(size); };
 		options.memory_free = [](void* user, void* ptr) { tf_free(ptr); };
-		result = cgltf_parse(&options, fileData, fileSize, &data);
-		fsCloseStream(&file);
+		cgltf_result result = cgltf_parse(&options, fileData, fileSize, &data);
 
 		if (cgltf_result_success != result)
 		{
 			LOGF(eERROR, "Failed to parse gltf file %s with error %u", pDesc->pFileName, (uint32_t)result);
 			ASSERT(false);
-			tf_free(fileData);
-			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+			fsCloseStream(&file);
+			return DECODE_RESULT_FAILED;
 		}
 
 #if defined(FORGE_DEBUG)
@@ -1085,6 +1273,10 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 #endif
 
 		// Load buffers located in separate files (.bin) using our file system
+		// Mapped files are used in place, otherwise all reads are issued before waiting on any of them so they overlap
+		FileStream* pBufferStreams = (FileStream*)tf_calloc(data->buffers_count + 1, sizeof(FileStream));
+		FileAsyncRead* pBufferReads = (FileAsyncRead*)tf_calloc(data->buffers_count + 1, sizeof(FileAsyncRead));
+		bool readFailed = false;
 		for (uint32_t i = 0; i < data->buffers_count; ++i)
 		{
 			const char* uri = data->buffers[i].uri;
@@ -1100,26 +1292,93 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 				fsGetParentPath(pDesc->pFileName, parent);
 				char path[FS_MAX_PATH] = { 0 };
 				fsAppendPathComponent(parent, uri, path);
-				FileStream fs = {};
-				if (fsOpenStreamFromPath(RD_MESHES, path, FM_READ_BINARY, &fs))
+				FileStream* fs = &pBufferStreams[i];
+				if (fsOpenStreamMapped(RD_MESHES, path, fs))
 				{
-					ASSERT(fsGetStreamFileSize(&fs) >= (ssize_t)data->buffers[i].size);
+					if (fsGetStreamFileSize(fs) < (ssize_t)data->buffers[i].size)
+					{
+						LOGF(eERROR, "Buffer %s of gltf file %s is smaller than its declared size", uri, pDesc->pFileName);
+						readFailed = true;
+						fsCloseStream(fs);
+						*fs = {};
+						continue;
+					}
+					const void* mapped = fsGetStreamBuffer(fs);
+					if (mapped)
+					{
+						data->buffers[i].data = (void*)mapped;
+						continue;
+					}
 					data->buffers[i].data = tf_malloc(data->buffers[i].size);
-					fsReadFromStream(&fs, data->buffers[i].data, data->buffers[i].size);
+					if (!fsReadFromStreamAsync(fs, data->buffers[i].data, data->buffers[i].size, &pBufferReads[i]))
+					{
+						// Nothing to wait for, the buffer is freed with the other cgltf data
+						LOGF(eERROR, "Failed to read buffer %s of gltf file %s", uri, pDesc->pFileName);
+						readFailed = true;
+						fsCloseStream(fs);
+						*fs = {};
+					}
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < data->buffers_count; ++i)
+		{
+			if (pBufferStreams[i].pIO && !fsGetStreamBuffer(&pBufferStreams[i]))
+			{
+				fsWaitAsyncRead(&pBufferReads[i]);
+				if (pBufferReads[i].mBytesRead != data->buffers[i].size)
+				{
+					LOGF(eERROR, "Failed to read buffer %s of gltf file %s, read %llu of %llu bytes", data->buffers[i].uri, pDesc->pFileName,
+						(unsigned long long)pBufferReads[i].mBytesRead, (unsigned long long)data->buffers[i].size);
+					readFailed = true;
 				}
-				fsCloseStream(&fs);
+				fsCloseStream(&pBufferStreams[i]);
+				pBufferStreams[i] = {};
 			}
 		}
+		tf_free(pBufferReads);
+
+		pDecoded->pData = data;
+		pDecoded->mFile = file;
+		pDecoded->pBufferFiles = pBufferStreams;
+
+		if (readFailed)
+		{
+			ASSERT(false);
+			releaseDecodedGeometry(pDecoded);
+			return DECODE_RESULT_FAILED;
+		}
 
 		result = cgltf_load_buffers(&options, data, pDesc->pFileName);
 		if (cgltf_result_success != result)
 		{
 			LOGF(eERROR, "Failed to load buffers from gltf file %s with error %u", pDesc->pFileName, (uint32_t)result);
 			ASSERT(false);
-			tf_free(fileData);
-			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+			releaseDecodedGeometry(pDecoded);
+			return DECODE_RESULT_FAILED;
 		}
 
+		return DECODE_RESULT_SUCCESS;
+	}
+
+	return DECODE_RESULT_FAILED;
+}
+
+static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pGeometryLoad)
+{
+	GeometryLoadDesc* pDesc = &pGeometryLoad.geomLoadDesc;
+
+	// Decode here unless one of the decode workers already did
+	if (DECODE_RESULT_NONE == pGeometryLoad.mDecodeResult)
+	{
+		pGeometryLoad.mDecodeResult = decodeGeometry(pDesc, &pGeometryLoad.mDecodedGeometry);
+	}
+
+	if (DECODE_RESULT_SUCCESS == pGeometryLoad.mDecodeResult)
+	{
+		cgltf_data* data = pGeometryLoad.mDecodedGeometry.pData;
+
 		typedef void (*PackingFunction)(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst);
 
 		uint32_t vertexStrides[SEMANTIC_TEXCOORD9 + 1] = {};
@@ -1477,8 +1736,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 			}
 		}
 
-		data->file_data = fileData;
-		cgltf_free(data);
+		releaseDecodedGeometry(&pGeometryLoad.mDecodedGeometry);
 
 		tf_free(pDesc->pVertexLayout);
 
@@ -1487,59 +1745,207 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		return uploadResult;
 	}
 
+	tf_free(pDesc->pVertexLayout);
 	return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 }
 /************************************************************************/
 // Internal Resource Loader Implementation
 /************************************************************************/
-static bool areTasksAvailable(ResourceLoader* pLoader)
+// Called with mQueueMutex held so tokens reach the queues in increasing order
+static SyncToken allocateToken(ResourceLoader* pLoader, int32_t priority)
 {
-	for (size_t i = 0; i < MAX_LINKED_GPUS; ++i)
+	MutexLock lock(pLoader->mTokenMutex);
+	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	pLoader->mPendingTokens.push_back({ t, priority });
+	return t;
+}
+
+static void signalTokens(ResourceLoader* pLoader, uint32_t set)
+{
+	eastl::vector<SyncToken>& submittedTokens = pLoader->mSubmittedTokens[set];
+	if (submittedTokens.empty())
 	{
-		if (!pLoader->mRequestQueue[i].empty())
-		{
-			return true;
-		}
+		return;
 	}
 
-	return false;
+	pLoader->mTokenMutex.Acquire();
+	for (SyncToken token : submittedTokens)
+	{
+		eastl::vector<TokenState>::iterator it =
+			eastl::lower_bound(pLoader->mPendingTokens.begin(), pLoader->mPendingTokens.end(), token);
+		ASSERT(it != pLoader->mPendingTokens.end() && it->mToken == token);
+		TokenState state = *it;
+		pLoader->mPendingTokens.erase(it);
+		pLoader->mCompletedTokens.insert(
+			eastl::lower_bound(pLoader->mCompletedTokens.begin(), pLoader->mCompletedTokens.end(), token), state);
+	}
+	submittedTokens.clear();
+
+	SyncToken lastCompleted = pLoader->mPendingTokens.empty() ? tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter)
+															  : pLoader->mPendingTokens.front().mToken - 1;
+	pLoader->mCompletedTokens.erase(
+		pLoader->mCompletedTokens.begin(),
+		eastl::lower_bound(pLoader->mCompletedTokens.begin(), pLoader->mCompletedTokens.end(), lastCompleted + 1));
+	tfrg_atomic64_store_release(&pLoader->mTokenCompleted, lastCompleted);
+	pLoader->mTokenMutex.Release();
+	pLoader->mTokenCond.WakeAll();
 }
 
-static void streamerThreadFunc(void* pThreadData)
+// A token stands for its own request and everything queued before it, as callers combine tokens with max().
+// Loads may overtake older loads of a lower priority though, so a completed load token does not wait for those.
+// Called with mTokenMutex held
+static bool isTokenCompletedLocked(ResourceLoader* pLoader, SyncToken token)
 {
-	ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
-	ASSERT(pLoader);
+	if (token <= tfrg_atomic64_load_relaxed(&pLoader->mTokenCompleted))
+	{
+		return true;
+	}
 
-#if defined(GLES)
-	GLContext localContext;
-	if (!pLoader->mDesc.mSingleThreaded)
-		initGLContext(pLoader->pRenderer->pConfig, &localContext, pLoader->pRenderer->pContext);
-#endif
+	eastl::vector<TokenState>::iterator it =
+		eastl::lower_bound(pLoader->mCompletedTokens.begin(), pLoader->mCompletedTokens.end(), token);
+	if (it == pLoader->mCompletedTokens.end() || it->mToken != token)
+	{
+		return false;
+	}
 
-	uint32_t linkedGPUCount = pLoader->pRenderer->mLinkedNodeCount;
+	for (const TokenState& pending : pLoader->mPendingTokens)
+	{
+		if (pending.mToken > token)
+		{
+			break;
+		}
+		if (pending.mPriority >= it->mPriority)
+		{
+			return false;
+		}
+	}
 
-	SyncToken      maxToken = {};
+	return true;
+}
 
-	while (pLoader->mRun)
+static bool areTasksAvailable(ResourceLoader* pLoader)
+{
+	for (size_t i = 0; i < MAX_LINKED_GPUS; ++i)
 	{
-		pLoader->mQueueMutex.Acquire();
-
-		// Check for pending tokens
-		// Safe to use mTokenCounter as we are inside critical section
-		bool allTokensSignaled = (pLoader->mTokenCompleted == tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter));
+		if (!pLoader->mRequestQueue[i].empty())
+		{
+			return true;
+		}
 
-		while (!areTasksAvailable(pLoader) && allTokensSignaled && pLoader->mRun)
+		for (uint32_t p = 0; p < LOAD_PRIORITY_LEVELS; ++p)
 		{
-			// No waiting if not running dedicated resource loader thread.
-			if (pLoader->mDesc.mSingleThreaded)
+			if (!pLoader->mDecodedQueue[i][p].empty())
 			{
-				return;
+				return true;
 			}
-			// Sleep until someone adds an update request to the queue
-			pLoader->mQueueCond.Wait(pLoader->mQueueMutex);
 		}
+	}
 
-		pLoader->mQueueMutex.Release();
+	return false;
+}
+
+// Releases a load request which never reached the copy thread, decoded or not
+static void releaseLoadRequest(UpdateRequest& request)
+{
+	if (UPDATE_REQUEST_LOAD_TEXTURE == request.mType)
+	{
+		if (DECODE_RESULT_SUCCESS == request.mDecodeResult)
+		{
+			fsCloseStream(&request.mDecodedTexture.mUpdateDesc.mStream);
+		}
+	}
+	else if (UPDATE_REQUEST_LOAD_GEOMETRY == request.mType)
+	{
+		if (DECODE_RESULT_SUCCESS == request.mDecodeResult)
+		{
+			releaseDecodedGeometry(&request.mDecodedGeometry);
+		}
+		// Copied by addResource, owned by the request until loadGeometry
+		tf_free(request.geomLoadDesc.pVertexLayout);
+	}
+
+	request.mDecodeResult = DECODE_RESULT_NONE;
+}
+
+static void decodeTaskFunc(void* pUser, uintptr_t)
+{
+	ResourceLoader* pLoader = (ResourceLoader*)pUser;
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RESOURCE_LOADER);
+
+	// Every task decodes the highest priority request pending at the time it runs rather than a fixed one,
+	// which lets high priority loads overtake the ones queued before them
+	pLoader->mQueueMutex.Acquire();
+	uint32_t level = LOAD_PRIORITY_LEVELS;
+	while (level > 0 && pLoader->mDecodeQueue[level - 1].empty())
+	{
+		--level;
+	}
+	if (!level || !pLoader->mRun)
+	{
+		pLoader->mQueueMutex.Release();
+		return;
+	}
+	UpdateRequest request = pLoader->mDecodeQueue[level - 1].front();
+	pLoader->mDecodeQueue[level - 1].pop_front();
+	pLoader->mQueueMutex.Release();
+
+	uint32_t nodeIndex = 0;
+	if (UPDATE_REQUEST_LOAD_TEXTURE == request.mType)
+	{
+		request.mDecodeResult = decodeTexture(&request.texLoadDesc, &request.mDecodedTexture);
+		nodeIndex = request.texLoadDesc.mNodeIndex;
+	}
+	else
+	{
+		request.mDecodeResult = decodeGeometry(&request.geomLoadDesc, &request.mDecodedGeometry);
+		nodeIndex = request.geomLoadDesc.mNodeIndex;
+	}
+
+	pLoader->mQueueMutex.Acquire();
+	pLoader->mDecodedQueue[nodeIndex][level - 1].push_back(request);
+	pLoader->mQueueMutex.Release();
+	pLoader->mQueueCond.WakeOne();
+}
+
+static void streamerThreadFunc(void* pThreadData)
+{
+	ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
+	ASSERT(pLoader);
+	// Buffers, textures and staging memory created for the loads count as loader memory
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RESOURCE_LOADER);
+
+#if defined(GLES)
+	GLContext localContext;
+	if (!pLoader->mDesc.mSingleThreaded)
+		initGLContext(pLoader->pRenderer->pConfig, &localContext, pLoader->pRenderer->pContext);
+#endif
+
+	uint32_t linkedGPUCount = pLoader->pRenderer->mLinkedNodeCount;
+
+	while (pLoader->mRun)
+	{
+		pLoader->mQueueMutex.Acquire();
+
+		// Check for submitted tokens which still have to be signaled
+		// Tokens of loads which are being decoded are signaled after the decoded request has been submitted
+		bool allTokensSignaled = true;
+		for (uint32_t i = 0; i < pLoader->mDesc.mBufferCount; ++i)
+		{
+			allTokensSignaled &= pLoader->mSubmittedTokens[i].empty();
+		}
+
+		while (!areTasksAvailable(pLoader) && allTokensSignaled && pLoader->mRun)
+		{
+			// No waiting if not running dedicated resource loader thread.
+			if (pLoader->mDesc.mSingleThreaded)
+			{
+				return;
+			}
+			// Sleep until someone adds an update request to the queue
+			pLoader->mQueueCond.Wait(pLoader->mQueueMutex);
+		}
+
+		pLoader->mQueueMutex.Release();
 
 		pLoader->mNextSet = (pLoader->mNextSet + 1) % pLoader->mDesc.mBufferCount;
 		for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
@@ -1549,10 +1955,7 @@ static void streamerThreadFunc(void* pThreadData)
 		}
 
 		// Signal pending tokens from previous frames
-		pLoader->mTokenMutex.Acquire();
-		tfrg_atomic64_store_release(&pLoader->mTokenCompleted, pLoader->mCurrentTokenState[pLoader->mNextSet]);
-		pLoader->mTokenMutex.Release();
-		pLoader->mTokenCond.WakeAll();
+		signalTokens(pLoader, pLoader->mNextSet);
 
 		for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
 		{
@@ -1563,7 +1966,13 @@ static void streamerThreadFunc(void* pThreadData)
 			eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex];
 			CopyEngine& copyEngine = pLoader->pCopyEngines[nodeIndex];
 
-			if (!requestQueue.size())
+			bool decodedLoadsAvailable = false;
+			for (uint32_t p = 0; p < LOAD_PRIORITY_LEVELS; ++p)
+			{
+				decodedLoadsAvailable |= !pLoader->mDecodedQueue[nodeIndex][p].empty();
+			}
+
+			if (!requestQueue.size() && !decodedLoadsAvailable)
 			{
 				pLoader->mQueueMutex.Release();
 				continue;
@@ -1571,6 +1980,14 @@ static void streamerThreadFunc(void* pThreadData)
 
 			eastl::vector<UpdateRequest> activeQueue;
 			eastl::swap(requestQueue, activeQueue);
+
+			// Decoded loads follow the updates / barriers, highest priority first
+			for (uint32_t p = LOAD_PRIORITY_LEVELS; p > 0; --p)
+			{
+				eastl::vector<UpdateRequest>& decodedQueue = pLoader->mDecodedQueue[nodeIndex][p - 1];
+				activeQueue.insert(activeQueue.end(), decodedQueue.begin(), decodedQueue.end());
+				decodedQueue.clear();
+			}
 			pLoader->mQueueMutex.Release();
 
 			size_t requestCount = activeQueue.size();
@@ -1578,6 +1995,7 @@ static void streamerThreadFunc(void* pThreadData)
 			for (size_t j = 0; j < requestCount; ++j)
 			{
 				UpdateRequest updateState = activeQueue[j];
+				pLoader->mSubmittedTokens[pLoader->mNextSet].push_back(updateState.mWaitIndex);
 
 				UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
 				switch (updateState.mType)
@@ -1616,12 +2034,6 @@ static void streamerThreadFunc(void* pThreadData)
 
 				completionMask |= completed << nodeIndex;
 
-				if (updateState.mWaitIndex && completed)
-				{
-					ASSERT(maxToken < updateState.mWaitIndex);
-					maxToken = updateState.mWaitIndex;
-				}
-
 				ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
 			}
 
@@ -1634,8 +2046,6 @@ static void streamerThreadFunc(void* pThreadData)
 			}
 		}
 
-		SyncToken nextToken = max(maxToken, getLastTokenCompleted());
-		pLoader->mCurrentTokenState[pLoader->mNextSet] = nextToken;
 		if (pResourceLoader->mDesc.mSingleThreaded)
 		{
 			return;
@@ -1701,6 +2111,13 @@ static void addResourceLoader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, Re
 		pLoader->mThread = create_thread(&pLoader->mThreadDesc);
 	}
 
+	// Decode workers need the copy thread to pick up their results
+	pLoader->pDecodeThreadSystem = NULL;
+	if (!pLoader->mDesc.mSingleThreaded && pLoader->mDesc.mDecodeThreadCount)
+	{
+		initThreadSystem(&pLoader->pDecodeThreadSystem, pLoader->mDesc.mDecodeThreadCount, 0, true, "ResourceDecode");
+	}
+
 	*ppLoader = pLoader;
 }
 
@@ -1718,6 +2135,31 @@ static void removeResourceLoader(ResourceLoader* pLoader)
 		destroy_thread(pLoader->mThread);
 	}
 
+	// Remaining decode tasks see mRun == false and leave their requests untouched
+	if (pLoader->pDecodeThreadSystem)
+	{
+		shutdownThreadSystem(pLoader->pDecodeThreadSystem);
+	}
+
+	for (uint32_t i = 0; i < MAX_LINKED_GPUS; ++i)
+	{
+		for (uint32_t p = 0; p < LOAD_PRIORITY_LEVELS; ++p)
+		{
+			for (UpdateRequest& request : pLoader->mDecodedQueue[i][p])
+			{
+				releaseLoadRequest(request);
+			}
+		}
+	}
+
+	for (uint32_t p = 0; p < LOAD_PRIORITY_LEVELS; ++p)
+	{
+		for (UpdateRequest& request : pLoader->mDecodeQueue[p])
+		{
+			releaseLoadRequest(request);
+		}
+	}
+
 	pLoader->mQueueCond.Destroy();
 	pLoader->mTokenCond.Destroy();
 	pLoader->mQueueMutex.Destroy();
@@ -1731,7 +2173,7 @@ static void queueBufferUpdate(ResourceLoader* pLoader, BufferUpdateDesc* pBuffer
 	uint32_t nodeIndex = pBufferUpdate->pBuffer->mNodeIndex;
 	pLoader->mQueueMutex.Acquire();
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	SyncToken t = allocateToken(pLoader, LOAD_PRIORITY_ORDERED);
 
 	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pBufferUpdate));
 	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
@@ -1743,32 +2185,41 @@ static void queueBufferUpdate(ResourceLoader* pLoader, BufferUpdateDesc* pBuffer
 	if (token) *token = max(t, *token);
 }
 
-static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDesc* pTextureUpdate, SyncToken* token)
+static void queueLoadRequest(ResourceLoader* pLoader, const UpdateRequest& request, uint32_t nodeIndex, SyncToken* token)
 {
-	uint32_t nodeIndex = pTextureUpdate->mNodeIndex;
+	ASSERT(request.mPriority >= LOAD_PRIORITY_LOW && request.mPriority <= LOAD_PRIORITY_HIGH);
 	pLoader->mQueueMutex.Acquire();
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	SyncToken t = allocateToken(pLoader, request.mPriority);
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
-	pLoader->mQueueMutex.Release();
-	pLoader->mQueueCond.WakeOne();
+	if (pLoader->pDecodeThreadSystem)
+	{
+		eastl::deque<UpdateRequest>& decodeQueue = pLoader->mDecodeQueue[request.mPriority - LOAD_PRIORITY_LOW];
+		decodeQueue.push_back(request);
+		decodeQueue.back().mWaitIndex = t;
+		pLoader->mQueueMutex.Release();
+		addThreadSystemTask(pLoader->pDecodeThreadSystem, decodeTaskFunc, pLoader);
+	}
+	else
+	{
+		// Without decode workers the copy thread decodes the load itself, still picking the highest priority first
+		eastl::vector<UpdateRequest>& decodedQueue = pLoader->mDecodedQueue[nodeIndex][request.mPriority - LOAD_PRIORITY_LOW];
+		decodedQueue.push_back(request);
+		decodedQueue.back().mWaitIndex = t;
+		pLoader->mQueueMutex.Release();
+		pLoader->mQueueCond.WakeOne();
+	}
 	if (token) *token = max(t, *token);
 }
 
-static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
+static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDesc* pTextureUpdate, SyncToken* token)
 {
-	uint32_t nodeIndex = pGeometryLoad->mNodeIndex;
-	pLoader->mQueueMutex.Acquire();
-
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	queueLoadRequest(pLoader, UpdateRequest(*pTextureUpdate), pTextureUpdate->mNodeIndex, token);
+}
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pGeometryLoad));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
-	pLoader->mQueueMutex.Release();
-	pLoader->mQueueCond.WakeOne();
-	if (token) *token = max(t, *token);
+static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
+{
+	queueLoadRequest(pLoader, UpdateRequest(*pGeometryLoad), pGeometryLoad->mNodeIndex, token);
 }
 
 static void queueTextureUpdate(ResourceLoader* pLoader, TextureUpdateDescInternal* pTextureUpdate, SyncToken* token)
@@ -1778,7 +2229,7 @@ static void queueTextureUpdate(ResourceLoader* pLoader, TextureUpdateDescInterna
 	uint32_t nodeIndex = pTextureUpdate->pTexture->mNodeIndex;
 	pLoader->mQueueMutex.Acquire();
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	SyncToken t = allocateToken(pLoader, LOAD_PRIORITY_ORDERED);
 
 	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
 	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
@@ -1794,7 +2245,7 @@ static void queueBufferBarrier(ResourceLoader* pLoader, Buffer* pBuffer, Resourc
 	uint32_t nodeIndex = pBuffer->mNodeIndex;
 	pLoader->mQueueMutex.Acquire();
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	SyncToken t = allocateToken(pLoader, LOAD_PRIORITY_ORDERED);
 
 	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest{ BufferBarrier{ pBuffer, RESOURCE_STATE_UNDEFINED, state } });
 	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
@@ -1808,7 +2259,7 @@ static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, Reso
 	uint32_t nodeIndex = pTexture->mNodeIndex;
 	pLoader->mQueueMutex.Acquire();
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	SyncToken t = allocateToken(pLoader, LOAD_PRIORITY_ORDERED);
 
 	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest{ TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state } });
 	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
@@ -1824,7 +2275,7 @@ static void waitForToken(ResourceLoader* pLoader, const SyncToken* token)
 		return;
 	}
 	pLoader->mTokenMutex.Acquire();
-	while (!isTokenCompleted(token))
+	while (!isTokenCompletedLocked(pLoader, *token))
 	{
 		pLoader->mTokenCond.Wait(pLoader->mTokenMutex);
 	}
@@ -1840,6 +2291,19 @@ void initResourceLoaderInterface(Renderer* pRenderer, ResourceLoaderDesc* pDesc)
 
 void exitResourceLoaderInterface(Renderer* pRenderer)
 {
+	ShaderCacheStats shaderCacheStats = {};
+	getShaderCacheStats(&shaderCacheStats);
+	const uint32_t shaderStageCount = shaderCacheStats.mHitCount + shaderCacheStats.mMissCount;
+	if (shaderStageCount)
+	{
+		LOGF(LogLevel::eINFO, "Shader cache: %u of %u stages loaded from the cache (%.1f%%)", shaderCacheStats.mHitCount, shaderStageCount,
+			100.0f * (float)shaderCacheStats.mHitCount / (float)shaderStageCount);
+	}
+	if (shaderCacheStats.mLibraryHitCount)
+	{
+		LOGF(LogLevel::eINFO, "Shader cache: %u stages loaded from shader libraries", shaderCacheStats.mLibraryHitCount);
+	}
+
 	removeResourceLoader(pResourceLoader);
 }
 
@@ -2046,10 +2510,29 @@ void beginUpdateResource(TextureUpdateDesc* pTextureUpdate)
 	const Texture* texture = pTextureUpdate->pTexture;
 	const TinyImageFormat fmt = (TinyImageFormat)texture->mFormat;
 	const uint32_t alignment = util_get_texture_subresource_alignment(pResourceLoader->pRenderer, fmt);
+	const uint32_t width = MIP_REDUCE(texture->mWidth, pTextureUpdate->mMipLevel);
+	const uint32_t height = MIP_REDUCE(texture->mHeight, pTextureUpdate->mMipLevel);
+
+	// A region covering the whole subresource is a regular update
+	if (pTextureUpdate->mRegionWidth && pTextureUpdate->mRegionHeight &&
+		(pTextureUpdate->mRegionX || pTextureUpdate->mRegionY || pTextureUpdate->mRegionWidth != width || pTextureUpdate->mRegionHeight != height))
+	{
+		ASSERT(pTextureUpdate->mRegionX + pTextureUpdate->mRegionWidth <= width);
+		ASSERT(pTextureUpdate->mRegionY + pTextureUpdate->mRegionHeight <= height);
+		ASSERT(pTextureUpdate->mRegionX % TinyImageFormat_WidthOfBlock(fmt) == 0);
+		ASSERT(pTextureUpdate->mRegionY % TinyImageFormat_HeightOfBlock(fmt) == 0);
+	}
+	else
+	{
+		pTextureUpdate->mRegionX = 0;
+		pTextureUpdate->mRegionY = 0;
+		pTextureUpdate->mRegionWidth = 0;
+		pTextureUpdate->mRegionHeight = 0;
+	}
 
 	bool success = util_get_surface_info(
-		MIP_REDUCE(texture->mWidth, pTextureUpdate->mMipLevel),
-		MIP_REDUCE(texture->mHeight, pTextureUpdate->mMipLevel),
+		pTextureUpdate->mRegionWidth ? pTextureUpdate->mRegionWidth : width,
+		pTextureUpdate->mRegionHeight ? pTextureUpdate->mRegionHeight : height,
 		fmt,
 		&pTextureUpdate->mSrcSliceStride,
 		&pTextureUpdate->mSrcRowStride,
@@ -2079,6 +2562,10 @@ void endUpdateResource(TextureUpdateDesc* pTextureUpdate, SyncToken* token)
 	desc.mMipLevels = 1;
 	desc.mBaseArrayLayer = pTextureUpdate->mArrayLayer;
 	desc.mLayerCount = 1;
+	desc.mRegionX = pTextureUpdate->mRegionX;
+	desc.mRegionY = pTextureUpdate->mRegionY;
+	desc.mRegionWidth = pTextureUpdate->mRegionWidth;
+	desc.mRegionHeight = pTextureUpdate->mRegionHeight;
 	queueTextureUpdate(pResourceLoader, &desc, token);
 
 	// Restore the state to before the beginUpdateResource call.
@@ -2097,7 +2584,13 @@ SyncToken getLastTokenCompleted()
 
 bool isTokenCompleted(const SyncToken* token)
 {
-	return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted);
+	if (*token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted))
+	{
+		return true;
+	}
+
+	MutexLock lock(pResourceLoader->mTokenMutex);
+	return isTokenCompletedLocked(pResourceLoader, *token);
 }
 
 void waitForToken(const SyncToken* token)
@@ -2113,8 +2606,17 @@ bool allResourceLoadsCompleted()
 
 void waitForAllResourceLoads()
 {
+	if (pResourceLoader->mDesc.mSingleThreaded)
+	{
+		return;
+	}
+	// Not waitForToken: the last token can be a high priority load that completed ahead of older loads
 	SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter);
-	waitForToken(pResourceLoader, &token);
+	MutexLock lock(pResourceLoader->mTokenMutex);
+	while (token > tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCompleted))
+	{
+		pResourceLoader->mTokenCond.Wait(pResourceLoader->mTokenMutex);
+	}
 }
 /************************************************************************/
 // Shader loading
@@ -2181,6 +2683,16 @@ void vk_compileShader(
 	shaderc_compiler_release(compiler);
 }
 #else
+// Replaces pDstPath with pSrcPath in one step, so readers of pDstPath never see a partially written file
+static bool replaceFile(const char* pSrcPath, const char* pDstPath)
+{
+#if defined(_WINDOWS)
+	return MoveFileExA(pSrcPath, pDstPath, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(pSrcPath, pDstPath) == 0;
+#endif
+}
+
 // PC:
 // Vulkan has no builtin functions to compile source to spirv
 // So we call the glslangValidator tool located inside VulkanSDK on user machine to compile the glsl code to spirv
@@ -2194,6 +2706,12 @@ void vk_compileShader(
 	fsAppendPathComponent(fsGetResourceDirectory(RD_SHADER_SOURCES), fileName, filePath);
 	char outFilePath[FS_MAX_PATH] = { 0 };
 	fsAppendPathComponent(fsGetResourceDirectory(RD_SHADER_BINARIES), outFile, outFilePath);
+	// glslangValidator writes to a temporary file which replaces outFile once it is complete, so an interrupted
+	// or failed compile never leaves a truncated binary in the cache
+	char tmpFile[FS_MAX_PATH] = { 0 };
+	snprintf(tmpFile, sizeof(tmpFile), "%s.%llu.tmp", outFile, (unsigned long long)Thread::GetCurrentThreadID());
+	char tmpFilePath[FS_MAX_PATH] = { 0 };
+	fsAppendPathComponent(fsGetResourceDirectory(RD_SHADER_BINARIES), tmpFile, tmpFilePath);
 	
 	// If there is a config file located in the shader source directory use it to specify the limits
 	FileStream confStream = {};
@@ -2208,13 +2726,13 @@ void vk_compileShader(
 			"\"%s\" -V \"%s\" -o \"%s\"",
 			configFilePath,
 			filePath,
-			outFilePath);
+			tmpFilePath);
 	}
 	else
 	{
 		commandLine.append_sprintf("-V \"%s\" -o \"%s\"",
 			filePath,
-			outFilePath);
+			tmpFilePath);
 	}
 
 	if (target >= shader_target_6_0)
@@ -2256,16 +2774,25 @@ void vk_compileShader(
 	if (systemRun(glslangValidator.c_str(), args, 1, logFilePath) == 0)
 	{
 		FileStream fh = {};
-		bool success = fsOpenStreamFromPath(RD_SHADER_BINARIES, outFile, FM_READ_BINARY, &fh);
+		bool success = fsOpenStreamFromPath(RD_SHADER_BINARIES, tmpFile, FM_READ_BINARY, &fh);
 		//Check if the File Handle exists
 		ASSERT(success);
 		pOut->mByteCodeSize = (uint32_t)fsGetStreamFileSize(&fh);
 		pOut->pByteCode = tf_malloc(pOut->mByteCodeSize);
 		fsReadFromStream(&fh, pOut->pByteCode, pOut->mByteCodeSize);
 		fsCloseStream(&fh);
+
+		// The byte code is already loaded, failing to cache it only costs a compile next time
+		if (!replaceFile(tmpFilePath, outFilePath))
+		{
+			LOGF(LogLevel::eWARNING, "Failed to move compiled shader %s to %s", tmpFilePath, outFilePath);
+			remove(tmpFilePath);
+		}
 	}
 	else
 	{
+		remove(tmpFilePath);
+
 		FileStream fh = {};
 		// If for some reason the error file could not be created just log error msg
 		if (!fsOpenStreamFromPath(RD_SHADER_BINARIES, logFileName, FM_READ_BINARY, &fh))
@@ -2410,6 +2937,10 @@ extern bool prospero_compileShader(
 extern void gl_compileShader(Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
 	bool enablePrimitiveId, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint);
 #endif
+#if defined(NULL_RENDERER)
+extern void null_compileShader(Renderer* pRenderer, ShaderTarget target, ShaderStage stage, const char* fileName, uint32_t codeSize, const char* code,
+	bool enablePrimitiveId, uint32_t macroCount, ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, const char* pEntryPoint);
+#endif
 
 static eastl::string fsReadFromStreamSTLLine(FileStream* stream)
 {
@@ -2443,27 +2974,86 @@ static eastl::string fsReadFromStreamSTLLine(FileStream* stream)
 	return result;
 }
 
-// Function to generate the timestamp of this shader source file considering all include file timestamp
+/************************************************************************/
+// Shader binary cache
+/************************************************************************/
+// Binaries are named after a hash of everything the compiler output depends on: the source with all its #include files,
+// the macros, the API, target, stage, entry point, flags and the compiler. A binary that exists is up to date, so no
+// timestamps are compared and the same cache can be copied between machines.
+// Bump SHADER_CACHE_VERSION whenever a compiler or the options passed to it change.
+#define SHADER_CACHE_VERSION 1
+
+static tfrg_atomic32_t gShaderCacheHitCount = 0;
+static tfrg_atomic32_t gShaderCacheMissCount = 0;
+static tfrg_atomic32_t gShaderLibraryHitCount = 0;
+
+static uint64_t shaderCacheHash(uint64_t hash, const void* pData, size_t size)
+{
+	// FNV-1a
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ pBytes[i]) * 0x100000001b3ull;
+	return hash;
+}
+
+// Hashes the terminator as well so that consecutive strings can not alias each other
+static uint64_t shaderCacheHashString(uint64_t hash, const char* str)
+{
+	return shaderCacheHash(hash, str, strlen(str) + 1);
+}
+
 #if !defined(NX64)
-static bool process_source_file(const char* pAppName, FileStream* original, const char* filePath, FileStream* file, time_t& outTimeStamp, eastl::string& outCode)
+static uint64_t shaderCacheHashCompiler(uint64_t hash)
 {
-	// If the source if a non-packaged file, store the timestamp
-	if (file)
+	const uint32_t version = SHADER_CACHE_VERSION;
+	hash = shaderCacheHash(hash, &version, sizeof(version));
+#if defined(VULKAN) && !defined(__ANDROID__) && !defined(NX64)
+	// glslangValidator is taken from the Vulkan SDK, whose install path contains its version.
+	// Keep in sync with the platform macro and the config file used by vk_compileShader
+	const char* pVulkanSdk = getenv("VULKAN_SDK");
+	hash = shaderCacheHashString(hash, pVulkanSdk ? pVulkanSdk : "");
+#ifdef _WINDOWS
+	hash = shaderCacheHashString(hash, "WINDOWS");
+#elif defined(__linux__)
+	hash = shaderCacheHashString(hash, "LINUX");
+#endif
+	FileStream confStream = {};
+	if (fsOpenStreamFromPath(RD_SHADER_SOURCES, "config.conf", FM_READ_BINARY, &confStream))
 	{
-		time_t fileTimeStamp = fsGetLastModifiedTime(RD_SHADER_SOURCES, filePath);
-
-		if (fileTimeStamp > outTimeStamp)
-			outTimeStamp = fileTimeStamp;
+		while (!fsStreamAtEnd(&confStream))
+		{
+			eastl::string line = fsReadFromStreamSTLLine(&confStream);
+			hash = shaderCacheHashString(hash, line.c_str());
+		}
+		fsCloseStream(&confStream);
 	}
-	else
+#endif
+	return hash;
+}
+#endif
+
+void getShaderCacheStats(ShaderCacheStats* pOutStats)
+{
+	ASSERT(pOutStats);
+	pOutStats->mHitCount = tfrg_atomic32_load_relaxed(&gShaderCacheHitCount);
+	pOutStats->mMissCount = tfrg_atomic32_load_relaxed(&gShaderCacheMissCount);
+	pOutStats->mLibraryHitCount = tfrg_atomic32_load_relaxed(&gShaderLibraryHitCount);
+}
+
+// Function to hash the contents of this shader source file and of all the files it includes
+#if !defined(NX64)
+static bool process_source_file(const char* pAppName, FileStream* original, const char* filePath, FileStream* file, uint64_t& outHash, eastl::string& outCode)
+{
+	if (!file)
 	{
-		return true; // The source file is missing, but we may still be able to use the shader binary.
+		return true; // The source file is missing, the caller reports it
 	}
 
 	const eastl::string pIncludeDirective = "#include";
 	while (!fsStreamAtEnd(file))
 	{
 		eastl::string line = fsReadFromStreamSTLLine(file);
+		outHash = shaderCacheHashString(outHash, line.c_str());
 
 		size_t        filePos = line.find(pIncludeDirective, 0);
 		const size_t  commentPosCpp = line.find("//", 0);
@@ -2517,7 +3107,7 @@ static bool process_source_file(const char* pAppName, FileStream* original, cons
 			}
 
 			// Add the include file into the current code recursively
-			if (!process_source_file(pAppName, original, includePath, &fHandle, outTimeStamp, outCode))
+			if (!process_source_file(pAppName, original, includePath, &fHandle, outHash, outCode))
 			{
 				fsCloseStream(&fHandle);
 				return false;
@@ -2554,21 +3144,12 @@ static bool process_source_file(const char* pAppName, FileStream* original, cons
 }
 #endif
 
-// Loads the bytecode from file if the binary shader file is newer than the source
-bool check_for_byte_code(Renderer* pRenderer, const char* binaryShaderPath, time_t sourceTimeStamp, BinaryShaderStageDesc* pOut)
+// Loads the bytecode from file if it was already compiled. The binary name identifies the source and the compile options
+bool check_for_byte_code(Renderer* pRenderer, const char* binaryShaderPath, BinaryShaderStageDesc* pOut)
 {
-	// If source code is loaded from a package, its timestamp will be zero. Else check that binary is not older
-	// than source
-	time_t dstTimeStamp = fsGetLastModifiedTime(RD_SHADER_BINARIES, binaryShaderPath);
-	if (!sourceTimeStamp || (dstTimeStamp < sourceTimeStamp))
-		return false;
-
 	FileStream fh = {};
 	if (!fsOpenStreamFromPath(RD_SHADER_BINARIES, binaryShaderPath, FM_READ_BINARY, &fh))
-	{
-		LOGF(LogLevel::eERROR, "'%s' is not a valid shader bytecode file", binaryShaderPath);
 		return false;
-	}
 
 	if (!fsGetStreamFileSize(&fh))
 	{
@@ -2607,15 +3188,63 @@ bool save_byte_code(const char* binaryShaderPath, char* byteCode, uint32_t byteC
 	return true;
 }
 
+// Stages loaded by one addShaders call. Stages sharing a binary are compiled once, the others wait for it and load it from the cache
+typedef struct ShaderCompileBatch
+{
+	Mutex                   mMutex;
+	// Signaled each time a stage is done compiling
+	ConditionVariable       mCompiled;
+	eastl::vector<uint64_t> mCompilingKeys;
+} ShaderCompileBatch;
+
+#if !defined(NX64)
+static void lockShaderCacheEntry(ShaderCompileBatch* pBatch, uint64_t key)
+{
+	if (!pBatch)
+		return;
+
+	MutexLock lock(pBatch->mMutex);
+	for (;;)
+	{
+		bool compiling = false;
+		for (uint64_t compilingKey : pBatch->mCompilingKeys)
+			compiling |= compilingKey == key;
+		if (!compiling)
+		{
+			pBatch->mCompilingKeys.push_back(key);
+			return;
+		}
+		pBatch->mCompiled.Wait(pBatch->mMutex);
+	}
+}
+
+static void unlockShaderCacheEntry(ShaderCompileBatch* pBatch, uint64_t key)
+{
+	if (!pBatch)
+		return;
+
+	MutexLock lock(pBatch->mMutex);
+	for (uint32_t i = 0; i < (uint32_t)pBatch->mCompilingKeys.size(); ++i)
+	{
+		if (pBatch->mCompilingKeys[i] == key)
+		{
+			pBatch->mCompilingKeys.erase_unsorted(pBatch->mCompilingKeys.begin() + i);
+			break;
+		}
+	}
+	pBatch->mCompiled.WakeAll();
+}
+#endif
+
 bool load_shader_stage_byte_code(
 	Renderer* pRenderer, ShaderTarget target, ShaderStage stage, ShaderStage allStages, const ShaderStageLoadDesc& loadDesc, uint32_t macroCount,
-	ShaderMacro* pMacros, BinaryShaderStageDesc* pOut)
+	ShaderMacro* pMacros, BinaryShaderStageDesc* pOut, ShaderCompileBatch* pBatch)
 {
 	UNREF_PARAM(loadDesc.mFlags);
 
 	eastl::string code;
 #if !defined(NX64)
-	time_t          timeStamp = 0;
+	uint64_t cacheKey = shaderCacheHashCompiler(0xcbf29ce484222325ull);
 #endif
 
 #if !defined(METAL) && !defined(NX64)
@@ -2623,7 +3252,7 @@ bool load_shader_stage_byte_code(
 	bool sourceExists = fsOpenStreamFromPath(RD_SHADER_SOURCES, loadDesc.pFileName, FM_READ_BINARY, &sourceFileStream);
 	ASSERT(sourceExists);
 
-	if (!process_source_file(pRenderer->pName, &sourceFileStream, loadDesc.pFileName, &sourceFileStream, timeStamp, code))
+	if (!process_source_file(pRenderer->pName, &sourceFileStream, loadDesc.pFileName, sourceExists ? &sourceFileStream : NULL, cacheKey, code))
 	{
 		fsCloseStream(&sourceFileStream);
 		return false;
@@ -2669,7 +3298,7 @@ bool load_shader_stage_byte_code(
 	FileStream sourceFileStream = {};
 	bool sourceExists = fsOpenStreamFromPath(RD_SHADER_SOURCES, metalShaderPath, FM_READ_BINARY, &sourceFileStream);
 	ASSERT(sourceExists);
-	if (!process_source_file(pRenderer->pName, &sourceFileStream, metalShaderPath, &sourceFileStream, timeStamp, code))
+	if (!process_source_file(pRenderer->pName, &sourceFileStream, metalShaderPath, sourceExists ? &sourceFileStream : NULL, cacheKey, code))
 	{
 		fsCloseStream(&sourceFileStream);
 		return false;
@@ -2677,16 +3306,16 @@ bool load_shader_stage_byte_code(
 #endif
 
 #ifndef NX64
-	eastl::string shaderDefines;
 	// Apply user specified macros
 	for (uint32_t i = 0; i < macroCount; ++i)
 	{
-		shaderDefines += (eastl::string(pMacros[i].definition) + pMacros[i].value);
+		cacheKey = shaderCacheHashString(cacheKey, pMacros[i].definition);
+		cacheKey = shaderCacheHashString(cacheKey, pMacros[i].value);
 	}
 #ifdef _DEBUG
-	shaderDefines += "_DEBUG";
+	cacheKey = shaderCacheHashString(cacheKey, "_DEBUG");
 #else
-	shaderDefines += "NDEBUG";
+	cacheKey = shaderCacheHashString(cacheKey, "NDEBUG");
 #endif
 
 	eastl::string rendererApi;
@@ -2698,6 +3327,7 @@ bool load_shader_stage_byte_code(
 	case RENDERER_API_VULKAN: rendererApi = "Vulkan"; break;
 	case RENDERER_API_METAL: rendererApi = "Metal"; break;
 	case RENDERER_API_GLES: rendererApi = "GLES"; break;
+	case RENDERER_API_NULL: rendererApi = "Null"; break;
 	default: break;
 	}
 	char extension[FS_MAX_PATH] = { 0 };
@@ -2711,22 +3341,31 @@ bool load_shader_stage_byte_code(
 	appName = appName != pRenderer->pName ? appName : appName + "_";
 #endif
 
-	eastl::string binaryShaderComponent = fileName +
-		eastl::string().sprintf("_%zu", eastl::string_hash<eastl::string>()(shaderDefines)) + extension +
-		eastl::string().sprintf("%u", target) +
+	const uint32_t stageOptions[] = { (uint32_t)target, (uint32_t)stage, (uint32_t)loadDesc.mFlags,
 #ifdef DIRECT3D11
-		eastl::string().sprintf("%u", pRenderer->mFeatureLevel) +
+		(uint32_t)pRenderer->mFeatureLevel,
 #endif
-		".bin";
+	};
+	cacheKey = shaderCacheHashString(cacheKey, rendererApi.c_str());
+	cacheKey = shaderCacheHashString(cacheKey, loadDesc.pEntryPointName ? loadDesc.pEntryPointName : "");
+	cacheKey = shaderCacheHash(cacheKey, stageOptions, sizeof(stageOptions));
+
+	eastl::string binaryShaderComponent = eastl::string().sprintf("%s_%s_%016llx.bin", fileName, extension, (unsigned long long)cacheKey);
 
-	// Shader source is newer than binary
-	if (!check_for_byte_code(pRenderer, binaryShaderComponent.c_str(), timeStamp, pOut))
+	if (!sourceExists)
 	{
-		if (!sourceExists)
-		{
-			LOGF(eERROR, "No source shader or precompiled binary present for file %s", fileName);
-			return false;
-		}
+		LOGF(eERROR, "No source shader present for file %s", fileName);
+		return false;
+	}
+
+	lockShaderCacheEntry(pBatch, cacheKey);
+	if (check_for_byte_code(pRenderer, binaryShaderComponent.c_str(), pOut))
+	{
+		tfrg_atomic32_add_relaxed(&gShaderCacheHitCount, 1);
+	}
+	else
+	{
+		tfrg_atomic32_add_relaxed(&gShaderCacheMissCount, 1);
 
 #if defined(ORBIS)
 		orbis_compileShader(pRenderer,
@@ -2772,6 +3411,17 @@ bool load_shader_stage_byte_code(
 				macroCount, pMacros,
 				pOut, loadDesc.pEntryPointName);
 
+			if (!save_byte_code(binaryShaderComponent.c_str(), (char*)(pOut->pByteCode), pOut->mByteCodeSize))
+			{
+				LOGF(LogLevel::eWARNING, "Failed to save byte code for file %s", loadDesc.pFileName);
+			}
+#elif defined(NULL_RENDERER)
+			null_compileShader(
+				pRenderer, target, stage, loadDesc.pFileName, (uint32_t)code.size(), code.c_str(),
+				loadDesc.mFlags & SHADER_STAGE_LOAD_FLAG_ENABLE_PS_PRIMITIVEID,
+				macroCount, pMacros,
+				pOut, loadDesc.pEntryPointName);
+
 			if (!save_byte_code(binaryShaderComponent.c_str(), (char*)(pOut->pByteCode), pOut->mByteCodeSize))
 			{
 				LOGF(LogLevel::eWARNING, "Failed to save byte code for file %s", loadDesc.pFileName);
@@ -2781,12 +3431,14 @@ bool load_shader_stage_byte_code(
 		if (!pOut->pByteCode)
 		{
 			LOGF(eERROR, "Error while generating bytecode for shader %s", loadDesc.pFileName);
+			unlockShaderCacheEntry(pBatch, cacheKey);
 			fsCloseStream(&sourceFileStream);
 			ASSERT(false);
 			return false;
 		}
 #endif
 	}
+	unlockShaderCacheEntry(pBatch, cacheKey);
 #else
 #endif
 
@@ -2888,123 +3540,635 @@ bool find_shader_stage(
 	return true;
 }
 #endif
-void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShader)
+#ifndef TARGET_IOS
+typedef struct ShaderStageLoadTask
 {
-#ifndef DIRECT3D11
-	if ((uint32_t)pDesc->mTarget > pRenderer->mShaderTarget)
+	const ShaderLoadDesc*      pDesc;
+	uint32_t                   mStageIndex;
+	ShaderStage                mStage;
+	ShaderStage                mAllStages;
+	BinaryShaderStageDesc*     pOut;
+	eastl::vector<ShaderMacro> mMacros;
+	bool                       mLoaded;
+	/// Byte code points into a shader library and must not be freed
+	bool                       mFromLibrary;
+} ShaderStageLoadTask;
+
+typedef struct ShaderStageLoadBatch
+{
+	Renderer*            pRenderer;
+	ShaderStageLoadTask* pTasks;
+	ShaderCompileBatch   mCompileBatch;
+} ShaderStageLoadBatch;
+
+static void loadShaderStagesTaskFunc(void* pUser, uintptr_t begin, uintptr_t end)
+{
+	ShaderStageLoadBatch* pBatch = (ShaderStageLoadBatch*)pUser;
+	for (uintptr_t i = begin; i < end; ++i)
 	{
-		eastl::string error = eastl::string().sprintf("Requested shader target (%u) is higher than the shader target that the renderer supports (%u). Shader wont be compiled",
-			(uint32_t)pDesc->mTarget, (uint32_t)pRenderer->mShaderTarget);
-		LOGF(LogLevel::eERROR, error.c_str());
-		return;
+		ShaderStageLoadTask* pTask = &pBatch->pTasks[i];
+		if (pTask->mLoaded)
+			continue;
+		pTask->mLoaded = load_shader_stage_byte_code(
+			pBatch->pRenderer, pTask->pDesc->mTarget, pTask->mStage, pTask->mAllStages, pTask->pDesc->mStages[pTask->mStageIndex],
+			(uint32_t)pTask->mMacros.size(), pTask->mMacros.data(), pTask->pOut, &pBatch->mCompileBatch);
 	}
-#endif
+}
 
-#ifndef TARGET_IOS
-	BinaryShaderDesc      binaryDesc = {};
-#if defined(METAL)
-	char* pSources[SHADER_STAGE_COUNT] = {};
+// Whether the shader compiler of the renderer can run on several threads at once
+static bool canCompileShadersInParallel(Renderer* pRenderer)
+{
+#if defined(ORBIS) || defined(PROSPERO)
+	return false;
+#else
+	// gl_compileShader needs the GL context of the calling thread
+	return pRenderer->mApi != RENDERER_API_GLES;
 #endif
+}
 
-	ShaderStage stages = SHADER_STAGE_NONE;
-	for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
-	{
-		if (pDesc->mStages[i].pFileName && strlen(pDesc->mStages[i].pFileName) != 0)
-		{
-			ShaderStage            stage;
-			BinaryShaderStageDesc* pStage = NULL;
-			char ext[FS_MAX_PATH] = { 0 };
-			fsGetPathExtension(pDesc->mStages[i].pFileName, ext);
-			if (find_shader_stage(ext, &binaryDesc, &pStage, &stage))
-				stages |= stage;
-		}
-	}
-	for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
+static void freeShaderByteCode(BinaryShaderDesc* pBinaryDesc, ShaderStage stages)
+{
+#if !defined(PROSPERO)
+	if (stages & SHADER_STAGE_VERT)
+		tf_free(pBinaryDesc->mVert.pByteCode);
+	if (stages & SHADER_STAGE_FRAG)
+		tf_free(pBinaryDesc->mFrag.pByteCode);
+	if (stages & SHADER_STAGE_COMP)
+		tf_free(pBinaryDesc->mComp.pByteCode);
+#if !defined(METAL)
+	if (stages & SHADER_STAGE_TESC)
+		tf_free(pBinaryDesc->mHull.pByteCode);
+	if (stages & SHADER_STAGE_TESE)
+		tf_free(pBinaryDesc->mDomain.pByteCode);
+	if (stages & SHADER_STAGE_GEOM)
+		tf_free(pBinaryDesc->mGeom.pByteCode);
+	if (stages & SHADER_STAGE_RAYTRACING)
+		tf_free(pBinaryDesc->mComp.pByteCode);
+#endif
+#endif
+}
+
+// Collects the stages of all shaders, they are loaded or compiled independently of each other.
+// skipped[i] is set for the shaders that can not be loaded at all
+static void gatherShaderStages(
+	Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, BinaryShaderDesc* pBinaryDescs,
+	eastl::vector<ShaderStageLoadTask>& tasks, eastl::vector<bool>& skipped)
+{
+	for (uint32_t s = 0; s < shaderCount; ++s)
 	{
-		if (pDesc->mStages[i].pFileName && strlen(pDesc->mStages[i].pFileName) != 0)
+		const ShaderLoadDesc* pDesc = &pDescs[s];
+		BinaryShaderDesc*     pBinaryDesc = &pBinaryDescs[s];
+
+#ifndef DIRECT3D11
+		if ((uint32_t)pDesc->mTarget > pRenderer->mShaderTarget)
 		{
-			const char* fileName = pDesc->mStages[i].pFileName;
+			eastl::string error = eastl::string().sprintf("Requested shader target (%u) is higher than the shader target that the renderer supports (%u). Shader wont be compiled",
+				(uint32_t)pDesc->mTarget, (uint32_t)pRenderer->mShaderTarget);
+			LOGF(LogLevel::eERROR, "%s", error.c_str());
+			skipped[s] = true;
+			continue;
+		}
+#endif
 
-			ShaderStage            stage;
-			BinaryShaderStageDesc* pStage = NULL;
-			char ext[FS_MAX_PATH] = { 0 };
-			fsGetPathExtension(fileName, ext);
-			if (find_shader_stage(ext, &binaryDesc, &pStage, &stage))
+		ShaderStage stages = SHADER_STAGE_NONE;
+		for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
+		{
+			if (pDesc->mStages[i].pFileName && strlen(pDesc->mStages[i].pFileName) != 0)
+			{
+				ShaderStage            stage;
+				BinaryShaderStageDesc* pStage = NULL;
+				char ext[FS_MAX_PATH] = { 0 };
+				fsGetPathExtension(pDesc->mStages[i].pFileName, ext);
+				if (find_shader_stage(ext, pBinaryDesc, &pStage, &stage))
+					stages |= stage;
+			}
+		}
+		for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
+		{
+			if (pDesc->mStages[i].pFileName && strlen(pDesc->mStages[i].pFileName) != 0)
 			{
-				const uint32_t macroCount = pDesc->mStages[i].mMacroCount + pRenderer->mBuiltinShaderDefinesCount;
-				eastl::vector<ShaderMacro> macros(macroCount);
-				for (uint32_t macro = 0; macro < pRenderer->mBuiltinShaderDefinesCount; ++macro)
-					macros[macro] = pRenderer->pBuiltinShaderDefines[macro];
-				for (uint32_t macro = 0; macro < pDesc->mStages[i].mMacroCount; ++macro)
-					macros[pRenderer->mBuiltinShaderDefinesCount + macro] = pDesc->mStages[i].pMacros[macro];
-
-				if (!load_shader_stage_byte_code(
-					pRenderer, pDesc->mTarget, stage, stages, pDesc->mStages[i], macroCount, macros.data(),
-					pStage))
-					return;
-
-				binaryDesc.mStages |= stage;
+				ShaderStage            stage;
+				BinaryShaderStageDesc* pStage = NULL;
+				char ext[FS_MAX_PATH] = { 0 };
+				fsGetPathExtension(pDesc->mStages[i].pFileName, ext);
+				if (find_shader_stage(ext, pBinaryDesc, &pStage, &stage))
+				{
+					ShaderStageLoadTask task = {};
+					task.pDesc = pDesc;
+					task.mStageIndex = i;
+					task.mStage = stage;
+					task.mAllStages = stages;
+					task.pOut = pStage;
+
+					const uint32_t macroCount = pDesc->mStages[i].mMacroCount + pRenderer->mBuiltinShaderDefinesCount;
+					task.mMacros.resize(macroCount);
+					for (uint32_t macro = 0; macro < pRenderer->mBuiltinShaderDefinesCount; ++macro)
+						task.mMacros[macro] = pRenderer->pBuiltinShaderDefines[macro];
+					for (uint32_t macro = 0; macro < pDesc->mStages[i].mMacroCount; ++macro)
+						task.mMacros[pRenderer->mBuiltinShaderDefinesCount + macro] = pDesc->mStages[i].pMacros[macro];
+					tasks.push_back(eastl::move(task));
+				}
+			}
+		}
+	}
+}
+
+// Loads the stages that are not loaded yet from the binary cache, compiling the missing ones
+static void loadShaderStages(Renderer* pRenderer, eastl::vector<ShaderStageLoadTask>& tasks)
+{
+	ShaderStageLoadBatch batch = {};
+	batch.pRenderer = pRenderer;
+	batch.pTasks = tasks.data();
+	batch.mCompileBatch.mMutex.Init();
+	batch.mCompileBatch.mCompiled.Init();
+
+	ShaderCacheStats statsBefore = {};
+	getShaderCacheStats(&statsBefore);
+	const int64_t startTime = getUSec();
+
+	ThreadSystem* pThreadSystem = pResourceLoader ? pResourceLoader->pDecodeThreadSystem : NULL;
+	if (pThreadSystem && tasks.size() > 1 && canCompileShadersInParallel(pRenderer))
+		parallelFor(pThreadSystem, 0, tasks.size(), 1, loadShaderStagesTaskFunc, &batch);
+	else
+		loadShaderStagesTaskFunc(&batch, 0, tasks.size());
+
+	batch.mCompileBatch.mCompiled.Destroy();
+	batch.mCompileBatch.mMutex.Destroy();
+
+	ShaderCacheStats statsAfter = {};
+	getShaderCacheStats(&statsAfter);
+	const uint32_t hitCount = statsAfter.mHitCount - statsBefore.mHitCount;
+	const uint32_t missCount = statsAfter.mMissCount - statsBefore.mMissCount;
+	if (missCount)
+	{
+		// Counters are global, stages loaded concurrently by other threads can show up in these numbers
+		LOGF(LogLevel::eINFO, "Shader cache: %u of %u stages loaded from the cache (%.1f%%), compiled %u in %.1f ms",
+			hitCount, hitCount + missCount, 100.0f * (float)hitCount / (float)(hitCount + missCount), missCount,
+			(float)(getUSec() - startTime) / 1000.0f);
+	}
+}
+#endif
+/************************************************************************/
+// Shader library
+/************************************************************************/
+// Layout (little endian):
+//   ShaderLibraryHeader, padded to SHADER_LIBRARY_DATA_ALIGNMENT
+//   Byte code of every entry, each starting at a multiple of SHADER_LIBRARY_DATA_ALIGNMENT
+//   ShaderLibraryEntry[mEntryCount] at mEntryOffset, sorted by mKey
+//
+// Entries are keyed by the permutation (file name, stage, macros, entry point, flags, target) rather than by the
+// source contents, so a lookup touches neither the shader sources nor the file system. Each entry also records a
+// hash of its source and includes: debug builds check it on every hit and load stale stages through the binary
+// cache instead, release builds trust the build step calling saveShaderLibrary to rebuild the library.
+#define SHADER_LIBRARY_MAGIC 0x4C534654 // "TFSL"
+#define SHADER_LIBRARY_VERSION 2
+#define SHADER_LIBRARY_DATA_ALIGNMENT 256
+#define MAX_SHADER_LIBRARIES 8
+
+typedef struct ShaderLibraryHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	/// RendererApi the byte code was compiled for
+	uint32_t mApi;
+	uint32_t mEntryCount;
+	uint64_t mEntryOffset;
+	uint64_t mReserved;
+} ShaderLibraryHeader;
+
+typedef struct ShaderLibraryEntry
+{
+	uint64_t mKey;
+	/// Hash of the stage source and the files it includes when the entry was built
+	uint64_t mSourceHash;
+	uint64_t mOffset;
+	uint32_t mSize;
+	uint32_t mReserved;
+} ShaderLibraryEntry;
+
+COMPILE_ASSERT(sizeof(ShaderLibraryHeader) == 32);
+COMPILE_ASSERT(sizeof(ShaderLibraryEntry) == 32);
+
+typedef struct ShaderLibrary
+{
+	FileStream                mFile;
+	/// Whole library, either the mapping of mFile or pFileData
+	const uint8_t*            pData;
+	void*                     pFileData;
+	const ShaderLibraryEntry* pEntries;
+	uint32_t                  mEntryCount;
+} ShaderLibrary;
+
+static ShaderLibrary* gShaderLibraries[MAX_SHADER_LIBRARIES] = {};
+
+#ifndef TARGET_IOS
+static uint64_t shaderPermutationKey(Renderer* pRenderer, const ShaderStageLoadTask* pTask)
+{
+	const ShaderStageLoadDesc* pStageDesc = &pTask->pDesc->mStages[pTask->mStageIndex];
+	uint64_t key = 0xcbf29ce484222325ull;
+	key = shaderCacheHashString(key, pStageDesc->pFileName);
+	key = shaderCacheHashString(key, pStageDesc->pEntryPointName ? pStageDesc->pEntryPointName : "");
+	for (const ShaderMacro& macro : pTask->mMacros)
+	{
+		key = shaderCacheHashString(key, macro.definition);
+		key = shaderCacheHashString(key, macro.value);
+	}
+	const uint32_t stageOptions[] = { (uint32_t)pRenderer->mApi, (uint32_t)pTask->pDesc->mTarget, (uint32_t)pTask->mStage,
+									  (uint32_t)pStageDesc->mFlags,
+#ifdef DIRECT3D11
+									  (uint32_t)pRenderer->mFeatureLevel,
+#endif
+	};
+	return shaderCacheHash(key, stageOptions, sizeof(stageOptions));
+}
+
+// Hash of the stage source and the files it includes, 0 where the sources are not available
+static uint64_t shaderSourceHash(Renderer* pRenderer, const ShaderStageLoadDesc* pStageDesc)
+{
+#if defined(NX64)
+	UNREF_PARAM(pRenderer);
+	UNREF_PARAM(pStageDesc);
+	return 0;
+#else
 #if defined(METAL)
-				if (pDesc->mStages[i].pEntryPointName)
-					pStage->pEntryPoint = pDesc->mStages[i].pEntryPointName;
-				else
-					pStage->pEntryPoint = "stageMain";
+	char sourcePath[FS_MAX_PATH] = {};
+	fsAppendPathExtension(pStageDesc->pFileName, "metal", sourcePath);
+#else
+	const char* sourcePath = pStageDesc->pFileName;
+#endif
+	FileStream sourceFileStream = {};
+	if (!fsOpenStreamFromPath(RD_SHADER_SOURCES, sourcePath, FM_READ_BINARY, &sourceFileStream))
+		return 0;
 
-				char metalFileName[FS_MAX_PATH] = {0};
-				fsAppendPathExtension(fileName, "metal", metalFileName);
+	uint64_t      hash = 0xcbf29ce484222325ull;
+	eastl::string code;
+	process_source_file(pRenderer->pName, &sourceFileStream, sourcePath, &sourceFileStream, hash, code);
+	fsCloseStream(&sourceFileStream);
+	return hash;
+#endif
+}
 
-				FileStream fh = {};
-				fsOpenStreamFromPath(RD_SHADER_SOURCES, metalFileName, FM_READ_BINARY, &fh);
-				size_t metalFileSize = fsGetStreamFileSize(&fh);
-				pSources[i] = (char*)tf_malloc(metalFileSize + 1);
-				pStage->pSource = pSources[i];
-				pStage->mSourceSize = (uint32_t)metalFileSize;
-				fsReadFromStream(&fh, pSources[i], metalFileSize);
-				pSources[i][metalFileSize] = 0; // Ensure the shader text is null-terminated
-				fsCloseStream(&fh);
-#elif !defined(ORBIS) && !defined(PROSPERO)
-				if (pDesc->mStages[i].pEntryPointName)
-					pStage->pEntryPoint = pDesc->mStages[i].pEntryPointName;
-				else
-					pStage->pEntryPoint = "main";
+static const ShaderLibraryEntry* findShaderLibraryEntry(const ShaderLibrary* pLibrary, uint64_t key)
+{
+	uint32_t first = 0;
+	uint32_t count = pLibrary->mEntryCount;
+	while (count)
+	{
+		uint32_t half = count / 2;
+		if (pLibrary->pEntries[first + half].mKey < key)
+		{
+			first += half + 1;
+			count -= half + 1;
+		}
+		else
+		{
+			count = half;
+		}
+	}
+	return first < pLibrary->mEntryCount && pLibrary->pEntries[first].mKey == key ? &pLibrary->pEntries[first] : NULL;
+}
+
+// Points the stages found in the added shader libraries at their byte code
+static void loadShaderStagesFromLibraries(Renderer* pRenderer, eastl::vector<ShaderStageLoadTask>& tasks)
+{
+#if defined(PROSPERO)
+	// addShaderBinary takes ownership of the byte code
+	UNREF_PARAM(pRenderer);
+	UNREF_PARAM(tasks);
+#else
+	bool anyLibrary = false;
+	for (uint32_t l = 0; l < MAX_SHADER_LIBRARIES; ++l)
+		anyLibrary |= gShaderLibraries[l] != NULL;
+	if (!anyLibrary)
+		return;
+
+	for (ShaderStageLoadTask& task : tasks)
+	{
+		const uint64_t key = shaderPermutationKey(pRenderer, &task);
+		for (uint32_t l = 0; l < MAX_SHADER_LIBRARIES && !task.mLoaded; ++l)
+		{
+			const ShaderLibrary* pLibrary = gShaderLibraries[l];
+			const ShaderLibraryEntry* pEntry = pLibrary ? findShaderLibraryEntry(pLibrary, key) : NULL;
+#if defined(_DEBUG)
+			// Sources that are not shipped hash to 0 and the library is trusted
+			uint64_t sourceHash = pEntry ? shaderSourceHash(pRenderer, &task.pDesc->mStages[task.mStageIndex]) : 0;
+			if (sourceHash && sourceHash != pEntry->mSourceHash)
+			{
+				LOGF(LogLevel::eWARNING, "Shader library entry for %s is out of date with its source, loading it from the cache",
+					task.pDesc->mStages[task.mStageIndex].pFileName);
+				pEntry = NULL;
+				break;
+			}
 #endif
+			if (pEntry)
+			{
+				task.pOut->pByteCode = (void*)(pLibrary->pData + pEntry->mOffset);
+				task.pOut->mByteCodeSize = pEntry->mSize;
+				task.mLoaded = true;
+				task.mFromLibrary = true;
+				tfrg_atomic32_add_relaxed(&gShaderLibraryHitCount, 1);
 			}
 		}
 	}
+#endif
+}
+#endif
 
-#if defined(PROSPERO)
-	binaryDesc.mOwnByteCode = true;
+void addShaderLibrary(Renderer* pRenderer, const ShaderLibraryLoadDesc* pDesc, ShaderLibrary** ppLibrary)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->pFileName);
+	ASSERT(ppLibrary);
+
+	*ppLibrary = NULL;
+	ShaderLibrary* pLibrary = (ShaderLibrary*)tf_calloc(1, sizeof(ShaderLibrary));
+	bool success = fsOpenStreamMapped(RD_SHADER_BINARIES, pDesc->pFileName, &pLibrary->mFile);
+	uint64_t fileSize = 0;
+	if (success)
+	{
+		fileSize = (uint64_t)fsGetStreamFileSize(&pLibrary->mFile);
+		pLibrary->pData = (const uint8_t*)fsGetStreamBuffer(&pLibrary->mFile);
+		if (!pLibrary->pData)
+		{
+			// Not mappable, keep the whole library in memory so lookups still return pointers into it
+			pLibrary->pFileData = tf_memalign(SHADER_LIBRARY_DATA_ALIGNMENT, (size_t)fileSize);
+			success = fsReadFromStream(&pLibrary->mFile, pLibrary->pFileData, (size_t)fileSize) == fileSize;
+			pLibrary->pData = (const uint8_t*)pLibrary->pFileData;
+		}
+	}
+
+	if (success)
+	{
+		const ShaderLibraryHeader* pHeader = (const ShaderLibraryHeader*)pLibrary->pData;
+		success = fileSize >= sizeof(ShaderLibraryHeader) && pHeader->mMagic == SHADER_LIBRARY_MAGIC &&
+				  pHeader->mVersion == SHADER_LIBRARY_VERSION && pHeader->mEntryOffset <= fileSize &&
+				  (fileSize - pHeader->mEntryOffset) / sizeof(ShaderLibraryEntry) >= pHeader->mEntryCount;
+		if (success && pHeader->mApi != (uint32_t)pRenderer->mApi)
+		{
+			LOGF(LogLevel::eERROR, "Shader library %s was built for another renderer API (%u, expected %u)", pDesc->pFileName,
+				pHeader->mApi, (uint32_t)pRenderer->mApi);
+			success = false;
+		}
+		if (success)
+		{
+			pLibrary->pEntries = (const ShaderLibraryEntry*)(pLibrary->pData + pHeader->mEntryOffset);
+			pLibrary->mEntryCount = pHeader->mEntryCount;
+			for (uint32_t i = 0; i < pLibrary->mEntryCount && success; ++i)
+			{
+				const ShaderLibraryEntry* pEntry = &pLibrary->pEntries[i];
+				success = pEntry->mOffset <= pHeader->mEntryOffset && pEntry->mSize <= pHeader->mEntryOffset - pEntry->mOffset &&
+						  (i == 0 || pLibrary->pEntries[i - 1].mKey < pEntry->mKey);
+			}
+		}
+	}
+
+	uint32_t slot = MAX_SHADER_LIBRARIES;
+	for (uint32_t l = 0; l < MAX_SHADER_LIBRARIES && success; ++l)
+	{
+		if (!gShaderLibraries[l])
+		{
+			slot = l;
+			break;
+		}
+	}
+	if (success && slot == MAX_SHADER_LIBRARIES)
+	{
+		LOGF(LogLevel::eERROR, "Too many shader libraries, at most %u can be added", MAX_SHADER_LIBRARIES);
+		success = false;
+	}
+
+	if (!success)
+	{
+		LOGF(LogLevel::eERROR, "Failed to load shader library %s", pDesc->pFileName);
+		if (pLibrary->mFile.pIO)
+		{
+			fsCloseStream(&pLibrary->mFile);
+		}
+		tf_free(pLibrary->pFileData);
+		tf_free(pLibrary);
+		return;
+	}
+
+	gShaderLibraries[slot] = pLibrary;
+	*ppLibrary = pLibrary;
+}
+
+void removeShaderLibrary(Renderer* pRenderer, ShaderLibrary* pLibrary)
+{
+	UNREF_PARAM(pRenderer);
+	if (!pLibrary)
+		return;
+
+	for (uint32_t l = 0; l < MAX_SHADER_LIBRARIES; ++l)
+	{
+		if (gShaderLibraries[l] == pLibrary)
+			gShaderLibraries[l] = NULL;
+	}
+	fsCloseStream(&pLibrary->mFile);
+	tf_free(pLibrary->pFileData);
+	tf_free(pLibrary);
+}
+
+bool saveShaderLibrary(Renderer* pRenderer, const ShaderLibrarySaveDesc* pDesc)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->pFileName);
+	ASSERT(pDesc->mShaderCount == 0 || pDesc->pShaders);
+
+#if defined(TARGET_IOS) || defined(PROSPERO)
+	LOGF(LogLevel::eERROR, "Shader libraries are not supported on this platform");
+	return false;
+#else
+	eastl::vector<BinaryShaderDesc>    binaryDescs(pDesc->mShaderCount);
+	eastl::vector<ShaderStageLoadTask> tasks;
+	eastl::vector<bool>                skipped(pDesc->mShaderCount, false);
+	gatherShaderStages(pRenderer, pDesc->mShaderCount, pDesc->pShaders, binaryDescs.data(), tasks, skipped);
+	loadShaderStages(pRenderer, tasks);
+
+	// Permutations declared several times are stored once
+	eastl::vector<ShaderLibraryEntry> entries;
+	eastl::vector<const ShaderStageLoadTask*> entryTasks;
+	bool success = true;
+	for (const ShaderStageLoadTask& task : tasks)
+	{
+		if (!task.mLoaded)
+		{
+			LOGF(LogLevel::eERROR, "Shader library %s: failed to load %s", pDesc->pFileName, task.pDesc->mStages[task.mStageIndex].pFileName);
+			success = false;
+			continue;
+		}
+
+		ShaderLibraryEntry entry = {};
+		entry.mKey = shaderPermutationKey(pRenderer, &task);
+		entry.mSize = task.pOut->mByteCodeSize;
+		entry.mSourceHash = shaderSourceHash(pRenderer, &task.pDesc->mStages[task.mStageIndex]);
+		entries.push_back(entry);
+		entryTasks.push_back(&task);
+	}
+
+	eastl::vector<uint32_t> order(entries.size());
+	for (uint32_t i = 0; i < (uint32_t)order.size(); ++i)
+		order[i] = i;
+	eastl::sort(order.begin(), order.end(), [&entries](uint32_t a, uint32_t b) { return entries[a].mKey < entries[b].mKey; });
+
+	FileStream file = {};
+	if (success && !fsOpenStreamFromPath(RD_SHADER_BINARIES, pDesc->pFileName, FM_WRITE_BINARY, &file))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open shader library %s for writing", pDesc->pFileName);
+		success = false;
+	}
+
+	if (success)
+	{
+		const uint8_t padding[SHADER_LIBRARY_DATA_ALIGNMENT] = {};
+		eastl::vector<ShaderLibraryEntry> sortedEntries;
+		sortedEntries.reserve(entries.size());
+
+		ShaderLibraryHeader header = {};
+		header.mMagic = SHADER_LIBRARY_MAGIC;
+		header.mVersion = SHADER_LIBRARY_VERSION;
+		header.mApi = (uint32_t)pRenderer->mApi;
+		fsWriteToStream(&file, &header, sizeof(header));
+		fsWriteToStream(&file, padding, SHADER_LIBRARY_DATA_ALIGNMENT - sizeof(header));
+
+		uint64_t offset = SHADER_LIBRARY_DATA_ALIGNMENT;
+		for (uint32_t index : order)
+		{
+			ShaderLibraryEntry entry = entries[index];
+			if (!sortedEntries.empty() && sortedEntries.back().mKey == entry.mKey)
+				continue;
+
+			entry.mOffset = offset;
+			fsWriteToStream(&file, entryTasks[index]->pOut->pByteCode, entry.mSize);
+			const uint32_t paddingSize = (SHADER_LIBRARY_DATA_ALIGNMENT - entry.mSize % SHADER_LIBRARY_DATA_ALIGNMENT) % SHADER_LIBRARY_DATA_ALIGNMENT;
+			fsWriteToStream(&file, padding, paddingSize);
+			offset += entry.mSize + paddingSize;
+			sortedEntries.push_back(entry);
+		}
+
+		if (!sortedEntries.empty())
+			fsWriteToStream(&file, sortedEntries.data(), sortedEntries.size() * sizeof(ShaderLibraryEntry));
+
+		header.mEntryCount = (uint32_t)sortedEntries.size();
+		header.mEntryOffset = offset;
+		fsSeekStream(&file, SBO_START_OF_FILE, 0);
+		fsWriteToStream(&file, &header, sizeof(header));
+		success = fsFlushStream(&file);
+		fsCloseStream(&file);
+
+		LOGF(LogLevel::eINFO, "Shader library %s: %u stages, %.1f KB", pDesc->pFileName, header.mEntryCount,
+			(float)(offset + sortedEntries.size() * sizeof(ShaderLibraryEntry)) / 1024.0f);
+	}
+
+	for (const ShaderStageLoadTask& task : tasks)
+	{
+		if (task.mLoaded)
+			binaryDescs[task.pDesc - pDesc->pShaders].mStages |= task.mStage;
+	}
+	for (BinaryShaderDesc& binaryDesc : binaryDescs)
+		freeShaderByteCode(&binaryDesc, binaryDesc.mStages);
+
+	return success;
 #endif
+}
 
-	addShaderBinary(pRenderer, &binaryDesc, ppShader);
+// Set between beginPipelineRecording and endPipelineRecording
+typedef struct PipelineRecorder PipelineRecorder;
+static PipelineRecorder* pPipelineRecorder = NULL;
+static void recordShader(const ShaderLoadDesc* pDesc, Shader* pShader);
 
-#if defined(METAL)
-	for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
+void addShaders(Renderer* pRenderer, uint32_t shaderCount, const ShaderLoadDesc* pDescs, Shader** ppShaders)
+{
+#ifndef TARGET_IOS
+	eastl::vector<BinaryShaderDesc>    binaryDescs(shaderCount);
+	eastl::vector<ShaderStageLoadTask> tasks;
+	eastl::vector<bool>                skipped(shaderCount, false);
+	eastl::vector<ShaderStage>         libraryStages(shaderCount, SHADER_STAGE_NONE);
+
+	for (uint32_t s = 0; s < shaderCount; ++s)
+		ppShaders[s] = NULL;
+
+	gatherShaderStages(pRenderer, shaderCount, pDescs, binaryDescs.data(), tasks, skipped);
+	loadShaderStagesFromLibraries(pRenderer, tasks);
+	loadShaderStages(pRenderer, tasks);
+
+	for (uint32_t t = 0; t < (uint32_t)tasks.size(); ++t)
 	{
-		if (pSources[i])
+		ShaderStageLoadTask* pTask = &tasks[t];
+		const uint32_t       s = (uint32_t)(pTask->pDesc - pDescs);
+		if (!pTask->mLoaded)
 		{
-			tf_free(pSources[i]);
+			skipped[s] = true;
+			continue;
 		}
+
+		BinaryShaderStageDesc* pStage = pTask->pOut;
+		binaryDescs[s].mStages |= pTask->mStage;
+		if (pTask->mFromLibrary)
+			libraryStages[s] |= pTask->mStage;
+#if defined(METAL)
+		const ShaderStageLoadDesc* pStageDesc = &pTask->pDesc->mStages[pTask->mStageIndex];
+		if (pStageDesc->pEntryPointName)
+			pStage->pEntryPoint = pStageDesc->pEntryPointName;
+		else
+			pStage->pEntryPoint = "stageMain";
+
+		char metalFileName[FS_MAX_PATH] = {0};
+		fsAppendPathExtension(pStageDesc->pFileName, "metal", metalFileName);
+
+		FileStream fh = {};
+		fsOpenStreamFromPath(RD_SHADER_SOURCES, metalFileName, FM_READ_BINARY, &fh);
+		size_t metalFileSize = fsGetStreamFileSize(&fh);
+		char* pSource = (char*)tf_malloc(metalFileSize + 1);
+		pStage->pSource = pSource;
+		pStage->mSourceSize = (uint32_t)metalFileSize;
+		fsReadFromStream(&fh, pSource, metalFileSize);
+		pSource[metalFileSize] = 0; // Ensure the shader text is null-terminated
+		fsCloseStream(&fh);
+#elif !defined(ORBIS) && !defined(PROSPERO)
+		const ShaderStageLoadDesc* pStageDesc = &pTask->pDesc->mStages[pTask->mStageIndex];
+		if (pStageDesc->pEntryPointName)
+			pStage->pEntryPoint = pStageDesc->pEntryPointName;
+		else
+			pStage->pEntryPoint = "main";
+#else
+		UNREF_PARAM(pStage);
+#endif
 	}
+
+	for (uint32_t s = 0; s < shaderCount; ++s)
+	{
+		BinaryShaderDesc* pBinaryDesc = &binaryDescs[s];
+		if (!skipped[s])
+		{
+#if defined(PROSPERO)
+			pBinaryDesc->mOwnByteCode = true;
 #endif
-#if !defined(PROSPERO)
-	if (binaryDesc.mStages & SHADER_STAGE_VERT)
-		tf_free(binaryDesc.mVert.pByteCode);
-	if (binaryDesc.mStages & SHADER_STAGE_FRAG)
-		tf_free(binaryDesc.mFrag.pByteCode);
-	if (binaryDesc.mStages & SHADER_STAGE_COMP)
-		tf_free(binaryDesc.mComp.pByteCode);
-#if !defined(METAL)
-	if (binaryDesc.mStages & SHADER_STAGE_TESC)
-		tf_free(binaryDesc.mHull.pByteCode);
-	if (binaryDesc.mStages & SHADER_STAGE_TESE)
-		tf_free(binaryDesc.mDomain.pByteCode);
-	if (binaryDesc.mStages & SHADER_STAGE_GEOM)
-		tf_free(binaryDesc.mGeom.pByteCode);
-	if (binaryDesc.mStages & SHADER_STAGE_RAYTRACING)
-		tf_free(binaryDesc.mComp.pByteCode);
+			addShaderBinary(pRenderer, pBinaryDesc, &ppShaders[s]);
+			if (pPipelineRecorder && ppShaders[s])
+				recordShader(&pDescs[s], ppShaders[s]);
+		}
+
+#if defined(METAL)
+		if (pBinaryDesc->mStages & SHADER_STAGE_VERT)
+			tf_free(pBinaryDesc->mVert.pSource);
+		if (pBinaryDesc->mStages & SHADER_STAGE_FRAG)
+			tf_free(pBinaryDesc->mFrag.pSource);
+		if (pBinaryDesc->mStages & SHADER_STAGE_COMP)
+			tf_free(pBinaryDesc->mComp.pSource);
 #endif
+		freeShaderByteCode(pBinaryDesc, (ShaderStage)(pBinaryDesc->mStages & ~libraryStages[s]));
+	}
+#else
+	for (uint32_t s = 0; s < shaderCount; ++s)
+		addShader(pRenderer, &pDescs[s], &ppShaders[s]);
 #endif
+}
+
+void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShader)
+{
+#ifndef TARGET_IOS
+	addShaders(pRenderer, 1, pDesc, ppShader);
 #else
 	// Binary shaders are not supported on iOS.
 	ShaderDesc desc = {};
@@ -3109,4 +4273,557 @@ void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, Pipel
 #endif
 }
 /************************************************************************/
+// Asynchronous pipelines, pipeline recording and replay
+/************************************************************************/
+// Deep copy of a graphics or compute PipelineDesc, the pointers of mDesc point into the struct itself
+typedef struct PipelineDescStorage
+{
+	PipelineDesc        mDesc;
+	VertexLayout        mVertexLayout;
+	BlendStateDesc      mBlendState;
+	DepthStateDesc      mDepthState;
+	RasterizerStateDesc mRasterizerState;
+	TinyImageFormat     mColorFormats[MAX_RENDER_TARGET_ATTACHMENTS];
+	eastl::string       mName;
+} PipelineDescStorage;
+
+typedef struct AsyncPipeline
+{
+	PipelineDescStorage mStorage;
+	Renderer*           pRenderer;
+	Pipeline*           pPipeline;
+	TaskCounter         mCounter;
+} AsyncPipeline;
+
+typedef struct PipelineRecorder
+{
+	Mutex                                  mMutex;
+	/// Serialized shader recipes and pipelines, deduplicated by content. Pipelines store the root signature pointer,
+	/// endPipelineRecording replaces it by its index in PipelineRecordDesc::ppRootSignatures
+	eastl::vector<eastl::vector<uint8_t> > mShaders;
+	eastl::vector<eastl::vector<uint8_t> > mPipelines;
+	eastl::unordered_map<uint64_t, uint32_t> mShaderIndices;
+	eastl::unordered_map<uint64_t, uint32_t> mPipelineIndices;
+	/// Recipe index of every shader loaded through addShaders while recording
+	eastl::unordered_map<Shader*, uint32_t> mShaderRecipes;
+} PipelineRecorder;
+
+#define PIPELINE_RECORD_MAGIC 0x52504654 // "TFPR"
+#define PIPELINE_RECORD_VERSION 1
+
+static bool copyPipelineDesc(const PipelineDesc* pDesc, PipelineDescStorage* pOut)
+{
+	// Extensions are backend specific and raytracing descs reference arrays of unknown lifetime
+	if (pDesc->mExtensionCount || (pDesc->mType != PIPELINE_TYPE_GRAPHICS && pDesc->mType != PIPELINE_TYPE_COMPUTE))
+		return false;
+
+	pOut->mDesc = *pDesc;
+	pOut->mName = pDesc->pName ? pDesc->pName : "";
+	pOut->mDesc.pName = pDesc->pName ? pOut->mName.c_str() : NULL;
+	if (pDesc->mType == PIPELINE_TYPE_GRAPHICS)
+	{
+		const GraphicsPipelineDesc* pSrc = &pDesc->mGraphicsDesc;
+		GraphicsPipelineDesc*       pDst = &pOut->mDesc.mGraphicsDesc;
+		if (pSrc->pVertexLayout)
+		{
+			pOut->mVertexLayout = *pSrc->pVertexLayout;
+			pDst->pVertexLayout = &pOut->mVertexLayout;
+		}
+		if (pSrc->pBlendState)
+		{
+			pOut->mBlendState = *pSrc->pBlendState;
+			pDst->pBlendState = &pOut->mBlendState;
+		}
+		if (pSrc->pDepthState)
+		{
+			pOut->mDepthState = *pSrc->pDepthState;
+			pDst->pDepthState = &pOut->mDepthState;
+		}
+		if (pSrc->pRasterizerState)
+		{
+			pOut->mRasterizerState = *pSrc->pRasterizerState;
+			pDst->pRasterizerState = &pOut->mRasterizerState;
+		}
+		ASSERT(pSrc->mRenderTargetCount <= MAX_RENDER_TARGET_ATTACHMENTS);
+		if (pSrc->pColorFormats)
+		{
+			memcpy(pOut->mColorFormats, pSrc->pColorFormats, pSrc->mRenderTargetCount * sizeof(TinyImageFormat));
+			pDst->pColorFormats = pOut->mColorFormats;
+		}
+	}
+	return true;
+}
+
+static void asyncPipelineTaskFunc(void* pUser, uintptr_t)
+{
+	AsyncPipeline* pAsync = (AsyncPipeline*)pUser;
+	addPipeline(pAsync->pRenderer, &pAsync->mStorage.mDesc, &pAsync->pPipeline);
+}
+
+// Pipelines are created on the decode threads unless the backend needs the calling thread
+static ThreadSystem* getPipelineThreadSystem(Renderer* pRenderer)
+{
+	ThreadSystem* pThreadSystem = pResourceLoader ? pResourceLoader->pDecodeThreadSystem : NULL;
+	return canCompileShadersInParallel(pRenderer) ? pThreadSystem : NULL;
+}
+
+static void pipelineRecordWrite(eastl::vector<uint8_t>& buffer, const void* pData, size_t size)
+{
+	buffer.insert(buffer.end(), (const uint8_t*)pData, (const uint8_t*)pData + size);
+}
+
+static void pipelineRecordWriteU32(eastl::vector<uint8_t>& buffer, uint32_t value)
+{
+	pipelineRecordWrite(buffer, &value, sizeof(value));
+}
+
+// Strings are stored with their terminator so that they can be used in place when reading
+static void pipelineRecordWriteString(eastl::vector<uint8_t>& buffer, const char* str)
+{
+	const uint32_t size = str ? (uint32_t)strlen(str) + 1 : 0;
+	pipelineRecordWriteU32(buffer, size);
+	pipelineRecordWrite(buffer, str, size);
+}
+
+typedef struct PipelineRecordReader
+{
+	const uint8_t* pData;
+	size_t         mSize;
+	size_t         mOffset;
+	bool           mError;
+} PipelineRecordReader;
+
+static bool pipelineRecordRead(PipelineRecordReader* pReader, void* pOut, size_t size)
+{
+	if (pReader->mError || size > pReader->mSize - pReader->mOffset)
+	{
+		pReader->mError = true;
+		memset(pOut, 0, size);
+		return false;
+	}
+	memcpy(pOut, pReader->pData + pReader->mOffset, size);
+	pReader->mOffset += size;
+	return true;
+}
+
+static uint32_t pipelineRecordReadU32(PipelineRecordReader* pReader)
+{
+	uint32_t value = 0;
+	pipelineRecordRead(pReader, &value, sizeof(value));
+	return value;
+}
+
+static const char* pipelineRecordReadString(PipelineRecordReader* pReader)
+{
+	const uint32_t size = pipelineRecordReadU32(pReader);
+	if (pReader->mError || size > pReader->mSize - pReader->mOffset || (size && pReader->pData[pReader->mOffset + size - 1] != 0))
+	{
+		pReader->mError = true;
+		return NULL;
+	}
+	const char* str = size ? (const char*)pReader->pData + pReader->mOffset : NULL;
+	pReader->mOffset += size;
+	return str;
+}
+
+static uint32_t addPipelineRecordEntry(
+	eastl::vector<eastl::vector<uint8_t> >& entries, eastl::unordered_map<uint64_t, uint32_t>& indices, eastl::vector<uint8_t>& entry)
+{
+	const uint64_t key = shaderCacheHash(0xcbf29ce484222325ull, entry.data(), entry.size());
+	eastl::unordered_map<uint64_t, uint32_t>::iterator it = indices.find(key);
+	if (it != indices.end())
+		return it->second;
+
+	const uint32_t index = (uint32_t)entries.size();
+	entries.push_back(eastl::move(entry));
+	indices[key] = index;
+	return index;
+}
+
+static void recordShader(const ShaderLoadDesc* pDesc, Shader* pShader)
+{
+	eastl::vector<uint8_t> recipe;
+	pipelineRecordWriteU32(recipe, (uint32_t)pDesc->mTarget);
+	for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
+	{
+		const ShaderStageLoadDesc* pStage = &pDesc->mStages[i];
+		const bool                 used = pStage->pFileName && pStage->pFileName[0];
+		pipelineRecordWriteString(recipe, used ? pStage->pFileName : NULL);
+		if (!used)
+			continue;
+		pipelineRecordWriteString(recipe, pStage->pEntryPointName);
+		pipelineRecordWriteU32(recipe, (uint32_t)pStage->mFlags);
+		pipelineRecordWriteU32(recipe, pStage->mMacroCount);
+		for (uint32_t m = 0; m < pStage->mMacroCount; ++m)
+		{
+			pipelineRecordWriteString(recipe, pStage->pMacros[m].definition);
+			pipelineRecordWriteString(recipe, pStage->pMacros[m].value);
+		}
+	}
+
+	MutexLock lock(pPipelineRecorder->mMutex);
+	pPipelineRecorder->mShaderRecipes[pShader] = addPipelineRecordEntry(pPipelineRecorder->mShaders, pPipelineRecorder->mShaderIndices, recipe);
+}
+
+// Called by addPipeline of every backend
+void recordPipeline(const PipelineDesc* pDesc)
+{
+	if (!pPipelineRecorder || (pDesc->mType != PIPELINE_TYPE_GRAPHICS && pDesc->mType != PIPELINE_TYPE_COMPUTE))
+		return;
+
+	const Shader*        pShader = pDesc->mType == PIPELINE_TYPE_GRAPHICS ? pDesc->mGraphicsDesc.pShaderProgram : pDesc->mComputeDesc.pShaderProgram;
+	const RootSignature* pRootSignature = pDesc->mType == PIPELINE_TYPE_GRAPHICS ? pDesc->mGraphicsDesc.pRootSignature : pDesc->mComputeDesc.pRootSignature;
+
+	MutexLock lock(pPipelineRecorder->mMutex);
+	eastl::unordered_map<Shader*, uint32_t>::iterator shaderIt = pPipelineRecorder->mShaderRecipes.find((Shader*)pShader);
+	if (shaderIt == pPipelineRecorder->mShaderRecipes.end())
+	{
+		LOGF(LogLevel::eWARNING, "Pipeline %s can not be recorded, its shader was not loaded with addShader while recording", pDesc->pName ? pDesc->pName : "");
+		return;
+	}
+
+	const uint64_t rootSignature = (uint64_t)(uintptr_t)pRootSignature;
+	eastl::vector<uint8_t> entry;
+	pipelineRecordWriteU32(entry, (uint32_t)pDesc->mType);
+	pipelineRecordWriteU32(entry, shaderIt->second);
+	pipelineRecordWrite(entry, &rootSignature, sizeof(rootSignature));
+	pipelineRecordWriteString(entry, pDesc->pName);
+	if (pDesc->mType == PIPELINE_TYPE_GRAPHICS)
+	{
+		const GraphicsPipelineDesc* pGraphics = &pDesc->mGraphicsDesc;
+		const uint32_t states = (pGraphics->pVertexLayout ? 0x1 : 0) | (pGraphics->pBlendState ? 0x2 : 0) | (pGraphics->pDepthState ? 0x4 : 0) |
+								(pGraphics->pRasterizerState ? 0x8 : 0) | (pGraphics->pColorFormats ? 0x10 : 0);
+		pipelineRecordWriteU32(entry, states);
+		if (pGraphics->pVertexLayout)
+			pipelineRecordWrite(entry, pGraphics->pVertexLayout, sizeof(VertexLayout));
+		if (pGraphics->pBlendState)
+			pipelineRecordWrite(entry, pGraphics->pBlendState, sizeof(BlendStateDesc));
+		if (pGraphics->pDepthState)
+			pipelineRecordWrite(entry, pGraphics->pDepthState, sizeof(DepthStateDesc));
+		if (pGraphics->pRasterizerState)
+			pipelineRecordWrite(entry, pGraphics->pRasterizerState, sizeof(RasterizerStateDesc));
+		pipelineRecordWriteU32(entry, pGraphics->mRenderTargetCount);
+		if (pGraphics->pColorFormats)
+			pipelineRecordWrite(entry, pGraphics->pColorFormats, pGraphics->mRenderTargetCount * sizeof(TinyImageFormat));
+		pipelineRecordWriteU32(entry, (uint32_t)pGraphics->mSampleCount);
+		pipelineRecordWriteU32(entry, pGraphics->mSampleQuality);
+		pipelineRecordWriteU32(entry, (uint32_t)pGraphics->mDepthStencilFormat);
+		pipelineRecordWriteU32(entry, (uint32_t)pGraphics->mPrimitiveTopo);
+		pipelineRecordWriteU32(entry, pGraphics->mSupportIndirectCommandBuffer ? 1 : 0);
+	}
+	addPipelineRecordEntry(pPipelineRecorder->mPipelines, pPipelineRecorder->mPipelineIndices, entry);
+}
+
+void addPipelineAsync(Renderer* pRenderer, const PipelineDesc* pDesc, AsyncPipeline** ppAsyncPipeline)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppAsyncPipeline);
+
+	AsyncPipeline* pAsync = tf_new(AsyncPipeline);
+	pAsync->pRenderer = pRenderer;
+	initTaskCounter(&pAsync->mCounter);
+
+	ThreadSystem* pThreadSystem = getPipelineThreadSystem(pRenderer);
+	if (pThreadSystem && copyPipelineDesc(pDesc, &pAsync->mStorage))
+	{
+		ThreadSystemTaskDesc taskDesc = {};
+		taskDesc.pTask = asyncPipelineTaskFunc;
+		taskDesc.pUser = pAsync;
+		taskDesc.mStart = 0;
+		taskDesc.mEnd = 1;
+		taskDesc.pSignalCounter = &pAsync->mCounter;
+		addThreadSystemTasks(pThreadSystem, &taskDesc);
+	}
+	else
+	{
+		addPipeline(pRenderer, pDesc, &pAsync->pPipeline);
+	}
+
+	*ppAsyncPipeline = pAsync;
+}
+
+Pipeline* getAsyncPipeline(AsyncPipeline* pAsyncPipeline)
+{
+	ASSERT(pAsyncPipeline);
+	return isTaskCounterDone(&pAsyncPipeline->mCounter) ? pAsyncPipeline->pPipeline : NULL;
+}
+
+Pipeline* waitForAsyncPipeline(AsyncPipeline* pAsyncPipeline)
+{
+	ASSERT(pAsyncPipeline);
+	if (!isTaskCounterDone(&pAsyncPipeline->mCounter))
+		waitTaskCounter(getPipelineThreadSystem(pAsyncPipeline->pRenderer), &pAsyncPipeline->mCounter);
+	return pAsyncPipeline->pPipeline;
+}
+
+void removeAsyncPipeline(Renderer* pRenderer, AsyncPipeline* pAsyncPipeline)
+{
+	if (!pAsyncPipeline)
+		return;
+
+	Pipeline* pPipeline = waitForAsyncPipeline(pAsyncPipeline);
+	if (pPipeline)
+		removePipeline(pRenderer, pPipeline);
+	tf_delete(pAsyncPipeline);
+}
+
+void beginPipelineRecording()
+{
+	ASSERT(!pPipelineRecorder);
+
+	PipelineRecorder* pRecorder = tf_new(PipelineRecorder);
+	pRecorder->mMutex.Init();
+	pPipelineRecorder = pRecorder;
+}
+
+bool endPipelineRecording(const PipelineRecordDesc* pDesc)
+{
+	ASSERT(pPipelineRecorder);
+	ASSERT(pDesc && pDesc->pFileName);
+	// Pending addPipelineAsync tasks record from the decode threads
+	if (pResourceLoader && pResourceLoader->pDecodeThreadSystem)
+		waitThreadSystemIdle(pResourceLoader->pDecodeThreadSystem);
+	PipelineRecorder* pRecorder = pPipelineRecorder;
+	pPipelineRecorder = NULL;
+
+	// Pipelines start with their type, shader index and root signature pointer
+	const size_t rootSignatureOffset = 2 * sizeof(uint32_t);
+	eastl::vector<uint8_t> pipelines;
+	uint32_t               pipelineCount = 0;
+	for (const eastl::vector<uint8_t>& pipeline : pRecorder->mPipelines)
+	{
+		uint64_t rootSignature = 0;
+		memcpy(&rootSignature, pipeline.data() + rootSignatureOffset, sizeof(rootSignature));
+		uint32_t rootSignatureIndex = 0;
+		while (rootSignatureIndex < pDesc->mRootSignatureCount && (uint64_t)(uintptr_t)pDesc->ppRootSignatures[rootSignatureIndex] != rootSignature)
+			++rootSignatureIndex;
+		if (rootSignatureIndex == pDesc->mRootSignatureCount)
+			continue;
+
+		pipelineRecordWrite(pipelines, pipeline.data(), rootSignatureOffset);
+		pipelineRecordWriteU32(pipelines, rootSignatureIndex);
+		pipelineRecordWrite(pipelines, pipeline.data() + rootSignatureOffset + sizeof(rootSignature), pipeline.size() - rootSignatureOffset - sizeof(rootSignature));
+		++pipelineCount;
+	}
+	if (pipelineCount != (uint32_t)pRecorder->mPipelines.size())
+		LOGF(LogLevel::eWARNING, "%u recorded pipelines use a root signature missing from PipelineRecordDesc::ppRootSignatures, they are not saved",
+			(uint32_t)pRecorder->mPipelines.size() - pipelineCount);
+
+	eastl::vector<uint8_t> file;
+	pipelineRecordWriteU32(file, PIPELINE_RECORD_MAGIC);
+	pipelineRecordWriteU32(file, PIPELINE_RECORD_VERSION);
+	pipelineRecordWriteU32(file, pDesc->mRootSignatureCount);
+	pipelineRecordWriteU32(file, (uint32_t)pRecorder->mShaders.size());
+	pipelineRecordWriteU32(file, pipelineCount);
+	for (const eastl::vector<uint8_t>& shader : pRecorder->mShaders)
+		pipelineRecordWrite(file, shader.data(), shader.size());
+	pipelineRecordWrite(file, pipelines.data(), pipelines.size());
+
+	FileStream stream = {};
+	bool success = fsOpenStreamFromPath(RD_PIPELINE_CACHE, pDesc->pFileName, FM_WRITE_BINARY, &stream);
+	if (success)
+	{
+		success = fsWriteToStream(&stream, file.data(), file.size()) == file.size();
+		fsCloseStream(&stream);
+	}
+	if (success)
+		LOGF(LogLevel::eINFO, "Recorded %u pipelines using %u shaders to %s", pipelineCount, (uint32_t)pRecorder->mShaders.size(), pDesc->pFileName);
+	else
+		LOGF(LogLevel::eERROR, "Failed to write the pipeline recording %s", pDesc->pFileName);
+
+	pRecorder->mMutex.Destroy();
+	tf_delete(pRecorder);
+	return success;
+}
+
+typedef struct ReplayedPipeline
+{
+	PipelineDescStorage mStorage;
+	uint32_t            mShader;
+	uint32_t            mRootSignature;
+} ReplayedPipeline;
+
+typedef struct PipelineReplay
+{
+	Renderer*         pRenderer;
+	ReplayedPipeline* pPipelines;
+	Shader**          ppShaders;
+	RootSignature**   ppRootSignatures;
+	PipelineCache*    pCache;
+	tfrg_atomic32_t   mCreatedCount;
+} PipelineReplay;
+
+static void replayPipelinesTaskFunc(void* pUser, uintptr_t begin, uintptr_t end)
+{
+	PipelineReplay* pReplay = (PipelineReplay*)pUser;
+	for (uintptr_t i = begin; i < end; ++i)
+	{
+		ReplayedPipeline* pReplayed = &pReplay->pPipelines[i];
+		PipelineDesc*     pDesc = &pReplayed->mStorage.mDesc;
+		Shader*           pShader = pReplay->ppShaders[pReplayed->mShader];
+		if (!pShader)
+			continue;
+		pDesc->pCache = pReplay->pCache;
+		if (pDesc->mType == PIPELINE_TYPE_GRAPHICS)
+		{
+			pDesc->mGraphicsDesc.pShaderProgram = pShader;
+			pDesc->mGraphicsDesc.pRootSignature = pReplay->ppRootSignatures[pReplayed->mRootSignature];
+		}
+		else
+		{
+			pDesc->mComputeDesc.pShaderProgram = pShader;
+			pDesc->mComputeDesc.pRootSignature = pReplay->ppRootSignatures[pReplayed->mRootSignature];
+		}
+
+		Pipeline* pPipeline = NULL;
+		addPipeline(pReplay->pRenderer, pDesc, &pPipeline);
+		if (pPipeline)
+		{
+			removePipeline(pReplay->pRenderer, pPipeline);
+			tfrg_atomic32_add_relaxed(&pReplay->mCreatedCount, 1);
+		}
+	}
+}
+
+uint32_t replayPipelines(Renderer* pRenderer, const PipelineReplayDesc* pDesc)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->pFileName);
+
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_PIPELINE_CACHE, pDesc->pFileName, FM_READ_BINARY, &stream))
+		return 0;
+
+	const int64_t startTime = getUSec();
+	eastl::vector<uint8_t> file((size_t)max((ssize_t)0, fsGetStreamFileSize(&stream)));
+	const bool readSuccess = fsReadFromStream(&stream, file.data(), file.size()) == file.size();
+	fsCloseStream(&stream);
+
+	PipelineRecordReader reader = { file.data(), readSuccess ? file.size() : 0, 0, false };
+	const uint32_t magic = pipelineRecordReadU32(&reader);
+	const uint32_t version = pipelineRecordReadU32(&reader);
+	const uint32_t rootSignatureCount = pipelineRecordReadU32(&reader);
+	const uint32_t shaderCount = pipelineRecordReadU32(&reader);
+	const uint32_t pipelineCount = pipelineRecordReadU32(&reader);
+	if (reader.mError || magic != PIPELINE_RECORD_MAGIC || version != PIPELINE_RECORD_VERSION)
+	{
+		LOGF(LogLevel::eWARNING, "Pipeline recording %s is invalid or outdated, nothing to replay", pDesc->pFileName);
+		return 0;
+	}
+	if (rootSignatureCount != pDesc->mRootSignatureCount)
+	{
+		LOGF(LogLevel::eWARNING, "Pipeline recording %s was made with %u root signatures, %u were passed. Nothing to replay", pDesc->pFileName,
+			rootSignatureCount, pDesc->mRootSignatureCount);
+		return 0;
+	}
+
+	// Shader recipes point into the file data
+	eastl::vector<ShaderLoadDesc> shaderDescs(shaderCount);
+	eastl::vector<eastl::vector<ShaderMacro> > shaderMacros(shaderCount * SHADER_STAGE_COUNT);
+	for (uint32_t s = 0; s < shaderCount && !reader.mError; ++s)
+	{
+		ShaderLoadDesc* pShaderDesc = &shaderDescs[s];
+		memset(pShaderDesc, 0, sizeof(*pShaderDesc));
+		pShaderDesc->mTarget = (ShaderTarget)pipelineRecordReadU32(&reader);
+		for (uint32_t i = 0; i < SHADER_STAGE_COUNT && !reader.mError; ++i)
+		{
+			ShaderStageLoadDesc* pStage = &pShaderDesc->mStages[i];
+			pStage->pFileName = pipelineRecordReadString(&reader);
+			if (!pStage->pFileName)
+				continue;
+			pStage->pEntryPointName = pipelineRecordReadString(&reader);
+			pStage->mFlags = (ShaderStageLoadFlags)pipelineRecordReadU32(&reader);
+			const uint32_t macroCount = pipelineRecordReadU32(&reader);
+			eastl::vector<ShaderMacro>& macros = shaderMacros[s * SHADER_STAGE_COUNT + i];
+			for (uint32_t m = 0; m < macroCount && !reader.mError; ++m)
+			{
+				ShaderMacro macro = {};
+				macro.definition = pipelineRecordReadString(&reader);
+				macro.value = pipelineRecordReadString(&reader);
+				macro.definition = macro.definition ? macro.definition : "";
+				macro.value = macro.value ? macro.value : "";
+				macros.push_back(macro);
+			}
+			pStage->pMacros = macros.data();
+			pStage->mMacroCount = (uint32_t)macros.size();
+		}
+	}
+
+	eastl::vector<ReplayedPipeline> pipelines(pipelineCount);
+	for (uint32_t p = 0; p < pipelineCount && !reader.mError; ++p)
+	{
+		ReplayedPipeline* pReplayed = &pipelines[p];
+		PipelineDesc      desc = {};
+		desc.mType = (PipelineType)pipelineRecordReadU32(&reader);
+		pReplayed->mShader = pipelineRecordReadU32(&reader);
+		pReplayed->mRootSignature = pipelineRecordReadU32(&reader);
+		desc.pName = pipelineRecordReadString(&reader);
+
+		VertexLayout        vertexLayout = {};
+		BlendStateDesc      blendState = {};
+		DepthStateDesc      depthState = {};
+		RasterizerStateDesc rasterizerState = {};
+		TinyImageFormat     colorFormats[MAX_RENDER_TARGET_ATTACHMENTS] = {};
+		if (desc.mType == PIPELINE_TYPE_GRAPHICS)
+		{
+			GraphicsPipelineDesc* pGraphics = &desc.mGraphicsDesc;
+			const uint32_t        states = pipelineRecordReadU32(&reader);
+			if ((states & 0x1) && pipelineRecordRead(&reader, &vertexLayout, sizeof(vertexLayout)))
+				pGraphics->pVertexLayout = &vertexLayout;
+			if ((states & 0x2) && pipelineRecordRead(&reader, &blendState, sizeof(blendState)))
+				pGraphics->pBlendState = &blendState;
+			if ((states & 0x4) && pipelineRecordRead(&reader, &depthState, sizeof(depthState)))
+				pGraphics->pDepthState = &depthState;
+			if ((states & 0x8) && pipelineRecordRead(&reader, &rasterizerState, sizeof(rasterizerState)))
+				pGraphics->pRasterizerState = &rasterizerState;
+			pGraphics->mRenderTargetCount = min(pipelineRecordReadU32(&reader), (uint32_t)MAX_RENDER_TARGET_ATTACHMENTS);
+			if ((states & 0x10) && pipelineRecordRead(&reader, colorFormats, pGraphics->mRenderTargetCount * sizeof(TinyImageFormat)))
+				pGraphics->pColorFormats = colorFormats;
+			pGraphics->mSampleCount = (SampleCount)pipelineRecordReadU32(&reader);
+			pGraphics->mSampleQuality = pipelineRecordReadU32(&reader);
+			pGraphics->mDepthStencilFormat = (TinyImageFormat)pipelineRecordReadU32(&reader);
+			pGraphics->mPrimitiveTopo = (PrimitiveTopology)pipelineRecordReadU32(&reader);
+			pGraphics->mSupportIndirectCommandBuffer = pipelineRecordReadU32(&reader) != 0;
+		}
+
+		if (pReplayed->mShader >= shaderCount || pReplayed->mRootSignature >= rootSignatureCount || !copyPipelineDesc(&desc, &pReplayed->mStorage))
+			reader.mError = true;
+	}
+
+	if (reader.mError)
+	{
+		LOGF(LogLevel::eWARNING, "Pipeline recording %s is truncated or corrupt, nothing to replay", pDesc->pFileName);
+		return 0;
+	}
+
+	// Shaders come from the shader libraries or the binary cache, compiling the missing ones in parallel
+	eastl::vector<Shader*> shaders(shaderCount);
+	addShaders(pRenderer, shaderCount, shaderDescs.data(), shaders.data());
+
+	PipelineReplay replay = {};
+	replay.pRenderer = pRenderer;
+	replay.pPipelines = pipelines.data();
+	replay.ppShaders = shaders.data();
+	replay.ppRootSignatures = pDesc->ppRootSignatures;
+	replay.pCache = pDesc->pCache;
+
+	ThreadSystem* pThreadSystem = getPipelineThreadSystem(pRenderer);
+	if (pThreadSystem && pipelineCount > 1)
+		parallelFor(pThreadSystem, 0, pipelineCount, 1, replayPipelinesTaskFunc, &replay);
+	else
+		replayPipelinesTaskFunc(&replay, 0, pipelineCount);
+
+	for (Shader* pShader : shaders)
+	{
+		if (pShader)
+			removeShader(pRenderer, pShader);
+	}
+
+	const uint32_t createdCount = tfrg_atomic32_load_relaxed(&replay.mCreatedCount);
+	LOGF(LogLevel::eINFO, "Replayed %u of %u recorded pipelines from %s in %.1f ms", createdCount, pipelineCount, pDesc->pFileName,
+		(float)(getUSec() - startTime) / 1000.0f);
+	return createdCount;
+}
+/************************************************************************/
 /************************************************************************/
@@ -4554,7 +4554,7 @@ void updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDe
 	if (!(descriptor))																					\
 	{																									\
 		eastl::string msg = __FUNCTION__ + eastl::string(" : ") + eastl::string().sprintf(__VA_ARGS__);	\
-		LOGF(LogLevel::eERROR, msg.c_str());															\
+		LOGF(LogLevel::eERROR, "%s", msg.c_str());														\
 		_FailedAssert(__FILE__, __LINE__, msg.c_str());													\
 		continue;																						\
 	}
@@ -5912,8 +5912,12 @@ static void addComputePipeline(Renderer* pRenderer, const PipelineDesc* pMainDes
 	*ppPipeline = pPipeline;
 }
 
+extern void recordPipeline(const PipelineDesc* pDesc);
+
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
+	recordPipeline(pDesc);
+
 	switch (pDesc->mType)
 	{
 		case(PIPELINE_TYPE_COMPUTE):
@@ -6584,6 +6588,10 @@ typedef struct SubresourceDataDesc
 	uint64_t mSrcOffset;
 	uint32_t mMipLevel;
 	uint32_t mArrayLayer;
+	uint32_t mRegionX;
+	uint32_t mRegionY;
+	uint32_t mRegionWidth;
+	uint32_t mRegionHeight;
 	uint32_t mRowPitch;
 	uint32_t mSlicePitch;
 } SubresourceDataDesc;
@@ -6595,8 +6603,9 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 
 	if (isSinglePlane)
 	{
-		const uint32_t width = max<uint32_t>(1, pTexture->mWidth >> pSubresourceDesc->mMipLevel);
-		const uint32_t height = max<uint32_t>(1, pTexture->mHeight >> pSubresourceDesc->mMipLevel);
+		const bool region = pSubresourceDesc->mRegionWidth && pSubresourceDesc->mRegionHeight;
+		const uint32_t width = region ? pSubresourceDesc->mRegionWidth : max<uint32_t>(1, pTexture->mWidth >> pSubresourceDesc->mMipLevel);
+		const uint32_t height = region ? pSubresourceDesc->mRegionHeight : max<uint32_t>(1, pTexture->mHeight >> pSubresourceDesc->mMipLevel);
 		const uint32_t depth = max<uint32_t>(1, pTexture->mDepth >> pSubresourceDesc->mMipLevel);
 		const uint32_t numBlocksWide = pSubresourceDesc->mRowPitch / (TinyImageFormat_BitSizeOfBlock(fmt) >> 3);
 		const uint32_t numBlocksHigh = (pSubresourceDesc->mSlicePitch / pSubresourceDesc->mRowPitch);
@@ -6609,8 +6618,8 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 		copy.imageSubresource.mipLevel = pSubresourceDesc->mMipLevel;
 		copy.imageSubresource.baseArrayLayer = pSubresourceDesc->mArrayLayer;
 		copy.imageSubresource.layerCount = 1;
-		copy.imageOffset.x = 0;
-		copy.imageOffset.y = 0;
+		copy.imageOffset.x = (int32_t)pSubresourceDesc->mRegionX;
+		copy.imageOffset.y = (int32_t)pSubresourceDesc->mRegionY;
 		copy.imageOffset.z = 0;
 		copy.imageExtent.width = width;
 		copy.imageExtent.height = height;
@@ -144,6 +144,20 @@ FONS_DEF int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, struct FON
 FONS_DEF const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* height);
 FONS_DEF int fonsValidateTexture(FONScontext* s, int* dirty);
 
+// #TheForgeChangesBegin
+// Signed distance field fonts: every glyph is rasterized once as a distance field at sdfSize pixels
+// and its quads are scaled to the requested size. Blur is ignored. Requires the stb_truetype backend.
+// Must be set before any glyph of the font is used. Returns 0 on failure.
+FONS_DEF int fonsSetFontSDF(FONScontext* s, int font, float sdfSize);
+FONS_DEF float fonsGetFontSDF(FONScontext* s, int font);
+
+// Glyph cache snapshot: atlas texels, atlas packing and the glyphs of every font.
+// fonsSaveAtlas returns the number of bytes needed and writes them if out is large enough.
+// fonsLoadAtlas replaces the glyph cache of the fonts found by name, the atlas sizes must match. Returns 0 on failure.
+FONS_DEF int fonsSaveAtlas(FONScontext* s, unsigned char* out, int outSize);
+FONS_DEF int fonsLoadAtlas(FONScontext* s, const unsigned char* data, int dataSize);
+// #TheForgeChangesEnd
+
 // Draws the stash texture for debugging
 FONS_DEF void fonsDrawDebug(FONScontext* s, float x, float y);
 
@@ -257,6 +271,20 @@ static int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int gl
 	return (int)((ftKerning.x + 32) >> 6);  // Round up and convert to integer
 }
 
+// #TheForgeChangesBegin
+// Never called, fonsSetFontSDF refuses distance field fonts with this backend
+static unsigned char* fons__tt_renderGlyphSDF(FONSttFontImpl *font, int glyph, float scale, int padding,
+									 int *advance, int *x0, int *y0, int *x1, int *y1)
+{
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(glyph);
+	FONS_NOTUSED(scale);
+	FONS_NOTUSED(padding);
+	*advance = *x0 = *y0 = *x1 = *y1 = 0;
+	return NULL;
+}
+// #TheForgeChangesEnd
+
 #else
 
 #define STB_TRUETYPE_IMPLEMENTATION
@@ -323,6 +351,26 @@ static int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int gl
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
 }
 
+// #TheForgeChangesBegin
+// The distance is 128 on the outline and falls off by 128 over padding pixels on either side.
+// The bitmap comes from the scratch allocator.
+static unsigned char* fons__tt_renderGlyphSDF(FONSttFontImpl *font, int glyph, float scale, int padding,
+									 int *advance, int *x0, int *y0, int *x1, int *y1)
+{
+	int lsb, w = 0, h = 0, xoff = 0, yoff = 0;
+	unsigned char* sdf;
+	stbtt_GetGlyphHMetrics(&font->font, glyph, advance, &lsb);
+	sdf = stbtt_GetGlyphSDF(&font->font, scale, glyph, padding, 128, 128.0f / (float)padding, &w, &h, &xoff, &yoff);
+	if (sdf == NULL)
+		w = h = 0;
+	*x0 = xoff;
+	*y0 = yoff;
+	*x1 = xoff + w;
+	*y1 = yoff + h;
+	return sdf;
+}
+// #TheForgeChangesEnd
+
 #endif
 
 #ifndef FONS_SCRATCH_BUF_SIZE
@@ -349,6 +397,12 @@ static int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int gl
 #ifndef FONS_MAX_FALLBACKS
 #	define FONS_MAX_FALLBACKS 20
 #endif
+// #TheForgeChangesBegin
+// Glyphs bigger than this would not fit the scratch buffer once turned into a distance field
+#ifndef FONS_MAX_SDF_SIZE
+#	define FONS_MAX_SDF_SIZE 128.0f
+#endif
+// #TheForgeChangesEnd
 
 static unsigned int fons__hashint(unsigned int a)
 {
@@ -398,6 +452,12 @@ struct FONSfont
 	int lut[FONS_HASH_LUT_SIZE];
 	int fallbacks[FONS_MAX_FALLBACKS];
 	int nfallbacks;
+	// #TheForgeChangesBegin
+	// Size the distance field glyphs are rasterized at, 0 for regular glyphs
+	float sdfSize;
+	// Pixel height scale at sdfSize
+	float sdfScale;
+	// #TheForgeChangesEnd
 };
 typedef struct FONSfont FONSfont;
 
@@ -1108,11 +1168,24 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	unsigned char* bdst;
 	unsigned char* dst;
 	FONSfont* renderFont = font;
+	// #TheForgeChangesBegin
+	unsigned char* sdf = NULL;
+	// #TheForgeChangesEnd
 
 	if (isize < 2) return NULL;
 	if (iblur > 20) iblur = 20;
 	pad = iblur+2;
 
+	// #TheForgeChangesBegin
+	// Every size shares the distance field glyph, it only needs the one pixel empty border
+	if (font->sdfSize > 0.0f) {
+		isize = (short)(font->sdfSize*10.0f);
+		iblur = 0;
+		size = font->sdfSize;
+		pad = 1;
+	}
+	// #TheForgeChangesEnd
+
 	// Reset allocator.
 	stash->nscratch = 0;
 
@@ -1142,6 +1215,11 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		// In that case the glyph index 'g' is 0, and we'll proceed below and cache empty glyph.
 	}
 	scale = fons__tt_getPixelHeightScale(&renderFont->font, size);
+	// #TheForgeChangesBegin
+	if (font->sdfSize > 0.0f)
+		sdf = fons__tt_renderGlyphSDF(&renderFont->font, g, scale, fons__maxi(2, (int)(font->sdfSize / 8.0f)), &advance, &x0, &y0, &x1, &y1);
+	else
+	// #TheForgeChangesEnd
 	fons__tt_buildGlyphBitmap(&renderFont->font, g, size, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
 	gw = x1-x0 + pad*2;
 	gh = y1-y0 + pad*2;
@@ -1176,6 +1254,13 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 
 	// Rasterize
 	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
+	// #TheForgeChangesBegin
+	if (font->sdfSize > 0.0f) {
+		for (y = 0; y < gh-pad*2; y++)
+			memcpy(&dst[y*stash->params.width], &sdf[y*(gw-pad*2)], gw-pad*2);
+	}
+	else
+	// #TheForgeChangesEnd
 	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale,scale, g);
 
 	// Make sure there is one pixel empty border.
@@ -1225,6 +1310,30 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 		*x += (int)(adv + spacing + 0.5f);
 	}
 
+	// #TheForgeChangesBegin
+	// Distance field glyphs are scaled from the SDF size, without snapping to pixels
+	if (font->sdfSize > 0.0f) {
+		float glyphScale = scale / font->sdfScale;
+		float w = (float)(glyph->x1 - glyph->x0 - 2) * glyphScale;
+		float h = (float)(glyph->y1 - glyph->y0 - 2) * glyphScale;
+		rx = *x + (float)(glyph->xoff+1) * glyphScale;
+		ry = (stash->params.flags & FONS_ZERO_TOPLEFT) ? *y + (float)(glyph->yoff+1) * glyphScale : *y - (float)(glyph->yoff+1) * glyphScale;
+
+		q->x0 = rx;
+		q->y0 = ry;
+		q->x1 = rx + w;
+		q->y1 = (stash->params.flags & FONS_ZERO_TOPLEFT) ? ry + h : ry - h;
+
+		q->s0 = (float)(glyph->x0+1) * stash->itw;
+		q->t0 = (float)(glyph->y0+1) * stash->ith;
+		q->s1 = (float)(glyph->x1-1) * stash->itw;
+		q->t1 = (float)(glyph->y1-1) * stash->ith;
+
+		*x += glyph->xadv / 10.0f * glyphScale;
+		return;
+	}
+	// #TheForgeChangesEnd
+
 	// Each glyph has 2px border to allow good interpolation,
 	// one pixel to prevent leaking, and one to allow good interpolation for rendering.
 	// Inset the texture region by one pixel for correct interpolation.
@@ -1789,4 +1898,170 @@ FONS_DEF int fonsResetAtlas(FONScontext* stash, int width, int height)
 	return 1;
 }
 
+// #TheForgeChangesBegin
+FONS_DEF int fonsSetFontSDF(FONScontext* stash, int font, float sdfSize)
+{
+	FONSfont* f;
+	if (stash == NULL || font < 0 || font >= stash->nfonts) return 0;
+	f = stash->fonts[font];
+	// Glyphs already in the cache were rasterized for another size
+	if (f->nglyphs > 0 || sdfSize <= 0.0f || sdfSize > FONS_MAX_SDF_SIZE) return 0;
+#ifdef FONS_USE_FREETYPE
+	// The FreeType backend has no distance field rasterizer, the font keeps its regular glyphs
+	return 0;
+#else
+	f->sdfSize = sdfSize;
+	f->sdfScale = fons__tt_getPixelHeightScale(&f->font, sdfSize);
+	return 1;
+#endif
+}
+
+FONS_DEF float fonsGetFontSDF(FONScontext* stash, int font)
+{
+	if (stash == NULL || font < 0 || font >= stash->nfonts) return 0.0f;
+	return stash->fonts[font]->sdfSize;
+}
+
+// Atlas snapshot layout, native endianness:
+//   int width, height, nodeCount, fontCount
+//   FONSatlasNode nodes[nodeCount]
+//   per font: char name[64], float sdfSize, int glyphCount, FONSbakedGlyph glyphs[glyphCount]
+//   unsigned char texels[width * height]
+struct FONSbakedGlyph
+{
+	unsigned int codepoint;
+	int index;
+	short size, blur;
+	short x0, y0, x1, y1;
+	short xadv, xoff, yoff;
+	short reserved;
+};
+typedef struct FONSbakedGlyph FONSbakedGlyph;
+
+static void fons__write(unsigned char* out, int outSize, int* offset, const void* data, int size)
+{
+	if (out != NULL && *offset + size <= outSize)
+		memcpy(out + *offset, data, size);
+	*offset += size;
+}
+
+static int fons__read(const unsigned char* data, int dataSize, int* offset, void* out, int size)
+{
+	if (size < 0 || *offset + size > dataSize) return 0;
+	memcpy(out, data + *offset, size);
+	*offset += size;
+	return 1;
+}
+
+FONS_DEF int fonsSaveAtlas(FONScontext* stash, unsigned char* out, int outSize)
+{
+	int i, j, offset = 0;
+	if (stash == NULL) return 0;
+
+	fons__write(out, outSize, &offset, &stash->params.width, sizeof(int));
+	fons__write(out, outSize, &offset, &stash->params.height, sizeof(int));
+	fons__write(out, outSize, &offset, &stash->atlas->nnodes, sizeof(int));
+	fons__write(out, outSize, &offset, &stash->nfonts, sizeof(int));
+	fons__write(out, outSize, &offset, stash->atlas->nodes, sizeof(FONSatlasNode) * stash->atlas->nnodes);
+	for (i = 0; i < stash->nfonts; ++i) {
+		FONSfont* font = stash->fonts[i];
+		fons__write(out, outSize, &offset, font->name, sizeof(font->name));
+		fons__write(out, outSize, &offset, &font->sdfSize, sizeof(float));
+		fons__write(out, outSize, &offset, &font->nglyphs, sizeof(int));
+		for (j = 0; j < font->nglyphs; ++j) {
+			const FONSglyph* glyph = &font->glyphs[j];
+			FONSbakedGlyph baked = { glyph->codepoint, glyph->index, glyph->size, glyph->blur,
+				glyph->x0, glyph->y0, glyph->x1, glyph->y1, glyph->xadv, glyph->xoff, glyph->yoff, 0 };
+			fons__write(out, outSize, &offset, &baked, sizeof(baked));
+		}
+	}
+	fons__write(out, outSize, &offset, stash->texData, stash->params.width * stash->params.height);
+	return offset;
+}
+
+FONS_DEF int fonsLoadAtlas(FONScontext* stash, const unsigned char* data, int dataSize)
+{
+	int i, j, width, height, nnodes, nfonts, offset = 0;
+	if (stash == NULL || data == NULL) return 0;
+
+	if (!fons__read(data, dataSize, &offset, &width, sizeof(int)) ||
+		!fons__read(data, dataSize, &offset, &height, sizeof(int)) ||
+		!fons__read(data, dataSize, &offset, &nnodes, sizeof(int)) ||
+		!fons__read(data, dataSize, &offset, &nfonts, sizeof(int)))
+		return 0;
+	if (width != stash->params.width || height != stash->params.height || nnodes <= 0 || nnodes > width || nfonts < 0)
+		return 0;
+	if (nnodes > stash->atlas->cnodes) {
+		FONSatlasNode* nodes = (FONSatlasNode*)tf_realloc(stash->atlas->nodes, sizeof(FONSatlasNode) * nnodes);
+		if (nodes == NULL) return 0;
+		stash->atlas->nodes = nodes;
+		stash->atlas->cnodes = nnodes;
+	}
+	if (!fons__read(data, dataSize, &offset, stash->atlas->nodes, sizeof(FONSatlasNode) * nnodes)) {
+		fonsResetAtlas(stash, width, height);
+		return 0;
+	}
+	stash->atlas->nnodes = nnodes;
+
+	// The texels of the glyphs cached so far get overwritten
+	for (i = 0; i < stash->nfonts; ++i) {
+		FONSfont* font = stash->fonts[i];
+		font->nglyphs = 0;
+		for (j = 0; j < FONS_HASH_LUT_SIZE; ++j)
+			font->lut[j] = -1;
+	}
+
+	for (i = 0; i < nfonts; ++i) {
+		char name[64];
+		float sdfSize;
+		int nglyphs, fontIndex;
+		FONSfont* font = NULL;
+		if (!fons__read(data, dataSize, &offset, name, sizeof(name)) ||
+			!fons__read(data, dataSize, &offset, &sdfSize, sizeof(float)) ||
+			!fons__read(data, dataSize, &offset, &nglyphs, sizeof(int)) ||
+			nglyphs < 0 || nglyphs > (dataSize - offset) / (int)sizeof(FONSbakedGlyph)) {
+			fonsResetAtlas(stash, width, height);
+			return 0;
+		}
+		name[sizeof(name) - 1] = '\0';
+		// Glyphs of fonts that are not defined, or not with the same SDF size, are skipped
+		fontIndex = fonsGetFontByName(stash, name);
+		if (fontIndex != FONS_INVALID && stash->fonts[fontIndex]->sdfSize == sdfSize)
+			font = stash->fonts[fontIndex];
+		for (j = 0; j < nglyphs; ++j) {
+			FONSbakedGlyph baked;
+			FONSglyph* glyph;
+			unsigned int h;
+			fons__read(data, dataSize, &offset, &baked, sizeof(baked));
+			if (font == NULL || (glyph = fons__allocGlyph(font)) == NULL)
+				continue;
+			glyph->codepoint = baked.codepoint;
+			glyph->index = baked.index;
+			glyph->size = baked.size;
+			glyph->blur = baked.blur;
+			glyph->x0 = baked.x0;
+			glyph->y0 = baked.y0;
+			glyph->x1 = baked.x1;
+			glyph->y1 = baked.y1;
+			glyph->xadv = baked.xadv;
+			glyph->xoff = baked.xoff;
+			glyph->yoff = baked.yoff;
+			h = fons__hashint(glyph->codepoint) & (FONS_HASH_LUT_SIZE-1);
+			glyph->next = font->lut[h];
+			font->lut[h] = font->nglyphs-1;
+		}
+	}
+
+	if (!fons__read(data, dataSize, &offset, stash->texData, width * height)) {
+		fonsResetAtlas(stash, width, height);
+		return 0;
+	}
+	stash->dirtyRect[0] = 0;
+	stash->dirtyRect[1] = 0;
+	stash->dirtyRect[2] = width;
+	stash->dirtyRect[3] = height;
+	return 1;
+}
+// #TheForgeChangesEnd
+
 #endif // FONTSTASH_IMPLEMENTATION
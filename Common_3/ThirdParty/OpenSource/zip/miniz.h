@@ -4153,7 +4153,7 @@ void *tdefl_write_image_to_png_file_in_memory(const void *pImage, int w, int h,
 
 static bool MZ_FOPEN(const ResourceDirectory resourceDirectory, const char *fileName, const char *pMode, MZ_FILE* pOut)
 {
-	return fsOpenStreamFromPath(resourceDirectory, fileName, FM_READ_BINARY, pOut);
+	return fsOpenStreamFromPath(resourceDirectory, fileName, fsFileModeFromString(pMode), pOut);
 }
 static bool MZ_FREOPEN(const ResourceDirectory resourceDirectory, const char* fileName, const char *pMode, MZ_FILE* pStream)
 {
@@ -5819,6 +5819,11 @@ mz_bool mz_zip_reader_end(mz_zip_archive *pZip) {
   mz_zip_array_clear(pZip, &pState->m_sorted_central_dir_offsets);
 
 #ifndef MINIZ_NO_STDIO
+  // CONFFX_BEGIN - Custom File IO (readers using mz_zip_reader_init have no file)
+#ifdef MINIZ_FORGE_IO
+  if (pState->m_pFile.pIO)
+#endif
+  // CONFFX_END
     MZ_FCLOSE(&pState->m_pFile);
 #endif // #ifndef MINIZ_NO_STDIO
 
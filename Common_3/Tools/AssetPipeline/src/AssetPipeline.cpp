@@ -58,6 +58,9 @@
 
 #include "../../FileSystem/IToolFileSystem.h"
 
+// Pak
+#include "../../../OS/FileSystem/PakFileSystem.h"
+
 #include "../../../OS/Interfaces/IMemory.h"    //NOTE: this should be the last include in a .cpp
 
 typedef eastl::unordered_map<eastl::string, eastl::vector<eastl::string>> AnimationAssetMap;
@@ -1163,3 +1166,72 @@ bool AssetPipeline::CreateRuntimeAnimation(
 
 	return true;
 }
+
+bool AssetPipeline::ProcessPak(ProcessAssetsSettings* settings)
+{
+	// Collect the files with any of the requested extensions in all directories
+	eastl::vector<eastl::string> extensions;
+	for (const char* ext = settings->pPakExtensions; *ext;)
+	{
+		const char* end = strchr(ext, ',');
+		size_t length = end ? (size_t)(end - ext) : strlen(ext);
+		if (length)
+		{
+			extensions.push_back("." + eastl::string(ext, length));
+		}
+		ext += end ? length + 1 : length;
+	}
+
+	eastl::vector<eastl::string> files;
+	eastl::vector<eastl::string> directories;
+	directories.push_back("");
+	for (size_t i = 0; i < directories.size(); ++i)
+	{
+		// fsGetSubDirectories appends to `directories`, which can reallocate it
+		eastl::string directory = directories[i];
+		fsGetSubDirectories(RD_INPUT, directory.c_str(), directories);
+		for (const eastl::string& ext : extensions)
+		{
+			fsGetFilesWithExtension(RD_INPUT, directory.c_str(), ext.c_str(), files);
+		}
+	}
+
+	eastl::vector<const char*> fileNames;
+	for (const eastl::string& fileName : files)
+	{
+		fileNames.push_back(fileName.c_str());
+	}
+
+	PakCreateDesc pakDesc = {};
+	pakDesc.mInputDir = RD_INPUT;
+	pakDesc.ppFileNames = fileNames.data();
+	pakDesc.mFileCount = (uint32_t)fileNames.size();
+	pakDesc.mStoreOnly = settings->mPakStoreOnly;
+	pakDesc.mVerbose = !settings->quiet;
+	return fsCreatePakFile(RD_OUTPUT, settings->pPakName, &pakDesc);
+}
+
+bool AssetPipeline::ProcessBinaryLogs(ProcessAssetsSettings* settings)
+{
+	UNREF_PARAM(settings);
+
+	// Binary logs written with LogAsyncDesc::pBinaryFileName
+	eastl::vector<eastl::string> logFiles;
+	fsGetFilesWithExtension(RD_INPUT, "", ".tflog", logFiles);
+
+	bool success = true;
+	for (const eastl::string& logFile : logFiles)
+	{
+		char fileName[FS_MAX_PATH] = {};
+		char outputFile[FS_MAX_PATH] = {};
+		fsGetPathFileName(logFile.c_str(), fileName);
+		fsAppendPathExtension(fileName, "log", outputFile);
+
+		if (!Log::DecodeBinaryFile(RD_INPUT, logFile.c_str(), RD_OUTPUT, outputFile))
+		{
+			success = false;
+		}
+	}
+
+	return success;
+}
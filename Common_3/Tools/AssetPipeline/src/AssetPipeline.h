@@ -42,6 +42,11 @@ struct ProcessAssetsSettings
 	uint32_t    mFollowHairCount;
 	float       mMaxRadiusAroundGuideHair;
 	float       mTipSeperationFactor;
+
+	// Pak settings
+	const char* pPakName;        // Output file name
+	const char* pPakExtensions;  // Comma separated list of extensions to pack
+	bool        mPakStoreOnly;   // Do not compress
 };
 
 class AssetPipeline
@@ -57,4 +62,6 @@ public:
 
 	static bool ProcessVirtualTextures(ProcessAssetsSettings* settings);
 	static bool ProcessTFX(ProcessAssetsSettings* settings);
+	static bool ProcessPak(ProcessAssetsSettings* settings);
+	static bool ProcessBinaryLogs(ProcessAssetsSettings* settings);
 };
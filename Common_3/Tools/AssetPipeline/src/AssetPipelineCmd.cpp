@@ -43,6 +43,11 @@ void PrintHelp()
 			"\t --fhc | -followhaircount      : Number of follow hairs around loaded guide hairs procedually\n"
 			"\t --tsf | -tipseparationfactor  : Separation factor for the follow hairs\n"
 			"\t --maxradius | -maxradius      : Max radius of the random distribution to generate follow hairs\n"
+		"\nCommand: ProcessPak                 (Files to PAK) -pak \"source directory/\" \"output directory/\" [flags]\n"
+			"\t --pakname                     : Name of the output archive. Defaults to Assets.pak\n"
+			"\t --ext                         : Comma separated list of extensions to pack. Defaults to common asset types\n"
+			"\t --store                       : Store all files uncompressed\n"
+		"\nCommand: ProcessBinaryLogs          (TFLOG to LOG) -decodelog \"binary log directory/\" \"output directory/\"\n"
 		"\nCommon Options:\n"
 			"\t --quiet                       : Print only error messages.\n"
 			"\t --force                       : Force all assets to be processed. Including ones that are already up-to-date.\n"
@@ -83,6 +88,8 @@ int AssetPipelineCmd(int argc, char** argv)
 	settings.quiet = false;
 	settings.force = false;
 	settings.minLastModifiedTime = (unsigned int)appLastModified;
+	settings.pPakName = "Assets.pak";
+	settings.pPakExtensions = "ktx,dds,basis,svt,gltf,bin,ozz,tfx,ttf,otf,json,txt,bytes";
 
 	const char* command = argv[1];
 
@@ -113,6 +120,24 @@ int AssetPipelineCmd(int argc, char** argv)
 		{
 			settings.mMaxRadiusAroundGuideHair = (float)atof(argv[++i]);
 		}
+		else if (stricmp(arg, "--pakname") == 0)
+		{
+			if (i + 1 < argc)
+				settings.pPakName = argv[++i];
+			else
+				printf("WARNING: Argument expects a value: %s\n", arg);
+		}
+		else if (stricmp(arg, "--ext") == 0)
+		{
+			if (i + 1 < argc)
+				settings.pPakExtensions = argv[++i];
+			else
+				printf("WARNING: Argument expects a value: %s\n", arg);
+		}
+		else if (stricmp(arg, "--store") == 0)
+		{
+			settings.mPakStoreOnly = true;
+		}
 		else
 		{
 			printf("WARNING: Unrecognized argument: %s\n", arg);
@@ -134,6 +159,16 @@ int AssetPipelineCmd(int argc, char** argv)
 		if (!AssetPipeline::ProcessTFX(&settings))
 			return 1;
 	}
+	else if (stricmp(command, "-pak") == 0)
+	{
+		if (!AssetPipeline::ProcessPak(&settings))
+			return 1;
+	}
+	else if (stricmp(command, "-decodelog") == 0)
+	{
+		if (!AssetPipeline::ProcessBinaryLogs(&settings))
+			return 1;
+	}
 	else
 	{
 		printf("ERROR: Invalid command. %s\n", command);
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Offline step building a shader library (see saveShaderLibrary) from a manifest listing the shader permutations
+// an application loads. Each line of the manifest is one ShaderLoadDesc: the stage files in mStages order followed
+// by the macros shared by all stages, e.g.
+//     visibilityBuffer_pass.vert visibilityBuffer_pass.frag -DSAMPLE_COUNT=4
+// Empty lines and lines starting with # are ignored.
+
+#include "../../../ThirdParty/OpenSource/EASTL/string.h"
+#include "../../../ThirdParty/OpenSource/EASTL/vector.h"
+#include "../../../OS/Interfaces/ILog.h"
+#include "../../../OS/Interfaces/IFileSystem.h"
+#include "../../../Renderer/IRenderer.h"
+#include "../../../Renderer/IResourceLoader.h"
+
+#include <cstdio>
+
+#include "../../../OS/Interfaces/IMemory.h"
+
+const char* gApplicationName = "ShaderLibraryBuilder";
+
+void PrintHelp()
+{
+	printf("ShaderLibraryBuilder\n");
+	printf(
+		"\nUsage: ShaderLibraryBuilder \"shader source directory/\" \"output directory/\" \"manifest\" \"library name\"\n"
+		"\t manifest                      : Relative to the shader source directory. One shader per line, stage files in\n"
+		"\t                                 mStages order then -DNAME=VALUE macros\n"
+		"\t library name                  : Written to the output directory, next to the binary cache of the compiled stages\n"
+		"\t -h | -help                    : Print usage information.\n");
+}
+
+typedef struct ManifestShader
+{
+	eastl::vector<eastl::string> mStages;
+	eastl::vector<eastl::string> mMacroNames;
+	eastl::vector<eastl::string> mMacroValues;
+} ManifestShader;
+
+static bool ParseManifest(const char* manifestPath, eastl::vector<ManifestShader>& outShaders)
+{
+	FileStream file = {};
+	if (!fsOpenStreamFromPath(RD_SHADER_SOURCES, manifestPath, FM_READ, &file))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open manifest %s", manifestPath);
+		return false;
+	}
+
+	eastl::string text;
+	text.resize((size_t)fsGetStreamFileSize(&file));
+	fsReadFromStream(&file, text.begin(), text.size());
+	fsCloseStream(&file);
+
+	size_t lineStart = 0;
+	uint32_t lineNumber = 0;
+	while (lineStart < text.size())
+	{
+		size_t lineEnd = text.find('\n', lineStart);
+		if (lineEnd == eastl::string::npos)
+			lineEnd = text.size();
+		eastl::string line = text.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		++lineNumber;
+
+		ManifestShader shader;
+		size_t tokenStart = line.find_first_not_of(" \t\r");
+		while (tokenStart != eastl::string::npos && line[tokenStart] != '#')
+		{
+			size_t tokenEnd = line.find_first_of(" \t\r", tokenStart);
+			if (tokenEnd == eastl::string::npos)
+				tokenEnd = line.size();
+			eastl::string token = line.substr(tokenStart, tokenEnd - tokenStart);
+			tokenStart = line.find_first_not_of(" \t\r", tokenEnd);
+
+			if (token.compare(0, 2, "-D") == 0)
+			{
+				size_t equals = token.find('=');
+				shader.mMacroNames.push_back(token.substr(2, equals == eastl::string::npos ? eastl::string::npos : equals - 2));
+				shader.mMacroValues.push_back(equals == eastl::string::npos ? eastl::string() : token.substr(equals + 1));
+			}
+			else
+			{
+				shader.mStages.push_back(token);
+			}
+		}
+
+		if (shader.mStages.empty())
+		{
+			if (!shader.mMacroNames.empty())
+				LOGF(LogLevel::eWARNING, "%s(%u): macros without a shader stage are ignored", manifestPath, lineNumber);
+			continue;
+		}
+		if (shader.mStages.size() > SHADER_STAGE_COUNT)
+		{
+			LOGF(LogLevel::eERROR, "%s(%u): more than %u shader stages", manifestPath, lineNumber, (uint32_t)SHADER_STAGE_COUNT);
+			return false;
+		}
+		outShaders.push_back(shader);
+	}
+
+	return true;
+}
+
+int ShaderLibraryBuilder(int argc, char** argv)
+{
+	if (argc == 1 || stricmp(argv[1], "-h") == 0 || stricmp(argv[1], "-help") == 0)
+	{
+		PrintHelp();
+		return 0;
+	}
+
+	if (argc < 5)
+	{
+		printf("ERROR: Invalid number of arguments.\n");
+		PrintHelp();
+		return 1;
+	}
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_SHADER_SOURCES, "");
+	fsSetPathForResourceDir(pSystemFileIO, RM_SAVE_0, RD_SHADER_BINARIES, "");
+
+	eastl::vector<ManifestShader> manifest;
+	if (!ParseManifest(argv[3], manifest))
+		return 1;
+
+	RendererDesc settings = {};
+	Renderer*    pRenderer = NULL;
+	initRenderer(gApplicationName, &settings, &pRenderer);
+	if (!pRenderer)
+	{
+		LOGF(LogLevel::eERROR, "Failed to initialize the renderer");
+		return 1;
+	}
+	// The resource loader compiles the stages of all permutations in parallel
+	initResourceLoaderInterface(pRenderer);
+
+	// Macro arrays have to outlive saveShaderLibrary, they are only referenced by the ShaderStageLoadDesc
+	eastl::vector<eastl::vector<ShaderMacro> > macros(manifest.size());
+	eastl::vector<ShaderLoadDesc>              shaders(manifest.size());
+	for (size_t i = 0; i < manifest.size(); ++i)
+	{
+		const ManifestShader& entry = manifest[i];
+		for (size_t m = 0; m < entry.mMacroNames.size(); ++m)
+			macros[i].push_back({ entry.mMacroNames[m].c_str(), entry.mMacroValues[m].c_str() });
+
+		ShaderLoadDesc& desc = shaders[i];
+		desc = {};
+		for (size_t s = 0; s < entry.mStages.size(); ++s)
+		{
+			desc.mStages[s].pFileName = entry.mStages[s].c_str();
+			desc.mStages[s].pMacros = macros[i].data();
+			desc.mStages[s].mMacroCount = (uint32_t)macros[i].size();
+		}
+	}
+
+	ShaderLibrarySaveDesc saveDesc = {};
+	saveDesc.pFileName = argv[4];
+	saveDesc.pShaders = shaders.data();
+	saveDesc.mShaderCount = (uint32_t)shaders.size();
+	bool success = saveShaderLibrary(pRenderer, &saveDesc);
+	if (success)
+		LOGF(LogLevel::eINFO, "Wrote %u shaders to %s", saveDesc.mShaderCount, argv[4]);
+
+	exitResourceLoaderInterface(pRenderer);
+	removeRenderer(pRenderer);
+
+	return success ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+	extern bool MemAllocInit(const char*);
+	extern void MemAllocExit();
+
+	if (!MemAllocInit(gApplicationName))
+		return EXIT_FAILURE;
+
+	FileSystemInitDesc fsDesc = {};
+	fsDesc.pAppName = gApplicationName;
+
+	if (argc >= 5)
+	{
+		fsDesc.pResourceMounts[RM_CONTENT] = argv[1];
+		fsDesc.pResourceMounts[RM_SAVE_0] = argv[2];
+	}
+
+	if (!initFileSystem(&fsDesc))
+		return EXIT_FAILURE;
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_LOG, "");
+
+	Log::Init(gApplicationName);
+
+	int ret = ShaderLibraryBuilder(argc, argv);
+
+	Log::Exit();
+	exitFileSystem();
+	MemAllocExit();
+
+	return ret;
+}
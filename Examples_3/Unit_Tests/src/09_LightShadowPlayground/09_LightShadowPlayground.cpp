@@ -1588,7 +1588,6 @@ struct CalculateMeshSDFTask
 	const SDFVolumeData::TriangeList* mMeshTrianglesList;
 	const AABB* mSDFVolumeBounds;
 	const ivec3*  mSDFVolumeDimension;
-	int32_t mZIndex;
 	float mSDFVolumeMaxDist;
 	BVHTree* mBVHTree;
 	SDFVolumeData::SDFVolumeList* mSDFVolumeList;
@@ -1602,7 +1601,7 @@ void DoCalculateMeshSDFTask(void* dataPtr, uintptr_t index)
 
 	const AABB& sdfVolumeBounds = *task->mSDFVolumeBounds;
 	const ivec3& sdfVolumeDimension = *task->mSDFVolumeDimension;
-	int32_t zIndex = task->mZIndex;
+	int32_t zIndex = (int32_t)index;
 	float sdfVolumeMaxDist = task->mSDFVolumeMaxDist;
 
 	const SDFVolumeData::SampleDirectionsList& directionsList = *task->mDirectionsList;
@@ -1765,6 +1764,17 @@ bool GenerateVolumeDataFromFile(SDFVolumeData** outVolumeDataPP, const eastl::st
 	return true;
 }
 
+// Each index is one z slice of the volume
+void DoCalculateMeshSDFTaskRange(void* dataPtr, uintptr_t begin, uintptr_t end)
+{
+	for (uintptr_t zIndex = begin; zIndex < end; ++zIndex)
+	{
+		if (shouldExitSDFGeneration) break;
+
+		DoCalculateMeshSDFTask(dataPtr, zIndex);
+	}
+}
+
 void GenerateVolumeDataFromMesh(ThreadSystem* threadSystem, SDFMesh* mainMesh, SDFMeshInstance* subMesh,
 	float sdfResolutionScale, bool generateAsIfTwoSided, SDFVolumeData** outVolumeDataPP,
 	const eastl::string& subMeshName, float twoSidedWorldSpaceBias = 0.4f,
@@ -1892,13 +1902,8 @@ void GenerateVolumeDataFromMesh(ThreadSystem* threadSystem, SDFMesh* mainMesh, S
 	calculateMeshSDFTask.mIsTwoSided = generateAsIfTwoSided;
 
 
-	for (int32_t zIndex = 0; zIndex < finalSDFVolumeDimension.getZ(); ++zIndex)
-	{
-		if (shouldExitSDFGeneration) break;
-
-		calculateMeshSDFTask.mZIndex = zIndex;
-		DoCalculateMeshSDFTask(&calculateMeshSDFTask, 0);
-	}
+	// Slices are independent, the thread system splits them over the idle workers
+	parallelFor(threadSystem, 0, (uintptr_t)finalSDFVolumeDimension.getZ(), 1, DoCalculateMeshSDFTaskRange, &calculateMeshSDFTask);
 
 	DeleteBVHTree(bvhTree.mRootNode);
 
@@ -4878,7 +4883,8 @@ class LightShadowPlayground: public IApp
 		fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG,   RD_OTHER_FILES,		"SDF");
 		fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_SCRIPTS,			"Scripts");
 
-		initThreadSystem(&pThreadSystem);
+		// The SDF bake splits its meshes over every core
+		initThreadSystem(&pThreadSystem, THREAD_SYSTEM_ALL_CORES);
 
 		CameraMotionParameters cmp{ 146.0f, 300.0f, 140.0f };
 		vec3                   camPos{};
@@ -7660,7 +7666,7 @@ class LightShadowPlayground: public IApp
 #if defined(DIRECT3D12) || defined(METAL) || defined(ORBIS) || defined(PROSPERO)
 			vec2 windowSize = vec2(gs_ASMDepthAtlasTextureWidth, gs_ASMDepthAtlasTextureHeight);
 			gVisibilityBufferConstants[gFrameIndex].mCullingViewports[VIEW_SHADOW].mWindowSize = v2ToF2(windowSize);
-#elif defined(VULKAN)
+#elif defined(VULKAN) || defined(NULL_RENDERER)
 			vec2 windowSize = vec2(gs_ASMDepthAtlasTextureWidth, gs_ASMDepthAtlasTextureHeight);
 			gVisibilityBufferConstants[gFrameIndex].mCullingViewports[VIEW_SHADOW].mWindowSize = windowSize;
 #endif
@@ -7863,7 +7869,7 @@ class LightShadowPlayground: public IApp
 			vec2 windowSize(ESM_SHADOWMAP_RES, ESM_SHADOWMAP_RES);
 #if defined(DIRECT3D12) || defined(METAL) || defined(ORBIS) || defined(PROSPERO)
 			gVisibilityBufferConstants[gFrameIndex].mCullingViewports[VIEW_SHADOW].mWindowSize = v2ToF2(windowSize);
-#elif defined(VULKAN)
+#elif defined(VULKAN) || defined(NULL_RENDERER)
 			gVisibilityBufferConstants[gFrameIndex].mCullingViewports[VIEW_SHADOW].mWindowSize = windowSize;
 #endif
 		}
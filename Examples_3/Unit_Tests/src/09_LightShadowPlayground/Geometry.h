@@ -53,7 +53,7 @@ namespace eastl
 #include "Shaders/D3D12/Shader_Defs.h"
 #include "Shaders/D3D12/ASMShader_Defs.h"
 #include "Shaders/D3D12/SDF_Constant.h"
-#elif defined(VULKAN)
+#elif defined(VULKAN) || defined(NULL_RENDERER)
 #define NO_GLSL_DEFINITIONS
 #include "Shaders/Vulkan/Shader_Defs.h"
 #include "Shaders/Vulkan/ASMShader_Defs.h"
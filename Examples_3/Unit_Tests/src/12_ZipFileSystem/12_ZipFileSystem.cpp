@@ -40,6 +40,8 @@
 #include "../../../../Common_3/Renderer/IResourceLoader.h"
 
 #include "../../../../Common_3/OS/Interfaces/IInput.h"
+#include "../../../../Common_3/OS/Core/ThreadSystem.h"
+#include "../../../../Common_3/OS/FileSystem/PakFileSystem.h"
 //Math
 #include "../../../../Common_3/OS/Math/MathTypes.h"
 
@@ -147,6 +149,11 @@ IFileSystem gZipFileSystem = {};
 bool fsOpenZipFile(const ResourceDirectory resourceDir, const char* fileName, FileMode mode, IFileSystem* pOut);
 bool fsCloseZipFile(IFileSystem* pZip);
 
+// "-pak <file>" mounts a pak archive from the ZipFiles directory as gZipFileSystem instead of the zip, e.g. one
+// built from the extracted zip with: AssetPipelineCmd -pak <extracted zip>/ <ZipFiles>/ --pakname 28-ZipFileSystem.pak
+const char* pPakFile = NULL;
+ThreadSystem* pPakThreadSystem = NULL;
+
 bool gTestGraphicsReset = false;
 void testGraphicsReset()
 {
@@ -164,7 +171,23 @@ public:
 		// FILE PATHS
 		fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_OTHER_FILES, "ZipFiles");
 
-		if (!fsOpenZipFile(RD_OTHER_FILES, pZipFiles, FM_READ, &gZipFileSystem))
+		for (int i = 0; i + 1 < argc; ++i)
+		{
+			if (strcmp(argv[i], "-pak") == 0)
+				pPakFile = argv[i + 1];
+		}
+
+		if (pPakFile)
+		{
+			// Reads spanning several chunks are decompressed on these threads
+			initThreadSystem(&pPakThreadSystem);
+			if (!fsOpenPakFile(RD_OTHER_FILES, pPakFile, &gZipFileSystem, pPakThreadSystem))
+			{
+				ASSERT("Failed to Open pak file");
+				return false;
+			}
+		}
+		else if (!fsOpenZipFile(RD_OTHER_FILES, pZipFiles, FM_READ, &gZipFileSystem))
 		{
 			ASSERT("Failed to Open zip file");
 			return false;
@@ -269,7 +292,15 @@ public:
 	void Exit()
 	{
 		// Close the Zip file
-		fsCloseZipFile(&gZipFileSystem);
+		if (pPakFile)
+		{
+			fsClosePakFile(&gZipFileSystem);
+			shutdownThreadSystem(pPakThreadSystem);
+		}
+		else
+		{
+			fsCloseZipFile(&gZipFileSystem);
+		}
 
 		gTextDataVector.clear();
 		gTextDataVector.set_capacity(0);
@@ -686,12 +686,6 @@ public:
 	{
 		exitInputSystem();
 
-        if (mBenchmark)
-        {
-            dumpProfileData(pRenderer, mOutput, nBenchmarkFrames);
-            dumpBenchmarkData(pRenderer, &mSettings, mOutput);
-        }
-
 		destroyCameraController(pCameraController);
 	}
 
@@ -737,7 +731,11 @@ public:
 
 			const char* ppGpuProfilerName[1] = { "Graphics" };
 			initProfiler(pRenderer, &pQueue, ppGpuProfilerName, &gGpuProfileToken, 1);
-			if (mBenchmark) setAggregateFrames(nBenchmarkFrames);
+			if (mBenchmark)
+			{
+				setAggregateFrames(nBenchmarkFrames);
+				beginBenchmark();
+			}
 
 			/************************************************************************/
 			// GUI
@@ -1232,6 +1230,12 @@ public:
 
 		if (mSettings.mResetGraphics || mSettings.mQuit) 
 		{
+			// exitProfiler ends the benchmark and frees its samples
+			if (mBenchmark)
+			{
+				dumpProfileData(pRenderer, mOutput, nBenchmarkFrames);
+				dumpBenchmarkData(pRenderer, &mSettings, mOutput);
+			}
 			exitProfiler();
 			gAppUI.Exit();
 			gVirtualJoystick.Exit();
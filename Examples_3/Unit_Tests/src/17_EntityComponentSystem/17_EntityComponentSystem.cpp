@@ -29,6 +29,7 @@
 
 // ECS
 #include "../../../../Middleware_3/ECS/EntityManager.h"
+#include "../../../../Middleware_3/ECS/SpatialHash.h"
 #include "../../../../Middleware_3/ECS/ComponentRepresentation.h"
 
 // REPRESENTATIONS
@@ -154,77 +155,49 @@ void MoveEntities(PositionComponent& position, MoveComponent& move, float& delta
 	}
 }
 
-struct timeAndBounds {
-	Entity** entities;
-	float deltaTime;
-	const WorldBoundsComponent* bounds;
-};
-
 struct MoveSystem
 {
-	struct Task
-	{
-		size_t         start;
-		size_t         end;
-		timeAndBounds* data;
-	};
+	eastl::vector<ArchetypeChunk*> mChunks;
+	float                          mDeltaTime = 0.0f;
+	const WorldBoundsComponent*    pBounds = NULL;
+	ParallelForDesc                moveDesc = {};
 
-	Task          tasks[MAX_LOAD_THREADS + 2] = {};
-
-	void Update(float deltaTime)
+	// Does not wait for the threaded part of the update, pDoneCounter reaches zero once all entities have moved
+	void Update(float deltaTime, TaskCounter* pDoneCounter)
 	{
-		const WorldBoundsComponent& bounds = *worldBoundsEntity->getComponent<WorldBoundsComponent>();
+		mDeltaTime = deltaTime;
+		pBounds = worldBoundsEntity->getComponent<WorldBoundsComponent>();
 
-		timeAndBounds moveData = { spriteEntities, deltaTime, &bounds };
-		timeAndBounds avoidData = { avoidEntities, deltaTime, &bounds };
-		
-		// 1 thread used by resource loader
-		const uint32_t numThreads = max(1u, getThreadSystemThreadCount(pThreadSystem) - 1);
-		const uint32_t entitiesPerThread = SpriteEntityCount / (numThreads + 1);
+		// Sprites and the objects to avoid share the archetype, the chunks hold both of them
+		mChunks.clear();
+		pEntityManager->queryChunks<PositionComponent, MoveComponent>(mChunks);
 
-		// Make sure there is enough workload for parallel processing
-		if (multiThread && entitiesPerThread < SpriteEntityCount / 2)
+		if (multiThread)
 		{
-			uint32_t taskCount = 0;
-
-			for (taskCount = 0; taskCount < numThreads; ++taskCount)
-			{
-				Task* task = &tasks[taskCount];
-				task->start = taskCount * entitiesPerThread;
-				task->end = min((size_t)SpriteEntityCount, task->start + entitiesPerThread);
-				task->data = &moveData;
-				addThreadSystemTask(pThreadSystem, &memberTaskFunc<MoveSystem, &MoveSystem::threadedUpdate>, this, taskCount);
-			}
-
-			// Remaining entities on main thread
-			tasks[taskCount] = { tasks[taskCount - 1].end, SpriteEntityCount, &moveData };
-			threadedUpdate(taskCount++);
-			
-			tasks[taskCount] = { 0, AvoidCount, &avoidData };
-			threadedUpdate(taskCount++);
-
-			waitThreadSystemIdle(pThreadSystem);
+			// Chunking is left to the thread system, the main thread joins in when it waits on the counter
+			moveDesc.pFunc = &memberRangeTaskFunc<MoveSystem, &MoveSystem::threadedUpdate>;
+			moveDesc.pUser = this;
+			moveDesc.mBegin = 0;
+			moveDesc.mEnd = mChunks.size();
+			moveDesc.pSignalCounter = pDoneCounter;
+			addThreadSystemParallelFor(pThreadSystem, &moveDesc);
 		}
 		else
 		{
-			tasks[0] = { 0, SpriteEntityCount, &moveData };
-			threadedUpdate(0);
-
-			tasks[1] = { 0, AvoidCount, &avoidData };
-			threadedUpdate(1);
+			threadedUpdate(0, mChunks.size());
 		}
 	}
 
-	void threadedUpdate(uintptr_t id)
+	void threadedUpdate(uintptr_t start, uintptr_t end)
 	{
-		const Task* task = &tasks[id];
-		for (uintptr_t i = task->start; i < task->end; ++i)
+		for (uintptr_t i = start; i < end; ++i)
 		{
-			Entity* pEntity = (task->data->entities)[i];
-			PositionComponent& position = *(pEntity->getComponent<PositionComponent>());
-			MoveComponent& move = *(pEntity->getComponent<MoveComponent>());
+			ArchetypeChunk*    pChunk = mChunks[i];
+			PositionComponent* pPositions = pChunk->getComponents<PositionComponent>();
+			MoveComponent*     pMoves = pChunk->getComponents<MoveComponent>();
 
-			MoveEntities(position, move, task->data->deltaTime, *task->data->bounds);
+			for (uint32_t j = 0; j < pChunk->mCount; ++j)
+				MoveEntities(pPositions[j], pMoves[j], mDeltaTime, *pBounds);
 		}
 	}
 };
@@ -238,26 +211,19 @@ static float DistanceSq(const PositionComponent& a, const PositionComponent& b)
 
 struct AvoidanceSystem
 {
-	struct Task
-	{
-		size_t         start;
-		size_t         end;
-		timeAndBounds* data;
-	};
-
-	Task tasks[MAX_LOAD_THREADS + 1] = {};
-
 	static eastl::vector<float>    avoidDistanceList;
 
 	Mutex emplaceMutex;
 	
 	bool init()
 	{
+		mAvoidGrid.init(2.0f, 1024);
 		return emplaceMutex.Init();
 	}
 	
 	void exit()
 	{
+		mAvoidGrid.exit();
 		emplaceMutex.Destroy();
 	}
 
@@ -274,11 +240,8 @@ struct AvoidanceSystem
 		avoidDistanceList.set_capacity(0);
 	}
 
-	static void resolveCollision(Entity* pEntity, float deltaTime)
+	static void resolveCollision(PositionComponent& pos, MoveComponent& move, float deltaTime)
 	{
-		PositionComponent& pos  = *(pEntity->getComponent<PositionComponent>());
-		MoveComponent&     move = *(pEntity->getComponent<MoveComponent>());
-
 		// flip velocity
 		move.velx = -move.velx;
 		move.vely = -move.vely;
@@ -288,70 +251,102 @@ struct AvoidanceSystem
 		pos.y += move.vely * deltaTime * 1.1f;
 	}
 
-	void Update(float deltaTime)
+	bool isAvoidObject(const PositionComponent* pPosition) const
 	{
-		const WorldBoundsComponent& bounds = *worldBoundsEntity->getComponent<WorldBoundsComponent>();
+		// An object to avoid is in the grid at its own position
+		return !mAvoidGrid.query(pPosition->x, pPosition->y, 0.0f, [this, pPosition](uint32_t j, float, float)
+		{
+			return pAvoidPositions[j] != pPosition;
+		});
+	}
 
-		timeAndBounds data = { spriteEntities, deltaTime, &bounds };
-		
-		// 1 thread used by resource loader
-		const uint32_t numThreads = max(1u, getThreadSystemThreadCount(pThreadSystem) - 1);
-		const uint32_t entitiesPerThread = SpriteEntityCount / (numThreads + 1);
+	TaskCounter                    mDoneCounter = {};
+	ParallelForDesc                mDesc = {};
+	eastl::vector<ArchetypeChunk*> mChunks;
+	float                          mDeltaTime = 0.0f;
+	float                          mMaxAvoidDistance = 0.0f;
+	// Objects to avoid by index, the grid is updated once they have moved and only read by the tasks
+	SpatialHash                    mAvoidGrid;
+	PositionComponent*             pAvoidPositions[AvoidCount] = {};
+	SpriteComponent*               pAvoidSprites[AvoidCount] = {};
+
+	// Waits for pMoveCounter to reach zero before the threaded part, all of the update is done when this returns
+	void Update(float deltaTime, TaskCounter* pMoveCounter)
+	{
+		mDeltaTime = deltaTime;
 
-		// Make sure there is enough workload for parallel processing
-		if (multiThread && entitiesPerThread < SpriteEntityCount / 2)
-		{
-			uint32_t taskCount = 0;
+		// Helps with the move until it is done, the grid needs the final positions of the objects to avoid
+		if (multiThread)
+			waitTaskCounter(pThreadSystem, pMoveCounter);
 
-			for (taskCount = 0; taskCount < numThreads; ++taskCount)
-			{
-				Task* task = &tasks[taskCount];
-				task->start = taskCount * entitiesPerThread;
-				task->end = min((size_t)SpriteEntityCount, task->start + entitiesPerThread);
-				task->data = &data;
-				addThreadSystemTask(pThreadSystem, &memberTaskFunc<AvoidanceSystem, &AvoidanceSystem::threadedUpdate>, this, taskCount);
-			}
+		float maxDistanceSq = 0.0f;
+		for (uint32_t j = 0; j < AvoidCount; ++j)
+		{
+			pAvoidPositions[j] = avoidEntities[j]->getComponent<PositionComponent>();
+			pAvoidSprites[j] = avoidEntities[j]->getComponent<SpriteComponent>();
+			mAvoidGrid.update(j, pAvoidPositions[j]->x, pAvoidPositions[j]->y);
+			maxDistanceSq = max(maxDistanceSq, avoidDistanceList[j]);
+		}
+		mMaxAvoidDistance = sqrtf(maxDistanceSq);
 
-			// Remaining entities on main thread
-			tasks[taskCount] = { tasks[taskCount - 1].end, SpriteEntityCount, &data };
-			threadedUpdate(taskCount++);
+		mChunks.clear();
+		pEntityManager->queryChunks<PositionComponent, MoveComponent, SpriteComponent>(mChunks);
 
-			waitThreadSystemIdle(pThreadSystem);
+		if (multiThread)
+		{
+			mDesc.pFunc = &memberRangeTaskFunc<AvoidanceSystem, &AvoidanceSystem::threadedUpdate>;
+			mDesc.pUser = this;
+			mDesc.mBegin = 0;
+			mDesc.mEnd = mChunks.size();
+			mDesc.pSignalCounter = &mDoneCounter;
+			addThreadSystemParallelFor(pThreadSystem, &mDesc);
+
+			// Helps with the avoidance ranges until they are done
+			waitTaskCounter(pThreadSystem, &mDoneCounter);
 		}
 		else
 		{
-			tasks[0] = { 0, SpriteEntityCount, &data };
-			threadedUpdate(0);
+			threadedUpdate(0, mChunks.size());
 		}
 	}
 
-	void threadedUpdate(uintptr_t id)
+	void threadedUpdate(uintptr_t start, uintptr_t end)
 	{
-		const Task* task = &tasks[id];
-		const timeAndBounds& data = *task->data;
-
-		for (uintptr_t i = task->start; i < task->end; ++i)
+		for (uintptr_t i = start; i < end; ++i)
 		{
-			Entity* pEntity = spriteEntities[i];
-			PositionComponent& position = *(pEntity->getComponent<PositionComponent>());
+			ArchetypeChunk*    pChunk = mChunks[i];
+			PositionComponent* pPositions = pChunk->getComponents<PositionComponent>();
+			MoveComponent*     pMoves = pChunk->getComponents<MoveComponent>();
+			SpriteComponent*   pSprites = pChunk->getComponents<SpriteComponent>();
 
-			for (size_t j = 0; j < AvoidCount; ++j)
+			for (uint32_t row = 0; row < pChunk->mCount; ++row)
 			{
-				Entity*					pAvoidEntity = avoidEntities[j];
-				float                    avDistance = avoidDistanceList[j];
-				PositionComponent&	  avoidPosition = *(pAvoidEntity->getComponent<PositionComponent>());
+				PositionComponent& position = pPositions[row];
+				MoveComponent&     move = pMoves[row];
+				SpriteComponent&   mySprite = pSprites[row];
 
-				// is our position closer to "thing to avoid" position than the avoid distance?
-				if (DistanceSq(position, avoidPosition) < avDistance)
+				// only the objects to avoid in the cells around us can be close enough
+				mAvoidGrid.query(position.x, position.y, mMaxAvoidDistance, [&](uint32_t j, float, float)
 				{
-					resolveCollision(pEntity, data.deltaTime);
-					// also make our sprite take the color of the thing we just bumped into
-					SpriteComponent& avoidSprite = *(pAvoidEntity->getComponent<SpriteComponent>());
-					SpriteComponent& mySprite = *(pEntity->getComponent<SpriteComponent>());
-					mySprite.colorR = avoidSprite.colorR;
-					mySprite.colorG = avoidSprite.colorG;
-					mySprite.colorB = avoidSprite.colorB;
-				}
+					float                    avDistance = avoidDistanceList[j];
+					const PositionComponent& avoidPosition = *pAvoidPositions[j];
+
+					// is our position closer to "thing to avoid" position than the avoid distance?
+					if (DistanceSq(position, avoidPosition) < avDistance)
+					{
+						// the things to avoid share the chunks with the sprites but do not avoid each other
+						if (isAvoidObject(&position))
+							return false;
+
+						resolveCollision(position, move, mDeltaTime);
+						// also make our sprite take the color of the thing we just bumped into
+						const SpriteComponent& avoidSprite = *pAvoidSprites[j];
+						mySprite.colorR = avoidSprite.colorR;
+						mySprite.colorG = avoidSprite.colorG;
+						mySprite.colorB = avoidSprite.colorB;
+					}
+					return true;
+				});
 			}
 		}
 	}
@@ -365,38 +360,29 @@ static AvoidanceSystem* pAvoidanceSystem;
 struct CreationData
 {
 	Entity** entities;
+	const EntityId* entityIds;
 	WorldBoundsComponent* bounds;
 	const char* entityTypeName;
 };
 
-static void createEntities(void* pData, uintptr_t i)
+static void initEntity(void* pData, uintptr_t i)
 {
-	// NOT DESERIALIZED WAY TO CREATE ENTITIES
-	//spriteEntities[i] = pEntityManager->createEntity();
-
 	CreationData data = *(CreationData*)pData;
 
-	// DESERIALIZED WAY
-	EntityId entityId = pEntityManager->createEntity();
-	(data.entities)[i] = pEntityManager->getEntityById(entityId);
+	// The entities come from a batch created with all their components
+	(data.entities)[i] = pEntityManager->getEntityById((data.entityIds)[i]);
 
 	float x = RandomFloat(data.bounds->xMin, data.bounds->xMax);
 	float y = RandomFloat(data.bounds->yMin, data.bounds->yMax);
 
 	PositionComponent* position = (data.entities)[i]->getComponent<PositionComponent>();
-	if (!position)
-		position = &(pEntityManager->addComponentToEntity<PositionComponent>(entityId));	// ADD CUSTOM COMPONENTS
 	position->x = x;
 	position->y = y;
 	
 	MoveComponent* move = (data.entities)[i]->getComponent<MoveComponent>();
-	if (!move)
-		move = &( pEntityManager->addComponentToEntity<MoveComponent>(entityId) );
 	move->Initialize(0.3f, 0.6f);
 
 	SpriteComponent* sprite = (data.entities)[i]->getComponent<SpriteComponent>();
-	if (!sprite)
-		sprite = &( pEntityManager->addComponentToEntity<SpriteComponent>(entityId) );
 
 	if (strcmp(data.entityTypeName, "avoid")) {
 		pAvoidanceSystem->addAvoidThisObjectToSystem((data.entities)[i], 1.3f);
@@ -441,7 +427,8 @@ class EntityComponentSystem: public IApp
 		PositionComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
 		WorldBoundsComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
 
-		initThreadSystem(&pThreadSystem);
+		// Spawning and the systems scale with the core count, the sample owns the machine
+		initThreadSystem(&pThreadSystem, THREAD_SYSTEM_ALL_CORES);
 
 		pEntityManager = tf_new(EntityManager);
 
@@ -453,7 +440,7 @@ class EntityComponentSystem: public IApp
 
 		EntityId worldBoundsEntityId = pEntityManager->createEntity();
 		worldBoundsEntity = pEntityManager->getEntityById(worldBoundsEntityId);
-		WorldBoundsComponent* bounds = &(pEntityManager->addComponentToEntity<WorldBoundsComponent>(worldBoundsEntityId));
+		WorldBoundsComponent* bounds = pEntityManager->addComponentToEntity<WorldBoundsComponent>(worldBoundsEntityId);
 		bounds->xMin = -80.0f;
 		bounds->xMax = 80.0f;
 		bounds->yMin = -50.0f;
@@ -462,17 +449,22 @@ class EntityComponentSystem: public IApp
 		// THIS IS HOW YOU SERIALIZE AN ENTITY
 		//pSerializer->SerializeEntity(worldBoundsEntityId, "serializedWorldBounds", "../../../src/17_EntityComponentSystem/Entities/");
 
-		CreationData data	   = { spriteEntities, bounds, "sprite" };
-		CreationData avoidData = { avoidEntities,  bounds, "avoid" };
-		
+		// Create the entities in batches, straight into the archetype holding all of their components
+		Archetype* pSpriteArchetype = pEntityManager->getArchetype<PositionComponent, MoveComponent, SpriteComponent>();
+		eastl::vector<EntityId> entityIds(SpriteEntityCount);
+
+		pEntityManager->createEntities(SpriteEntityCount, pSpriteArchetype, entityIds.data());
+		CreationData data = { spriteEntities, entityIds.data(), bounds, "sprite" };
 		for (size_t i = 0; i < SpriteEntityCount; ++i)
 		{
-			createEntities(&data, i);
+			initEntity(&data, i);
 		}
 
+		pEntityManager->createEntities(AvoidCount, pSpriteArchetype, entityIds.data());
+		CreationData avoidData = { avoidEntities, entityIds.data(), bounds, "avoid" };
 		for (size_t i = 0; i < AvoidCount; ++i)
 		{
-			createEntities(&avoidData, i);
+			initEntity(&avoidData, i);
 		}
 
 		if (!initInputSystem(pWindow))
@@ -752,33 +744,17 @@ class EntityComponentSystem: public IApp
 		currentTime += deltaTime * 1000.0f;
 
 		// update object systems
-		pMoveSystem->Update(deltaTime * 3.0f);
-		pAvoidanceSystem->Update(deltaTime * 3.0f);
+		TaskCounter moveCounter = {};
+		pMoveSystem->Update(deltaTime * 3.0f, &moveCounter);
+		pAvoidanceSystem->Update(deltaTime * 3.0f, &moveCounter);
 
 		// Iterate all entities with transform and plane component
 		gDrawSpriteCount = 0;
 		float globalScale = 0.05f;
 
-		for (size_t i = 0; i < SpriteEntityCount; ++i) {
-			Entity* pEntity				= spriteEntities[i];
-			PositionComponent& position = *(pEntity->getComponent<PositionComponent>());
-			SpriteComponent&     sprite = *(pEntity->getComponent<SpriteComponent>());
-			
-			SpriteData& spriteData = gSpriteData[gDrawSpriteCount++];
-			spriteData.posX   = position.x * globalScale;
-			spriteData.posY   = position.y * globalScale;
-			spriteData.scale  = sprite.scale * globalScale;
-			spriteData.colR   = sprite.colorR;
-			spriteData.colG   = sprite.colorG;
-			spriteData.colB   = sprite.colorB;
-			spriteData.sprite = (float)sprite.spriteIndex;
-		}
-
-		for (size_t i = 0; i < AvoidCount; ++i) {
-			Entity* pEntity				= avoidEntities[i];
-			PositionComponent& position = *(pEntity->getComponent<PositionComponent>());
-			SpriteComponent&     sprite = *(pEntity->getComponent<SpriteComponent>());
-
+		// Sprites come first in the chunks, followed by the objects to avoid
+		pEntityManager->forEach<PositionComponent, SpriteComponent>([globalScale](PositionComponent& position, SpriteComponent& sprite)
+		{
 			SpriteData& spriteData = gSpriteData[gDrawSpriteCount++];
 			spriteData.posX   = position.x * globalScale;
 			spriteData.posY   = position.y * globalScale;
@@ -787,7 +763,7 @@ class EntityComponentSystem: public IApp
 			spriteData.colG   = sprite.colorG;
 			spriteData.colB   = sprite.colorB;
 			spriteData.sprite = (float)sprite.spriteIndex;
-		}
+		});
 
 		gAppUI.Update(deltaTime);
 	}
@@ -48,6 +48,7 @@
 // Middleware packages
 #include "../../../../Middleware_3/Animation/SkeletonBatcher.h"
 #include "../../../../Middleware_3/Animation/AnimatedObject.h"
+#include "../../../../Middleware_3/Animation/AnimationSystem.h"
 #include "../../../../Middleware_3/Animation/Animation.h"
 #include "../../../../Middleware_3/Animation/Clip.h"
 #include "../../../../Middleware_3/Animation/ClipController.h"
@@ -128,6 +129,20 @@ const unsigned int kMaxNumRigs = 4096;
 
 // AnimatedObjects
 AnimatedObject gStickFigureAnimObjects[kMaxNumRigs];
+AnimatedObject* gStickFigureAnimObjectPtrs[kMaxNumRigs];
+
+// Updates the animated objects in batches over the thread system
+AnimationSystem gAnimationSystem;
+
+// Rigs further away from the camera sample their animation less often
+const AnimationLodDesc gAnimationLods[] = { { 20.0f, 2 }, { 40.0f, 4 } };
+bool                   gEnableAnimationLod = true;
+bool                   gAnimationLodEnabled = false;
+
+// Every rig plays the walk clip, so its key frames are decompressed once for all of them
+const float gWalkClipSampleRate = 30.0f;
+bool        gShareClipSampling = true;
+bool        gClipSamplingShared = false;
 
 // Animations
 Animation gWalkAnimations[kMaxNumRigs];
@@ -172,14 +187,6 @@ const unsigned int kMaxTaskCount = kMaxNumRigs;
 // Number of rigs per task that will be adjusted by the UI
 unsigned int gGrainSize = 32;
 
-struct ThreadData
-{
-	AnimatedObject* mAnimatedObject;
-	float           mDeltaTime;
-	unsigned int    mNumberSystems;
-};
-ThreadData gThreadData[kMaxTaskCount];
-
 struct ThreadSkeletonData
 {
 	unsigned int	mFrameNumber;
@@ -206,6 +213,8 @@ struct UIData
 	struct SampleControlData
 	{
 		unsigned int* mNumberOfRigs = &gNumRigs;
+		bool*         mEnableAnimationLod = &gEnableAnimationLod;
+		bool*         mShareClipSampling = &gShareClipSampling;
 	};
 	SampleControlData mSampleControl;
 
@@ -312,6 +321,7 @@ class MultiThread: public IApp
 		for (unsigned int i = 0; i < kMaxNumRigs; i++)
 		{
 			gStickFigureAnimObjects[i].Initialize(&gStickFigureRigs[i], &gWalkAnimations[i]);
+			gStickFigureAnimObjectPtrs[i] = &gStickFigureAnimObjects[i];
 
 			// Calculate and set offset for each rig
 			vec3 offset = vec3(-8.75f + 0.75f * (i % gridWidth), ((i / gridWidth) / gridDepth) * 2.0f, 8.0f - 2 * ((i / gridWidth) % gridDepth));
@@ -332,6 +342,11 @@ class MultiThread: public IApp
 		//
 		initThreadSystem(&pThreadSystem);
 
+		AnimationSystemDesc animationSystemDesc = {};
+		animationSystemDesc.pThreadSystem = pThreadSystem;
+		animationSystemDesc.mGrainSize = gGrainSize;
+		gAnimationSystem.Initialize(animationSystemDesc);
+
 		if (!initInputSystem(pWindow))
 			return false;
 
@@ -373,6 +388,7 @@ class MultiThread: public IApp
 	void Exit()
 	{
 		exitInputSystem();
+		gAnimationSystem.Destroy();
 		shutdownThreadSystem(pThreadSystem);
 
 		// Rigs
@@ -588,6 +604,12 @@ class MultiThread: public IApp
 				CollapsingSampleControlWidgets.AddSubWidget(SeparatorWidget());
 				CollapsingSampleControlWidgets.AddSubWidget(
 					SliderUintWidget("Number of Rigs", gUIData.mSampleControl.mNumberOfRigs, uintValMin, uintValMax, sliderStepSizeUint));
+
+				// AnimationLod - Checkbox
+				CollapsingSampleControlWidgets.AddSubWidget(CheckboxWidget("Animation LOD", gUIData.mSampleControl.mEnableAnimationLod));
+
+				// ShareClipSampling - Checkbox
+				CollapsingSampleControlWidgets.AddSubWidget(CheckboxWidget("Share Clip Sampling", gUIData.mSampleControl.mShareClipSampling));
 				CollapsingSampleControlWidgets.AddSubWidget(SeparatorWidget());
 
 				// GENERAL SETTINGS
@@ -802,6 +824,22 @@ class MultiThread: public IApp
 		/************************************************************************/
 		gAnimationUpdateTimer.Reset();
 
+		// No rig is being sampled here, so the clip and the update rates can change
+		if (gShareClipSampling != gClipSamplingShared)
+		{
+			gWalkClip.EnableSharedSampling(gShareClipSampling ? gWalkClipSampleRate : 0.0f);
+			gClipSamplingShared = gShareClipSampling;
+		}
+
+		if (gEnableAnimationLod != gAnimationLodEnabled)
+		{
+			gAnimationSystem.SetLods(gAnimationLods, gEnableAnimationLod ? (uint32_t)(sizeof(gAnimationLods) / sizeof(gAnimationLods[0])) : 0);
+			for (unsigned int i = 0; i < kMaxNumRigs && !gEnableAnimationLod; ++i)
+				gStickFigureAnimObjects[i].SetUpdateInterval(1);
+			gAnimationLodEnabled = gEnableAnimationLod;
+		}
+		gAnimationSystem.SetViewPosition(pCameraController->getViewPosition());
+
 		// Update the animated objects amd pose the rigs based on the animated object's updated values for this frame
 		gSkeletonBatcher.SetActiveRigs(gNumRigs);
 		// Threading
@@ -814,27 +852,14 @@ class MultiThread: public IApp
 			}
 
 			gGrainSize = min(gGrainSize, gNumRigs);
-			unsigned int taskCount = max(1U, gNumRigs / gGrainSize);
 
-			// Submit taskCount number of jobs
-			for (unsigned int i = 0; i < taskCount; i++)
-			{
-				gThreadData[i].mAnimatedObject = &gStickFigureAnimObjects[gGrainSize * i];
-				gThreadData[i].mDeltaTime = deltaTime;
-				gThreadData[i].mNumberSystems = gGrainSize;
-			}
-			addThreadSystemRangeTask(pThreadSystem, &MultiThread::AnimatedObjectThreadedUpdate, gThreadData, taskCount);
-
-			// If there is a remainder, submit another job to finish it
-			unsigned int remainder = (uint32_t)max(0, (int32_t)gNumRigs - (int32_t)(taskCount * gGrainSize));
-			if (remainder != 0)
-			{
-				gThreadData[taskCount].mAnimatedObject = &gStickFigureAnimObjects[gGrainSize * taskCount];
-				gThreadData[taskCount].mDeltaTime = deltaTime;
-				gThreadData[taskCount].mNumberSystems = remainder;
+			// Samples the rigs in parallel and poses them in SoA batches, returns once all of them are done
+			gAnimationSystem.SetGrainSize(gGrainSize);
+			if (!gAnimationSystem.Update(gStickFigureAnimObjectPtrs, gNumRigs, deltaTime))
+				LOGF(eERROR, "Animation NOT Updating!");
 
-				addThreadSystemTask(pThreadSystem, &MultiThread::AnimatedObjectThreadedUpdate, &gThreadData[taskCount]);
-			}
+			// Record animation update time
+			gAnimationUpdateTimer.GetUSec(true);
 		}
 		// Naive
 		else
@@ -859,16 +884,6 @@ class MultiThread: public IApp
 		/************************************************************************/
 		gUniformDataPlane.mProjectView = projViewMat;
 		gUniformDataPlane.mToWorldMat = mat4::identity();
-
-		if (gEnableThreading)
-		{
-			// Ensure all jobs are finished before proceeding
-			while (assistThreadSystem(pThreadSystem)) {};
-			waitThreadSystemIdle(pThreadSystem);
-
-			// Record animation update time
-			gAnimationUpdateTimer.GetUSec(true);
-		}
 	}
 
 	void Draw()
@@ -1084,25 +1099,6 @@ class MultiThread: public IApp
 		ThreadSkeletonData* data = ((ThreadSkeletonData*)pData) + i;
 		gSkeletonBatcher.SetPerInstanceUniforms(data->mFrameNumber, data->mNumberRigs, data->mOffset);
 	}
-
-	// Threaded animated object update call
-	static void AnimatedObjectThreadedUpdate(void* pData, uintptr_t i)
-	{
-		// Unpack data
-		ThreadData*     data = ((ThreadData*)pData)+i;
-		AnimatedObject* animSystem = data->mAnimatedObject;
-		float           deltaTime = data->mDeltaTime;
-		unsigned int    numberSystems = data->mNumberSystems;
-
-		// Update the systems
-		for (unsigned int i = 0; i < numberSystems; ++i)
-		{
-			if (!(animSystem[i].Update(deltaTime)))
-				LOGF(eERROR, "Animation NOT Updating!");
-
-			animSystem[i].PoseRig();
-		}
-	}
 };
 
 DEFINE_APPLICATION_MAIN(MultiThread)
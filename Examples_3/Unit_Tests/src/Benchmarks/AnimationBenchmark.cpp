@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+// Characters per millisecond of the walking stick figures of 27_MultiThread: AnimatedObject::Update and PoseRig on
+// one object at a time against AnimationSystem::Update, on the calling thread only and over a ThreadSystem. The last
+// columns add the shared clip sampling and the distance based LODs 27_MultiThread enables, with the view at the
+// corner of the crowd.
+
+#include "Benchmarks.h"
+
+#include "../../../../Middleware_3/Animation/AnimationSystem.h"
+#include "../../../../Middleware_3/Animation/Animation.h"
+#include "../../../../Middleware_3/Animation/Clip.h"
+#include "../../../../Middleware_3/Animation/ClipController.h"
+#include "../../../../Middleware_3/Animation/Rig.h"
+
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+#include "../../../../Common_3/OS/Core/ThreadSystem.h"
+
+#include <cstdio>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+typedef struct Character
+{
+	Rig            mRig;
+	ClipController mClipController;
+	Animation      mAnimation;
+	AnimatedObject mAnimatedObject;
+} Character;
+
+static const float            gAnimationDeltaTime = 1.0f / 60.0f;
+static const float            gWalkClipSampleRate = 30.0f;
+static const AnimationLodDesc gAnimationLods[] = { { 20.0f, 2 }, { 40.0f, 4 } };
+
+static double benchmarkScalar(AnimatedObject** ppObjects, uint32_t count, uint32_t frameCount)
+{
+	const int64_t start = getUSec();
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			ppObjects[i]->Update(gAnimationDeltaTime);
+			ppObjects[i]->PoseRig();
+		}
+	}
+	return (double)(getUSec() - start);
+}
+
+static double benchmarkSystem(AnimationSystem* pSystem, AnimatedObject** ppObjects, uint32_t count, uint32_t frameCount)
+{
+	const int64_t start = getUSec();
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+		pSystem->Update(ppObjects, count, gAnimationDeltaTime);
+	return (double)(getUSec() - start);
+}
+
+int AnimationBenchmark(int argc, char** argv)
+{
+	const uint32_t maxCharacterCount = getBenchmarkOption(argc, argv, "maxrigs", 10000u);
+	const uint32_t frameCount = max(getBenchmarkOption(argc, argv, "frames", 5u), 1u);
+	const char*    pSkeletonName = "stickFigure/skeleton.ozz";
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_ANIMATIONS, "Animation");
+
+	Rig clipRig;
+	clipRig.Initialize(RD_ANIMATIONS, pSkeletonName);
+	Clip walkClip;
+	walkClip.Initialize(RD_ANIMATIONS, "stickFigure/animations/walk.ozz", &clipRig);
+
+	Character*       pCharacters = (Character*)tf_malloc(maxCharacterCount * sizeof(Character));
+	AnimatedObject** ppObjects = (AnimatedObject**)tf_malloc(maxCharacterCount * sizeof(AnimatedObject*));
+	for (uint32_t i = 0; i < maxCharacterCount; ++i)
+	{
+		Character* pCharacter = tf_placement_new<Character>(pCharacters + i);
+		pCharacter->mRig.Initialize(RD_ANIMATIONS, pSkeletonName);
+		pCharacter->mClipController.Initialize(walkClip.GetDuration());
+		// Spread the characters over the clip so they do not sample the same keys
+		pCharacter->mClipController.SetTimeRatio((i % 97) / 97.0f);
+
+		AnimationDesc animationDesc{};
+		animationDesc.mRig = &pCharacter->mRig;
+		animationDesc.mNumLayers = 1;
+		animationDesc.mLayerProperties[0].mClip = &walkClip;
+		animationDesc.mLayerProperties[0].mClipController = &pCharacter->mClipController;
+		pCharacter->mAnimation.Initialize(animationDesc);
+
+		pCharacter->mAnimatedObject.Initialize(&pCharacter->mRig, &pCharacter->mAnimation);
+		pCharacter->mAnimatedObject.SetRootTransform(mat4::translation(vec3(0.75f * (i % 100), 0.0f, -2.0f * (i / 100))));
+		ppObjects[i] = &pCharacter->mAnimatedObject;
+	}
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	AnimationSystem singleThreadedSystem;
+	AnimationSystemDesc animationSystemDesc = {};
+	singleThreadedSystem.Initialize(animationSystemDesc);
+
+	AnimationSystem threadedSystem;
+	animationSystemDesc.pThreadSystem = pThreadSystem;
+	threadedSystem.Initialize(animationSystemDesc);
+	threadedSystem.SetViewPosition(vec3(0.0f));
+
+	printf("Animation: %s with %u joints walking over %u frames, %u workers, characters per millisecond (best of 3)\n",
+		   pSkeletonName, clipRig.GetNumJoints(), frameCount, getThreadSystemThreadCount(pThreadSystem));
+	printf("%8s %12s %12s %12s %12s %12s\n", "rigs", "perObject", "system", "systemMT", "shared", "sharedLod");
+	// Doubles from 1000 up to maxCharacterCount, always including maxCharacterCount
+	for (uint32_t count = min(1000u, maxCharacterCount);; count = min(count * 2, maxCharacterCount))
+	{
+		double best[5] = { 1e30, 1e30, 1e30, 1e30, 1e30 };
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			best[0] = min(best[0], benchmarkScalar(ppObjects, count, frameCount));
+			best[1] = min(best[1], benchmarkSystem(&singleThreadedSystem, ppObjects, count, frameCount));
+			best[2] = min(best[2], benchmarkSystem(&threadedSystem, ppObjects, count, frameCount));
+
+			walkClip.EnableSharedSampling(gWalkClipSampleRate);
+			best[3] = min(best[3], benchmarkSystem(&threadedSystem, ppObjects, count, frameCount));
+			threadedSystem.SetLods(gAnimationLods, sizeof(gAnimationLods) / sizeof(gAnimationLods[0]));
+			best[4] = min(best[4], benchmarkSystem(&threadedSystem, ppObjects, count, frameCount));
+
+			// Back to sampling every object every frame on its own
+			threadedSystem.SetLods(NULL, 0);
+			for (uint32_t i = 0; i < maxCharacterCount; ++i)
+				ppObjects[i]->SetUpdateInterval(1);
+			walkClip.EnableSharedSampling(0.0f);
+		}
+
+		const double characterCount = (double)count * frameCount * 1000.0;
+		printf("%8u %12.1f %12.1f %12.1f %12.1f %12.1f\n", count, characterCount / best[0], characterCount / best[1],
+			   characterCount / best[2], characterCount / best[3], characterCount / best[4]);
+		if (count >= maxCharacterCount)
+			break;
+	}
+
+	threadedSystem.Destroy();
+	singleThreadedSystem.Destroy();
+	shutdownThreadSystem(pThreadSystem);
+
+	for (uint32_t i = 0; i < maxCharacterCount; ++i)
+	{
+		pCharacters[i].mAnimatedObject.Destroy();
+		pCharacters[i].mAnimation.Destroy();
+		pCharacters[i].mRig.Destroy();
+		pCharacters[i].~Character();
+	}
+	tf_free(ppObjects);
+	tf_free(pCharacters);
+
+	walkClip.Destroy();
+	clipRig.Destroy();
+	return 0;
+}
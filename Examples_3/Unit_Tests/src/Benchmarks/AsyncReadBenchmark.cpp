@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Read throughput of fsReadFromStreamAsync (io_uring or IO threads) against blocking fsReadFromStream, on a cold
+// and on a warm page cache. The cold runs evict the benchmark files with posix_fadvise, which needs no privileges
+// but only drops clean pages, so the files are synced after they are written.
+
+#include "Benchmarks.h"
+
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+
+#include <cstdio>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+static void getBenchmarkFileName(uint32_t index, char* pFileName) { sprintf(pFileName, "Benchmark_%u.bin", index); }
+
+static bool evictFromPageCache(uint32_t fileCount)
+{
+#if defined(__linux__)
+	for (uint32_t i = 0; i < fileCount; ++i)
+	{
+		char fileName[64] = {};
+		char filePath[FS_MAX_PATH] = {};
+		getBenchmarkFileName(i, fileName);
+		fsAppendPathComponent(fsGetResourceDirectory(RD_OTHER_FILES), fileName, filePath);
+		int fd = open(filePath, O_RDONLY);
+		if (fd < 0)
+			return false;
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+// One file after the other, as the resource loader read them before the async API
+static uint64_t readBlocking(uint32_t fileCount, uint8_t* pBuffer, size_t chunkSize)
+{
+	uint64_t bytesRead = 0;
+	for (uint32_t i = 0; i < fileCount; ++i)
+	{
+		char fileName[64] = {};
+		getBenchmarkFileName(i, fileName);
+		FileStream stream = {};
+		if (!fsOpenStreamFromPath(RD_OTHER_FILES, fileName, FM_READ_BINARY, &stream))
+			return 0;
+		size_t read = 0;
+		while ((read = fsReadFromStream(&stream, pBuffer, chunkSize)) > 0)
+			bytesRead += read;
+		fsCloseStream(&stream);
+	}
+	return bytesRead;
+}
+
+// The same chunks, keeping up to inFlightCount of them queued at once
+static uint64_t readAsync(uint32_t fileCount, size_t fileSize, uint8_t* pBuffers, size_t chunkSize, uint32_t inFlightCount)
+{
+	FileStream*    pStreams = (FileStream*)tf_calloc(fileCount, sizeof(FileStream));
+	FileAsyncRead* pReads = (FileAsyncRead*)tf_calloc(inFlightCount, sizeof(FileAsyncRead));
+	uint64_t       bytesRead = 0;
+	uint32_t       queuedCount = 0;
+	bool           success = true;
+
+	for (uint32_t i = 0; i < fileCount && success; ++i)
+	{
+		char fileName[64] = {};
+		getBenchmarkFileName(i, fileName);
+		success = fsOpenStreamFromPath(RD_OTHER_FILES, fileName, FM_READ_BINARY, &pStreams[i]);
+		for (size_t offset = 0; success && offset < fileSize; offset += chunkSize, ++queuedCount)
+		{
+			const uint32_t slot = queuedCount % inFlightCount;
+			if (queuedCount >= inFlightCount)
+				bytesRead += fsWaitAsyncRead(&pReads[slot]);
+			pReads[slot] = {};
+			success = fsReadFromStreamAsync(&pStreams[i], pBuffers + slot * chunkSize, chunkSize, &pReads[slot]);
+		}
+	}
+	for (uint32_t i = queuedCount > inFlightCount ? queuedCount - inFlightCount : 0; i < queuedCount; ++i)
+		bytesRead += fsWaitAsyncRead(&pReads[i % inFlightCount]);
+
+	for (uint32_t i = 0; i < fileCount; ++i)
+	{
+		if (pStreams[i].pIO)
+			fsCloseStream(&pStreams[i]);
+	}
+	tf_free(pReads);
+	tf_free(pStreams);
+	return success ? bytesRead : 0;
+}
+
+int AsyncReadBenchmark(int argc, char** argv)
+{
+	const uint32_t fileCount = getBenchmarkOption(argc, argv, "files", 64u);
+	const size_t   fileSize = (size_t)getBenchmarkOption(argc, argv, "size", 4096u) * 1024;
+	const size_t   chunkSize = (size_t)getBenchmarkOption(argc, argv, "chunk", 256u) * 1024;
+	const uint32_t inFlightCount = max(1u, getBenchmarkOption(argc, argv, "inflight", 32u));
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_OTHER_FILES, "BenchmarkFiles");
+
+	uint8_t* pBuffers = (uint8_t*)tf_malloc(inFlightCount * chunkSize);
+	for (size_t i = 0; i < chunkSize; ++i)
+		pBuffers[i] = (uint8_t)(i * 31);
+	for (uint32_t i = 0; i < fileCount; ++i)
+	{
+		char fileName[64] = {};
+		getBenchmarkFileName(i, fileName);
+		FileStream stream = {};
+		bool       success = fsOpenStreamFromPath(RD_OTHER_FILES, fileName, FM_WRITE_BINARY, &stream);
+		for (size_t offset = 0; success && offset < fileSize; offset += chunkSize)
+			success = fsWriteToStream(&stream, pBuffers, min(chunkSize, fileSize - offset)) > 0;
+		if (!success || !fsCloseStream(&stream))
+		{
+			LOGF(LogLevel::eERROR, "Could not write benchmark file %s", fileName);
+			tf_free(pBuffers);
+			return 1;
+		}
+	}
+
+	const uint64_t totalSize = (uint64_t)fileCount * fileSize;
+	const double   megabytes = totalSize / (1024.0 * 1024.0);
+	printf("Async reads: %u files of %zu KB in %zu KB chunks, %u reads in flight, MB/s\n", fileCount, fileSize / 1024,
+		   chunkSize / 1024, inFlightCount);
+	printf("%8s %12s %12s\n", "cache", "blocking", "async");
+
+	for (uint32_t cold = 1;; cold = 0)
+	{
+		const char* pCache = cold ? "cold" : "warm";
+		if (cold && !evictFromPageCache(fileCount))
+		{
+			printf("%8s %12s %12s\n", pCache, "-", "-");
+			continue;
+		}
+
+		double   best[2] = { 1e30, 1e30 };
+		uint64_t bytesRead[2] = {};
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			if (cold)
+				evictFromPageCache(fileCount);
+			int64_t start = getUSec();
+			bytesRead[0] = readBlocking(fileCount, pBuffers, chunkSize);
+			best[0] = min(best[0], (double)(getUSec() - start));
+
+			if (cold)
+				evictFromPageCache(fileCount);
+			start = getUSec();
+			bytesRead[1] = readAsync(fileCount, fileSize, pBuffers, chunkSize, inFlightCount);
+			best[1] = min(best[1], (double)(getUSec() - start));
+		}
+		if (bytesRead[0] != totalSize || bytesRead[1] != totalSize)
+		{
+			LOGF(LogLevel::eERROR, "Read %llu and %llu bytes instead of %llu", (unsigned long long)bytesRead[0],
+				 (unsigned long long)bytesRead[1], (unsigned long long)totalSize);
+			tf_free(pBuffers);
+			return 1;
+		}
+		printf("%8s %12.1f %12.1f\n", pCache, megabytes * 1e6 / best[0], megabytes * 1e6 / best[1]);
+
+		if (!cold)
+			break;
+	}
+
+	tf_free(pBuffers);
+	return 0;
+}
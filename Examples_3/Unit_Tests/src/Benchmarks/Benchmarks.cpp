@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include "Benchmarks.h"
+
+#include "../../../../Common_3/OS/Interfaces/IOperatingSystem.h"
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+const char* gApplicationName = "Benchmarks";
+
+typedef struct BenchmarkCommand
+{
+	const char*   pName;
+	const char*   pOptions;
+	BenchmarkFunc pFunc;
+} BenchmarkCommand;
+
+static const BenchmarkCommand gBenchmarkCommands[] = {
+	{ "threadsystem", "-tasks 200000 -maxthreads <cores>", ThreadSystemBenchmark },
+	{ "resourceloader", "-textures 512 -size 256 -maxthreads <cores>", ResourceLoaderBenchmark },
+	{ "asyncread", "-files 64 -size 4096 (KB) -chunk 256 (KB) -inflight 32", AsyncReadBenchmark },
+	{ "pak", "-files 4000 -size 4 (KB)", PakBenchmark },
+	{ "ecsupdate", "-maxentities 1000000 -frames 10", EcsUpdateBenchmark },
+	{ "ecsspawn", "-entities 200000 -batch 1000 -maxthreads <cores>", EcsSpawnBenchmark },
+	{ "spatialhash", "-maxentities 100000 -maxavoid 1280 -frames 10", SpatialHashBenchmark },
+	{ "animation", "-maxrigs 10000 -frames 5", AnimationBenchmark },
+	{ "text", "-labels 2000 -frames 100 -ring 8 (MB)", TextBenchmark },
+	{ "log", "-messages 2000 -maxthreads 8 -buffer 1024 (KB)", LogBenchmark },
+};
+
+static void PrintHelp()
+{
+	printf("Benchmarks <benchmark> [-option value ...]\n\nBenchmarks and their options with default values:\n");
+	for (const BenchmarkCommand& command : gBenchmarkCommands)
+		printf("\t%-16s %s\n", command.pName, command.pOptions);
+}
+
+uint32_t getBenchmarkOption(int argc, char** argv, const char* pName, uint32_t defaultValue)
+{
+	const char* pValue = getBenchmarkOption(argc, argv, pName, (const char*)NULL);
+	return pValue ? (uint32_t)strtoul(pValue, NULL, 10) : defaultValue;
+}
+
+const char* getBenchmarkOption(int argc, char** argv, const char* pName, const char* pDefaultValue)
+{
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (argv[i][0] == '-' && strcmp(argv[i] + 1, pName) == 0)
+			return argv[i + 1];
+	}
+	return pDefaultValue;
+}
+
+static volatile uint64_t gBenchmarkSink = 0;
+
+void benchmarkSink(uint64_t value) { gBenchmarkSink = gBenchmarkSink + value; }
+
+int main(int argc, char** argv)
+{
+	extern bool MemAllocInit(const char*);
+	extern void MemAllocExit();
+
+	if (argc < 2 || stricmp(argv[1], "-h") == 0 || stricmp(argv[1], "-help") == 0)
+	{
+		PrintHelp();
+		return 0;
+	}
+
+	const BenchmarkCommand* pCommand = NULL;
+	for (const BenchmarkCommand& command : gBenchmarkCommands)
+	{
+		if (stricmp(argv[1], command.pName) == 0)
+			pCommand = &command;
+	}
+	if (!pCommand)
+	{
+		printf("ERROR: Unknown benchmark %s\n", argv[1]);
+		PrintHelp();
+		return 1;
+	}
+
+	if (!MemAllocInit(gApplicationName))
+		return EXIT_FAILURE;
+
+	FileSystemInitDesc fsDesc = {};
+	fsDesc.pAppName = gApplicationName;
+	if (!initFileSystem(&fsDesc))
+		return EXIT_FAILURE;
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_LOG, "");
+
+	Log::Init(gApplicationName);
+
+	int ret = pCommand->pFunc(argc - 1, argv + 1);
+
+	Log::Exit();
+	exitFileSystem();
+	MemAllocExit();
+
+	return ret;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+// Headless benchmarks for the engine systems, one subcommand each:
+//     Benchmarks <benchmark> [-option value ...]
+// Results are printed as one table per benchmark so runs can be diffed.
+
+#include <stdint.h>
+
+typedef int (*BenchmarkFunc)(int argc, char** argv);
+
+extern const char* gApplicationName;
+
+/// argv[0] is the benchmark name, options follow as "-name value" pairs
+int ThreadSystemBenchmark(int argc, char** argv);
+int ResourceLoaderBenchmark(int argc, char** argv);
+int AsyncReadBenchmark(int argc, char** argv);
+int PakBenchmark(int argc, char** argv);
+int EcsUpdateBenchmark(int argc, char** argv);
+int EcsSpawnBenchmark(int argc, char** argv);
+int SpatialHashBenchmark(int argc, char** argv);
+int AnimationBenchmark(int argc, char** argv);
+int TextBenchmark(int argc, char** argv);
+int LogBenchmark(int argc, char** argv);
+
+/// Value of option "-pName", or defaultValue if it is not passed
+uint32_t    getBenchmarkOption(int argc, char** argv, const char* pName, uint32_t defaultValue);
+const char* getBenchmarkOption(int argc, char** argv, const char* pName, const char* pDefaultValue);
+
+/// Keeps the compiler from optimizing away the work being measured
+void benchmarkSink(uint64_t value);
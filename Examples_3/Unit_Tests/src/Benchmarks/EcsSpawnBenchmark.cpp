@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+// Spawn rate of the sprite entities of 17_EntityComponentSystem: batches created with createEntities against one
+// createEntity and an addComponentToEntity per component for every entity, from a growing number of threads.
+
+#include "Benchmarks.h"
+
+#include "../../../../Middleware_3/ECS/EntityManager.h"
+
+#include "../17_EntityComponentSystem/Representations/PositionRepresentation.h"
+#include "../17_EntityComponentSystem/Representations/SpriteRepresentation.h"
+#include "../17_EntityComponentSystem/Representations/MoveRepresentation.h"
+
+#include "../17_EntityComponentSystem/Components/PositionComponent.h"
+#include "../17_EntityComponentSystem/Components/SpriteComponent.h"
+#include "../17_EntityComponentSystem/Components/MoveComponent.h"
+
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+
+#include <cstdio>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+typedef struct SpawnBenchmark
+{
+	EntityManager* pEntityManager;
+	Archetype*     pArchetype;
+	EntityId*      pIds;
+	uint32_t       mEntityCount;
+	uint32_t       mBatchSize;
+	uint32_t       mThreadCount;
+	bool           mBatched;
+} SpawnBenchmark;
+
+typedef struct SpawnThread
+{
+	SpawnBenchmark* pBenchmark;
+	uint32_t        mIndex;
+} SpawnThread;
+
+static void spawnEntities(void* pData)
+{
+	SpawnThread*    pThread = (SpawnThread*)pData;
+	SpawnBenchmark* pBenchmark = pThread->pBenchmark;
+	EntityManager*  pEntityManager = pBenchmark->pEntityManager;
+	// Every thread spawns a contiguous range of the ids
+	const uint32_t  begin = (uint32_t)((uint64_t)pBenchmark->mEntityCount * pThread->mIndex / pBenchmark->mThreadCount);
+	const uint32_t  end = (uint32_t)((uint64_t)pBenchmark->mEntityCount * (pThread->mIndex + 1) / pBenchmark->mThreadCount);
+
+	if (pBenchmark->mBatched)
+	{
+		for (uint32_t i = begin; i < end; i += pBenchmark->mBatchSize)
+			pEntityManager->createEntities(min(pBenchmark->mBatchSize, end - i), pBenchmark->pArchetype, pBenchmark->pIds + i);
+	}
+	else
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			pBenchmark->pIds[i] = pEntityManager->createEntity();
+			pEntityManager->addComponentToEntity<PositionComponent>(pBenchmark->pIds[i]);
+			pEntityManager->addComponentToEntity<MoveComponent>(pBenchmark->pIds[i]);
+			pEntityManager->addComponentToEntity<SpriteComponent>(pBenchmark->pIds[i]);
+		}
+	}
+}
+
+static double benchmarkSpawn(SpawnBenchmark* pBenchmark)
+{
+	// create_thread keeps a pointer to the desc, so the descs live as long as the threads
+	ThreadHandle* pThreads = (ThreadHandle*)tf_malloc(pBenchmark->mThreadCount * sizeof(ThreadHandle));
+	ThreadDesc*   pThreadDescs = (ThreadDesc*)tf_calloc(pBenchmark->mThreadCount, sizeof(ThreadDesc));
+	SpawnThread*  pSpawnThreads = (SpawnThread*)tf_calloc(pBenchmark->mThreadCount, sizeof(SpawnThread));
+
+	const int64_t start = getUSec();
+	for (uint32_t i = 0; i < pBenchmark->mThreadCount; ++i)
+	{
+		pSpawnThreads[i].pBenchmark = pBenchmark;
+		pSpawnThreads[i].mIndex = i;
+		pThreadDescs[i].pFunc = spawnEntities;
+		pThreadDescs[i].pData = &pSpawnThreads[i];
+		pThreads[i] = create_thread(&pThreadDescs[i]);
+	}
+	for (uint32_t i = 0; i < pBenchmark->mThreadCount; ++i)
+		destroy_thread(pThreads[i]);
+	const double elapsed = (double)(getUSec() - start);
+
+	// Every id is spawned exactly once
+	for (uint32_t i = 0; i < pBenchmark->mEntityCount; ++i)
+	{
+		Entity* pEntity = pBenchmark->pEntityManager->getEntityById(pBenchmark->pIds[i]);
+		ASSERT(pEntity && pEntity->getComponent<SpriteComponent>());
+		UNREF_PARAM(pEntity);
+	}
+	pBenchmark->pEntityManager->reset();
+
+	tf_free(pSpawnThreads);
+	tf_free(pThreadDescs);
+	tf_free(pThreads);
+	return elapsed;
+}
+
+int EcsSpawnBenchmark(int argc, char** argv)
+{
+	const uint32_t coreCount = Thread::GetNumCPUCores();
+
+	SpawnBenchmark benchmark = {};
+	benchmark.mEntityCount = getBenchmarkOption(argc, argv, "entities", 200000u);
+	benchmark.mBatchSize = max(getBenchmarkOption(argc, argv, "batch", 1000u), 1u);
+	const uint32_t maxThreads = max(getBenchmarkOption(argc, argv, "maxthreads", coreCount), 1u);
+
+	SpriteComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+	MoveComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+	PositionComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+
+	benchmark.pEntityManager = tf_new(EntityManager);
+	benchmark.pArchetype = benchmark.pEntityManager->getArchetype<PositionComponent, MoveComponent, SpriteComponent>();
+	benchmark.pIds = (EntityId*)tf_malloc(benchmark.mEntityCount * sizeof(EntityId));
+
+	printf("ECS spawn: %u entities with 3 components, batches of %u, %u cores, million entities per second (best of 3)\n",
+		   benchmark.mEntityCount, benchmark.mBatchSize, coreCount);
+	printf("%8s %12s %12s\n", "threads", "batched", "perEntity");
+	// Powers of two up to maxThreads, always including maxThreads
+	for (uint32_t threadCount = 1;; threadCount = min(threadCount * 2, maxThreads))
+	{
+		benchmark.mThreadCount = threadCount;
+
+		double best[2] = { 1e30, 1e30 };
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			benchmark.mBatched = true;
+			best[0] = min(best[0], benchmarkSpawn(&benchmark));
+			benchmark.mBatched = false;
+			best[1] = min(best[1], benchmarkSpawn(&benchmark));
+		}
+
+		// Entities per microsecond are million entities per second
+		printf("%8u %12.2f %12.2f\n", threadCount, benchmark.mEntityCount / best[0], benchmark.mEntityCount / best[1]);
+		if (threadCount >= maxThreads)
+			break;
+	}
+
+	tf_free(benchmark.pIds);
+	tf_delete(benchmark.pEntityManager);
+
+	SpriteComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+	MoveComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+	PositionComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+
+	return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+// Per entity cost of the position update of 17_EntityComponentSystem through the archetype queries, compared with
+// looking up the components of every entity and with the old layout: components allocated one by one and found
+// through a hash map in each entity.
+
+#include "Benchmarks.h"
+
+#include "../../../../Middleware_3/ECS/EntityManager.h"
+
+#include "../17_EntityComponentSystem/Representations/WorldBoundsRepresentation.h"
+#include "../17_EntityComponentSystem/Representations/PositionRepresentation.h"
+#include "../17_EntityComponentSystem/Representations/SpriteRepresentation.h"
+#include "../17_EntityComponentSystem/Representations/MoveRepresentation.h"
+
+#include "../17_EntityComponentSystem/Components/WorldBoundsComponent.h"
+#include "../17_EntityComponentSystem/Components/PositionComponent.h"
+#include "../17_EntityComponentSystem/Components/SpriteComponent.h"
+#include "../17_EntityComponentSystem/Components/MoveComponent.h"
+
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+// Entity of the layout the EntityManager used before archetypes
+typedef eastl::unordered_map<uint32_t, BaseComponent*> HeapComponentMap;
+
+static void moveEntity(PositionComponent& position, MoveComponent& move, float deltaTime, const WorldBoundsComponent& bounds)
+{
+	position.x += move.velx * deltaTime;
+	position.y += move.vely * deltaTime;
+
+	if (position.x < bounds.xMin)
+	{
+		move.velx = -move.velx;
+		position.x = bounds.xMin;
+	}
+	if (position.x > bounds.xMax)
+	{
+		move.velx = -move.velx;
+		position.x = bounds.xMax;
+	}
+	if (position.y < bounds.yMin)
+	{
+		move.vely = -move.vely;
+		position.y = bounds.yMin;
+	}
+	if (position.y > bounds.yMax)
+	{
+		move.vely = -move.vely;
+		position.y = bounds.yMax;
+	}
+}
+
+static void initEntity(PositionComponent& position, MoveComponent& move, const WorldBoundsComponent& bounds)
+{
+	position.x = bounds.xMin + (bounds.xMax - bounds.xMin) * (float)rand() / (float)RAND_MAX;
+	position.y = bounds.yMin + (bounds.yMax - bounds.yMin) * (float)rand() / (float)RAND_MAX;
+	move.Initialize(0.3f, 0.6f);
+}
+
+int EcsUpdateBenchmark(int argc, char** argv)
+{
+	const uint32_t maxEntityCount = getBenchmarkOption(argc, argv, "maxentities", 1000000u);
+	const uint32_t frameCount = getBenchmarkOption(argc, argv, "frames", 10u);
+	const float    deltaTime = 1.0f / 60.0f;
+
+	SpriteComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+	MoveComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+	PositionComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+	WorldBoundsComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+
+	WorldBoundsComponent bounds;
+	bounds.xMin = -80.0f;
+	bounds.xMax = 80.0f;
+	bounds.yMin = -50.0f;
+	bounds.yMax = 50.0f;
+
+	// Only one EntityManager at a time, its destructor unregisters the component types
+	EntityManager* pEntityManager = tf_new(EntityManager);
+	Archetype*     pArchetype = pEntityManager->getArchetype<PositionComponent, MoveComponent, SpriteComponent>();
+
+	printf("ECS update: position update of the sprites over %u frames, nanoseconds per entity (best of 3)\n", frameCount);
+	printf("%10s %12s %12s %12s %12s\n", "entities", "forEach", "queryChunks", "getComponent", "heapEntity");
+	// Powers of ten up to maxEntityCount, always including maxEntityCount
+	for (uint32_t entityCount = min(10000u, maxEntityCount);; entityCount = min(entityCount * 10, maxEntityCount))
+	{
+		EntityId* pIds = (EntityId*)tf_malloc(entityCount * sizeof(EntityId));
+		Entity**  ppEntities = (Entity**)tf_malloc(entityCount * sizeof(Entity*));
+		pEntityManager->createEntities(entityCount, pArchetype, pIds);
+		for (uint32_t i = 0; i < entityCount; ++i)
+		{
+			ppEntities[i] = pEntityManager->getEntityById(pIds[i]);
+			initEntity(*ppEntities[i]->getComponent<PositionComponent>(), *ppEntities[i]->getComponent<MoveComponent>(), bounds);
+		}
+
+		HeapComponentMap* pHeapEntities = (HeapComponentMap*)tf_malloc(entityCount * sizeof(HeapComponentMap));
+		for (uint32_t i = 0; i < entityCount; ++i)
+		{
+			tf_placement_new<HeapComponentMap>(pHeapEntities + i);
+			PositionComponent* pPosition = tf_new(PositionComponent);
+			MoveComponent*     pMove = tf_new(MoveComponent);
+			initEntity(*pPosition, *pMove, bounds);
+			pHeapEntities[i][PositionComponent::getTypeStatic()] = pPosition;
+			pHeapEntities[i][MoveComponent::getTypeStatic()] = pMove;
+			pHeapEntities[i][SpriteComponent::getTypeStatic()] = tf_new(SpriteComponent);
+		}
+
+		double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			int64_t start = getUSec();
+			for (uint32_t frame = 0; frame < frameCount; ++frame)
+			{
+				pEntityManager->forEach<PositionComponent, MoveComponent>(
+					[&](PositionComponent& position, MoveComponent& move) { moveEntity(position, move, deltaTime, bounds); });
+			}
+			best[0] = min(best[0], (double)(getUSec() - start));
+
+			start = getUSec();
+			eastl::vector<ArchetypeChunk*> chunks;
+			for (uint32_t frame = 0; frame < frameCount; ++frame)
+			{
+				chunks.clear();
+				pEntityManager->queryChunks<PositionComponent, MoveComponent>(chunks);
+				for (ArchetypeChunk* pChunk : chunks)
+				{
+					PositionComponent* pPositions = pChunk->getComponents<PositionComponent>();
+					MoveComponent*     pMoves = pChunk->getComponents<MoveComponent>();
+					for (uint32_t i = 0; i < pChunk->mCount; ++i)
+						moveEntity(pPositions[i], pMoves[i], deltaTime, bounds);
+				}
+			}
+			best[1] = min(best[1], (double)(getUSec() - start));
+
+			start = getUSec();
+			for (uint32_t frame = 0; frame < frameCount; ++frame)
+			{
+				for (uint32_t i = 0; i < entityCount; ++i)
+					moveEntity(*ppEntities[i]->getComponent<PositionComponent>(), *ppEntities[i]->getComponent<MoveComponent>(),
+							   deltaTime, bounds);
+			}
+			best[2] = min(best[2], (double)(getUSec() - start));
+
+			start = getUSec();
+			for (uint32_t frame = 0; frame < frameCount; ++frame)
+			{
+				for (uint32_t i = 0; i < entityCount; ++i)
+				{
+					PositionComponent* pPosition = (PositionComponent*)pHeapEntities[i].find(PositionComponent::getTypeStatic())->second;
+					MoveComponent*     pMove = (MoveComponent*)pHeapEntities[i].find(MoveComponent::getTypeStatic())->second;
+					moveEntity(*pPosition, *pMove, deltaTime, bounds);
+				}
+			}
+			best[3] = min(best[3], (double)(getUSec() - start));
+		}
+
+		const double updateCount = (double)entityCount * frameCount;
+		printf("%10u %12.2f %12.2f %12.2f %12.2f\n", entityCount, best[0] * 1000.0 / updateCount, best[1] * 1000.0 / updateCount,
+			   best[2] * 1000.0 / updateCount, best[3] * 1000.0 / updateCount);
+
+		double checksum = 0.0;
+		pEntityManager->forEach<PositionComponent>([&](PositionComponent& position) { checksum += position.x + position.y; });
+		for (uint32_t i = 0; i < entityCount; ++i)
+		{
+			PositionComponent* pPosition = (PositionComponent*)pHeapEntities[i][PositionComponent::getTypeStatic()];
+			checksum += pPosition->x + pPosition->y;
+			for (HeapComponentMap::value_type& component : pHeapEntities[i])
+				tf_delete(component.second);
+			pHeapEntities[i].~HeapComponentMap();
+		}
+		benchmarkSink((uint64_t)checksum);
+
+		tf_free(pHeapEntities);
+		tf_free(ppEntities);
+		tf_free(pIds);
+		pEntityManager->reset();
+
+		if (entityCount >= maxEntityCount)
+			break;
+	}
+
+	tf_delete(pEntityManager);
+
+	SpriteComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+	MoveComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+	PositionComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+	WorldBoundsComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+
+	return 0;
+}
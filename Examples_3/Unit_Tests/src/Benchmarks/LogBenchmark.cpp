@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+// Logging throughput of N threads logging at once, the way the resource loader and the workers do while streaming.
+// Synchronous logging formats and writes the log file on the calling thread under the log mutex, asynchronous
+// logging only appends to the buffer of the thread, deferred formatting also leaves the formatting to the writer.
+
+#include "Benchmarks.h"
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+
+#include <cstdio>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+typedef struct LogThread
+{
+	uint32_t mIndex;
+	uint32_t mMessageCount;
+} LogThread;
+
+static void logMessages(void* pData)
+{
+	LogThread* pThread = (LogThread*)pData;
+	for (uint32_t i = 0; i < pThread->mMessageCount; ++i)
+	{
+		LOGF(LogLevel::eINFO, "Streaming %s: %u bytes at offset %llu in %.3f ms from thread %u", "Textures/Benchmark.dds",
+			 4096u + i, (unsigned long long)i * 4096, i * 0.001, pThread->mIndex);
+	}
+}
+
+// Time in microseconds until every thread is done logging, pFlushed receives the time until the messages are written
+static double benchmarkLog(uint32_t threadCount, uint32_t messageCount, double* pFlushed)
+{
+	// create_thread keeps a pointer to the desc, so the descs live as long as the threads
+	ThreadHandle* pThreads = (ThreadHandle*)tf_malloc(threadCount * sizeof(ThreadHandle));
+	ThreadDesc*   pThreadDescs = (ThreadDesc*)tf_calloc(threadCount, sizeof(ThreadDesc));
+	LogThread*    pLogThreads = (LogThread*)tf_calloc(threadCount, sizeof(LogThread));
+
+	const int64_t start = getUSec();
+	for (uint32_t i = 0; i < threadCount; ++i)
+	{
+		pLogThreads[i].mIndex = i;
+		pLogThreads[i].mMessageCount = messageCount;
+		pThreadDescs[i].pFunc = logMessages;
+		pThreadDescs[i].pData = &pLogThreads[i];
+		pThreads[i] = create_thread(&pThreadDescs[i]);
+	}
+	for (uint32_t i = 0; i < threadCount; ++i)
+		destroy_thread(pThreads[i]);
+	const double elapsed = (double)(getUSec() - start);
+
+	Log::Flush();
+	*pFlushed = (double)(getUSec() - start);
+
+	tf_free(pLogThreads);
+	tf_free(pThreadDescs);
+	tf_free(pThreads);
+	return elapsed;
+}
+
+int LogBenchmark(int argc, char** argv)
+{
+	const uint32_t messageCount = getBenchmarkOption(argc, argv, "messages", 2000u);
+	const uint32_t maxThreads = max(getBenchmarkOption(argc, argv, "maxthreads", 8u), 1u);
+	// By default a burst fits the buffers, so the first columns are the cost of a call without waiting for the writer
+	const uint32_t bufferSize = getBenchmarkOption(argc, argv, "buffer", 1024u) * 1024;
+
+	printf("Log: %u messages of 5 arguments per thread to %s.log, %u KB buffers (best of 3)\n", messageCount, gApplicationName,
+		   bufferSize / 1024);
+	printf("%8s %30s %30s\n", "", "us per message on a thread", "thousand messages/s written");
+	printf("%8s %10s %10s %10s %10s %10s %10s\n", "threads", "sync", "async", "deferred", "sync", "async", "deferred");
+
+	// The console would be the bottleneck, only the log file is written
+	Log::SetConsoleLogging(false);
+	// Powers of two up to maxThreads, always including maxThreads
+	for (uint32_t threadCount = 1;; threadCount = min(threadCount * 2, maxThreads))
+	{
+		double best[3] = { 1e30, 1e30, 1e30 };
+		double bestFlushed[3] = { 1e30, 1e30, 1e30 };
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			for (uint32_t mode = 0; mode < 3; ++mode)
+			{
+				if (mode > 0)
+				{
+					LogAsyncDesc asyncDesc = {};
+					asyncDesc.mThreadBufferSize = bufferSize;
+					// Blocking keeps every message, so all modes write the same log
+					asyncDesc.mOverflowPolicy = LOG_OVERFLOW_BLOCK;
+					asyncDesc.mDeferredFormatting = mode == 2;
+					Log::EnableAsync(&asyncDesc);
+				}
+
+				double flushed = 0.0;
+				best[mode] = min(best[mode], benchmarkLog(threadCount, messageCount, &flushed));
+				bestFlushed[mode] = min(bestFlushed[mode], flushed);
+
+				if (mode > 0)
+					Log::DisableAsync();
+			}
+		}
+
+		const double totalCount = (double)threadCount * messageCount;
+		printf("%8u %10.2f %10.2f %10.2f %10.1f %10.1f %10.1f\n", threadCount, best[0] / messageCount, best[1] / messageCount,
+			   best[2] / messageCount, totalCount * 1000.0 / bestFlushed[0], totalCount * 1000.0 / bestFlushed[1],
+			   totalCount * 1000.0 / bestFlushed[2]);
+		if (threadCount >= maxThreads)
+			break;
+	}
+	Log::SetConsoleLogging(true);
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Open + read + close latency of many small files from loose files, a pak archive (compressed and stored) and a zip
+// archive. The benchmark writes the files and builds both archives itself, so the results are on a warm page cache.
+
+#include "Benchmarks.h"
+
+#include "../../../../Common_3/OS/FileSystem/PakFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/zip/zip.h"
+
+#include <cstdio>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+// Defined in ZipFileSystem.cpp
+bool fsOpenZipFile(const ResourceDirectory resourceDir, const char* fileName, FileMode mode, IFileSystem* pOut);
+bool fsCloseZipFile(IFileSystem* pZip);
+
+static const ResourceDirectory RD_LOOSE_FILES = RD_MIDDLEWARE_0;
+static const ResourceDirectory RD_PAK_FILES = RD_MIDDLEWARE_1;
+static const ResourceDirectory RD_STORED_PAK_FILES = RD_MIDDLEWARE_2;
+static const ResourceDirectory RD_ZIP_FILES = RD_MIDDLEWARE_3;
+
+// Text like content that deflate compresses well
+static void fillBenchmarkFile(uint8_t* pData, size_t size, uint32_t seed)
+{
+	static const char* pWords[] = { "vertex ", "texture ", "material ", "shader ", "mesh ", "float4 ", "0.25, ", "1.0\n" };
+	uint32_t           state = seed * 747796405u + 2891336453u;
+	for (size_t i = 0; i < size;)
+	{
+		state = state * 1664525u + 1013904223u;
+		for (const char* pWord = pWords[state >> 29]; *pWord && i < size; ++pWord)
+			pData[i++] = (uint8_t)*pWord;
+	}
+}
+
+static size_t getBenchmarkFileSize(uint32_t index, size_t averageSize)
+{
+	// Between half and one and a half times the average
+	return averageSize / 2 + (size_t)((index * 2654435761u) % (uint32_t)(averageSize + 1));
+}
+
+// Files are visited in a scattered order so that neither source benefits from sequential access
+static double readAll(ResourceDirectory resourceDir, uint32_t fileCount, uint8_t* pBuffer, size_t bufferSize, uint64_t* pBytesRead)
+{
+	*pBytesRead = 0;
+	const int64_t start = getUSec();
+	for (uint32_t i = 0; i < fileCount; ++i)
+	{
+		char fileName[64] = {};
+		sprintf(fileName, "File_%u.bin", (uint32_t)(((uint64_t)i * 7919) % fileCount));
+		FileStream stream = {};
+		if (!fsOpenStreamFromPath(resourceDir, fileName, FM_READ_BINARY, &stream))
+			return 0.0;
+		const size_t size = (size_t)fsGetStreamFileSize(&stream);
+		*pBytesRead += fsReadFromStream(&stream, pBuffer, min(size, bufferSize));
+		fsCloseStream(&stream);
+	}
+	return (double)(getUSec() - start);
+}
+
+int PakBenchmark(int argc, char** argv)
+{
+	// 7919 is prime, so the scattered order visits every file unless it divides the count
+	const uint32_t fileCount = getBenchmarkOption(argc, argv, "files", 4000u) | 1u;
+	const size_t   averageSize = (size_t)getBenchmarkOption(argc, argv, "size", 4u) * 1024;
+	const size_t   bufferSize = averageSize * 2;
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_OTHER_FILES, "BenchmarkPak");
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_LOOSE_FILES, "BenchmarkPak/Files");
+
+	uint8_t*     pBuffer = (uint8_t*)tf_malloc(bufferSize);
+	const char** ppFileNames = (const char**)tf_calloc(fileCount, sizeof(const char*));
+	char*        pNames = (char*)tf_calloc(fileCount, 32);
+	bool         success = true;
+	zip_t*       pZip = zip_open(RD_OTHER_FILES, "Benchmark.zip", ZIP_DEFAULT_COMPRESSION_LEVEL, 'w');
+	success = pZip != NULL;
+	for (uint32_t i = 0; i < fileCount && success; ++i)
+	{
+		char fileName[32] = {};
+		sprintf(fileName, "File_%u.bin", i);
+		sprintf(pNames + i * 32, "Files/%s", fileName);
+		ppFileNames[i] = pNames + i * 32;
+
+		const size_t size = getBenchmarkFileSize(i, averageSize);
+		fillBenchmarkFile(pBuffer, size, i);
+		FileStream stream = {};
+		success = fsOpenStreamFromPath(RD_LOOSE_FILES, fileName, FM_WRITE_BINARY, &stream);
+		success = success && fsWriteToStream(&stream, pBuffer, size) == size;
+		success = success && fsCloseStream(&stream);
+		success = success && zip_entry_open(pZip, ppFileNames[i]) == 0;
+		success = success && zip_entry_write(pZip, pBuffer, size) == 0;
+		success = success && zip_entry_close(pZip) == 0;
+	}
+	if (pZip)
+		zip_close(pZip);
+
+	PakCreateDesc pakDesc = {};
+	pakDesc.mInputDir = RD_OTHER_FILES;
+	pakDesc.ppFileNames = ppFileNames;
+	pakDesc.mFileCount = fileCount;
+	success = success && fsCreatePakFile(RD_OTHER_FILES, "Benchmark.pak", &pakDesc);
+	pakDesc.mStoreOnly = true;
+	success = success && fsCreatePakFile(RD_OTHER_FILES, "BenchmarkStored.pak", &pakDesc);
+	tf_free(pNames);
+	tf_free(ppFileNames);
+
+	IFileSystem pakFileSystem = {};
+	IFileSystem storedPakFileSystem = {};
+	IFileSystem zipFileSystem = {};
+	success = success && fsOpenPakFile(RD_OTHER_FILES, "Benchmark.pak", &pakFileSystem);
+	success = success && fsOpenPakFile(RD_OTHER_FILES, "BenchmarkStored.pak", &storedPakFileSystem);
+	success = success && fsOpenZipFile(RD_OTHER_FILES, "Benchmark.zip", FM_READ, &zipFileSystem);
+	if (!success)
+	{
+		LOGF(LogLevel::eERROR, "Could not create the benchmark files");
+		tf_free(pBuffer);
+		return 1;
+	}
+	fsSetPathForResourceDir(&pakFileSystem, RM_CONTENT, RD_PAK_FILES, "Files");
+	fsSetPathForResourceDir(&storedPakFileSystem, RM_CONTENT, RD_STORED_PAK_FILES, "Files");
+	fsSetPathForResourceDir(&zipFileSystem, RM_CONTENT, RD_ZIP_FILES, "Files");
+
+	struct
+	{
+		const char*       pName;
+		ResourceDirectory mResourceDir;
+	} sources[] = {
+		{ "loose", RD_LOOSE_FILES },
+		{ "pak", RD_PAK_FILES },
+		{ "pak stored", RD_STORED_PAK_FILES },
+		{ "zip", RD_ZIP_FILES },
+	};
+
+	printf("Pak: %u files of %zu KB on average, open + read + close, best of 3\n", fileCount, averageSize / 1024);
+	printf("%12s %12s %12s %12s\n", "source", "files/s", "us/file", "MB/s");
+	uint64_t expectedBytes = 0;
+	for (uint32_t i = 0; i < fileCount; ++i)
+		expectedBytes += getBenchmarkFileSize(i, averageSize);
+	for (uint32_t s = 0; s < sizeof(sources) / sizeof(sources[0]) && success; ++s)
+	{
+		double   best = 1e30;
+		uint64_t bytesRead = 0;
+		for (uint32_t run = 0; run < 3 && success; ++run)
+		{
+			best = min(best, readAll(sources[s].mResourceDir, fileCount, pBuffer, bufferSize, &bytesRead));
+			success = bytesRead == expectedBytes;
+		}
+		if (!success)
+		{
+			LOGF(LogLevel::eERROR, "Read %llu bytes from %s instead of %llu", (unsigned long long)bytesRead, sources[s].pName,
+				 (unsigned long long)expectedBytes);
+			break;
+		}
+		printf("%12s %12.0f %12.2f %12.1f\n", sources[s].pName, fileCount * 1e6 / best, best / fileCount,
+			   expectedBytes / (1024.0 * 1024.0) * 1e6 / best);
+	}
+
+	fsCloseZipFile(&zipFileSystem);
+	fsClosePakFile(&storedPakFileSystem);
+	fsClosePakFile(&pakFileSystem);
+	tf_free(pBuffer);
+	return success ? 0 : 1;
+}
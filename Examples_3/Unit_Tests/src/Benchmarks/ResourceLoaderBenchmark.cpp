@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Texture loads per second through the resource loader for different decode worker counts, and how long a high
+// priority load waits when it is queued behind every other texture at low priority. The textures are uncompressed
+// DDS files written by the benchmark, so they are read from a warm page cache.
+
+#include "Benchmarks.h"
+
+#include "../../../../Common_3/Renderer/IRenderer.h"
+#include "../../../../Common_3/Renderer/IResourceLoader.h"
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+#include "../../../../Common_3/OS/Core/TextureContainers.h"
+
+#include <cstdio>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+static bool writeBenchmarkTexture(const char* pFileName, uint32_t size, uint32_t seed)
+{
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_TEXTURES, pFileName, FM_WRITE_BINARY, &stream))
+		return false;
+
+	DDS_HEADER header = {};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = 0x1 | DDS_HEIGHT | 0x4 | 0x1000; // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+	header.height = size;
+	header.width = size;
+	header.pitchOrLinearSize = size * 4;
+	header.mipMapCount = 1;
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.ddspf.flags = DDS_RGB | 0x1; // DDPF_ALPHAPIXELS
+	header.ddspf.RGBBitCount = 32;
+	header.ddspf.RBitMask = 0x000000ff;
+	header.ddspf.GBitMask = 0x0000ff00;
+	header.ddspf.BBitMask = 0x00ff0000;
+	header.ddspf.ABitMask = 0xff000000;
+	header.caps = 0x1000; // DDSCAPS_TEXTURE
+
+	fsWriteToStream(&stream, &DDS_MAGIC, sizeof(DDS_MAGIC));
+	fsWriteToStream(&stream, &header, sizeof(header));
+	uint32_t* pRow = (uint32_t*)tf_malloc(size * sizeof(uint32_t));
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+			pRow[x] = (x * 2654435761u) ^ (y * 40503u) ^ seed;
+		fsWriteToStream(&stream, pRow, size * sizeof(uint32_t));
+	}
+	tf_free(pRow);
+	return fsCloseStream(&stream);
+}
+
+int ResourceLoaderBenchmark(int argc, char** argv)
+{
+	const uint32_t textureCount = getBenchmarkOption(argc, argv, "textures", 512u);
+	const uint32_t textureSize = getBenchmarkOption(argc, argv, "size", 256u);
+	const uint32_t maxThreads = getBenchmarkOption(argc, argv, "maxthreads", Thread::GetNumCPUCores());
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_TEXTURES, "BenchmarkTextures");
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		char fileName[64] = {};
+		sprintf(fileName, "Benchmark_%u.dds", i);
+		if (!writeBenchmarkTexture(fileName, textureSize, i))
+		{
+			LOGF(LogLevel::eERROR, "Could not write benchmark texture %s", fileName);
+			return 1;
+		}
+	}
+
+	RendererDesc settings = {};
+	Renderer*    pRenderer = NULL;
+	initRenderer(gApplicationName, &settings, &pRenderer);
+	if (!pRenderer)
+		return 1;
+
+	Texture** ppTextures = (Texture**)tf_calloc(textureCount + 1, sizeof(Texture*));
+	char      fileName[64] = {};
+
+	const double megabytes = (double)textureCount * textureSize * textureSize * 4 / (1024.0 * 1024.0);
+	printf("ResourceLoader: %u textures of %ux%u RGBA8 (%.1f MB), best of 3\n", textureCount, textureSize, textureSize, megabytes);
+	printf("%8s %12s %12s %18s\n", "decoders", "assets/s", "MB/s", "high priority ms");
+	// 0 decodes on the copy thread, which is how the loader worked before the decode workers
+	for (uint32_t threadCount = 0;; threadCount = threadCount ? min(threadCount * 2, maxThreads) : 1)
+	{
+		ResourceLoaderDesc loaderDesc = gDefaultResourceLoaderDesc;
+		loaderDesc.mDecodeThreadCount = threadCount;
+		initResourceLoaderInterface(pRenderer, &loaderDesc);
+
+		double bestLoad = 1e30;
+		double bestHighPriority = 1e30;
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			int64_t start = getUSec();
+			for (uint32_t i = 0; i < textureCount; ++i)
+			{
+				sprintf(fileName, "Benchmark_%u", i);
+				TextureLoadDesc textureDesc = {};
+				textureDesc.pFileName = fileName;
+				textureDesc.ppTexture = &ppTextures[i];
+				addResource(&textureDesc, NULL);
+			}
+			waitForAllResourceLoads();
+			bestLoad = min(bestLoad, (double)(getUSec() - start));
+			for (uint32_t i = 0; i < textureCount; ++i)
+				removeResource(ppTextures[i]);
+
+			// Everything at low priority, then one texture that is needed right away
+			for (uint32_t i = 0; i < textureCount; ++i)
+			{
+				sprintf(fileName, "Benchmark_%u", i);
+				TextureLoadDesc textureDesc = {};
+				textureDesc.pFileName = fileName;
+				textureDesc.ppTexture = &ppTextures[i];
+				textureDesc.mPriority = LOAD_PRIORITY_LOW;
+				addResource(&textureDesc, NULL);
+			}
+			start = getUSec();
+			SyncToken       highPriorityToken = {};
+			TextureLoadDesc textureDesc = {};
+			textureDesc.pFileName = "Benchmark_0";
+			textureDesc.ppTexture = &ppTextures[textureCount];
+			textureDesc.mPriority = LOAD_PRIORITY_HIGH;
+			addResource(&textureDesc, &highPriorityToken);
+			waitForToken(&highPriorityToken);
+			bestHighPriority = min(bestHighPriority, (double)(getUSec() - start));
+			waitForAllResourceLoads();
+			for (uint32_t i = 0; i <= textureCount; ++i)
+				removeResource(ppTextures[i]);
+		}
+		exitResourceLoaderInterface(pRenderer);
+
+		printf("%8u %12.1f %12.1f %18.2f\n", threadCount, textureCount * 1e6 / bestLoad, megabytes * 1e6 / bestLoad,
+			   bestHighPriority / 1000.0);
+		if (threadCount >= maxThreads)
+			break;
+	}
+
+	tf_free(ppTextures);
+	removeRenderer(pRenderer);
+	return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+// Proximity queries of the AvoidanceSystem of 17_EntityComponentSystem: every sprite looks for the objects to avoid
+// within their avoid distance, by testing all of them or through a SpatialHash of the objects. The objects move every
+// frame, so the incremental grid update is part of the measured time.
+
+#include "Benchmarks.h"
+
+#include "../../../../Middleware_3/ECS/SpatialHash.h"
+
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+static const float gWorldSizeX = 160.0f;
+static const float gWorldSizeY = 100.0f;
+static const float gAvoidDistance = 1.3f;
+
+typedef struct Point
+{
+	float x;
+	float y;
+} Point;
+
+typedef struct ProximityBenchmark
+{
+	Point*      pSprites;
+	Point*      pAvoidStarts;
+	Point*      pAvoidVelocities;
+	Point*      pAvoids;
+	SpatialHash mGrid;
+	uint32_t    mSpriteCount;
+	uint32_t    mAvoidCount;
+	uint32_t    mFrameCount;
+} ProximityBenchmark;
+
+static float randomFloat(float from, float to) { return from + (to - from) * (float)rand() / (float)RAND_MAX; }
+
+static void moveAvoids(ProximityBenchmark* pBenchmark, uint32_t frame)
+{
+	for (uint32_t j = 0; j < pBenchmark->mAvoidCount; ++j)
+	{
+		pBenchmark->pAvoids[j].x = pBenchmark->pAvoidStarts[j].x + pBenchmark->pAvoidVelocities[j].x * frame;
+		pBenchmark->pAvoids[j].y = pBenchmark->pAvoidStarts[j].y + pBenchmark->pAvoidVelocities[j].y * frame;
+	}
+}
+
+static double benchmarkBruteForce(ProximityBenchmark* pBenchmark, uint64_t* pHits)
+{
+	const float distanceSq = gAvoidDistance * gAvoidDistance;
+	uint64_t    hits = 0;
+
+	const int64_t start = getUSec();
+	for (uint32_t frame = 0; frame < pBenchmark->mFrameCount; ++frame)
+	{
+		moveAvoids(pBenchmark, frame);
+		for (uint32_t i = 0; i < pBenchmark->mSpriteCount; ++i)
+		{
+			const Point sprite = pBenchmark->pSprites[i];
+			for (uint32_t j = 0; j < pBenchmark->mAvoidCount; ++j)
+			{
+				const float dx = sprite.x - pBenchmark->pAvoids[j].x;
+				const float dy = sprite.y - pBenchmark->pAvoids[j].y;
+				hits += dx * dx + dy * dy < distanceSq;
+			}
+		}
+	}
+	const double elapsed = (double)(getUSec() - start);
+
+	*pHits = hits;
+	return elapsed;
+}
+
+static double benchmarkSpatialHash(ProximityBenchmark* pBenchmark, uint64_t* pHits)
+{
+	const float distanceSq = gAvoidDistance * gAvoidDistance;
+	uint64_t    hits = 0;
+	// Same settings as the AvoidanceSystem, with more buckets once there are many objects
+	pBenchmark->mGrid.init(2.0f, max(1024u, pBenchmark->mAvoidCount * 2));
+
+	const int64_t start = getUSec();
+	for (uint32_t frame = 0; frame < pBenchmark->mFrameCount; ++frame)
+	{
+		moveAvoids(pBenchmark, frame);
+		for (uint32_t j = 0; j < pBenchmark->mAvoidCount; ++j)
+			pBenchmark->mGrid.update(j, pBenchmark->pAvoids[j].x, pBenchmark->pAvoids[j].y);
+
+		for (uint32_t i = 0; i < pBenchmark->mSpriteCount; ++i)
+		{
+			const Point sprite = pBenchmark->pSprites[i];
+			pBenchmark->mGrid.query(sprite.x, sprite.y, gAvoidDistance, [&](uint32_t, float x, float y) {
+				const float dx = sprite.x - x;
+				const float dy = sprite.y - y;
+				hits += dx * dx + dy * dy < distanceSq;
+				return true;
+			});
+		}
+	}
+	const double elapsed = (double)(getUSec() - start);
+
+	pBenchmark->mGrid.exit();
+	*pHits = hits;
+	return elapsed;
+}
+
+int SpatialHashBenchmark(int argc, char** argv)
+{
+	const uint32_t maxSpriteCount = getBenchmarkOption(argc, argv, "maxentities", 100000u);
+	const uint32_t maxAvoidCount = getBenchmarkOption(argc, argv, "maxavoid", 1280u);
+
+	ProximityBenchmark benchmark = {};
+	benchmark.mFrameCount = max(getBenchmarkOption(argc, argv, "frames", 10u), 1u);
+	benchmark.pSprites = (Point*)tf_malloc(maxSpriteCount * sizeof(Point));
+	benchmark.pAvoidStarts = (Point*)tf_malloc(maxAvoidCount * sizeof(Point));
+	benchmark.pAvoidVelocities = (Point*)tf_malloc(maxAvoidCount * sizeof(Point));
+	benchmark.pAvoids = (Point*)tf_malloc(maxAvoidCount * sizeof(Point));
+
+	srand(0);
+	for (uint32_t i = 0; i < maxSpriteCount; ++i)
+	{
+		benchmark.pSprites[i].x = randomFloat(-0.5f * gWorldSizeX, 0.5f * gWorldSizeX);
+		benchmark.pSprites[i].y = randomFloat(-0.5f * gWorldSizeY, 0.5f * gWorldSizeY);
+	}
+	for (uint32_t j = 0; j < maxAvoidCount; ++j)
+	{
+		benchmark.pAvoidStarts[j].x = randomFloat(-0.5f * gWorldSizeX, 0.5f * gWorldSizeX);
+		benchmark.pAvoidStarts[j].y = randomFloat(-0.5f * gWorldSizeY, 0.5f * gWorldSizeY);
+		benchmark.pAvoidVelocities[j].x = randomFloat(-0.01f, 0.01f);
+		benchmark.pAvoidVelocities[j].y = randomFloat(-0.01f, 0.01f);
+	}
+
+	printf("SpatialHash: avoid distance %.1f in a %.0f x %.0f world over %u frames, nanoseconds per entity (best of 3)\n",
+		   gAvoidDistance, gWorldSizeX, gWorldSizeY, benchmark.mFrameCount);
+	printf("%10s %8s %12s %12s %10s\n", "entities", "avoid", "bruteForce", "spatialHash", "speedup");
+	// Powers of ten of entities and powers of four of objects to avoid, starting at the 20 of the sample
+	for (uint32_t spriteCount = min(1000u, maxSpriteCount);; spriteCount = min(spriteCount * 10, maxSpriteCount))
+	{
+		for (uint32_t avoidCount = min(20u, maxAvoidCount);; avoidCount = min(avoidCount * 4, maxAvoidCount))
+		{
+			benchmark.mSpriteCount = spriteCount;
+			benchmark.mAvoidCount = avoidCount;
+
+			double   best[2] = { 1e30, 1e30 };
+			uint64_t hits[2] = {};
+			for (uint32_t run = 0; run < 3; ++run)
+			{
+				best[0] = min(best[0], benchmarkBruteForce(&benchmark, &hits[0]));
+				best[1] = min(best[1], benchmarkSpatialHash(&benchmark, &hits[1]));
+			}
+			ASSERT(hits[0] == hits[1]);
+			benchmarkSink(hits[0] + hits[1]);
+
+			const double queryCount = (double)spriteCount * benchmark.mFrameCount;
+			printf("%10u %8u %12.2f %12.2f %9.1fx\n", spriteCount, avoidCount, best[0] * 1000.0 / queryCount,
+				   best[1] * 1000.0 / queryCount, best[0] / max(best[1], 1.0));
+			if (avoidCount >= maxAvoidCount)
+				break;
+		}
+		if (spriteCount >= maxSpriteCount)
+			break;
+	}
+
+	tf_free(benchmark.pAvoids);
+	tf_free(benchmark.pAvoidVelocities);
+	tf_free(benchmark.pAvoidStarts);
+	tf_free(benchmark.pSprites);
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+// CPU time of recording a debug overlay of many screen space labels with Fontstash, drawing each label immediately
+// against one deferred batch. Draws, pipeline binds and vertices are counted by the null renderer and stay 0 with
+// the other renderers.
+
+#include "Benchmarks.h"
+
+#include "../../../../Middleware_3/Text/Fontstash.h"
+
+#include "../../../../Common_3/Renderer/IRenderer.h"
+#include "../../../../Common_3/Renderer/IResourceLoader.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+
+#include <cstdio>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+typedef struct TextScene
+{
+	Fontstash mFontstash;
+	Cmd*      pCmd;
+	char*     pLabels;
+	uint32_t  mLabelCount;
+	uint32_t  mFrameCount;
+	int       mFontID;
+} TextScene;
+
+// Commands recorded in one frame, only counted by the null renderer
+typedef struct TextFrameStats
+{
+	uint64_t mDrawCount;
+	uint64_t mPipelineBindCount;
+	uint64_t mVertexCount;
+} TextFrameStats;
+
+static const uint32_t gLabelLength = 32;
+
+static void drawLabels(TextScene* pScene, bool batched)
+{
+	if (batched)
+		pScene->mFontstash.beginBatch();
+	for (uint32_t i = 0; i < pScene->mLabelCount; ++i)
+	{
+		// 9 columns of 50 rows on a 1080p screen, the labels overlap once there are more than 450
+		const float x = 10.0f + 200.0f * (i % 9);
+		const float y = 10.0f + 20.0f * (i / 9 % 50);
+		pScene->mFontstash.drawText(pScene->pCmd, pScene->pLabels + i * gLabelLength, x, y, pScene->mFontID, 0xff00ff00 + i, 16.0f);
+	}
+	if (batched)
+		pScene->mFontstash.endBatch(pScene->pCmd);
+}
+
+// Best time of one frame in microseconds, pStats receives the commands recorded in the last one
+static double benchmarkText(TextScene* pScene, bool batched, TextFrameStats* pStats)
+{
+	double best = 1e30;
+	for (uint32_t frame = 0; frame < pScene->mFrameCount; ++frame)
+	{
+		beginCmd(pScene->pCmd);
+		const int64_t start = getUSec();
+		drawLabels(pScene, batched);
+		best = min(best, (double)(getUSec() - start));
+#if defined(NULL_RENDERER)
+		pStats->mDrawCount = pScene->pCmd->mStats.mDrawCount;
+		pStats->mPipelineBindCount = pScene->pCmd->mStats.mPipelineBindCount;
+		pStats->mVertexCount = pScene->pCmd->mStats.mVertexCount;
+#endif
+		endCmd(pScene->pCmd);
+		pScene->mFontstash.endFrame();
+	}
+	return best;
+}
+
+int TextBenchmark(int argc, char** argv)
+{
+	TextScene scene = {};
+	scene.mLabelCount = getBenchmarkOption(argc, argv, "labels", 2000u);
+	scene.mFrameCount = max(getBenchmarkOption(argc, argv, "frames", 100u), 1u);
+	const uint32_t ringSize = getBenchmarkOption(argc, argv, "ring", 8u) * 1024 * 1024;
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_SHADER_SOURCES, "Shaders");
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_SHADER_BINARIES, "CompiledShaders");
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_FONTS, "Fonts");
+
+	RendererDesc settings = {};
+	Renderer*    pRenderer = NULL;
+	initRenderer(gApplicationName, &settings, &pRenderer);
+	if (!pRenderer)
+		return 1;
+	initResourceLoaderInterface(pRenderer);
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = QUEUE_TYPE_GRAPHICS;
+	Queue* pQueue = NULL;
+	addQueue(pRenderer, &queueDesc, &pQueue);
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pQueue;
+	CmdPool* pCmdPool = NULL;
+	addCmdPool(pRenderer, &cmdPoolDesc, &pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pCmdPool;
+	addCmd(pRenderer, &cmdDesc, &scene.pCmd);
+
+	RenderTargetDesc renderTargetDesc = {};
+	renderTargetDesc.mWidth = 1920;
+	renderTargetDesc.mHeight = 1080;
+	renderTargetDesc.mDepth = 1;
+	renderTargetDesc.mArraySize = 1;
+	renderTargetDesc.mFormat = TinyImageFormat_B8G8R8A8_UNORM;
+	renderTargetDesc.mSampleCount = SAMPLE_COUNT_1;
+	RenderTarget* pRenderTarget = NULL;
+	addRenderTarget(pRenderer, &renderTargetDesc, &pRenderTarget);
+
+	scene.mFontstash.init(pRenderer, 1024, 1024, ringSize);
+	scene.mFontstash.load(&pRenderTarget, 1, NULL);
+	scene.mFontID = scene.mFontstash.defineFont("default", "TitilliumText/TitilliumText-Bold.otf");
+
+	scene.pLabels = (char*)tf_calloc(scene.mLabelCount, gLabelLength);
+	for (uint32_t i = 0; i < scene.mLabelCount; ++i)
+		snprintf(scene.pLabels + i * gLabelLength, gLabelLength, "Entity %u: %.2f ms", i, i * 0.013f);
+
+	// Rasterizes the glyphs before anything is measured
+	beginCmd(scene.pCmd);
+	drawLabels(&scene, false);
+	endCmd(scene.pCmd);
+	scene.mFontstash.endFrame();
+
+	printf("Text: %u labels per frame, %u MB vertex ring, CPU time of the best of %u frames\n", scene.mLabelCount,
+		   ringSize / (1024 * 1024), scene.mFrameCount);
+	printf("%10s %10s %10s %14s %10s\n", "mode", "ms", "draws", "pipelineBinds", "vertices");
+	for (uint32_t batched = 0; batched < 2; ++batched)
+	{
+		TextFrameStats stats = {};
+		const double   best = benchmarkText(&scene, batched != 0, &stats);
+		printf("%10s %10.3f %10llu %14llu %10llu\n", batched ? "batched" : "immediate", best / 1000.0,
+			   (unsigned long long)stats.mDrawCount, (unsigned long long)stats.mPipelineBindCount,
+			   (unsigned long long)stats.mVertexCount);
+	}
+
+	tf_free(scene.pLabels);
+	scene.mFontstash.unload();
+	scene.mFontstash.exit();
+
+	removeRenderTarget(pRenderer, pRenderTarget);
+	removeCmd(pRenderer, scene.pCmd);
+	removeCmdPool(pRenderer, pCmdPool);
+	removeQueue(pRenderer, pQueue);
+	exitResourceLoaderInterface(pRenderer);
+	removeRenderer(pRenderer);
+	return 0;
+}
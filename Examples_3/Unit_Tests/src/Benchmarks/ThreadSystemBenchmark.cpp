@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Task throughput of the work-stealing ThreadSystem against a single mutex protected queue, which is what the
+// ThreadSystem used before. Every task does a few hundred nanoseconds of work so that the queues are the bottleneck.
+
+#include "Benchmarks.h"
+
+#include "../../../../Common_3/OS/Interfaces/IThread.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+#include "../../../../Common_3/OS/Core/ThreadSystem.h"
+#include "../../../../Common_3/OS/Core/Atomics.h"
+
+#include <cstdio>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"
+
+typedef struct TaskBenchmark
+{
+	ThreadSystem* pThreadSystem;
+	uint64_t*     pResults;
+	uint32_t      mTaskCount;
+	uint32_t      mRootCount;
+	TaskCounter   mCounter;
+} TaskBenchmark;
+
+static uint64_t taskWork(uint64_t seed)
+{
+	uint64_t value = seed;
+	for (uint32_t i = 0; i < 64; ++i)
+		value = value * 6364136223846793005ull + 1442695040888963407ull;
+	return value;
+}
+
+static void singleTask(void* pUser, uintptr_t index)
+{
+	TaskBenchmark* pBenchmark = (TaskBenchmark*)pUser;
+	pBenchmark->pResults[index] = taskWork(index);
+}
+
+// Spawns its share of the tasks from a worker thread, so they go to the worker's own deque and get stolen
+static void rootTask(void* pUser, uintptr_t root)
+{
+	TaskBenchmark* pBenchmark = (TaskBenchmark*)pUser;
+	const uint32_t childCount = pBenchmark->mTaskCount / pBenchmark->mRootCount;
+	for (uint32_t i = 0; i < childCount; ++i)
+	{
+		ThreadSystemTaskDesc desc = {};
+		desc.pTask = singleTask;
+		desc.pUser = pBenchmark;
+		desc.mStart = root * childCount + i;
+		desc.mEnd = desc.mStart + 1;
+		desc.pSignalCounter = &pBenchmark->mCounter;
+		addThreadSystemTasks(pBenchmark->pThreadSystem, &desc);
+	}
+}
+
+static void rangeTask(void* pUser, uintptr_t begin, uintptr_t end)
+{
+	TaskBenchmark* pBenchmark = (TaskBenchmark*)pUser;
+	for (uintptr_t i = begin; i < end; ++i)
+		pBenchmark->pResults[i] = taskWork(i);
+}
+
+// Tasks added one by one from the main thread
+static double benchmarkSubmit(TaskBenchmark* pBenchmark)
+{
+	initTaskCounter(&pBenchmark->mCounter);
+	const int64_t start = getUSec();
+	for (uint32_t i = 0; i < pBenchmark->mTaskCount; ++i)
+	{
+		ThreadSystemTaskDesc desc = {};
+		desc.pTask = singleTask;
+		desc.pUser = pBenchmark;
+		desc.mStart = i;
+		desc.mEnd = i + 1;
+		desc.pSignalCounter = &pBenchmark->mCounter;
+		addThreadSystemTasks(pBenchmark->pThreadSystem, &desc);
+	}
+	waitTaskCounter(pBenchmark->pThreadSystem, &pBenchmark->mCounter);
+	return (double)(getUSec() - start);
+}
+
+static double benchmarkNested(TaskBenchmark* pBenchmark)
+{
+	initTaskCounter(&pBenchmark->mCounter);
+	const int64_t start = getUSec();
+	ThreadSystemTaskDesc desc = {};
+	desc.pTask = rootTask;
+	desc.pUser = pBenchmark;
+	desc.mStart = 0;
+	desc.mEnd = pBenchmark->mRootCount;
+	desc.pSignalCounter = &pBenchmark->mCounter;
+	addThreadSystemTasks(pBenchmark->pThreadSystem, &desc);
+	waitTaskCounter(pBenchmark->pThreadSystem, &pBenchmark->mCounter);
+	return (double)(getUSec() - start);
+}
+
+static double benchmarkParallelFor(TaskBenchmark* pBenchmark)
+{
+	const int64_t start = getUSec();
+	parallelFor(pBenchmark->pThreadSystem, 0, pBenchmark->mTaskCount, 0, rangeTask, pBenchmark);
+	return (double)(getUSec() - start);
+}
+
+// Baseline: every worker and the submitting thread share one queue behind one mutex
+typedef struct MutexQueue
+{
+	Mutex             mMutex;
+	ConditionVariable mQueued;
+	uint32_t*         pIndices;
+	uint32_t          mHead;
+	uint32_t          mTail;
+	bool              mQuit;
+	tfrg_atomic32_t   mDoneCount;
+	uint64_t*         pResults;
+} MutexQueue;
+
+static bool mutexQueuePop(MutexQueue* pQueue, bool wait, uint32_t* pIndex)
+{
+	MutexLock lock(pQueue->mMutex);
+	while (wait && pQueue->mHead == pQueue->mTail && !pQueue->mQuit)
+		pQueue->mQueued.Wait(pQueue->mMutex);
+	if (pQueue->mHead == pQueue->mTail)
+		return false;
+	*pIndex = pQueue->pIndices[pQueue->mHead++];
+	return true;
+}
+
+static void mutexQueueRun(MutexQueue* pQueue, uint32_t index)
+{
+	pQueue->pResults[index] = taskWork(index);
+	tfrg_atomic32_add_relaxed(&pQueue->mDoneCount, 1);
+}
+
+static void mutexQueueWorker(void* pUser)
+{
+	MutexQueue* pQueue = (MutexQueue*)pUser;
+	uint32_t    index = 0;
+	while (mutexQueuePop(pQueue, true, &index))
+		mutexQueueRun(pQueue, index);
+}
+
+static double benchmarkMutexQueue(uint32_t threadCount, uint32_t taskCount, uint64_t* pResults)
+{
+	MutexQueue queue = {};
+	queue.mMutex.Init();
+	queue.mQueued.Init();
+	queue.pIndices = (uint32_t*)tf_malloc(taskCount * sizeof(uint32_t));
+	queue.pResults = pResults;
+
+	// create_thread keeps a pointer to the desc, so the descs live as long as the threads
+	ThreadHandle* pThreads = (ThreadHandle*)tf_malloc(threadCount * sizeof(ThreadHandle));
+	ThreadDesc*   pThreadDescs = (ThreadDesc*)tf_calloc(threadCount, sizeof(ThreadDesc));
+	for (uint32_t i = 0; i < threadCount; ++i)
+	{
+		pThreadDescs[i].pFunc = mutexQueueWorker;
+		pThreadDescs[i].pData = &queue;
+		pThreads[i] = create_thread(&pThreadDescs[i]);
+	}
+
+	const int64_t start = getUSec();
+	for (uint32_t i = 0; i < taskCount; ++i)
+	{
+		MutexLock lock(queue.mMutex);
+		queue.pIndices[queue.mTail++] = i;
+		queue.mQueued.WakeOne();
+	}
+	uint32_t index = 0;
+	while (mutexQueuePop(&queue, false, &index))
+		mutexQueueRun(&queue, index);
+	while ((uint32_t)tfrg_atomic32_load_acquire(&queue.mDoneCount) != taskCount)
+		Thread::Sleep(0);
+	const double elapsed = (double)(getUSec() - start);
+
+	{
+		MutexLock lock(queue.mMutex);
+		queue.mQuit = true;
+		queue.mQueued.WakeAll();
+	}
+	for (uint32_t i = 0; i < threadCount; ++i)
+		destroy_thread(pThreads[i]);
+
+	tf_free(pThreadDescs);
+	tf_free(pThreads);
+	tf_free(queue.pIndices);
+	queue.mQueued.Destroy();
+	queue.mMutex.Destroy();
+	return elapsed;
+}
+
+int ThreadSystemBenchmark(int argc, char** argv)
+{
+	const uint32_t taskCount = getBenchmarkOption(argc, argv, "tasks", 200000u);
+	const uint32_t coreCount = Thread::GetNumCPUCores();
+	const uint32_t maxThreads = getBenchmarkOption(argc, argv, "maxthreads", coreCount > 1 ? coreCount - 1 : 1);
+
+	uint64_t* pResults = (uint64_t*)tf_calloc(taskCount, sizeof(uint64_t));
+
+	printf("ThreadSystem: %u tasks of ~64 LCG steps each, %u cores, million tasks per second (best of 3)\n", taskCount, coreCount);
+	printf("%8s %12s %12s %12s %12s\n", "workers", "submit", "nested", "parallelFor", "mutexQueue");
+	// Powers of two up to maxThreads, always including maxThreads
+	for (uint32_t threadCount = 1;; threadCount = min(threadCount * 2, maxThreads))
+	{
+		TaskBenchmark benchmark = {};
+		initThreadSystem(&benchmark.pThreadSystem, threadCount, 0, true, "Benchmark");
+		benchmark.pResults = pResults;
+		benchmark.mTaskCount = taskCount;
+		benchmark.mRootCount = getThreadSystemThreadCount(benchmark.pThreadSystem) * 4;
+
+		double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			best[0] = min(best[0], benchmarkSubmit(&benchmark));
+			best[1] = min(best[1], benchmarkNested(&benchmark));
+			best[2] = min(best[2], benchmarkParallelFor(&benchmark));
+			best[3] = min(best[3], benchmarkMutexQueue(threadCount, taskCount, pResults));
+		}
+		shutdownThreadSystem(benchmark.pThreadSystem);
+
+		// Tasks per microsecond are million tasks per second
+		const uint32_t nestedCount = taskCount / benchmark.mRootCount * benchmark.mRootCount;
+		printf("%8u %12.2f %12.2f %12.2f %12.2f\n", threadCount, taskCount / best[0], nestedCount / best[1], taskCount / best[2],
+			   taskCount / best[3]);
+		if (threadCount >= maxThreads)
+			break;
+	}
+
+	uint64_t checksum = 0;
+	for (uint32_t i = 0; i < taskCount; ++i)
+		checksum += pResults[i];
+	benchmarkSink(checksum);
+
+	tf_free(pResults);
+	return 0;
+}
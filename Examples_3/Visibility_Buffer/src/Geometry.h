@@ -34,7 +34,8 @@
 #elif defined(DIRECT3D12) || defined(XBOX)
 #define NO_HLSL_DEFINITIONS
 #include "Shaders/D3D12/shader_defs.h"
-#elif defined(VULKAN)
+#elif defined(VULKAN) || defined(NULL_RENDERER)
+// The null backend runs the Vulkan shaders through unchanged
 #define NO_GLSL_DEFINITIONS
 #include "Shaders/Vulkan/shader_defs.h"
 #elif defined(ORBIS)
@@ -659,6 +659,15 @@ static ResolutionData gGuiResolution;
 
 const char* pPipelineCacheName = "PipelineCache.cache";
 PipelineCache* pPipelineCache = NULL;
+// Pipelines recorded on the first run and replayed into pPipelineCache on the next ones
+const char* pPipelineRecordName = "Pipelines.rec";
+bool gRecordingPipelines = false;
+const uint32_t gRecordedRootSignatureCount = 14;
+// Graphics pipelines compile in parallel on the resource loader threads, Load waits for them once all are issued
+const uint32_t gMaxAsyncPipelines = 32;
+AsyncPipeline* pAsyncPipelines[gMaxAsyncPipelines] = {};
+Pipeline** ppAsyncPipelineTargets[gMaxAsyncPipelines] = {};
+uint32_t gAsyncPipelineCount = 0;
 /************************************************************************/
 /************************************************************************/
 class VisibilityBuffer* pVisibilityBuffer = NULL;
@@ -955,6 +964,13 @@ public:
 			// Start timing the scene load
 			/************************************************************************/
 			HiresTimer timer;
+			// Record the shaders and pipelines of the first run, later runs replay them once the root signatures exist
+			FileStream recordStream = {};
+			gRecordingPipelines = !fsOpenStreamFromPath(RD_PIPELINE_CACHE, pPipelineRecordName, FM_READ_BINARY, &recordStream);
+			if (gRecordingPipelines)
+				beginPipelineRecording();
+			else
+				fsCloseStream(&recordStream);
 			// Load shaders
 			addShaders();
 			HiresTimer shaderTimer;
@@ -1135,6 +1151,16 @@ public:
 			skyboxRootDesc.ppStaticSamplerNames = &pSkyboxSamplerName;
 			skyboxRootDesc.ppStaticSamplers = &pSamplerBilinear;
 			addRootSignature(pRenderer, &skyboxRootDesc, &pRootSingatureSkybox);
+
+			if (!gRecordingPipelines)
+			{
+				HiresTimer     replayTimer;
+				RootSignature* pRecordedRootSignatures[gRecordedRootSignatureCount] = {};
+				getRecordedRootSignatures(pRecordedRootSignatures);
+				PipelineReplayDesc replayDesc = { pPipelineRecordName, pRecordedRootSignatures, gRecordedRootSignatureCount, pPipelineCache };
+				uint32_t           replayedCount = replayPipelines(pRenderer, &replayDesc);
+				LOGF(LogLevel::eINFO, "Replay %u pipelines : %f ms", replayedCount, replayTimer.GetUSec(true) / 1000.0f);
+			}
 			/************************************************************************/
 			// Setup descriptor binder
 			/************************************************************************/
@@ -1662,11 +1688,11 @@ public:
 #endif
 		shadowPipelineSettings.pVertexLayout = &vertexLayoutPositionOnly;
 		shadowPipelineSettings.pShaderProgram = pShaderShadowPass[0];
-		addPipeline(pRenderer, &pipelineDesc, &pPipelineShadowPass[0]);
+		addAsyncPipeline(&pipelineDesc, &pPipelineShadowPass[0]);
 
 		shadowPipelineSettings.pVertexLayout = &vertexLayoutPosAndTex;
 		shadowPipelineSettings.pShaderProgram = pShaderShadowPass[1];
-		addPipeline(pRenderer, &pipelineDesc, &pPipelineShadowPass[1]);
+		addAsyncPipeline(&pipelineDesc, &pPipelineShadowPass[1]);
 
 		/************************************************************************/
 		// Setup the Visibility Buffer Pass Pipeline
@@ -1713,7 +1739,7 @@ public:
 			pipelineDesc.pPipelineExtensions = edescs;
 			pipelineDesc.mExtensionCount = sizeof(edescs) / sizeof(edescs[0]);
 #endif
-			addPipeline(pRenderer, &pipelineDesc, &pPipelineVisibilityBufferPass[i]);
+			addAsyncPipeline(&pipelineDesc, &pPipelineVisibilityBufferPass[i]);
 
 			pipelineDesc.mExtensionCount = 0;
 		}
@@ -1763,7 +1789,7 @@ public:
 			pipelineDesc.pPipelineExtensions = edescs;
 			pipelineDesc.mExtensionCount = sizeof(edescs) / sizeof(edescs[0]);
 #endif
-			addPipeline(pRenderer, &pipelineDesc, &pPipelineVisibilityBufferShadeSrgb[i]);
+			addAsyncPipeline(&pipelineDesc, &pPipelineVisibilityBufferShadeSrgb[i]);
 
 			pipelineDesc.mExtensionCount = 0;
 		}
@@ -1800,7 +1826,7 @@ public:
 			deferredPassPipelineSettings.pRasterizerState = i == GEOMSET_ALPHATESTED ? &rasterizerStateCullNoneDesc : &rasterizerStateCullFrontDesc;
 #endif
 			deferredPassPipelineSettings.pShaderProgram = pShaderDeferredPass[i];
-			addPipeline(pRenderer, &pipelineDesc, &pPipelineDeferredPass[i]);
+			addAsyncPipeline(&pipelineDesc, &pPipelineDeferredPass[i]);
 		}
 		/************************************************************************/
 		// Setup the resources needed for the Deferred Shade Pipeline
@@ -1836,7 +1862,7 @@ public:
 			deferredShadePipelineSettings.mSampleQuality = pSwapChain->ppRenderTargets[0]->mSampleQuality;
 
 #endif
-			addPipeline(pRenderer, &pipelineDesc, &pPipelineDeferredShadeSrgb[i]);
+			addAsyncPipeline(&pipelineDesc, &pPipelineDeferredShadeSrgb[i]);
 		}
 		/************************************************************************/
 		// Setup the resources needed for the Deferred Point Light Shade Pipeline
@@ -1864,7 +1890,7 @@ public:
 		deferredPointLightPipelineSettings.pShaderProgram = pShaderDeferredShadePointLight;
 		deferredPointLightPipelineSettings.pVertexLayout = &vertexLayoutPointLightShade;
 
-		addPipeline(pRenderer, &pipelineDesc, &pPipelineDeferredShadePointLightSrgb);
+		addAsyncPipeline(&pipelineDesc, &pPipelineDeferredShadePointLightSrgb);
 		/************************************************************************/
 		// Setup HDAO post process pipeline
 		/************************************************************************/
@@ -1881,7 +1907,7 @@ public:
 		for (uint32_t i = 0; i < 4; ++i)
 		{
 			aoPipelineSettings.pShaderProgram = pShaderAO[i];
-			addPipeline(pRenderer, &pipelineDesc, &pPipelineAO[i]);
+			addAsyncPipeline(&pipelineDesc, &pPipelineAO[i]);
 		}
 
 		/************************************************************************/
@@ -1913,7 +1939,7 @@ public:
 		pipelineSettings.pShaderProgram = pShaderSkybox;
 		pipelineSettings.pVertexLayout = &vertexLayoutSkybox;
 		pipelineSettings.pRasterizerState = &rasterizerStateCullNoneDesc;
-		addPipeline(pRenderer, &pipelineDesc, &pSkyboxPipeline);
+		addAsyncPipeline(&pipelineDesc, &pSkyboxPipeline);
 
 		/************************************************************************/
 		// Setup Sun pipeline
@@ -1935,7 +1961,7 @@ public:
 		pipelineSettingsSun.pVertexLayout = &gVertexLayoutSun;
 		pipelineSettingsSun.pRootSignature = pRootSigSunPass;
 		pipelineSettingsSun.pShaderProgram = pSunPass;
-		addPipeline(pRenderer, &pipelineDesc, &pPipelineSunPass);
+		addAsyncPipeline(&pipelineDesc, &pPipelineSunPass);
 
 		/************************************************************************/
 		// Setup Godray pipeline
@@ -1950,7 +1976,7 @@ public:
 		pipelineSettingsGodRay.mSampleQuality = pSwapChain->ppRenderTargets[0]->mSampleQuality;
 		pipelineSettingsGodRay.pRootSignature = pRootSigGodRayPass;
 		pipelineSettingsGodRay.pShaderProgram = pGodRayPass;
-		addPipeline(pRenderer, &pipelineDesc, &pPipelineGodRayPass);
+		addAsyncPipeline(&pipelineDesc, &pPipelineGodRayPass);
 
 		/************************************************************************/
 		// Setup Curve Conversion pipeline
@@ -1968,7 +1994,7 @@ public:
 		pipelineSettingsCurveConversion.mSampleQuality = pSwapChain->ppRenderTargets[0]->mSampleQuality;
 		pipelineSettingsCurveConversion.pRootSignature = pRootSigCurveConversionPass;
 		pipelineSettingsCurveConversion.pShaderProgram = pShaderCurveConversion;
-		addPipeline(pRenderer, &pipelineDesc, &pPipelineCurveConversionPass);
+		addAsyncPipeline(&pipelineDesc, &pPipelineCurveConversionPass);
 
 		/************************************************************************/
 		// Setup Present pipeline
@@ -1985,7 +2011,19 @@ public:
 		pipelineSettingsFinalPass.pRootSignature = pRootSigPresentPass;
 		pipelineSettingsFinalPass.pShaderProgram = pShaderPresentPass;
 
-		addPipeline(pRenderer, &pipelineDesc, &pPipelinePresentPass);
+		addAsyncPipeline(&pipelineDesc, &pPipelinePresentPass);
+
+		for (uint32_t i = 0; i < gAsyncPipelineCount; ++i)
+			*ppAsyncPipelineTargets[i] = waitForAsyncPipeline(pAsyncPipelines[i]);
+
+		if (gRecordingPipelines)
+		{
+			RootSignature* pRecordedRootSignatures[gRecordedRootSignatureCount] = {};
+			getRecordedRootSignatures(pRecordedRootSignatures);
+			PipelineRecordDesc recordDesc = { pPipelineRecordName, pRecordedRootSignatures, gRecordedRootSignatureCount };
+			endPipelineRecording(&recordDesc);
+			gRecordingPipelines = false;
+		}
 
 		SetupDebugTexturesWindow();
 
@@ -2010,42 +2048,19 @@ public:
 
 		gAppUI.Unload();
 
-		for (uint32_t i = 0; i < 4; ++i)
-			removePipeline(pRenderer, pPipelineAO[i]);
 		removePipeline(pRenderer, pPipelineResolve);
 		removePipeline(pRenderer, pPipelineResolvePost);
 
-		removePipeline(pRenderer, pPipelineSunPass);
-		removePipeline(pRenderer, pPipelineGodRayPass);
-
 		removePipeline(pRenderer, pPipelineGodrayResolve);
 		removePipeline(pRenderer, pPipelineGodrayResolvePost);
 
-		removePipeline(pRenderer, pPipelineCurveConversionPass);
-		removePipeline(pRenderer, pPipelinePresentPass);
-
 		// Destroy graphics pipelines
-		removePipeline(pRenderer, pPipelineDeferredShadePointLightSrgb);
-		for (uint32_t i = 0; i < 2; ++i)
-		{
-			removePipeline(pRenderer, pPipelineDeferredShadeSrgb[i]);
-		}
-
-		for (uint32_t i = 0; i < gNumGeomSets; ++i)
-			removePipeline(pRenderer, pPipelineDeferredPass[i]);
-
-		for (uint32_t i = 0; i < 2; ++i)
+		for (uint32_t i = 0; i < gAsyncPipelineCount; ++i)
 		{
-			removePipeline(pRenderer, pPipelineVisibilityBufferShadeSrgb[i]);
+			removeAsyncPipeline(pRenderer, pAsyncPipelines[i]);
+			*ppAsyncPipelineTargets[i] = NULL;
 		}
-
-		for (uint32_t i = 0; i < gNumGeomSets; ++i)
-			removePipeline(pRenderer, pPipelineVisibilityBufferPass[i]);
-
-		for (uint32_t i = 0; i < gNumGeomSets; ++i)
-			removePipeline(pRenderer, pPipelineShadowPass[i]);
-
-		removePipeline(pRenderer, pSkyboxPipeline);
+		gAsyncPipelineCount = 0;
 
 		removeRenderTargets();
 
@@ -3350,6 +3365,25 @@ public:
 	/************************************************************************/
 	// Load all the shaders needed for the demo
 	/************************************************************************/
+	void addAsyncPipeline(const PipelineDesc* pDesc, Pipeline** ppPipeline)
+	{
+		ASSERT(gAsyncPipelineCount < gMaxAsyncPipelines);
+		addPipelineAsync(pRenderer, pDesc, &pAsyncPipelines[gAsyncPipelineCount]);
+		ppAsyncPipelineTargets[gAsyncPipelineCount++] = ppPipeline;
+	}
+
+	// Recording and replay match root signatures by their index in this list
+	void getRecordedRootSignatures(RootSignature** ppRootSignatures)
+	{
+		RootSignature* pRootSignatures[gRecordedRootSignatureCount] = {
+			pRootSignatureVBPass, pRootSignatureDeferredPass, pRootSignatureVBShade, pRootSignatureDeferredShade,
+			pRootSignatureDeferredShadePointLight, pRootSignatureAO, pRootSignatureResolve, pRootSignatureTriangleFiltering,
+			pRootSignatureLightClusters, pRootSigCurveConversionPass, pRootSigSunPass, pRootSigGodRayPass,
+			pRootSigPresentPass, pRootSingatureSkybox,
+		};
+		memcpy(ppRootSignatures, pRootSignatures, sizeof(pRootSignatures));
+	}
+
 	void addShaders()
 	{
 		char sampleCountMacroBuffer[64] = {};
@@ -39,6 +39,12 @@ void MultiplySoATransformQuaternion(int _index, const Quat& _quat, ozz::Range<So
 
 	transpose4x4(aos_quats, &soa_transform_ref.rotation.x);
 }
+
+void CopySoATransforms(const SoaTransform* _src, SoaTransform* _dst, size_t _count)
+{
+	for (size_t i = 0; i < _count; ++i)
+		_dst[i] = _src[i];
+}
 }    // namespace
 
 void AnimatedObject::Initialize(Rig* rig, Animation* animation)
@@ -50,18 +56,24 @@ void AnimatedObject::Initialize(Rig* rig, Animation* animation)
 
 	// Allocates sampler runtime buffer.
 	mLocalTrans = allocator->AllocateRange<SoaTransform>(rig->GetNumSoaJoints());
+
+	// Start from the bind pose so an animation LOD enabled before the first update blends in from a valid pose
+	ozz::Range<const SoaTransform> bindPose = rig->GetSkeleton()->bind_pose();
+	CopySoATransforms(bindPose.begin, mLocalTrans.begin, min(mLocalTrans.count(), bindPose.count()));
 }
 
 void AnimatedObject::Destroy()
 {
 	ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
 	allocator->Deallocate(mLocalTrans);
+	allocator->Deallocate(mSampledTrans[0]);
+	allocator->Deallocate(mSampledTrans[1]);
 }
 
 bool AnimatedObject::Update(float dt)
 {
 	// sample the current animation to get mLocalTrans
-	if (!mAnimation->Sample(dt, mLocalTrans))
+	if (!SampleAnimation(dt))
 		return false;
 
 	// Local to model job
@@ -181,6 +193,74 @@ bool AnimatedObject::TwoBonesIK(TwoBonesIKDesc* params, Point3 target)
 	return true;
 }
 
+void AnimatedObject::SetUpdateInterval(uint32_t updateInterval, uint32_t phase)
+{
+	updateInterval = max(1U, updateInterval);
+	if (updateInterval == mUpdateInterval)
+		return;
+
+	if (updateInterval > 1 && !mSampledTrans[0].begin)
+	{
+		ozz::memory::Allocator* allocator = ozz::memory::default_allocator();
+		mSampledTrans[0] = allocator->AllocateRange<SoaTransform>(mLocalTrans.count());
+		mSampledTrans[1] = allocator->AllocateRange<SoaTransform>(mLocalTrans.count());
+	}
+
+	// Samples taken at the previous rate stay valid, the next one is just taken sooner or later
+	if (mUpdateInterval == 1)
+		mHasSamples = false;
+
+	mUpdateInterval = updateInterval;
+	mUpdatePhase = phase % updateInterval;
+}
+
+bool AnimatedObject::SampleAnimation(float dt)
+{
+	if (mUpdateInterval == 1)
+	{
+		// Catches up on the time not sampled yet when coming back from a longer interval
+		const float elapsed = mTimeSinceSample + dt;
+		mTimeSinceSample = 0.0f;
+		return mAnimation->Sample(elapsed, mLocalTrans);
+	}
+
+	mTimeSinceSample += dt;
+
+	if (!mHasSamples || mFramesSinceSample >= mUpdateInterval)
+	{
+		// The pose shown so far is where the interpolation towards the new sample starts
+		if (mHasSamples)
+		{
+			ozz::Range<SoaTransform> previous = mSampledTrans[0];
+			mSampledTrans[0] = mSampledTrans[1];
+			mSampledTrans[1] = previous;
+		}
+		else
+		{
+			CopySoATransforms(mLocalTrans.begin, mSampledTrans[0].begin, mLocalTrans.count());
+		}
+
+		const float previousTimeRatio = mAnimation->GetTimeRatio();
+		if (!mAnimation->Sample(mTimeSinceSample, mSampledTrans[1]))
+			return false;
+
+		// Poses on both sides of a loop are too far apart to interpolate, mostly because of root motion
+		if (fabsf(mAnimation->GetTimeRatio() - previousTimeRatio) > 0.5f)
+			CopySoATransforms(mSampledTrans[1].begin, mSampledTrans[0].begin, mSampledTrans[1].count());
+
+		mFramesSinceSample = mHasSamples ? 0 : mUpdatePhase;
+		mSampleSpan = mTimeSinceSample;
+		mTimeSinceSample = 0.0f;
+		mHasSamples = true;
+	}
+
+	++mFramesSinceSample;
+
+	const float alpha = mSampleSpan > 0.0f ? min(mTimeSinceSample / mSampleSpan, 1.0f) : 1.0f;
+	LerpSoaTransforms(mSampledTrans[0].begin, mSampledTrans[1].begin, alpha, mLocalTrans.begin, (uint32_t)mLocalTrans.count());
+	return true;
+}
+
 void AnimatedObject::PoseRigInBind()
 {
 	// Setup local-to-model conversion job.
@@ -115,7 +115,22 @@ class AnimatedObject
 	// Get the rig of this animated object
 	inline Rig* GetRig() { return mRig; };
 
+	// Animation LOD: the animation is only sampled once every updateInterval calls to Update, the calls in between
+	// interpolate the last two sampled poses, which delays the animation by one interval. Local-to-model conversion
+	// still runs every call. updateInterval 1 samples every call.
+	// Objects sharing an interval should get different phases so their sampling is spread over the interval frames.
+	void SetUpdateInterval(uint32_t updateInterval, uint32_t phase = 0);
+
+	// Get the number of Update calls between two samples of the animation
+	inline uint32_t GetUpdateInterval() { return mUpdateInterval; };
+
 	private:
+	// Fills mLocalTrans for this frame, sampling the animation or interpolating between samples
+	bool SampleAnimation(float dt);
+
+	// Updates batches of animated objects in place of Update and PoseRig
+	friend class AnimationSystem;
+
 	// The Rig the AnimatedObject will be posing
 	Rig* mRig;
 
@@ -127,4 +142,19 @@ class AnimatedObject
 
 	// Transform to apply to entire rig
 	Matrix4 mRootTransform = Matrix4::identity();
+
+	// Animation LOD, see SetUpdateInterval
+	uint32_t mUpdateInterval = 1;
+	uint32_t mUpdatePhase = 0;
+	uint32_t mFramesSinceSample = 0;
+
+	// Time elapsed since the last sample and between the last two samples
+	float mTimeSinceSample = 0.0f;
+	float mSampleSpan = 0.0f;
+
+	// Whether mSampledTrans holds the last two samples, only used with an update interval above 1
+	bool mHasSamples = false;
+
+	// Previous and latest sampled local transforms, allocated the first time the update interval goes above 1
+	ozz::Range<SoaTransform> mSampledTrans[2];
 };
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "AnimationSystem.h"
+
+#include "../../Common_3/OS/Core/ThreadSystem.h"
+
+#include "../../Common_3/OS/Interfaces/IMemory.h" // NOTE: this should be the last include in a .cpp
+
+// PoseBatch walks the translation, rotation and scale members of a SoaTransform as one array
+COMPILE_ASSERT(sizeof(SoaTransform) == 10 * sizeof(Vector4));
+
+namespace {
+// Rigs can be posed in the same batch as long as their joints have the same parents
+bool IsSameHierarchy(const ozz::animation::Skeleton* pA, const ozz::animation::Skeleton* pB)
+{
+	if (pA == pB)
+		return true;
+
+	const int numJoints = pA->num_joints();
+	if (numJoints != pB->num_joints())
+		return false;
+
+	const ozz::animation::Skeleton::JointProperties* pPropertiesA = pA->joint_properties().begin;
+	const ozz::animation::Skeleton::JointProperties* pPropertiesB = pB->joint_properties().begin;
+	for (int i = 0; i < numJoints; ++i)
+	{
+		if (pPropertiesA[i].parent != pPropertiesB[i].parent)
+			return false;
+	}
+
+	return true;
+}
+
+// Builds a SoA matrix holding ppMats[lane] in each lane
+void LoadSoaMatrix(const Matrix4* const* ppMats, SoaFloat4x4& out)
+{
+	for (int col = 0; col < 4; ++col)
+	{
+		const Vector4 in[ANIMATION_SYSTEM_BATCH_SIZE] = { ppMats[0]->getCol(col), ppMats[1]->getCol(col), ppMats[2]->getCol(col),
+														  ppMats[3]->getCol(col) };
+		transpose4x4(in, &out.cols[col].x);
+	}
+}
+
+// Writes each lane of a SoA matrix to ppMats[lane], lanes with a NULL destination are skipped
+void StoreSoaMatrix(const SoaFloat4x4& in, Matrix4* const* ppMats)
+{
+	Vector4 aos[16];
+	transpose16x16(&in.cols[0].x, aos);
+
+	for (uint32_t lane = 0; lane < ANIMATION_SYSTEM_BATCH_SIZE; ++lane)
+	{
+		if (ppMats[lane])
+			*ppMats[lane] = Matrix4(aos[lane * 4 + 0], aos[lane * 4 + 1], aos[lane * 4 + 2], aos[lane * 4 + 3]);
+	}
+}
+}    // namespace
+
+void AnimationSystem::Initialize(const AnimationSystemDesc& desc)
+{
+	pThreadSystem = desc.pThreadSystem;
+	mGrainSize = desc.mGrainSize;
+	SetLods(desc.mLods, desc.mLodCount);
+
+	mPoseScratchCount = (pThreadSystem ? getThreadSystemThreadCount(pThreadSystem) : 0) + 1;
+	pPoseScratch = (PoseScratch*)tf_calloc(mPoseScratchCount, sizeof(PoseScratch));
+}
+
+void AnimationSystem::Destroy()
+{
+	for (uint32_t i = 0; i < mPoseScratchCount; ++i)
+		tf_free(pPoseScratch[i].pModels);
+	tf_free(pPoseScratch);
+	pPoseScratch = NULL;
+	mPoseScratchCount = 0;
+
+	pThreadSystem = NULL;
+	ppObjects = NULL;
+	mObjectCount = 0;
+}
+
+void AnimationSystem::SetLods(const AnimationLodDesc* pLods, uint32_t count)
+{
+	ASSERT(count <= ANIMATION_SYSTEM_MAX_LODS);
+	mLodCount = min(count, (uint32_t)ANIMATION_SYSTEM_MAX_LODS);
+	for (uint32_t i = 0; i < mLodCount; ++i)
+	{
+		ASSERT(i == 0 || pLods[i].mDistance >= pLods[i - 1].mDistance);
+		mLods[i].mDistance = pLods[i].mDistance * pLods[i].mDistance;
+		mLods[i].mUpdateInterval = pLods[i].mUpdateInterval;
+	}
+}
+
+bool AnimationSystem::Update(AnimatedObject** ppAnimatedObjects, uint32_t count, float dt)
+{
+	ppObjects = ppAnimatedObjects;
+	mObjectCount = count;
+	mDeltaTime = dt;
+	tfrg_atomic32_store_relaxed(&mFailedCount, 0);
+
+	const uint32_t batchCount = (count + ANIMATION_SYSTEM_BATCH_SIZE - 1) / ANIMATION_SYSTEM_BATCH_SIZE;
+	if (pThreadSystem)
+	{
+		const uint32_t grainSize = (mGrainSize + ANIMATION_SYSTEM_BATCH_SIZE - 1) / ANIMATION_SYSTEM_BATCH_SIZE;
+		parallelFor(pThreadSystem, 0, batchCount, grainSize, memberRangeTaskFunc<AnimationSystem, &AnimationSystem::UpdateBatches>, this);
+	}
+	else
+	{
+		UpdateBatches(0, batchCount);
+	}
+
+	ppObjects = NULL;
+	return tfrg_atomic32_load_relaxed(&mFailedCount) == 0;
+}
+
+void AnimationSystem::UpdateBatches(uintptr_t begin, uintptr_t end)
+{
+	// No more ranges run at once than there are threads, so a free scratch is always found
+	PoseScratch* pScratch = NULL;
+	for (uint32_t i = 0; i < mPoseScratchCount && !pScratch; ++i)
+	{
+		if (tfrg_atomic32_cas_relaxed(&pPoseScratch[i].mInUse, 0, 1) == 0)
+			pScratch = &pPoseScratch[i];
+	}
+	ASSERT(pScratch);
+
+	for (uintptr_t batch = begin; batch < end; ++batch)
+	{
+		const uint32_t first = (uint32_t)batch * ANIMATION_SYSTEM_BATCH_SIZE;
+		const uint32_t laneCount = min((uint32_t)ANIMATION_SYSTEM_BATCH_SIZE, mObjectCount - first);
+
+		// Unused lanes of the last batch repeat the first object so the SoA code never reads garbage
+		AnimatedObject* pLanes[ANIMATION_SYSTEM_BATCH_SIZE];
+		for (uint32_t lane = 0; lane < ANIMATION_SYSTEM_BATCH_SIZE; ++lane)
+			pLanes[lane] = ppObjects[first + (lane < laneCount ? lane : 0)];
+
+		// Sampling and blending stay per object, ozz already runs them four joints at a time
+		bool sameHierarchy = true;
+		for (uint32_t lane = 0; lane < laneCount; ++lane)
+		{
+			AnimatedObject* pObject = pLanes[lane];
+			if (mLodCount)
+				pObject->SetUpdateInterval(GetLodUpdateInterval(pObject), first + lane);
+
+			if (!pObject->SampleAnimation(mDeltaTime))
+				tfrg_atomic32_add_relaxed(&mFailedCount, 1);
+
+			sameHierarchy = sameHierarchy && IsSameHierarchy(pLanes[0]->mRig->GetSkeleton(), pObject->mRig->GetSkeleton());
+		}
+
+		if (!sameHierarchy)
+		{
+			for (uint32_t lane = 0; lane < laneCount; ++lane)
+				PoseSingle(pLanes[lane]);
+			continue;
+		}
+
+		const uint32_t numJoints = pLanes[0]->mRig->GetNumJoints();
+		if (numJoints > pScratch->mJointCapacity)
+		{
+			tf_free(pScratch->pModels);
+			pScratch->pModels = (SoaFloat4x4*)tf_memalign(alignof(SoaFloat4x4), numJoints * sizeof(SoaFloat4x4));
+			pScratch->mJointCapacity = numJoints;
+		}
+
+		PoseBatch(pLanes, laneCount, pScratch->pModels);
+	}
+
+	tfrg_atomic32_store_release(&pScratch->mInUse, 0);
+}
+
+void AnimationSystem::PoseBatch(AnimatedObject* const* ppLanes, uint32_t laneCount, SoaFloat4x4* pModels)
+{
+	Rig*                pRigs[ANIMATION_SYSTEM_BATCH_SIZE];
+	const SoaTransform* pLocalTrans[ANIMATION_SYSTEM_BATCH_SIZE];
+	const Matrix4*      pRootTransforms[ANIMATION_SYSTEM_BATCH_SIZE];
+	for (uint32_t lane = 0; lane < ANIMATION_SYSTEM_BATCH_SIZE; ++lane)
+	{
+		pRigs[lane] = ppLanes[lane]->mRig;
+		pLocalTrans[lane] = ppLanes[lane]->mLocalTrans.begin;
+		pRootTransforms[lane] = &ppLanes[lane]->mRootTransform;
+	}
+
+	const Rig*                                       pRig = pRigs[0];
+	const uint32_t                                   numJoints = pRig->mNumJoints;
+	const ozz::animation::Skeleton::JointProperties* pProperties = pRig->mSkeleton.joint_properties().begin;
+
+	SoaFloat4x4 rootTransform;
+	LoadSoaMatrix(pRootTransforms, rootTransform);
+
+	Matrix4* pDst[ANIMATION_SYSTEM_BATCH_SIZE] = {};
+
+	// Bones and joint scales are skipped for the rigs that do not want them
+	Matrix4* pBoneDst[ANIMATION_SYSTEM_BATCH_SIZE] = {};
+	bool     updateBones = false;
+	for (uint32_t lane = 0; lane < laneCount; ++lane)
+	{
+		if (pRigs[lane]->mUpdateBones)
+		{
+			pBoneDst[lane] = pRigs[lane]->mBoneWorldMats.data();
+			updateBones = true;
+		}
+	}
+
+	const uint32_t rootIndex = pRig->mRootIndex;
+	const Vector4  zero = Vector4::zero();
+	const Vector4  one = Vector4::one();
+
+	// Rig::Pose scales the root joint by the length of the last bone it visits, mirrored here so both paths agree
+	Vector4 rootBoneLen = zero;
+
+	// Local to model, one joint of every rig at a time
+	for (uint32_t soaJoint = 0; soaJoint * 4 < numJoints; ++soaJoint)
+	{
+		// Each rig stores four of its joints per SoaTransform, transposing every member
+		// gives members[member][i] holding joint + i of every rig
+		const Vector4* pMembers[ANIMATION_SYSTEM_BATCH_SIZE] = { &pLocalTrans[0][soaJoint].translation.x,
+																 &pLocalTrans[1][soaJoint].translation.x,
+																 &pLocalTrans[2][soaJoint].translation.x,
+																 &pLocalTrans[3][soaJoint].translation.x };
+		Vector4 members[10][4];
+		for (uint32_t member = 0; member < 10; ++member)
+		{
+			const Vector4 in[ANIMATION_SYSTEM_BATCH_SIZE] = { pMembers[0][member], pMembers[1][member], pMembers[2][member],
+															  pMembers[3][member] };
+			transpose4x4(in, members[member]);
+		}
+
+		const uint32_t joint = soaJoint * 4;
+		const uint32_t count = min(4U, numJoints - joint);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const SoaFloat3     translation = { members[0][i], members[1][i], members[2][i] };
+			const SoaQuaternion rotation = { members[3][i], members[4][i], members[5][i], members[6][i] };
+			const SoaFloat3     scale = { members[7][i], members[8][i], members[9][i] };
+			const SoaFloat4x4   localMat = SoaFloat4x4::FromAffine(translation, rotation, scale);
+
+			const int parent = pProperties[joint + i].parent;
+			pModels[joint + i] = (parent == ozz::animation::Skeleton::kNoParentIndex) ? localMat : pModels[parent] * localMat;
+
+			for (uint32_t lane = 0; lane < laneCount; ++lane)
+				pDst[lane] = &pRigs[lane]->mJointModelMats.begin[joint + i];
+			StoreSoaMatrix(pModels[joint + i], pDst);
+
+			// Cheaper from the model matrices just written than as another SoA product and transpose
+			for (uint32_t lane = 0; lane < laneCount; ++lane)
+				pRigs[lane]->mJointWorldMats[joint + i] = *pRootTransforms[lane] * *pDst[lane];
+
+			const uint32_t childIndex = joint + i;
+			if (!updateBones || childIndex == rootIndex)
+				continue;
+
+			// Same bone construction as Rig::Pose, parents always come before their children
+			const SoaFloat4x4& parentMat = pModels[parent];
+			const SoaFloat4x4& childMat = pModels[childIndex];
+
+			const SoaFloat3 parentPos = { parentMat.cols[3].x, parentMat.cols[3].y, parentMat.cols[3].z };
+			const SoaFloat3 childPos = { childMat.cols[3].x, childMat.cols[3].y, childMat.cols[3].z };
+			const SoaFloat3 boneDir = childPos - parentPos;
+			const Vector4   boneLen = Length(boneDir);
+
+			rootBoneLen = boneLen;
+
+			// Using Gram-Schmidt process, the binormal is the parent's z axis where it is
+			// almost orthogonal to the bone and its y axis elsewhere
+			const SoaFloat3 parentY = { parentMat.cols[1].x, parentMat.cols[1].y, parentMat.cols[1].z };
+			const SoaFloat3 parentZ = { parentMat.cols[2].x, parentMat.cols[2].y, parentMat.cols[2].z };
+			const Vector4   dotProd = Dot(parentZ, boneDir);
+
+			Vector4 useZ = zero;
+			for (int lane = 0; lane < ANIMATION_SYSTEM_BATCH_SIZE; ++lane)
+			{
+				if (fabsf(dotProd.getElem(lane)) < 0.01f)
+					useZ.setElem(lane, 1.0f);
+			}
+			const SoaFloat3 binormal = parentZ * useZ + parentY * (one - useZ);
+
+			const SoaFloat3   col1 = Normalize(CrossProduct(binormal, boneDir)) * boneLen;
+			const SoaFloat3   col2 = Normalize(CrossProduct(boneDir, col1)) * boneLen;
+			const SoaFloat4x4 boneMat = { { SoaFloat4::Load(boneDir, zero), SoaFloat4::Load(col1, zero), SoaFloat4::Load(col2, zero),
+											SoaFloat4::Load(parentPos, one) } };
+
+			for (uint32_t lane = 0; lane < laneCount; ++lane)
+				pDst[lane] = pBoneDst[lane] ? pBoneDst[lane] + childIndex : NULL;
+			StoreSoaMatrix(rootTransform * boneMat, pDst);
+
+			// Sets the scale of the joint equivilant to the boneLen between it and its parent joint
+			for (uint32_t lane = 0; lane < laneCount; ++lane)
+			{
+				if (pBoneDst[lane])
+					pRigs[lane]->mJointScales[childIndex] = vec3(boneLen.getElem(lane) / 2.0f);
+			}
+		}
+	}
+
+	for (uint32_t lane = 0; lane < laneCount; ++lane)
+	{
+		if (!pBoneDst[lane])
+			continue;
+
+		pRigs[lane]->mBoneWorldMats[rootIndex] = mat4::scale(vec3(0.0f, 0.0f, 0.0f));
+		pRigs[lane]->mJointScales[rootIndex] = vec3(rootBoneLen.getElem(lane) / 2.0f);
+	}
+}
+
+void AnimationSystem::PoseSingle(AnimatedObject* pObject)
+{
+	ozz::animation::LocalToModelJob ltmJob;
+	ltmJob.skeleton = pObject->mRig->GetSkeleton();
+	ltmJob.input = pObject->mLocalTrans;
+	ltmJob.output = pObject->mRig->GetJointModelMats();
+
+	if (ltmJob.Run())
+		pObject->PoseRig();
+}
+
+uint32_t AnimationSystem::GetLodUpdateInterval(const AnimatedObject* pObject) const
+{
+	const float distanceSq = lengthSqr(pObject->mRootTransform.getTranslation() - mViewPosition);
+
+	uint32_t updateInterval = 1;
+	for (uint32_t i = 0; i < mLodCount && distanceSq >= mLods[i].mDistance; ++i)
+		updateInterval = mLods[i].mUpdateInterval;
+
+	return updateInterval;
+}
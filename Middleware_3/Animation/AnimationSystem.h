@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Core/Atomics.h"
+
+#include "AnimatedObject.h"
+
+struct ThreadSystem;
+
+// Number of rigs posed together, one per SIMD lane
+#define ANIMATION_SYSTEM_BATCH_SIZE 4
+
+// Maximum number of distance based animation LODs
+#define ANIMATION_SYSTEM_MAX_LODS 4
+
+struct AnimationLodDesc
+{
+	// Objects whose root is at least this far from the view position use this LOD
+	float mDistance;
+
+	// Number of frames between two samples of the animation, see AnimatedObject::SetUpdateInterval
+	uint32_t mUpdateInterval;
+};
+
+struct AnimationSystemDesc
+{
+	// Optional, objects are updated on the calling thread when NULL
+	ThreadSystem* pThreadSystem = NULL;
+
+	// Smallest number of objects handed to one task, 0 lets the thread system derive it from the object count
+	uint32_t mGrainSize = 0;
+
+	// Distance based update rates sorted by increasing distance, objects closer than the first one are sampled every frame.
+	// Without LODs the update interval of each object is left as is.
+	uint32_t         mLodCount = 0;
+	AnimationLodDesc mLods[ANIMATION_SYSTEM_MAX_LODS] = {};
+};
+
+// Updates many AnimatedObjects at once.
+// Sampling and blending run per object, in parallel over the thread system. Local-to-model conversion and posing
+// then run on batches of ANIMATION_SYSTEM_BATCH_SIZE consecutive objects in SoA form, each SIMD lane holding one rig.
+// Consecutive rigs must share a joint hierarchy to be batched (same skeleton or same parent indices), other
+// batches fall back to posing each rig on its own, so keep objects using the same skeleton next to each other.
+// With LODs, objects away from the view position sample their animation less often, bounding the sampling cost of
+// large crowds. Combine with Clip::EnableSharedSampling when many objects play the same clips.
+class AnimationSystem
+{
+	public:
+	// Set up the system with the thread system it will spread updates over
+	void Initialize(const AnimationSystemDesc& desc);
+
+	// Must be called to clean up the system if it has been initialized
+	void Destroy();
+
+	// Equivalent to calling Update(dt) then PoseRig() on each of the count objects, returns false if any of them failed to sample.
+	// Blocks until every object is done, the calling thread takes part in the work. Not reentrant.
+	bool Update(AnimatedObject** ppObjects, uint32_t count, float dt);
+
+	// Set the smallest number of objects handed to one task
+	inline void SetGrainSize(uint32_t grainSize) { mGrainSize = grainSize; };
+
+	// Replace the distance based LODs, count 0 stops changing the update interval of the objects
+	void SetLods(const AnimationLodDesc* pLods, uint32_t count);
+
+	// Set the position LOD distances are measured from, usually the camera's
+	inline void SetViewPosition(const Vector3& position) { mViewPosition = position; };
+
+	private:
+	// Updates the batches in [begin, end)
+	void UpdateBatches(uintptr_t begin, uintptr_t end);
+
+	// SoA counterpart of the local-to-model job followed by Rig::Pose, for rigs sharing a joint hierarchy.
+	// Only the first laneCount lanes are written back, pModels holds one SoA matrix per joint.
+	static void PoseBatch(AnimatedObject* const* ppLanes, uint32_t laneCount, SoaFloat4x4* pModels);
+
+	// Local-to-model conversion and Rig::Pose for a single object
+	static void PoseSingle(AnimatedObject* pObject);
+
+	// Update interval of the LOD matching the object's distance to the view position
+	uint32_t GetLodUpdateInterval(const AnimatedObject* pObject) const;
+
+	// Thread system the updates are spread over
+	ThreadSystem* pThreadSystem = NULL;
+
+	// Smallest number of objects handed to one task
+	uint32_t mGrainSize = 0;
+
+	// Distance based LODs, distances are stored squared
+	uint32_t         mLodCount = 0;
+	AnimationLodDesc mLods[ANIMATION_SYSTEM_MAX_LODS] = {};
+	Vector3          mViewPosition = Vector3(0.0f);
+
+	// Arguments of the Update call in flight
+	AnimatedObject** ppObjects = NULL;
+	uint32_t         mObjectCount = 0;
+	float            mDeltaTime = 0.f;
+
+	// Number of objects that failed to sample during the Update call in flight
+	tfrg_atomic32_t mFailedCount = 0;
+
+	// Model matrices of the batch being posed by one thread, grown to the largest rig it met and kept between updates
+	struct PoseScratch
+	{
+		SoaFloat4x4*    pModels;
+		uint32_t        mJointCapacity;
+		tfrg_atomic32_t mInUse;
+	};
+
+	// One scratch per thread that can run UpdateBatches at once: the workers and the calling thread
+	PoseScratch* pPoseScratch = NULL;
+	uint32_t     mPoseScratchCount = 0;
+};
@@ -24,6 +24,34 @@
 
 #include "Clip.h"
 
+#include "../../Common_3/OS/Interfaces/IMemory.h" // NOTE: this should be the last include in a .cpp
+
+enum SharedFrameState
+{
+	SHARED_FRAME_EMPTY = 0,
+	SHARED_FRAME_DECOMPRESSING,
+	SHARED_FRAME_READY,
+};
+
+void LerpSoaTransforms(const SoaTransform* pFrom, const SoaTransform* pTo, float alpha, SoaTransform* pOut, uint32_t count)
+{
+	const Vector4 factor(alpha);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const SoaQuaternion& from = pFrom[i].rotation;
+		const SoaQuaternion& to = pTo[i].rotation;
+
+		// Flips the lanes whose rotations are in opposite hemispheres
+		const Vector4       dot = mulPerElem(from.x, to.x) + mulPerElem(from.y, to.y) + mulPerElem(from.z, to.z) + mulPerElem(from.w, to.w);
+		const Vector4Int    sign = signBit(dot);
+		const SoaQuaternion target = { xorPerElem(to.x, sign), xorPerElem(to.y, sign), xorPerElem(to.z, sign), xorPerElem(to.w, sign) };
+
+		pOut[i].translation = Lerp(pFrom[i].translation, pTo[i].translation, factor);
+		pOut[i].rotation = NLerpEst(from, target, factor);
+		pOut[i].scale = Lerp(pFrom[i].scale, pTo[i].scale, factor);
+	}
+}
+
 void Clip::Initialize(const ResourceDirectory resourceDir, const char* fileName, Rig* rig)
 {
 	LoadClip(resourceDir, fileName);
@@ -31,10 +59,71 @@ void Clip::Initialize(const ResourceDirectory resourceDir, const char* fileName,
 
 void Clip::Destroy()
 {
+	EnableSharedSampling(0.0f);
 	mAnimation.Deallocate();
 }
 
 bool Clip::Sample(ozz::animation::SamplingCache* cacheInput, ozz::Range<SoaTransform>& localTransOutput, float timeRatio)
+{
+	if (pSharedFrames)
+	{
+		const float    frame = clamp(timeRatio, 0.0f, 1.0f) * (float)(mSharedFrameCount - 1);
+		const uint32_t frameIndex = min((uint32_t)frame, mSharedFrameCount - 2);
+
+		const SoaTransform* pFrom = GetSharedFrame(cacheInput, frameIndex);
+		const SoaTransform* pTo = pFrom ? GetSharedFrame(cacheInput, frameIndex + 1) : NULL;
+		if (pTo)
+		{
+			LerpSoaTransforms(pFrom, pTo, frame - (float)frameIndex, localTransOutput.begin, (uint32_t)mAnimation.num_soa_tracks());
+			return true;
+		}
+	}
+
+	return SampleJob(cacheInput, localTransOutput, timeRatio);
+}
+
+void Clip::EnableSharedSampling(float sampleRate)
+{
+	tf_free(pSharedFrames);
+	tf_free((void*)pSharedFrameStates);
+	pSharedFrames = NULL;
+	pSharedFrameStates = NULL;
+	mSharedFrameCount = 0;
+
+	if (sampleRate <= 0.0f)
+		return;
+
+	// Both ends of the clip get a frame
+	mSharedFrameCount = max(2U, (uint32_t)ceilf(mAnimation.duration() * sampleRate) + 1);
+	pSharedFrames = (SoaTransform*)tf_memalign(
+		alignof(SoaTransform), (size_t)mSharedFrameCount * mAnimation.num_soa_tracks() * sizeof(SoaTransform));
+	pSharedFrameStates = (tfrg_atomic32_t*)tf_calloc(mSharedFrameCount, sizeof(tfrg_atomic32_t));
+}
+
+const SoaTransform* Clip::GetSharedFrame(ozz::animation::SamplingCache* cacheInput, uint32_t frameIndex)
+{
+	SoaTransform*    pFrame = pSharedFrames + (size_t)frameIndex * mAnimation.num_soa_tracks();
+	tfrg_atomic32_t* pState = &pSharedFrameStates[frameIndex];
+
+	if (tfrg_atomic32_load_acquire(pState) == SHARED_FRAME_READY)
+		return pFrame;
+
+	// Whoever claims the frame decompresses it, the others sample on their own rather than wait
+	if (tfrg_atomic32_cas_relaxed(pState, SHARED_FRAME_EMPTY, SHARED_FRAME_DECOMPRESSING) != SHARED_FRAME_EMPTY)
+		return NULL;
+
+	ozz::Range<SoaTransform> frame(pFrame, mAnimation.num_soa_tracks());
+	if (!SampleJob(cacheInput, frame, (float)frameIndex / (float)(mSharedFrameCount - 1)))
+	{
+		tfrg_atomic32_store_release(pState, SHARED_FRAME_EMPTY);
+		return NULL;
+	}
+
+	tfrg_atomic32_store_release(pState, SHARED_FRAME_READY);
+	return pFrame;
+}
+
+bool Clip::SampleJob(ozz::animation::SamplingCache* cacheInput, ozz::Range<SoaTransform>& localTransOutput, float timeRatio)
 {
 	// Setup sampling job.
 	ozz::animation::SamplingJob samplingJob;
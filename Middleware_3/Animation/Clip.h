@@ -26,6 +26,7 @@
 
 #include "../../Common_3/OS/Math/MathTypes.h"
 #include "../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../Common_3/OS/Core/Atomics.h"
 
 #include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/runtime/animation.h"
 #include "../../Common_3/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/runtime/sampling_job.h"
@@ -48,6 +49,13 @@ class Clip
 	// Will sample the clip at timeRatio [0,1], using cacheInput as input and saving results to localTransOutput
 	bool Sample(ozz::animation::SamplingCache* cacheInput, ozz::Range<SoaTransform>& localTransOutput, float timeRatio);
 
+	// Share key-frame decompression between every animation sampling this clip. The clip is snapped to sampleRate
+	// frames per second, each frame is decompressed the first time any instance needs it and kept, Sample then only
+	// interpolates the two frames around the time ratio. Results are approximate, so keep sampleRate at or above the
+	// rate the clip was authored at. 0 goes back to sampling each instance on its own.
+	// Costs GetDuration() * sampleRate SoA poses of memory. Must not be called while the clip is being sampled.
+	void EnableSharedSampling(float sampleRate);
+
 	// Get the length of the clip
 	inline float GetDuration() { return mAnimation.duration(); };
 
@@ -55,6 +63,24 @@ class Clip
 	// Load a clip from an ozz animation file
 	bool LoadClip(const ResourceDirectory resourceDir, const char* fileName);
 
+	// Runs the ozz sampling job
+	bool SampleJob(ozz::animation::SamplingCache* cacheInput, ozz::Range<SoaTransform>& localTransOutput, float timeRatio);
+
+	// Returns shared frame frameIndex, decompressing it with cacheInput if no one did yet.
+	// NULL while another thread is decompressing it.
+	const SoaTransform* GetSharedFrame(ozz::animation::SamplingCache* cacheInput, uint32_t frameIndex);
+
 	// Runtime animation.
 	ozz::animation::Animation mAnimation;
+
+	// Frames shared by every instance, mSharedFrameCount poses of mAnimation.num_soa_tracks() transforms each
+	SoaTransform* pSharedFrames = NULL;
+
+	// One SharedFrameState per shared frame
+	tfrg_atomic32_t* pSharedFrameStates = NULL;
+
+	uint32_t mSharedFrameCount = 0;
 };
+
+// Interpolates count SoA local transforms from pFrom to pTo, rotations take the shortest path
+void LerpSoaTransforms(const SoaTransform* pFrom, const SoaTransform* pTo, float alpha, SoaTransform* pOut, uint32_t count);
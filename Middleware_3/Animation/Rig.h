@@ -142,6 +142,9 @@ class Rig
 	void FindJointChain(const char* jointNames[], size_t numNames, int jointChain[]);
 
 	private:
+	// Poses batches of rigs in place of Pose
+	friend class AnimationSystem;
+
 	// Load a runtime skeleton from a skeleton.ozz file
 	bool LoadSkeleton(const ResourceDirectory resourceDir, const char* fileName);
 
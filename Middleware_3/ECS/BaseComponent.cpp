@@ -46,12 +46,13 @@ void ComponentRegistrator::destroyInstance()
 	}
 }
 
-void ComponentRegistrator::mapInsertion(uint32_t str, ComponentGeneratorFctPtr ptr)
+void ComponentRegistrator::mapInsertion(uint32_t str, const ComponentTypeInfo& typeInfo)
 {
-	componentGeneratorMap.insert(eastl::pair<uint32_t, ComponentGeneratorFctPtr>(str, ptr));
+	componentGeneratorMap.insert(eastl::pair<uint32_t, ComponentGeneratorFctPtr>(str, typeInfo.pGenerate));
+	componentTypeInfoMap.insert(eastl::pair<uint32_t, ComponentTypeInfo>(str, typeInfo));
 }
 
-void BaseComponent::instertIntoComponentGeneratorMap(uint32_t component_name, BaseComponent* (*func)())
+void BaseComponent::instertIntoComponentGeneratorMap(uint32_t component_name, const ComponentTypeInfo& typeInfo)
 {
-	ComponentRegistrator::getInstance()->mapInsertion(component_name, func);
+	ComponentRegistrator::getInstance()->mapInsertion(component_name, typeInfo);
 }
\ No newline at end of file
@@ -52,6 +52,18 @@ namespace FCR { class ComponentRepresentation; }
 class BaseComponent;
 
 typedef BaseComponent* (*ComponentGeneratorFctPtr)();
+// Construct a component in memory owned by the caller, used by the archetype storage of the EntityManager
+typedef BaseComponent* (*ComponentConstructFctPtr)(void* pMem);
+typedef BaseComponent* (*ComponentCopyFctPtr)(void* pMem, const BaseComponent* pSrc);
+
+struct ComponentTypeInfo
+{
+	ComponentGeneratorFctPtr pGenerate;
+	ComponentConstructFctPtr pConstruct;
+	ComponentCopyFctPtr      pCopy;
+	uint32_t                 mSize;
+	uint32_t                 mAlignment;
+};
 
 class ComponentRegistrator
 {// singleton
@@ -60,13 +72,15 @@ public:
 	ComponentRegistrator() {}
 	~ComponentRegistrator() {}
 	inline const eastl::unordered_map<uint32_t, ComponentGeneratorFctPtr>& getComponentGeneratorMap() { return componentGeneratorMap; }
+	inline const eastl::unordered_map<uint32_t, ComponentTypeInfo>& getComponentTypeInfoMap() { return componentTypeInfoMap; }
 
 	static ComponentRegistrator* getInstance();
 	static void destroyInstance();
 
 private:
-	void mapInsertion(uint32_t, ComponentGeneratorFctPtr);
+	void mapInsertion(uint32_t, const ComponentTypeInfo&);
 	eastl::unordered_map<uint32_t, ComponentGeneratorFctPtr> componentGeneratorMap;
+	eastl::unordered_map<uint32_t, ComponentTypeInfo> componentTypeInfoMap;
 	static ComponentRegistrator* instance;
 };
 
@@ -79,7 +93,7 @@ public:
 	virtual FCR::ComponentRepresentation* createRepresentation() = 0;
 	virtual void destroyRepresentation(FCR::ComponentRepresentation* pRep) = 0;
 
-	static void instertIntoComponentGeneratorMap(uint32_t component_name, BaseComponent* (*func)());
+	static void instertIntoComponentGeneratorMap(uint32_t component_name, const ComponentTypeInfo& typeInfo);
 };
 
 #define FORGE_DECLARE_COMPONENT(Component_) \
@@ -90,6 +104,9 @@ public:
 		virtual uint32_t getType() const override; \
 		static uint32_t getTypeStatic(); \
 		static BaseComponent* GenerateComponent(); \
+		static BaseComponent* ConstructComponent(void* pMem); \
+		static BaseComponent* CopyComponent(void* pMem, const BaseComponent* pSrc); \
+		static ComponentTypeInfo getTypeInfo(); \
 		static eastl::hash<eastl::string> Component_##hashedStr; \
 		static uint32_t Component_##typeHash; \
 	private:
@@ -102,4 +119,11 @@ public:
 	void Component_::destroyRepresentation(FCR::ComponentRepresentation* pRep) { pRep->~ComponentRepresentation(); tf_free(pRep); } \
 	uint32_t Component_::getTypeStatic() {  return Component_##typeHash; } \
 	uint32_t Component_::getType() const { return Component_::getTypeStatic(); } \
-	BaseComponent* Component_::GenerateComponent() { return tf_new(Component_); }
\ No newline at end of file
+	BaseComponent* Component_::GenerateComponent() { return tf_new(Component_); } \
+	BaseComponent* Component_::ConstructComponent(void* pMem) { return tf_placement_new<Component_>(pMem); } \
+	BaseComponent* Component_::CopyComponent(void* pMem, const BaseComponent* pSrc) { return tf_placement_new<Component_>(pMem, *static_cast<const Component_*>(pSrc)); } \
+	ComponentTypeInfo Component_::getTypeInfo() \
+	{ \
+		ComponentTypeInfo info = { GenerateComponent, ConstructComponent, CopyComponent, (uint32_t)sizeof(Component_), (uint32_t)alignof(Component_) }; \
+		return info; \
+	}
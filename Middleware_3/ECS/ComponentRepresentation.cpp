@@ -27,11 +27,11 @@
 #include "../../Common_3/OS/Interfaces/IMemory.h" // NOTE: this should be the last include in a .cpp
 using namespace FCR;
 
-uint32_t const UniqueIdGenerator::generateUniqueId(eastl::string component_name, BaseComponent* (*func)())
+uint32_t const UniqueIdGenerator::generateUniqueId(eastl::string component_name, const ComponentTypeInfo& typeInfo)
 {
 	static uint32_t m_VarIdCounter = 0;
 	eastl::hash < eastl::string > hashStr;
-	BaseComponent::instertIntoComponentGeneratorMap((uint32_t)hashStr(component_name), func);
+	BaseComponent::instertIntoComponentGeneratorMap((uint32_t)hashStr(component_name), typeInfo);
 	return m_VarIdCounter++;
 }
 
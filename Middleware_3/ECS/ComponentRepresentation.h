@@ -144,7 +144,7 @@ class UniqueIdGenerator
 public:
 	// Used by MACRO and helper functions
 	static uint32_t const
-		generateUniqueId(eastl::string component_name, BaseComponent* (*func)());
+		generateUniqueId(eastl::string component_name, const ComponentTypeInfo& typeInfo);
 };
 
 ////////////////////////////////////////////////////////
@@ -510,7 +510,7 @@ public:
 ///////// In .cpp //////////////////////////////////////////////////////////////////////////////////////
 #define FORGE_DEFINE_COMPONENT_ID(componentClass) uint32_t componentClass##Representation::ComponentID;
 #define FORGE_INIT_COMPONENT_ID( componentClass ) \
-	componentClass##Representation::ComponentID = FCR::UniqueIdGenerator::generateUniqueId(#componentClass, componentClass::GenerateComponent);
+	componentClass##Representation::ComponentID = FCR::UniqueIdGenerator::generateUniqueId(#componentClass, componentClass::getTypeInfo());
 
 // This macro matches REGISTER_COMPONENT_VAR macro
 #define FORGE_ASSIGN_UNIQUE_ID_TO_REGISTERED_COMPONENT(componentClass, varName, varid) \
@@ -36,35 +36,25 @@
 
 Entity::~Entity()
 {
-	for (ComponentMap::iterator it = mComponents.begin(); it != mComponents.end(); ++it)
-	{
-		it->second->~BaseComponent();
-		tf_free(it->second);
-	}
-
-	for (eastl::pair<uint32_t, FCR::ComponentRepresentation*> repMap_iter : mComponentRepresentations)
-	{
-		repMap_iter.second->~ComponentRepresentation();
-		tf_free(repMap_iter.second);
-	}
+	destroyRepresentations();
 }
 
-Entity* Entity::clone() const
+Entity::ComponentMap Entity::getComponents() const
 {
-	Entity* new_entity = tf_placement_new<Entity>(tf_calloc(1, sizeof(Entity)));
-	
-	for (ComponentMap::const_iterator it = mComponents.begin(); it != mComponents.end(); ++it)
+	ComponentMap components;
+	for (uint32_t i = 0; i < pArchetype->mComponentCount; ++i)
 	{
-		BaseComponent* pNewComponent = NULL;
-		pNewComponent = it->second->clone();
-		new_entity->addComponent(pNewComponent);
+		BaseComponent* pComponent = (BaseComponent*)pArchetype->getComponentData(i, mChunk, mRow);
+		components.insert({ pArchetype->mComponentTypes[i], pComponent });
 	}
-	
-	return new_entity;
+	return components;
 }
 
 FCR::ComponentRepresentation* const Entity::getComponentRepresentation(uint32_t const compId)
 {
+	if (mComponentRepresentations.empty())
+		createRepresentations();
+
 	eastl::unordered_map<uint32_t, FCR::ComponentRepresentation*>::iterator iter = mComponentRepresentations.find(compId);
 
 	if (iter == mComponentRepresentations.end())
@@ -75,29 +65,28 @@ FCR::ComponentRepresentation* const Entity::getComponentRepresentation(uint32_t
 	return iter->second;
 }
 
-
-void Entity::addComponent(BaseComponent* component)
+void Entity::createRepresentations()
 {
-	if (component)
+	for (uint32_t i = 0; i < pArchetype->mComponentCount; ++i)
 	{
-		uint32_t compType = component->getType();
-
-		ComponentMap::const_iterator const_itr = mComponents.find(compType);
-		if (const_itr == mComponents.end())
-		{
-			FCR::ComponentRepresentation* r = component->createRepresentation();
-			mComponents.insert({ compType, component });
-			mComponentRepresentations[r->getComponentID()] = r;
-		}
-		else
-		{
-			ASSERT(0 && "component for entity already exist");
-		}
+		BaseComponent* pComponent = (BaseComponent*)pArchetype->getComponentData(i, mChunk, mRow);
+		FCR::ComponentRepresentation* r = pComponent->createRepresentation();
+		mComponentRepresentations[r->getComponentID()] = r;
 	}
-	else
+}
+
+void Entity::destroyRepresentations()
+{
+	// clear() writes to the bucket array EASTL shares between all empty maps
+	if (mComponentRepresentations.empty())
+		return;
+
+	for (eastl::pair<uint32_t, FCR::ComponentRepresentation*> repMap_iter : mComponentRepresentations)
 	{
-		ASSERT(0 && "component is null");
+		repMap_iter.second->~ComponentRepresentation();
+		tf_free(repMap_iter.second);
 	}
+	mComponentRepresentations.clear();
 }
 
 EntityManager::EntityManager()
@@ -114,15 +103,26 @@ EntityManager::EntityManager()
 	}
 	
 	mEntitiesMutex.Init();
-	mIdMutex.Init();
 	mComponentMutex.Init();
+
+	pEmptyArchetype = getArchetype(NULL, 0);
 }
 
 EntityManager::~EntityManager()
 {
 	reset();
+	for (Archetype* pArchetype : mArchetypes)
+	{
+		destroyArchetype(pArchetype);
+	}
+	mArchetypes.set_capacity(0);
+	for (Entity* pBlock : mEntityBlocks)
+	{
+		tf_free(pBlock);
+	}
+	mEntityBlocks.set_capacity(0);
+	mFreeEntities.set_capacity(0);
 	mEntitiesMutex.Destroy();
-	mIdMutex.Destroy();
 	mComponentMutex.Destroy();
 	ComponentRegistrator::destroyInstance();
 }
@@ -138,7 +138,7 @@ void EntityManager::reset()
 	mEntities.clear();
 
 	// Clear stale component pointers
-	for (eastl::pair<uint32_t, ComponentLookup> pair : mComponentViseMap)
+	for (eastl::pair<const uint32_t, ComponentLookup>& pair : mComponentViseMap)
 	{
 		pair.second.clear();
 	}
@@ -146,32 +146,83 @@ void EntityManager::reset()
 
 EntityId EntityManager::createEntity()
 {
-	Entity* new_entity = tf_placement_new<Entity>(tf_calloc(1, sizeof(Entity)));
-
 	EntityId id = 0;
+	createEntities(1, pEmptyArchetype, &id);
+	return id;
+}
+
+void EntityManager::createEntities(uint32_t count, Archetype* pArchetype, EntityId* pIdsOut)
+{
+	ASSERT(pArchetype);
+	ASSERT(pIdsOut);
+	if (!count)
+		return;
+
+	EntityId firstId = (EntityId)tfrg_atomic32_add_relaxed(&mEntityIdCounter, count);
+
+    // If id < 0, the m_EntityIdCounter is over flow.
+    // id == 0 is reserved for SCENE_ROOT.
+    ASSERT(firstId > 0);
+
+	eastl::vector<Entity*> entities(count);
 	{
-		MutexLock lock(mIdMutex);
-		id = mEntityIdCounter++;
 		MutexLock entLock(mEntitiesMutex);
-		mEntities[id] = new_entity;
+		allocateEntities(count, entities.data());
 	}
 
-    // If id < 0, the m_EntityIdCounter is over flow.
-    // id == 0 is reserved for SCENE_ROOT.
-    ASSERT(id > 0);
+	// Rows are only reserved and constructed under the archetype's lock, other archetypes are not held up
+	{
+		MutexLock archetypeLock(pArchetype->mMutex);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Entity* pEntity = entities[i];
+			pEntity->mId = firstId + (EntityId)i;
+			allocateRow(pArchetype, pEntity);
+			for (uint32_t c = 0; c < pArchetype->mComponentCount; ++c)
+				pArchetype->mComponentInfos[c].pConstruct(pArchetype->getComponentData(c, pEntity->mChunk, pEntity->mRow));
+		}
+	}
 
-	return id;
+	// Entities are only published once their components exist. Rows only move under mComponentMutex,
+	// so the locations read here are current
+	MutexLock lock(mComponentMutex);
+	MutexLock entLock(mEntitiesMutex);
+	mEntities.reserve(mEntities.size() + count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Entity* pEntity = entities[i];
+		updateComponentLookups(pEntity);
+		mEntities[pEntity->mId] = pEntity;
+		pIdsOut[i] = pEntity->mId;
+	}
 }
 
 EntityId EntityManager::cloneEntity(EntityId id)
 {
 	Entity* source_entity = getEntityById(id);
-	Entity* new_entity	  = source_entity->clone();
+	Entity* new_entity	  = NULL;
+	{
+		MutexLock entLock(mEntitiesMutex);
+		allocateEntities(1, &new_entity);
+	}
+
+	EntityId newid = (EntityId)tfrg_atomic32_add_relaxed(&mEntityIdCounter, 1);
+	new_entity->mId = newid;
+
+	{
+		MutexLock lock(mComponentMutex);
+		Archetype* pArchetype = source_entity->pArchetype;
+		MutexLock archetypeLock(pArchetype->mMutex);
+		allocateRow(pArchetype, new_entity);
+		for (uint32_t i = 0; i < pArchetype->mComponentCount; ++i)
+		{
+			const BaseComponent* pSrc = (const BaseComponent*)pArchetype->getComponentData(i, source_entity->mChunk, source_entity->mRow);
+			pArchetype->mComponentInfos[i].pCopy(pArchetype->getComponentData(i, new_entity->mChunk, new_entity->mRow), pSrc);
+		}
+		updateComponentLookups(new_entity);
+	}
 
-	EntityId newid = 0;
 	{
-		MutexLock lock(mIdMutex);
-		newid = mEntityIdCounter++;
 		MutexLock entLock(mEntitiesMutex);
 		mEntities[newid] = new_entity;
 	}
@@ -190,16 +241,51 @@ void EntityManager::deleteEntity(EntityId id)
 	ASSERT(entity);
 
 	{
-		MutexLock lock(mEntitiesMutex);
-		// Unpopulate data structures
-		eastl::unordered_map<EntityId, Entity*>::iterator entities_iter = mEntities.find(id);
-		ASSERT(entities_iter != mEntities.end());
-		mEntities.erase(entities_iter);
+		MutexLock lock(mComponentMutex);
+		Archetype* pArchetype = entity->pArchetype;
+		MutexLock archetypeLock(pArchetype->mMutex);
+		for (uint32_t i = 0; i < pArchetype->mComponentCount; ++i)
+		{
+			ComponentViseMap::iterator itr = mComponentViseMap.find(pArchetype->mComponentTypes[i]);
+			if (itr != mComponentViseMap.end())
+				itr->second.erase(id);
+
+			((BaseComponent*)pArchetype->getComponentData(i, entity->mChunk, entity->mRow))->~BaseComponent();
+		}
+		freeRow(pArchetype, entity->mChunk, entity->mRow);
+	}
+
+	MutexLock entLock(mEntitiesMutex);
+	// Unpopulate data structures
+	eastl::unordered_map<EntityId, Entity*>::iterator entities_iter = mEntities.find(id);
+	ASSERT(entities_iter != mEntities.end());
+	mEntities.erase(entities_iter);
+	freeEntity(entity);
+}
+
+void EntityManager::allocateEntities(uint32_t count, Entity** ppEntities)
+{
+	while (mFreeEntities.size() < count)
+	{
+		Entity* pBlock = (Entity*)tf_calloc(ECS_ENTITY_BLOCK_SIZE, sizeof(Entity));
+		mEntityBlocks.push_back(pBlock);
+		// Hand out the entities of a block in order
+		for (uint32_t i = ECS_ENTITY_BLOCK_SIZE; i > 0; --i)
+			mFreeEntities.push_back(pBlock + i - 1);
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		ppEntities[i] = tf_placement_new<Entity>(mFreeEntities.back());
+		mFreeEntities.pop_back();
 	}
-	entity->~Entity();
-	tf_free(entity);
 }
 
+void EntityManager::freeEntity(Entity* pEntity)
+{
+	pEntity->~Entity();
+	mFreeEntities.push_back(pEntity);
+}
 
 Entity* EntityManager::getEntityById(EntityId const id)
 {
@@ -228,3 +314,202 @@ bool EntityManager::entityExist(EntityId const id)
 		return (iter != mEntities.end());
 	}
 }
+
+static uint32_t alignOffset(uint32_t offset, uint32_t alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+Archetype* EntityManager::getArchetype(const uint32_t* pTypes, uint32_t count)
+{
+	for (Archetype* pArchetype : mArchetypes)
+	{
+		if (pArchetype->mComponentCount == count && (!count || !memcmp(pArchetype->mComponentTypes, pTypes, count * sizeof(uint32_t))))
+			return pArchetype;
+	}
+
+	if (count > ECS_MAX_ARCHETYPE_COMPONENTS)
+	{
+		LOGF(eERROR, "Archetype with %u components exceeds ECS_MAX_ARCHETYPE_COMPONENTS (%u)", count, ECS_MAX_ARCHETYPE_COMPONENTS);
+		return NULL;
+	}
+
+	Archetype* pArchetype = tf_new(Archetype);
+	pArchetype->mMutex.Init();
+	pArchetype->mComponentCount = count;
+	memset(pArchetype->pChunkPages, 0, sizeof(pArchetype->pChunkPages));
+	pArchetype->mChunkCount = 0;
+
+	const eastl::unordered_map<uint32_t, ComponentTypeInfo>& CompInfoMap = ComponentRegistrator::getInstance()->getComponentTypeInfoMap();
+	uint32_t rowSize = sizeof(Entity*);
+	uint32_t maxPadding = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		eastl::unordered_map<uint32_t, ComponentTypeInfo>::const_iterator itr = CompInfoMap.find(pTypes[i]);
+		ASSERT(itr != CompInfoMap.end());
+		pArchetype->mComponentTypes[i] = pTypes[i];
+		pArchetype->mComponentInfos[i] = itr->second;
+		rowSize += itr->second.mSize;
+		maxPadding += itr->second.mAlignment;
+	}
+
+	// Chunks hold at least one row, even when the components are larger than ECS_CHUNK_SIZE
+	uint32_t capacity = ECS_CHUNK_SIZE > maxPadding ? (ECS_CHUNK_SIZE - maxPadding) / rowSize : 0;
+	pArchetype->mChunkCapacity = capacity ? capacity : 1;
+
+	uint32_t offset = pArchetype->mChunkCapacity * sizeof(Entity*);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		offset = alignOffset(offset, pArchetype->mComponentInfos[i].mAlignment);
+		pArchetype->mComponentOffsets[i] = offset;
+		offset += pArchetype->mChunkCapacity * pArchetype->mComponentInfos[i].mSize;
+	}
+	pArchetype->mChunkSize = offset;
+
+	mArchetypes.push_back(pArchetype);
+	return pArchetype;
+}
+
+Archetype* EntityManager::getArchetypeWithComponent(Archetype* pArchetype, uint32_t type)
+{
+	eastl::hash_map<uint32_t, Archetype*>::iterator itr = pArchetype->mAddTransitions.find(type);
+	if (itr != pArchetype->mAddTransitions.end())
+		return itr->second;
+
+	if (pArchetype->mComponentCount == ECS_MAX_ARCHETYPE_COMPONENTS)
+	{
+		LOGF(eERROR, "Cannot add a component to an entity that already has ECS_MAX_ARCHETYPE_COMPONENTS (%u) components", ECS_MAX_ARCHETYPE_COMPONENTS);
+		return NULL;
+	}
+
+	uint32_t types[ECS_MAX_ARCHETYPE_COMPONENTS];
+	uint32_t count = 0;
+	bool inserted = false;
+	for (uint32_t i = 0; i < pArchetype->mComponentCount; ++i)
+	{
+		if (!inserted && type < pArchetype->mComponentTypes[i])
+		{
+			types[count++] = type;
+			inserted = true;
+		}
+		types[count++] = pArchetype->mComponentTypes[i];
+	}
+	if (!inserted)
+		types[count++] = type;
+
+	Archetype* pResult = getArchetype(types, count);
+	if (pResult)
+		pArchetype->mAddTransitions.insert(eastl::pair<uint32_t, Archetype*>(type, pResult));
+	return pResult;
+}
+
+void EntityManager::destroyArchetype(Archetype* pArchetype)
+{
+	ASSERT(!pArchetype->mChunkCount);
+	for (uint32_t i = 0; i < ECS_MAX_CHUNK_PAGES && pArchetype->pChunkPages[i]; ++i)
+		tf_free(pArchetype->pChunkPages[i]);
+	pArchetype->mMutex.Destroy();
+	tf_delete(pArchetype);
+}
+
+void EntityManager::allocateRow(Archetype* pArchetype, Entity* pEntity)
+{
+	uint32_t chunkCount = pArchetype->mChunkCount;
+	if (!chunkCount || pArchetype->getChunk(chunkCount - 1)->mCount == pArchetype->mChunkCapacity)
+	{
+		uint32_t page = chunkCount / ECS_CHUNK_PAGE_SIZE;
+		ASSERT(page < ECS_MAX_CHUNK_PAGES);
+		if (!pArchetype->pChunkPages[page])
+			pArchetype->pChunkPages[page] = (ArchetypeChunk*)tf_calloc(ECS_CHUNK_PAGE_SIZE, sizeof(ArchetypeChunk));
+
+		ArchetypeChunk* pChunk = pArchetype->getChunk(chunkCount);
+		pChunk->pArchetype = pArchetype;
+		pChunk->pData = (uint8_t*)tf_memalign(64, pArchetype->mChunkSize);
+		pChunk->mCount = 0;
+		// The chunk is written before it is published to the queries
+		tfrg_atomic32_store_release(&pArchetype->mChunkCount, ++chunkCount);
+	}
+
+	ArchetypeChunk* pChunk = pArchetype->getChunk(chunkCount - 1);
+	pEntity->pArchetype = pArchetype;
+	pEntity->mChunk = chunkCount - 1;
+	pEntity->mRow = pChunk->mCount++;
+	pChunk->getEntities()[pEntity->mRow] = pEntity;
+}
+
+void EntityManager::freeRow(Archetype* pArchetype, uint32_t chunk, uint32_t row)
+{
+	uint32_t lastChunkIndex = pArchetype->mChunkCount - 1;
+	ArchetypeChunk& lastChunk = *pArchetype->getChunk(lastChunkIndex);
+	uint32_t lastRow = lastChunk.mCount - 1;
+
+	// Keep the rows packed by moving the last one into the hole
+	if (chunk != lastChunkIndex || row != lastRow)
+	{
+		Entity* pMoved = lastChunk.getEntities()[lastRow];
+		for (uint32_t i = 0; i < pArchetype->mComponentCount; ++i)
+		{
+			BaseComponent* pSrc = (BaseComponent*)pArchetype->getComponentData(i, lastChunkIndex, lastRow);
+			pArchetype->mComponentInfos[i].pCopy(pArchetype->getComponentData(i, chunk, row), pSrc);
+			pSrc->~BaseComponent();
+		}
+		pArchetype->getChunk(chunk)->getEntities()[row] = pMoved;
+		pMoved->mChunk = chunk;
+		pMoved->mRow = row;
+		pMoved->destroyRepresentations();
+		updateComponentLookups(pMoved);
+	}
+
+	if (--lastChunk.mCount == 0)
+	{
+		tfrg_atomic32_store_release(&pArchetype->mChunkCount, lastChunkIndex);
+		tf_free(lastChunk.pData);
+		lastChunk.pData = NULL;
+	}
+}
+
+BaseComponent* EntityManager::moveEntity(Entity* pEntity, Archetype* pDstArchetype, uint32_t newType)
+{
+	Archetype* pSrcArchetype = pEntity->pArchetype;
+	MutexLock srcLock(pSrcArchetype->mMutex);
+	MutexLock dstLock(pDstArchetype->mMutex);
+	uint32_t srcChunk = pEntity->mChunk;
+	uint32_t srcRow = pEntity->mRow;
+
+	allocateRow(pDstArchetype, pEntity);
+
+	BaseComponent* pNewComponent = NULL;
+	for (uint32_t i = 0; i < pDstArchetype->mComponentCount; ++i)
+	{
+		void* pDst = pDstArchetype->getComponentData(i, pEntity->mChunk, pEntity->mRow);
+		if (pDstArchetype->mComponentTypes[i] == newType)
+		{
+			pNewComponent = pDstArchetype->mComponentInfos[i].pConstruct(pDst);
+			continue;
+		}
+
+		int32_t srcColumn = pSrcArchetype->findComponent(pDstArchetype->mComponentTypes[i]);
+		ASSERT(srcColumn >= 0);
+		BaseComponent* pSrc = (BaseComponent*)pSrcArchetype->getComponentData((uint32_t)srcColumn, srcChunk, srcRow);
+		pDstArchetype->mComponentInfos[i].pCopy(pDst, pSrc);
+		pSrc->~BaseComponent();
+	}
+
+	freeRow(pSrcArchetype, srcChunk, srcRow);
+
+	pEntity->destroyRepresentations();
+	updateComponentLookups(pEntity);
+
+	return pNewComponent;
+}
+
+void EntityManager::updateComponentLookups(Entity* pEntity)
+{
+	Archetype* pArchetype = pEntity->pArchetype;
+	for (uint32_t i = 0; i < pArchetype->mComponentCount; ++i)
+	{
+		ComponentViseMap::iterator itr = mComponentViseMap.find(pArchetype->mComponentTypes[i]);
+		if (itr != mComponentViseMap.end())
+			itr->second[pEntity->mId] = (BaseComponent*)pArchetype->getComponentData(i, pEntity->mChunk, pEntity->mRow);
+	}
+}
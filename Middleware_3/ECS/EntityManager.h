@@ -26,11 +26,13 @@
 
 #include "../../Common_3/OS/Interfaces/ILog.h"
 #include "../../Common_3/OS/Interfaces/IThread.h"
+#include "../../Common_3/OS/Core/Atomics.h"
 
 #include "../../Common_3/ThirdParty/OpenSource/EASTL/string.h"
 #include "../../Common_3/ThirdParty/OpenSource/EASTL/unordered_set.h"
 #include "../../Common_3/ThirdParty/OpenSource/EASTL/unordered_map.h"
 #include "../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/sort.h"
 
 namespace FCR
 {
@@ -40,8 +42,13 @@ namespace FCR
 //class BaseComponent;
 #include "BaseComponent.h"
 
+typedef int32_t EntityId;
+
+struct Archetype;
+
 // An entity is collection of components.
 // An entity has a name.
+// The components themselves are owned by the EntityManager, which stores them in the chunks of the entity's archetype.
 class Entity
 {
 	friend class EntityManager; // only entity manager should directly modify entities
@@ -57,39 +64,138 @@ public:
 
 	~Entity();
 
-	Entity*
-	clone() const;
-
 	// Template getter that retrieves a component based on the component type passed in.
 	// The passed in pointer will point to the appropriate component if it is found.
+	// The returned pointer stays valid until the entity gains or loses a component, or another entity of the same
+	// archetype is deleted.
 
 	template<typename T> T* getComponent();
 	template<typename T> T const* getComponent() const;
 
 	template<typename T> void getComponent(T*& componentOut);
 
-	ComponentMap& getComponents() { return mComponents; }
+	ComponentMap getComponents() const;
 
+	// Representations are created on first use
 	FCR::ComponentRepresentation* const
 	getComponentRepresentation(uint32_t const compId);
 
-	//void addComponent(BaseComponent*);
+	EntityId getId() const { return mId; }
+
 private:
-	void addComponent(BaseComponent*);	// made this private. only way to add component is via EntityManager
+	void createRepresentations();
+	// Called when the components change address, the representations point to the component variables
+	void destroyRepresentations();
 
-	ComponentMap	mComponents;
 	ComponentRepMap	mComponentRepresentations;
+
+	// Location of the components
+	Archetype*		pArchetype;
+	uint32_t		mChunk;
+	uint32_t		mRow;
+	EntityId		mId;
+};
+
+/************************************************************************/
+// Archetype storage
+/************************************************************************/
+// All entities with the same set of component types share an archetype. The archetype stores the components in
+// fixed size chunks holding one contiguous array per component type, next to the array of the owning entities.
+// Rows are allocated at the end of the last chunk and freed by moving the last row of the archetype into the hole,
+// so every chunk but the last one is always full.
+#define ECS_CHUNK_SIZE (16 * 1024)
+#define ECS_MAX_ARCHETYPE_COMPONENTS 16
+// Chunks are kept in pages which never move, so the components of an entity can be read while rows are appended
+#define ECS_CHUNK_PAGE_SIZE 256
+#define ECS_MAX_CHUNK_PAGES 1024
+// Entities are allocated in blocks and recycled
+#define ECS_ENTITY_BLOCK_SIZE 1024
+
+struct ArchetypeChunk
+{
+	Archetype*	pArchetype;
+	uint8_t*	pData;
+	uint32_t	mCount;
+
+	Entity** getEntities() const { return (Entity**)pData; }
+
+	// mCount components, NULL if the archetype has no T
+	template<typename T> T* getComponents() const;
 };
 
+struct Archetype
+{
+	// Sorted by type
+	uint32_t			mComponentTypes[ECS_MAX_ARCHETYPE_COMPONENTS];
+	ComponentTypeInfo	mComponentInfos[ECS_MAX_ARCHETYPE_COMPONENTS];
+	// Offset of the component arrays in a chunk, the entity array is at offset 0
+	uint32_t			mComponentOffsets[ECS_MAX_ARCHETYPE_COMPONENTS];
+	uint32_t			mComponentCount;
+	uint32_t			mChunkCapacity;
+	uint32_t			mChunkSize;
+
+	// Guards the chunks, taken after EntityManager::mComponentMutex when both are needed
+	Mutex									mMutex;
+	// Chunk i is pChunkPages[i / ECS_CHUNK_PAGE_SIZE][i % ECS_CHUNK_PAGE_SIZE], pages are only freed with the archetype
+	ArchetypeChunk*							pChunkPages[ECS_MAX_CHUNK_PAGES];
+	tfrg_atomic32_t							mChunkCount;
+	// Archetypes reached by adding a component type to this one, guarded by EntityManager::mComponentMutex
+	eastl::hash_map<uint32_t, Archetype*>	mAddTransitions;
+
+	uint32_t getChunkCount() const
+	{
+		return tfrg_atomic32_load_acquire(const_cast<tfrg_atomic32_t*>(&mChunkCount));
+	}
+
+	ArchetypeChunk* getChunk(uint32_t const chunk) const
+	{
+		return &pChunkPages[chunk / ECS_CHUNK_PAGE_SIZE][chunk % ECS_CHUNK_PAGE_SIZE];
+	}
+
+	int32_t findComponent(uint32_t const type) const
+	{
+		for (uint32_t i = 0; i < mComponentCount; ++i)
+		{
+			if (mComponentTypes[i] == type)
+				return (int32_t)i;
+		}
+		return -1;
+	}
+
+	bool hasComponents(const uint32_t* pTypes, uint32_t const count) const
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (findComponent(pTypes[i]) < 0)
+				return false;
+		}
+		return true;
+	}
+
+	void* getComponentData(uint32_t const column, uint32_t const chunk, uint32_t const row) const
+	{
+		return getChunk(chunk)->pData + mComponentOffsets[column] + row * mComponentInfos[column].mSize;
+	}
+};
+
+template<typename T>
+T* ArchetypeChunk::getComponents() const
+{
+	int32_t column = pArchetype->findComponent(T::getTypeStatic());
+	if (column < 0)
+		return NULL;
+
+	return static_cast<T*>((void*)(pData + pArchetype->mComponentOffsets[column]));
+}
 
 template<typename T>
 T* Entity::getComponent()
 {
 	T* componentOut = NULL;
 
-	ComponentMap::iterator it = mComponents.find(T::getTypeStatic());
-	if (it != mComponents.end())
-		componentOut = (T*)it->second;
+	int32_t column = pArchetype->findComponent(T::getTypeStatic());
+	if (column >= 0)
+		componentOut = static_cast<T*>(pArchetype->getComponentData((uint32_t)column, mChunk, mRow));
 
 	//ASSERT((componentOut != nullptr) && "Couldn't find desired component on entity.");
 	
@@ -108,8 +214,6 @@ void Entity::getComponent(T*& componentOut)
 	componentOut = getComponent<T>();
 }
 
-typedef int32_t EntityId;
-
 typedef eastl::unordered_map<EntityId, Entity*>					 EntityMap;
 typedef eastl::unordered_map<EntityId, Entity*>::iterator		 EntityMapIterator;
 typedef eastl::unordered_map<EntityId, Entity*>::const_iterator  EntityMapConstIterator;
@@ -139,8 +243,22 @@ public:
 
 	const eastl::unordered_map<EntityId, Entity*>& getEntities() const { return mEntities; }
 
+	// Archetype with exactly the components T..., created on first use
+	// Returns NULL if a component type is not registered
+	template <typename... T>
+	Archetype* getArchetype();
+
+	// Creates count entities with default constructed components of pArchetype and writes their ids to pIdsOut.
+	// Batches can be created from several threads at once: ids are reserved with an atomic add, the rows are
+	// reserved and constructed holding only the archetype's mutex, then the whole batch is published to getEntities
+	// and the component lookups in one short section under mComponentMutex and mEntitiesMutex.
+	// Components of existing entities can be read with getComponent while a batch is created.
+	void createEntities(uint32_t count, Archetype* pArchetype, EntityId* pIdsOut);
+
+	// Moves the entity to the archetype with T added, pointers to its other components are invalidated.
+	// Returns NULL if the entity would exceed ECS_MAX_ARCHETYPE_COMPONENTS components.
 	template <typename T>
-	T& addComponentToEntity(EntityId id);
+	T* addComponentToEntity(EntityId id);
 
 	template <typename T>
 	Lookup& getByComponent()
@@ -157,8 +275,48 @@ public:
 		return *map;
 	}
 
+	// Queries over all entities having at least the components T...
+	// They must not run concurrently with entity creation, deletion or addComponentToEntity.
+
+	// fn(T&...) for each entity
+	template <typename... T, typename Fn>
+	void forEach(Fn fn);
+
+	// fn(uint32_t count, T*...) for each chunk
+	template <typename... T, typename Fn>
+	void forEachChunk(Fn fn);
+
+	// Appends the matching chunks to chunksOut, so they can be split between tasks.
+	// The pointers are invalidated by the next structural change.
+	template <typename... T>
+	void queryChunks(eastl::vector<ArchetypeChunk*>& chunksOut);
+
 private:
-	Mutex mIdMutex;
+	template <typename... T, typename Fn>
+	static void forEachRow(uint32_t count, Fn& fn, T*... pComponents)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			fn(pComponents[i]...);
+	}
+
+	// pTypes must be sorted, mComponentMutex must be held.
+	// Returns NULL when count exceeds ECS_MAX_ARCHETYPE_COMPONENTS.
+	Archetype* getArchetype(const uint32_t* pTypes, uint32_t count);
+	Archetype* getArchetypeWithComponent(Archetype* pArchetype, uint32_t type);
+	void destroyArchetype(Archetype* pArchetype);
+
+	// mEntitiesMutex must be held
+	void allocateEntities(uint32_t count, Entity** ppEntities);
+	void freeEntity(Entity* pEntity);
+
+	// The archetype's mutex must be held by the functions touching its rows
+	void allocateRow(Archetype* pArchetype, Entity* pEntity);
+	// Components of the row must already be destroyed or moved out
+	void freeRow(Archetype* pArchetype, uint32_t chunk, uint32_t row);
+	BaseComponent* moveEntity(Entity* pEntity, Archetype* pDstArchetype, uint32_t newType);
+
+	void updateComponentLookups(Entity* pEntity);
+
 	Mutex mEntitiesMutex;
 	Mutex mComponentMutex;
 	// Entities book-keeping data-structures ////////////////////////
@@ -173,43 +331,115 @@ private:
 	eastl::unordered_map<eastl::string, EntityId>	mEntitiesName;
 
 	// incr. on entity creation... used to fetch entities.
-	EntityId										mEntityIdCounter;
+	tfrg_atomic32_t									mEntityIdCounter;
+
+	// Entity allocations, guarded by mEntitiesMutex
+	eastl::vector<Entity*>							mEntityBlocks;
+	eastl::vector<Entity*>							mFreeEntities;
+	/////////////////////////////////////////////////////////////////
+
+	// Component storage, guarded by mComponentMutex ////////////////
+	eastl::vector<Archetype*>						mArchetypes;
+	// Archetype of entities without components
+	Archetype*										pEmptyArchetype;
 	/////////////////////////////////////////////////////////////////
 
 	ComponentViseMap mComponentViseMap;
 };
 
 
+template <typename... T>
+Archetype* EntityManager::getArchetype()
+{
+	static_assert(sizeof...(T) <= ECS_MAX_ARCHETYPE_COMPONENTS, "Too many components for one archetype");
+	uint32_t types[] = { 0, T::getTypeStatic()... };
+	eastl::sort(types + 1, types + 1 + sizeof...(T));
+
+	MutexLock lock(mComponentMutex);
+	return getArchetype(types + 1, sizeof...(T));
+}
+
 template <typename T>
-T& EntityManager::addComponentToEntity(EntityId _id)
+T* EntityManager::addComponentToEntity(EntityId _id)
 {
 	MutexLock lock(mComponentMutex);
 	
 	BaseComponent* pComponent = nullptr;
 
-	const eastl::unordered_map< uint32_t, ComponentGeneratorFctPtr >& CompGenMap   = ComponentRegistrator::getInstance()->getComponentGeneratorMap();
-	eastl::unordered_map< uint32_t, ComponentGeneratorFctPtr >::const_iterator itr = CompGenMap.find(T::getTypeStatic());
-	if (itr != CompGenMap.end())
+	const eastl::unordered_map< uint32_t, ComponentTypeInfo >& CompInfoMap   = ComponentRegistrator::getInstance()->getComponentTypeInfoMap();
+	eastl::unordered_map< uint32_t, ComponentTypeInfo >::const_iterator itr = CompInfoMap.find(T::getTypeStatic());
+	if (itr != CompInfoMap.end())
 	{
-		pComponent = itr->second();
 		Entity* pEntity = getEntityById(_id);
-		pEntity->addComponent(pComponent);
-
-		ComponentViseMap::iterator itr = mComponentViseMap.find(T::getTypeStatic());
-		if (itr != mComponentViseMap.end())
+		if (pEntity->pArchetype->findComponent(T::getTypeStatic()) < 0)
 		{
-			ComponentLookup& componentMap = itr->second;
-			componentMap.insert(Pair(_id, pComponent));
+			Archetype* pArchetype = getArchetypeWithComponent(pEntity->pArchetype, T::getTypeStatic());
+			if (pArchetype)
+				pComponent = moveEntity(pEntity, pArchetype, T::getTypeStatic());
 		}
 		else
 		{
-			ASSERT(0);
+			ASSERT(0 && "component for entity already exist");
+			pComponent = pEntity->getComponent<T>();
 		}
+
+		ASSERT(mComponentViseMap.find(T::getTypeStatic()) != mComponentViseMap.end());
 	}
 	else
 	{
 		ASSERT(0 && "COMPONENT OF GIVEN NAME NOT FOUND");
 	}
 
-	return *(static_cast<T*>(pComponent));
+	return static_cast<T*>(pComponent);
+}
+
+template <typename... T, typename Fn>
+void EntityManager::forEach(Fn fn)
+{
+	const uint32_t types[] = { T::getTypeStatic()... };
+	for (Archetype* pArchetype : mArchetypes)
+	{
+		if (!pArchetype->hasComponents(types, sizeof...(T)))
+			continue;
+
+		const uint32_t chunkCount = pArchetype->getChunkCount();
+		for (uint32_t i = 0; i < chunkCount; ++i)
+		{
+			const ArchetypeChunk* pChunk = pArchetype->getChunk(i);
+			forEachRow<T...>(pChunk->mCount, fn, pChunk->getComponents<T>()...);
+		}
+	}
+}
+
+template <typename... T, typename Fn>
+void EntityManager::forEachChunk(Fn fn)
+{
+	const uint32_t types[] = { T::getTypeStatic()... };
+	for (Archetype* pArchetype : mArchetypes)
+	{
+		if (!pArchetype->hasComponents(types, sizeof...(T)))
+			continue;
+
+		const uint32_t chunkCount = pArchetype->getChunkCount();
+		for (uint32_t i = 0; i < chunkCount; ++i)
+		{
+			const ArchetypeChunk* pChunk = pArchetype->getChunk(i);
+			fn(pChunk->mCount, pChunk->getComponents<T>()...);
+		}
+	}
+}
+
+template <typename... T>
+void EntityManager::queryChunks(eastl::vector<ArchetypeChunk*>& chunksOut)
+{
+	const uint32_t types[] = { T::getTypeStatic()... };
+	for (Archetype* pArchetype : mArchetypes)
+	{
+		if (!pArchetype->hasComponents(types, sizeof...(T)))
+			continue;
+
+		const uint32_t chunkCount = pArchetype->getChunkCount();
+		for (uint32_t i = 0; i < chunkCount; ++i)
+			chunksOut.push_back(pArchetype->getChunk(i));
+	}
 }
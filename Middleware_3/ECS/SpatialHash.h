@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Common_3/OS/Interfaces/ILog.h"
+
+#include "../../Common_3/ThirdParty/OpenSource/EASTL/vector.h"
+
+#include <math.h>
+
+// Uniform grid over the xy plane. Cells are hashed into a fixed number of buckets, so the grid does not need to know
+// the bounds of the world. Items are identified by indices chosen by the caller, e.g. the index of an entity in the
+// array of a system.
+// update() is incremental: an item is only relinked when its position crosses into another cell.
+// query() only reads the grid and can run from any number of threads at once, as long as no update runs concurrently.
+class SpatialHash
+{
+public:
+	static const uint32_t INVALID_ITEM = 0xFFFFFFFF;
+
+	SpatialHash(): mCellSize(1.0f), mInvCellSize(1.0f), mItemCount(0) {}
+
+	// bucketCount is rounded up to a power of two, about twice the number of items works well
+	void init(float cellSize, uint32_t bucketCount)
+	{
+		ASSERT(cellSize > 0.0f);
+		uint32_t count = 1;
+		while (count < bucketCount)
+			count <<= 1;
+
+		mCellSize = cellSize;
+		mInvCellSize = 1.0f / cellSize;
+		mBuckets.assign(count, INVALID_ITEM);
+		mItems.clear();
+		mItemCount = 0;
+	}
+
+	void exit()
+	{
+		mBuckets.set_capacity(0);
+		mItems.set_capacity(0);
+		mItemCount = 0;
+	}
+
+	void clear()
+	{
+		mBuckets.assign(mBuckets.size(), INVALID_ITEM);
+		mItems.clear();
+		mItemCount = 0;
+	}
+
+	float    getCellSize() const { return mCellSize; }
+	uint32_t getItemCount() const { return mItemCount; }
+
+	// Inserts the item or moves it to (x, y)
+	void update(uint32_t item, float x, float y)
+	{
+		ASSERT(item != INVALID_ITEM);
+		ASSERT(!mBuckets.empty() && "SpatialHash::init was not called");
+		if (item >= mItems.size())
+			mItems.resize(item + 1);
+
+		Item&   entry = mItems[item];
+		int32_t cellX = getCell(x);
+		int32_t cellY = getCell(y);
+		entry.mX = x;
+		entry.mY = y;
+
+		if (entry.mInserted)
+		{
+			if (entry.mCellX == cellX && entry.mCellY == cellY)
+				return;
+			unlink(item);
+		}
+		else
+		{
+			entry.mInserted = true;
+			++mItemCount;
+		}
+
+		entry.mCellX = cellX;
+		entry.mCellY = cellY;
+		link(item);
+	}
+
+	void remove(uint32_t item)
+	{
+		if (item >= mItems.size() || !mItems[item].mInserted)
+			return;
+
+		unlink(item);
+		mItems[item].mInserted = false;
+		--mItemCount;
+	}
+
+	// Calls fn(uint32_t item, float itemX, float itemY) for the items of every cell overlapping the square of half
+	// size radius around (x, y). The caller does the exact distance test. fn returns false to stop the query, in which
+	// case query returns false.
+	template <typename Fn>
+	bool query(float x, float y, float radius, Fn fn) const
+	{
+		if (!mItemCount)
+			return true;
+
+		int32_t minX = getCell(x - radius);
+		int32_t maxX = getCell(x + radius);
+		int32_t minY = getCell(y - radius);
+		int32_t maxY = getCell(y + radius);
+
+		for (int32_t cellY = minY; cellY <= maxY; ++cellY)
+		{
+			for (int32_t cellX = minX; cellX <= maxX; ++cellX)
+			{
+				// Other cells can share the bucket, each item is only reported for its own cell
+				for (uint32_t item = mBuckets[getBucket(cellX, cellY)]; item != INVALID_ITEM; item = mItems[item].mNext)
+				{
+					const Item& entry = mItems[item];
+					if (entry.mCellX != cellX || entry.mCellY != cellY)
+						continue;
+					if (!fn(item, entry.mX, entry.mY))
+						return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+private:
+	struct Item
+	{
+		Item(): mX(0.0f), mY(0.0f), mCellX(0), mCellY(0), mNext(INVALID_ITEM), mPrev(INVALID_ITEM), mInserted(false) {}
+
+		float    mX;
+		float    mY;
+		int32_t  mCellX;
+		int32_t  mCellY;
+		// Items of the same bucket
+		uint32_t mNext;
+		uint32_t mPrev;
+		bool     mInserted;
+	};
+
+	int32_t getCell(float value) const { return (int32_t)floorf(value * mInvCellSize); }
+
+	uint32_t getBucket(int32_t cellX, int32_t cellY) const
+	{
+		uint32_t hash = ((uint32_t)cellX * 73856093u) ^ ((uint32_t)cellY * 19349663u);
+		return hash & ((uint32_t)mBuckets.size() - 1);
+	}
+
+	void link(uint32_t item)
+	{
+		Item&     entry = mItems[item];
+		uint32_t& head = mBuckets[getBucket(entry.mCellX, entry.mCellY)];
+		entry.mPrev = INVALID_ITEM;
+		entry.mNext = head;
+		if (head != INVALID_ITEM)
+			mItems[head].mPrev = item;
+		head = item;
+	}
+
+	void unlink(uint32_t item)
+	{
+		Item& entry = mItems[item];
+		if (entry.mPrev != INVALID_ITEM)
+			mItems[entry.mPrev].mNext = entry.mNext;
+		else
+			mBuckets[getBucket(entry.mCellX, entry.mCellY)] = entry.mNext;
+		if (entry.mNext != INVALID_ITEM)
+			mItems[entry.mNext].mPrev = entry.mPrev;
+		entry.mNext = INVALID_ITEM;
+		entry.mPrev = INVALID_ITEM;
+	}
+
+	eastl::vector<uint32_t> mBuckets;
+	eastl::vector<Item>     mItems;
+	float                   mCellSize;
+	float                   mInvCellSize;
+	uint32_t                mItemCount;
+};
@@ -26,6 +26,10 @@
 #include "Shaders/Compiled/fontstash2D.vert.h"
 #include "Shaders/Compiled/fontstash3D.vert.h"
 #include "Shaders/Compiled/fontstash.frag.h"
+#include "Shaders/Compiled/fontstashBatch2D.vert.h"
+#include "Shaders/Compiled/fontstashBatch.frag.h"
+#include "Shaders/Compiled/fontstashSDF.frag.h"
+#include "Shaders/Compiled/fontstashBatchSDF.frag.h"
 #endif
 
 #include "Fontstash.h"
@@ -48,17 +52,71 @@
 
 #include "../../Common_3/OS/Interfaces/IMemory.h"
 
+// Pipelines: 2D text, 3D text and batched 2D text
+#define FONTSTASH_PIPELINE_2D 0
+#define FONTSTASH_PIPELINE_3D 1
+#define FONTSTASH_PIPELINE_BATCH_2D 2
+// Same as the above for signed distance field fonts
+#define FONTSTASH_PIPELINE_SDF_OFFSET 3
+#define FONTSTASH_PIPELINE_COUNT 6
+
+#define FONTSTASH_ATLAS_FILE_MAGIC 0x41544654 // "TFTA"
+#define FONTSTASH_ATLAS_FILE_VERSION 1
+
+// Header of the files written by Fontstash::saveAtlas, followed by the fonsSaveAtlas snapshot
+struct FontstashAtlasFileHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint32_t mSize;
+	uint32_t mReserved;
+};
+
+// Glyphs are uploaded to one atlas page while the other one is sampled, see updateTexture
+#define FONTSTASH_ATLAS_PAGE_COUNT 2
+// Frames a page stays untouched once it is no longer sampled, at least the number of frames the GPU can lag behind
+#define FONTSTASH_ATLAS_PAGE_RETIRE_FRAMES 3
+// 2D and 3D descriptor sets of each page
+#define FONTSTASH_PAGE_DESCRIPTOR_SET_COUNT 2
+
+// Vertex of the batched 2D text, as small as the unbatched one: texture coordinates are normalized 16 bit integers
+// and the color is the one given to drawText
+struct TextBatchVertex
+{
+	float    mPosition[2];
+	uint16_t mTexCoord[2];
+	uint32_t mColor;
+};
+
+struct AtlasPage
+{
+	Texture*  pTexture;
+	// Region of the CPU atlas not yet uploaded to this page, empty when mDirtyRect[0] >= mDirtyRect[2]
+	int       mDirtyRect[4];
+	SyncToken mUploadToken;
+	// Frame at which the page stopped being sampled
+	uint64_t  mRetireFrame;
+	bool      mUploading;
+};
+
 class _Impl_FontStash
 {
 public:
 	_Impl_FontStash()
 	{
-		pCurrentTexture = {};
+		memset(mPages, 0, sizeof(mPages));
+		mFrontPage = 0;
+		mFrameIndex = FONTSTASH_ATLAS_PAGE_RETIRE_FRAMES;
 		mWidth = 0;
 		mHeight = 0;
 		pContext = NULL;
 
 		mText3D = false;
+		mSDF = false;
+		mBatchSDF = false;
+		mBatching = false;
+		mBatchStart = {};
+		mBatchVertexCount = 0;
 	}
 
 	bool init(Renderer* renderer, int width_, int height_, uint32_t ringSizeBytes)
@@ -77,10 +135,13 @@ public:
 		desc.mStartState = RESOURCE_STATE_COMMON;
 		desc.mWidth = width_;
 		desc.pName = "Fontstash Texture";
-		TextureLoadDesc loadDesc = {};
-		loadDesc.ppTexture = &pCurrentTexture;
-		loadDesc.pDesc = &desc;
-		addResource(&loadDesc, NULL);
+		for (uint32_t i = 0; i < FONTSTASH_ATLAS_PAGE_COUNT; ++i)
+		{
+			TextureLoadDesc loadDesc = {};
+			loadDesc.ppTexture = &mPages[i].pTexture;
+			loadDesc.pDesc = &desc;
+			addResource(&loadDesc, NULL);
+		}
 
 		// create FONS context
 		FONSparams params;
@@ -95,6 +156,9 @@ public:
 		params.userPtr = this;
 
 		pContext = fonsCreateInternal(&params);
+
+		// Pages start out with the empty atlas so they never get sampled uninitialized
+		uploadAtlas();
 		/************************************************************************/
 		// Rendering resources
 		/************************************************************************/
@@ -120,6 +184,31 @@ public:
 		binaryShaderDesc.mVert.pByteCode = (char*)gShaderFontstash3DVert;
 		binaryShaderDesc.mVert.pEntryPoint = "main";
 		addShaderBinary(pRenderer, &binaryShaderDesc, &pShaders[1]);
+		binaryShaderDesc.mVert.mByteCodeSize = sizeof(gShaderFontstashBatch2DVert);
+		binaryShaderDesc.mVert.pByteCode = (char*)gShaderFontstashBatch2DVert;
+		binaryShaderDesc.mVert.pEntryPoint = "main";
+		binaryShaderDesc.mFrag.mByteCodeSize = sizeof(gShaderFontstashBatchFrag);
+		binaryShaderDesc.mFrag.pByteCode = (char*)gShaderFontstashBatchFrag;
+		binaryShaderDesc.mFrag.pEntryPoint = "main";
+		addShaderBinary(pRenderer, &binaryShaderDesc, &pShaders[2]);
+		binaryShaderDesc.mVert.mByteCodeSize = sizeof(gShaderFontstash2DVert);
+		binaryShaderDesc.mVert.pByteCode = (char*)gShaderFontstash2DVert;
+		binaryShaderDesc.mVert.pEntryPoint = "main";
+		binaryShaderDesc.mFrag.mByteCodeSize = sizeof(gShaderFontstashSDFFrag);
+		binaryShaderDesc.mFrag.pByteCode = (char*)gShaderFontstashSDFFrag;
+		binaryShaderDesc.mFrag.pEntryPoint = "main";
+		addShaderBinary(pRenderer, &binaryShaderDesc, &pShaders[FONTSTASH_PIPELINE_SDF_OFFSET + 0]);
+		binaryShaderDesc.mVert.mByteCodeSize = sizeof(gShaderFontstash3DVert);
+		binaryShaderDesc.mVert.pByteCode = (char*)gShaderFontstash3DVert;
+		binaryShaderDesc.mVert.pEntryPoint = "main";
+		addShaderBinary(pRenderer, &binaryShaderDesc, &pShaders[FONTSTASH_PIPELINE_SDF_OFFSET + 1]);
+		binaryShaderDesc.mVert.mByteCodeSize = sizeof(gShaderFontstashBatch2DVert);
+		binaryShaderDesc.mVert.pByteCode = (char*)gShaderFontstashBatch2DVert;
+		binaryShaderDesc.mVert.pEntryPoint = "main";
+		binaryShaderDesc.mFrag.mByteCodeSize = sizeof(gShaderFontstashBatchSDFFrag);
+		binaryShaderDesc.mFrag.pByteCode = (char*)gShaderFontstashBatchSDFFrag;
+		binaryShaderDesc.mFrag.pEntryPoint = "main";
+		addShaderBinary(pRenderer, &binaryShaderDesc, &pShaders[FONTSTASH_PIPELINE_SDF_OFFSET + 2]);
 #else
 		ShaderLoadDesc text2DShaderDesc = {};
 		text2DShaderDesc.mStages[0] = { "fontstash2D.vert", NULL, 0, NULL };
@@ -127,12 +216,23 @@ public:
 		ShaderLoadDesc text3DShaderDesc = {};
 		text3DShaderDesc.mStages[0] = { "fontstash3D.vert", NULL, 0, NULL };
 		text3DShaderDesc.mStages[1] = { "fontstash.frag", NULL, 0, NULL };
+		ShaderLoadDesc textBatch2DShaderDesc = {};
+		textBatch2DShaderDesc.mStages[0] = { "fontstashBatch2D.vert", NULL, 0, NULL };
+		textBatch2DShaderDesc.mStages[1] = { "fontstashBatch.frag", NULL, 0, NULL };
 
 		addShader(pRenderer, &text2DShaderDesc, &pShaders[0]);
 		addShader(pRenderer, &text3DShaderDesc, &pShaders[1]);
+		addShader(pRenderer, &textBatch2DShaderDesc, &pShaders[2]);
+
+		text2DShaderDesc.mStages[1] = { "fontstashSDF.frag", NULL, 0, NULL };
+		text3DShaderDesc.mStages[1] = { "fontstashSDF.frag", NULL, 0, NULL };
+		textBatch2DShaderDesc.mStages[1] = { "fontstashBatchSDF.frag", NULL, 0, NULL };
+		addShader(pRenderer, &text2DShaderDesc, &pShaders[FONTSTASH_PIPELINE_SDF_OFFSET + 0]);
+		addShader(pRenderer, &text3DShaderDesc, &pShaders[FONTSTASH_PIPELINE_SDF_OFFSET + 1]);
+		addShader(pRenderer, &textBatch2DShaderDesc, &pShaders[FONTSTASH_PIPELINE_SDF_OFFSET + 2]);
 #endif
 
-		RootSignatureDesc textureRootDesc = { pShaders, 2 };
+		RootSignatureDesc textureRootDesc = { pShaders, FONTSTASH_PIPELINE_COUNT };
 		const char* pStaticSamplers[] = { "uSampler0" };
 		textureRootDesc.mStaticSamplerCount = 1;
 		textureRootDesc.ppStaticSamplerNames = pStaticSamplers;
@@ -142,16 +242,19 @@ public:
 		addUniformGPURingBuffer(pRenderer, 65536, &pUniformRingBuffer, true);
 
 		uint64_t size = sizeof(mat4);
-		DescriptorSetDesc setDesc = { pRootSignature, DESCRIPTOR_UPDATE_FREQ_NONE, 2 };
+		DescriptorSetDesc setDesc = { pRootSignature, DESCRIPTOR_UPDATE_FREQ_NONE, FONTSTASH_ATLAS_PAGE_COUNT * FONTSTASH_PAGE_DESCRIPTOR_SET_COUNT };
 		addDescriptorSet(pRenderer, &setDesc, &pDescriptorSets);
-		DescriptorData setParams[2] = {};
-		setParams[0].pName = "uniformBlock_rootcbv";
-		setParams[0].ppBuffers = &pUniformRingBuffer->pBuffer;
-		setParams[0].pSizes = &size;
-		setParams[1].pName = "uTex0";
-		setParams[1].ppTextures = &pCurrentTexture;
-		updateDescriptorSet(pRenderer, 0, pDescriptorSets, 2, setParams);
-		updateDescriptorSet(pRenderer, 1, pDescriptorSets, 2, setParams);
+		for (uint32_t i = 0; i < FONTSTASH_ATLAS_PAGE_COUNT; ++i)
+		{
+			DescriptorData setParams[2] = {};
+			setParams[0].pName = "uniformBlock_rootcbv";
+			setParams[0].ppBuffers = &pUniformRingBuffer->pBuffer;
+			setParams[0].pSizes = &size;
+			setParams[1].pName = "uTex0";
+			setParams[1].ppTextures = &mPages[i].pTexture;
+			for (uint32_t j = 0; j < FONTSTASH_PAGE_DESCRIPTOR_SET_COUNT; ++j)
+				updateDescriptorSet(pRenderer, i * FONTSTASH_PAGE_DESCRIPTOR_SET_COUNT + j, pDescriptorSets, 2, setParams);
+		}
 
 		BufferDesc vbDesc = {};
 		vbDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
@@ -170,7 +273,8 @@ public:
 		// unload fontstash context
 		fonsDeleteInternal(pContext);
 
-		removeResource(pCurrentTexture);
+		for (uint32_t i = 0; i < FONTSTASH_ATLAS_PAGE_COUNT; ++i)
+			removeResource(mPages[i].pTexture);
 
 		// unload font buffers
 		for (unsigned int i = 0; i < (uint32_t)mFontBuffers.size(); i++)
@@ -179,7 +283,7 @@ public:
 		removeDescriptorSet(pRenderer, pDescriptorSets);
 		removeRootSignature(pRenderer, pRootSignature);
 
-		for (uint32_t i = 0; i < 2; ++i)
+		for (uint32_t i = 0; i < FONTSTASH_PIPELINE_COUNT; ++i)
 		{
 			removeShader(pRenderer, pShaders[i]);
 		}
@@ -249,8 +353,29 @@ public:
 			pipelineDesc.mGraphicsDesc.pDepthState = &depthStateDesc[i];
 			pipelineDesc.mGraphicsDesc.pRasterizerState = &rasterizerStateDesc[i];
 			addPipeline(pRenderer, &pipelineDesc, &pPipelines[i]);
+
+			pipelineDesc.mGraphicsDesc.pShaderProgram = pShaders[FONTSTASH_PIPELINE_SDF_OFFSET + i];
+			addPipeline(pRenderer, &pipelineDesc, &pPipelines[FONTSTASH_PIPELINE_SDF_OFFSET + i]);
 		}
 
+		// Same states as the 2D text, with the color moving from the root constants to the vertices
+		VertexLayout batchVertexLayout = vertexLayout;
+		batchVertexLayout.mAttribCount = 3;
+		batchVertexLayout.mAttribs[1].mFormat = TinyImageFormat_R16G16_UNORM;
+		batchVertexLayout.mAttribs[1].mOffset = offsetof(TextBatchVertex, mTexCoord);
+		batchVertexLayout.mAttribs[2].mSemantic = SEMANTIC_COLOR;
+		batchVertexLayout.mAttribs[2].mFormat = TinyImageFormat_R8G8B8A8_UNORM;
+		batchVertexLayout.mAttribs[2].mBinding = 0;
+		batchVertexLayout.mAttribs[2].mLocation = 2;
+		batchVertexLayout.mAttribs[2].mOffset = offsetof(TextBatchVertex, mColor);
+
+		pipelineDesc.mGraphicsDesc.mDepthStencilFormat = TinyImageFormat_UNDEFINED;
+		pipelineDesc.mGraphicsDesc.pShaderProgram = pShaders[FONTSTASH_PIPELINE_BATCH_2D];
+		pipelineDesc.mGraphicsDesc.pDepthState = &depthStateDesc[0];
+		pipelineDesc.mGraphicsDesc.pRasterizerState = &rasterizerStateDesc[0];
+		pipelineDesc.mGraphicsDesc.pVertexLayout = &batchVertexLayout;
+		addPipeline(pRenderer, &pipelineDesc, &pPipelines[FONTSTASH_PIPELINE_BATCH_2D]);
+
 		mScaleBias = { 2.0f / (float)pRts[0]->mWidth, -2.0f / (float)pRts[0]->mHeight };
 
 		return true;
@@ -258,7 +383,7 @@ public:
 
 	void unload()
 	{
-		for (uint32_t i = 0; i < 2; ++i)
+		for (uint32_t i = 0; i < FONTSTASH_PIPELINE_COUNT; ++i)
 		{
 			if (pPipelines[i])
 				removePipeline(pRenderer, pPipelines[i]);
@@ -272,12 +397,33 @@ public:
 	static void fonsImplementationRenderText(void* userPtr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts);
 	static void fonsImplementationRemoveTexture(void* userPtr);
 
+	// Flips to the back atlas page once its upload completed and starts uploading the glyphs it lacks, never waits on the GPU
+	void updateTexture();
+
+	// Queues the upload of the dirty region of the page to the resource loader
+	void uploadPage(AtlasPage& page);
+
+	// Uploads the whole atlas to every page and waits for it, only used when the atlas is (re)initialized
+	void uploadAtlas();
+
+	// Selects the font for the next draw or measure, SDF fonts are drawn with the SDF pipelines
+	void setFont(int fontID);
+
+	// Index of the descriptor set sampling the front atlas page
+	uint32_t getDescriptorSetIndex(uint32_t pipelineIndex) const { return mFrontPage * FONTSTASH_PAGE_DESCRIPTOR_SET_COUNT + pipelineIndex; }
+
+	// Draws the glyphs batched since the last flush with a single draw call
+	void flushBatch(Cmd* pCmd);
+
 	Renderer*    pRenderer;
 	FONScontext* pContext;
 
+	// CPU copy of the atlas owned by the FONS context
 	const uint8_t* pPixels;
-	Texture*       pCurrentTexture;
-	bool           mUpdateTexture;
+	// Draws sample mPages[mFrontPage], glyphs added since its last upload are missing until the next flip
+	AtlasPage      mPages[FONTSTASH_ATLAS_PAGE_COUNT];
+	uint32_t       mFrontPage;
+	uint64_t       mFrameIndex;
 
 	uint32_t mWidth;
 	uint32_t mHeight;
@@ -291,10 +437,10 @@ public:
 	mat4 mWorldMat;
 	Cmd* pCmd;
 
-	Shader*            pShaders[2];
+	Shader*            pShaders[FONTSTASH_PIPELINE_COUNT];
 	RootSignature*     pRootSignature;
 	DescriptorSet*     pDescriptorSets;
-	Pipeline*          pPipelines[2];
+	Pipeline*          pPipelines[FONTSTASH_PIPELINE_COUNT];
 	/// Default states
 	Sampler*             pDefaultSampler;
 	GPURingBuffer*       pUniformRingBuffer;
@@ -302,6 +448,13 @@ public:
 	float2               mDpiScale;
 	float                mDpiScaleMin;
 	bool                 mText3D;
+	bool                 mSDF;
+
+	// Batched glyphs are written straight to consecutive slices of pMeshRingBuffer, starting at mBatchStart
+	GPURingBufferOffset mBatchStart;
+	uint32_t            mBatchVertexCount;
+	bool                mBatchSDF;
+	bool                mBatching;
 };
 
 bool Fontstash::init(Renderer* renderer, uint32_t width, uint32_t height, uint32_t ringSizeBytes)
@@ -360,6 +513,95 @@ int Fontstash::defineFont(const char* identification, const char* pFontPath)
 	return INT32_MAX;
 }
 
+int Fontstash::defineSDFFont(const char* identification, const char* pFontPath, float sdfSize /*=48.0f*/)
+{
+	int fontID = defineFont(identification, pFontPath);
+	if (fontID < 0 || fontID == INT32_MAX)
+		return fontID;
+
+	if (!fonsSetFontSDF(impl->pContext, fontID, sdfSize))
+	{
+		LOGF(LogLevel::eWARNING, "Font '%s' can not be rendered as SDF, falling back to regular glyphs", pFontPath);
+	}
+
+	return fontID;
+}
+
+void Fontstash::bakeGlyphs(int fontID, const char* characters, float size /*=16.0f*/)
+{
+	float bounds[4] = {};
+	measureText(bounds, characters, 0.0f, 0.0f, fontID, 0xffffffff, size);
+}
+
+bool Fontstash::saveAtlas(ResourceDirectory resourceDir, const char* fileName)
+{
+	FONScontext* fs = impl->pContext;
+	const int    size = fonsSaveAtlas(fs, NULL, 0);
+	if (size <= 0)
+		return false;
+
+	unsigned char* pData = (unsigned char*)tf_malloc(size);
+	fonsSaveAtlas(fs, pData, size);
+
+	FontstashAtlasFileHeader header = {};
+	header.mMagic = FONTSTASH_ATLAS_FILE_MAGIC;
+	header.mVersion = FONTSTASH_ATLAS_FILE_VERSION;
+	header.mSize = (uint32_t)size;
+
+	FileStream fh = {};
+	bool       success = fsOpenStreamFromPath(resourceDir, fileName, FM_WRITE_BINARY, &fh);
+	if (success)
+	{
+		success = fsWriteToStream(&fh, &header, sizeof(header)) == sizeof(header) &&
+				  fsWriteToStream(&fh, pData, (size_t)size) == (size_t)size;
+		fsCloseStream(&fh);
+	}
+
+	tf_free(pData);
+	if (!success)
+		LOGF(LogLevel::eERROR, "Failed to write font atlas '%s'", fileName);
+	return success;
+}
+
+bool Fontstash::loadAtlas(ResourceDirectory resourceDir, const char* fileName)
+{
+	FileStream fh = {};
+	if (!fsOpenStreamFromPath(resourceDir, fileName, FM_READ_BINARY, &fh))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open font atlas '%s'", fileName);
+		return false;
+	}
+
+	FontstashAtlasFileHeader header = {};
+	const ssize_t            fileSize = fsGetStreamFileSize(&fh);
+	if (fsReadFromStream(&fh, &header, sizeof(header)) != sizeof(header) || header.mMagic != FONTSTASH_ATLAS_FILE_MAGIC ||
+		header.mVersion != FONTSTASH_ATLAS_FILE_VERSION || (ssize_t)(sizeof(header) + header.mSize) > fileSize)
+	{
+		LOGF(LogLevel::eERROR, "'%s' is not a valid font atlas", fileName);
+		fsCloseStream(&fh);
+		return false;
+	}
+
+	unsigned char* pData = (unsigned char*)tf_malloc(header.mSize);
+	bool           success = fsReadFromStream(&fh, pData, header.mSize) == header.mSize;
+	fsCloseStream(&fh);
+
+	// An atlas of another size is rejected as is, a truncated one leaves the atlas empty
+	success = success && fonsLoadAtlas(impl->pContext, pData, (int)header.mSize);
+	tf_free(pData);
+	if (!success)
+	{
+		LOGF(LogLevel::eERROR, "Font atlas '%s' does not match the defined fonts", fileName);
+		return false;
+	}
+
+	// Both pages get the whole atlas, fontstash itself no longer needs to report the restored glyphs
+	int dirtyRect[4] = {};
+	fonsValidateTexture(impl->pContext, dirtyRect);
+	impl->uploadAtlas();
+	return true;
+}
+
 void* Fontstash::getFontBuffer(uint32_t index)
 {
 	if (index < impl->mFontBuffers.size())
@@ -380,13 +622,14 @@ void Fontstash::drawText(
 {
 	impl->mText3D = false;
 	impl->pCmd = pCmd;
+	impl->setFont(fontID);
 	// clamp the font size to max size.
-	// Precomputed font texture puts limitation to the maximum size.
-	size = min(size, m_fFontMaxSize);
+	// Precomputed font texture puts limitation to the maximum size. SDF glyphs are rasterized at a fixed size.
+	if (!impl->mSDF)
+		size = min(size, m_fFontMaxSize);
 
 	FONScontext* fs = impl->pContext;
 	fonsSetSize(fs, size * impl->mDpiScaleMin);
-	fonsSetFont(fs, fontID);
 	fonsSetColor(fs, color);
 	fonsSetSpacing(fs, spacing * impl->mDpiScaleMin);
 	fonsSetBlur(fs, blur);
@@ -406,13 +649,14 @@ void Fontstash::drawText(
 	impl->mProjView = projView;
 	impl->mWorldMat = worldMat;
 	impl->pCmd = pCmd;
+	impl->setFont(fontID);
 	// clamp the font size to max size.
-	// Precomputed font texture puts limitation to the maximum size.
-	size = min(size, m_fFontMaxSize);
+	// Precomputed font texture puts limitation to the maximum size. SDF glyphs are rasterized at a fixed size.
+	if (!impl->mSDF)
+		size = min(size, m_fFontMaxSize);
 
 	FONScontext* fs = impl->pContext;
 	fonsSetSize(fs, size * impl->mDpiScaleMin);
-	fonsSetFont(fs, fontID);
 	fonsSetColor(fs, color);
 	fonsSetSpacing(fs, spacing * impl->mDpiScaleMin);
 	fonsSetBlur(fs, blur);
@@ -420,6 +664,23 @@ void Fontstash::drawText(
 	fonsDrawText(fs, 0.0f, 0.0f, message, NULL);
 }
 
+void Fontstash::beginBatch()
+{
+	impl->mBatchVertexCount = 0;
+	impl->mBatching = true;
+}
+
+void Fontstash::endBatch(Cmd* pCmd)
+{
+	impl->mBatching = false;
+	impl->flushBatch(pCmd);
+}
+
+void Fontstash::endFrame()
+{
+	++impl->mFrameIndex;
+}
+
 float Fontstash::measureText(
 	float* out_bounds, const char* message, float x, float y, int fontID, unsigned int color /*=0xffffffff*/
 	,
@@ -436,7 +697,7 @@ float Fontstash::measureText(
 	const int    messageLength = (int)strlen(message);
 	FONScontext* fs = impl->pContext;
 	fonsSetSize(fs, size * impl->mDpiScaleMin);
-	fonsSetFont(fs, fontID);
+	impl->setFont(fontID);
 	fonsSetColor(fs, color);
 	fonsSetSpacing(fs, spacing * impl->mDpiScaleMin);
 	fonsSetBlur(fs, blur);
@@ -455,52 +716,76 @@ int _Impl_FontStash::fonsImplementationGenerateTexture(void* userPtr, int width,
 	ctx->mWidth = width;
 	ctx->mHeight = height;
 
-	ctx->mUpdateTexture = true;
-
 	return 1;
 }
 
 void _Impl_FontStash::fonsImplementationModifyTexture(void* userPtr, int* rect, const unsigned char* data)
 {
-	UNREF_PARAM(rect);
-
 	_Impl_FontStash* ctx = (_Impl_FontStash*)userPtr;
 
 	ctx->pPixels = data;
-	ctx->mUpdateTexture = true;
+	for (uint32_t i = 0; i < FONTSTASH_ATLAS_PAGE_COUNT; ++i)
+	{
+		int* dirtyRect = ctx->mPages[i].mDirtyRect;
+		if (dirtyRect[0] >= dirtyRect[2] || dirtyRect[1] >= dirtyRect[3])
+		{
+			memcpy(dirtyRect, rect, sizeof(ctx->mPages[i].mDirtyRect));
+			continue;
+		}
+
+		dirtyRect[0] = min(dirtyRect[0], rect[0]);
+		dirtyRect[1] = min(dirtyRect[1], rect[1]);
+		dirtyRect[2] = max(dirtyRect[2], rect[2]);
+		dirtyRect[3] = max(dirtyRect[3], rect[3]);
+	}
 }
 
 void _Impl_FontStash::fonsImplementationRenderText(
 	void* userPtr, const float* verts, const float* tcoords, const unsigned int* colors, int nverts)
 {
 	_Impl_FontStash* ctx = (_Impl_FontStash*)userPtr;
-	if (!ctx->pCurrentTexture)
+	if (!ctx->mPages[0].pTexture)
 		return;
 
-	Cmd* pCmd = ctx->pCmd;
-
-	if (ctx->mUpdateTexture)
+	// Batched 2D text is only appended here and drawn by endBatch
+	if (ctx->mBatching && !ctx->mText3D)
 	{
-		// #TODO: Investigate - Causes hang on low-mid end Android phones (tested on Samsung Galaxy A50s)
-#ifndef __ANDROID__
-		waitQueueIdle(pCmd->pQueue);
-#endif
+		// Slices are only aligned to the vertex members so consecutive ones stay contiguous,
+		// a new draw is only needed when the ring buffer wraps around
+		GPURingBufferOffset buffer = getGPURingBufferOffset(ctx->pMeshRingBuffer, nverts * sizeof(TextBatchVertex), sizeof(uint32_t));
+		if (!buffer.pBuffer)
+			return;
+
+		if (!ctx->mBatchVertexCount || buffer.pBuffer != ctx->mBatchStart.pBuffer ||
+			buffer.mOffset != ctx->mBatchStart.mOffset + ctx->mBatchVertexCount * sizeof(TextBatchVertex) ||
+			ctx->mSDF != ctx->mBatchSDF)
+		{
+			ctx->flushBatch(ctx->pCmd);
+			ctx->mBatchStart = buffer;
+			ctx->mBatchSDF = ctx->mSDF;
+		}
 
-		SyncToken token = {};
-		TextureUpdateDesc updateDesc = {};
-		updateDesc.pTexture = ctx->pCurrentTexture;
-		beginUpdateResource(&updateDesc);
-		for (uint32_t r = 0; r < updateDesc.mRowCount; ++r)
+		BufferUpdateDesc update = { buffer.pBuffer, buffer.mOffset };
+		beginUpdateResource(&update);
+		TextBatchVertex* pVertices = (TextBatchVertex*)update.pMappedData;
+		for (int i = 0; i < nverts; ++i)
 		{
-			memcpy(updateDesc.pMappedData + r * updateDesc.mDstRowStride,
-				ctx->pPixels + r * updateDesc.mSrcRowStride, updateDesc.mSrcRowStride);
+			pVertices[i].mPosition[0] = verts[i * 2 + 0];
+			pVertices[i].mPosition[1] = verts[i * 2 + 1];
+			pVertices[i].mTexCoord[0] = (uint16_t)(tcoords[i * 2 + 0] * 65535.0f + 0.5f);
+			pVertices[i].mTexCoord[1] = (uint16_t)(tcoords[i * 2 + 1] * 65535.0f + 0.5f);
+			pVertices[i].mColor = colors[i];
 		}
-		endUpdateResource(&updateDesc, &token);
-		waitForToken(&token);
+		endUpdateResource(&update, NULL);
 
-		ctx->mUpdateTexture = false;
+		ctx->mBatchVertexCount += nverts;
+		return;
 	}
 
+	Cmd* pCmd = ctx->pCmd;
+
+	ctx->updateTexture();
+
 	GPURingBufferOffset buffer = getGPURingBufferOffset(ctx->pMeshRingBuffer, nverts * sizeof(float4));
 	BufferUpdateDesc update = { buffer.pBuffer, buffer.mOffset };
 	beginUpdateResource(&update);
@@ -521,8 +806,8 @@ void _Impl_FontStash::fonsImplementationRenderText(
 	for (int i = 0; i < 4; i++)
 		color[i] = ((float)colorByte[i]) / 255.0f;
 
-	uint32_t                               pipelineIndex = ctx->mText3D ? 1 : 0;
-	Pipeline*                              pPipeline = ctx->pPipelines[pipelineIndex];
+	uint32_t                               pipelineIndex = ctx->mText3D ? FONTSTASH_PIPELINE_3D : FONTSTASH_PIPELINE_2D;
+	Pipeline*                              pPipeline = ctx->pPipelines[pipelineIndex + (ctx->mSDF ? FONTSTASH_PIPELINE_SDF_OFFSET : 0)];
 	ASSERT(pPipeline);
 
 	cmdBindPipeline(pCmd, pPipeline);
@@ -557,8 +842,8 @@ void _Impl_FontStash::fonsImplementationRenderText(
 		params[0].ppBuffers = &uniformBlock.pBuffer;
 		params[0].pOffsets = &uniformBlock.mOffset;
 		params[0].pSizes = &size;
-		updateDescriptorSet(ctx->pRenderer, pipelineIndex, ctx->pDescriptorSets, 1, params);
-		cmdBindDescriptorSet(pCmd, pipelineIndex, ctx->pDescriptorSets);
+		updateDescriptorSet(ctx->pRenderer, ctx->getDescriptorSetIndex(pipelineIndex), ctx->pDescriptorSets, 1, params);
+		cmdBindDescriptorSet(pCmd, ctx->getDescriptorSetIndex(pipelineIndex), ctx->pDescriptorSets);
 		cmdBindPushConstants(pCmd, ctx->pRootSignature, "uRootConstants", &data);
 		cmdBindVertexBuffer(pCmd, 1, &buffer.pBuffer, &stride, &buffer.mOffset);
 		cmdDraw(pCmd, nverts, 0);
@@ -566,13 +851,115 @@ void _Impl_FontStash::fonsImplementationRenderText(
 	else
 	{
 		const uint32_t stride = sizeof(float4);
-		cmdBindDescriptorSet(pCmd, pipelineIndex, ctx->pDescriptorSets);
+		cmdBindDescriptorSet(pCmd, ctx->getDescriptorSetIndex(pipelineIndex), ctx->pDescriptorSets);
 		cmdBindPushConstants(pCmd, ctx->pRootSignature, "uRootConstants", &data);
 		cmdBindVertexBuffer(pCmd, 1, &buffer.pBuffer, &stride, &buffer.mOffset);
 		cmdDraw(pCmd, nverts, 0);
 	}
 }
 
+void _Impl_FontStash::updateTexture()
+{
+	AtlasPage& back = mPages[(mFrontPage + 1) % FONTSTASH_ATLAS_PAGE_COUNT];
+
+	// The back page holds every glyph the front page has once its upload landed, start sampling it
+	if (back.mUploading && isTokenCompleted(&back.mUploadToken))
+	{
+		back.mUploading = false;
+		mPages[mFrontPage].mRetireFrame = mFrameIndex;
+		mFrontPage = (mFrontPage + 1) % FONTSTASH_ATLAS_PAGE_COUNT;
+		return;
+	}
+
+	// Frames still in flight may sample the back page until it has been retired for long enough
+	if (back.mUploading || mFrameIndex < back.mRetireFrame + FONTSTASH_ATLAS_PAGE_RETIRE_FRAMES)
+		return;
+
+	if (back.mDirtyRect[0] < back.mDirtyRect[2] && back.mDirtyRect[1] < back.mDirtyRect[3])
+		uploadPage(back);
+}
+
+void _Impl_FontStash::uploadPage(AtlasPage& page)
+{
+	const uint32_t x = (uint32_t)page.mDirtyRect[0];
+	const uint32_t y = (uint32_t)page.mDirtyRect[1];
+
+	TextureUpdateDesc updateDesc = {};
+	updateDesc.pTexture = page.pTexture;
+	updateDesc.mRegionX = x;
+	updateDesc.mRegionY = y;
+	updateDesc.mRegionWidth = (uint32_t)page.mDirtyRect[2] - x;
+	updateDesc.mRegionHeight = (uint32_t)page.mDirtyRect[3] - y;
+	beginUpdateResource(&updateDesc);
+	for (uint32_t r = 0; r < updateDesc.mRowCount; ++r)
+	{
+		memcpy(updateDesc.pMappedData + r * updateDesc.mDstRowStride,
+			pPixels + (y + r) * mWidth + x, updateDesc.mSrcRowStride);
+	}
+	endUpdateResource(&updateDesc, &page.mUploadToken);
+
+	page.mUploading = true;
+	page.mDirtyRect[0] = (int)mWidth;
+	page.mDirtyRect[1] = (int)mHeight;
+	page.mDirtyRect[2] = 0;
+	page.mDirtyRect[3] = 0;
+}
+
+void _Impl_FontStash::uploadAtlas()
+{
+	int atlasWidth = 0;
+	int atlasHeight = 0;
+	pPixels = fonsGetTextureData(pContext, &atlasWidth, &atlasHeight);
+	SyncToken token = {};
+	for (uint32_t i = 0; i < FONTSTASH_ATLAS_PAGE_COUNT; ++i)
+	{
+		AtlasPage& page = mPages[i];
+		page.mDirtyRect[0] = 0;
+		page.mDirtyRect[1] = 0;
+		page.mDirtyRect[2] = atlasWidth;
+		page.mDirtyRect[3] = atlasHeight;
+		uploadPage(page);
+		page.mUploading = false;
+		token = max(token, page.mUploadToken);
+	}
+	waitForToken(&token);
+}
+
+void _Impl_FontStash::setFont(int fontID)
+{
+	fonsSetFont(pContext, fontID);
+	mSDF = fonsGetFontSDF(pContext, fontID) > 0.0f;
+}
+
+void _Impl_FontStash::flushBatch(Cmd* pCmd)
+{
+	const uint32_t vertexCount = mBatchVertexCount;
+	mBatchVertexCount = 0;
+	if (!vertexCount)
+		return;
+
+	updateTexture();
+
+	Pipeline* pPipeline = pPipelines[FONTSTASH_PIPELINE_BATCH_2D + (mBatchSDF ? FONTSTASH_PIPELINE_SDF_OFFSET : 0)];
+	ASSERT(pPipeline);
+
+	struct UniformData
+	{
+		float4 color;
+		float2 scaleBias;
+	} data;
+
+	data.color = float4(1.0f);
+	data.scaleBias = mScaleBias;
+
+	const uint32_t stride = sizeof(TextBatchVertex);
+	cmdBindPipeline(pCmd, pPipeline);
+	cmdBindDescriptorSet(pCmd, getDescriptorSetIndex(FONTSTASH_PIPELINE_2D), pDescriptorSets);
+	cmdBindPushConstants(pCmd, pRootSignature, "uRootConstants", &data);
+	cmdBindVertexBuffer(pCmd, 1, &mBatchStart.pBuffer, &stride, &mBatchStart.mOffset);
+	cmdDraw(pCmd, vertexCount, 0);
+}
+
 void _Impl_FontStash::fonsImplementationRemoveTexture(void* userPtr)
 {
 	UNREF_PARAM(userPtr);
@@ -63,6 +63,22 @@ public:
 	//! - When it is paramount to be able to unload individual fonts, use multiple fontstashes.
 	int defineFont(const char* identification, const char* pFontPath);
 
+	//! Same as defineFont, but glyphs are stored once as signed distance fields rasterized at sdfSize pixels and stay
+	//! sharp at any size, including world space text. Not clamped to the maximum font size and blur is ignored.
+	//! - Must be called before any text is drawn or measured with the font.
+	int defineSDFFont(const char* identification, const char* pFontPath, float sdfSize = 48.0f);
+
+	//! Rasterizes the glyphs of characters (UTF-8) into the atlas without drawing them, e.g. before saveAtlas.
+	//! Only SDF fonts share glyphs across sizes, other fonts have to be baked at every size they are drawn with.
+	void bakeGlyphs(int fontID, const char* characters, float size = 16.0f);
+
+	//! Pre-baked atlas files.
+	//! - saveAtlas writes the atlas texels and the glyphs cached so far.
+	//! - loadAtlas replaces the atlas with the file so the glyphs it holds are never rasterized. The fonts have to be
+	//!   defined as when the file was saved (same identifications and SDF sizes) and the Fontstash must have the same size.
+	bool saveAtlas(ResourceDirectory resourceDir, const char* fileName);
+	bool loadAtlas(ResourceDirectory resourceDir, const char* fileName);
+
 	void*       getFontBuffer(uint32_t index);
 	uint32_t    getFontBufferSize(uint32_t index);
 
@@ -76,6 +92,18 @@ public:
 		struct Cmd* pCmd, const char* message, const mat4& projView, const mat4& worldMat, int fontID, unsigned int color = 0xffffffff,
 		float size = 16.0f, float spacing = 0.0f, float blur = 0.0f);
 
+	//! Deferred text batch.
+	//! - Between beginBatch and endBatch, screen space drawText calls only append their glyphs, with their color, to the
+	//!   ring buffer given to init. World space text is still drawn immediately.
+	//! - endBatch records a single draw call for the whole batch into pCmd, plus one more each time the ring buffer
+	//!   wrapped around (6 vertices of 16 bytes per glyph).
+	void beginBatch();
+	void endBatch(struct Cmd* pCmd);
+
+	//! Call once per frame. New glyphs are uploaded to a second atlas page without waiting on the GPU and show up once
+	//! the upload completed, the frame count tells when the GPU is done sampling the page that is not drawn with anymore.
+	void endFrame();
+
 	//! Measure text boundaries. Results will be written to out_bounds (x,y,x2,y2).
 	float measureText(
 		float* out_bounds, const char* message, float x, float y, int fontID, unsigned int color = 0xffffffff, float size = 16.0f,
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+struct PsIn
+{
+	float4 position: SV_Position;
+	float2 texCoord: TEXCOORD0;
+	float4 color: COLOR0;
+};
+
+Texture2D uTex0 : register(t2);
+SamplerState uSampler0 : register(s3);
+
+float4 main(PsIn In) : SV_Target
+{
+	float dist = uTex0.Sample(uSampler0, In.texCoord).r;
+	// The field is 0.5 on the outline, the screen space derivative keeps the edge a pixel wide at any scale
+	float width = max(fwidth(dist) * 0.7, 0.001);
+	return float4(1.0, 1.0, 1.0, smoothstep(0.5 - width, 0.5 + width, dist)) * In.color;
+}
@@ -0,0 +1,17 @@
+#version 100
+#extension GL_OES_standard_derivatives : enable
+precision mediump float;
+precision mediump int;
+
+varying vec2 vertOutput_TEXCOORD0;
+varying vec4 vertOutput_COLOR0;
+
+uniform sampler2D uTex0;
+
+void main()
+{
+    float dist = texture2D(uTex0, vec2(vertOutput_TEXCOORD0)).r;
+    // The field is 0.5 on the outline, the screen space derivative keeps the edge a pixel wide at any scale
+    float width = max(fwidth(dist) * 0.7, 0.001);
+    gl_FragColor = vec4(1.0, 1.0, 1.0, smoothstep(0.5 - width, 0.5 + width, dist)) * vertOutput_COLOR0;
+}
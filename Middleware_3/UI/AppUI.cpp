@@ -764,7 +764,7 @@ bool UIApp::Init(Renderer* renderer, PipelineCache* pCache)
 
 	pLuaManager->SetFunction("LOGINFO", [](ILuaStateWrap* state) -> int {
 		eastl::string str = state->GetStringArg(1);
-		LOGF(LogLevel::eINFO, str.c_str());
+		LOGF(LogLevel::eINFO, "%s", str.c_str());
 		return 0;
 	});
 
@@ -844,6 +844,14 @@ uint32_t UIApp::LoadFont(const char* pFontPath)
 	return fontID;
 }
 
+uint32_t UIApp::LoadSDFFont(const char* pFontPath, float sdfSize)
+{
+	uint32_t fontID = (uint32_t)pImpl->pFontStash->defineSDFFont(pFontPath, pFontPath, sdfSize);
+	ASSERT(fontID != -1);
+
+	return fontID;
+}
+
 float2 UIApp::MeasureText(const char* pText, const TextDrawDesc& drawDesc) const
 {
 	float textBounds[4] = {};
@@ -867,6 +875,16 @@ void UIApp::DrawTextInWorldSpace(Cmd* pCmd, const char* pText, const mat4& matWo
 		pCmd, pText, matProjView, matWorld, pDesc->mFontID, pDesc->mFontColor, pDesc->mFontSize, pDesc->mFontSpacing, pDesc->mFontBlur);
 }
 
+void UIApp::BeginTextBatch()
+{
+	pImpl->pFontStash->beginBatch();
+}
+
+void UIApp::EndTextBatch(Cmd* pCmd)
+{
+	pImpl->pFontStash->endBatch(pCmd);
+}
+
 #if defined(__linux__) || defined(NX64)
 #define sprintf_s sprintf    // On linux and NX, we should use sprintf as sprintf_s is not part of the standard c library
 #endif
@@ -969,6 +987,8 @@ void UIApp::Update(float deltaTime)
 
 void UIApp::Draw(Cmd* pCmd)
 {
+	pImpl->pFontStash->endFrame();
+
 	if (pImpl->mUpdated)
 	{
 		pImpl->mUpdated = false;
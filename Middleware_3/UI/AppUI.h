@@ -976,6 +976,8 @@ public:
 	void RunTestScript(const char* filename);
 
 	uint          LoadFont(const char* pFontPath);
+	// Signed distance field font, see Fontstash::defineSDFFont. Identified by its path for pre-baked atlas files.
+	uint          LoadSDFFont(const char* pFontPath, float sdfSize = 48.0f);
 	GuiComponent* AddGuiComponent(const char* pTitle, const GuiDesc* pDesc);
 	void          RemoveGuiComponent(GuiComponent* pComponent);
 	void          RemoveAllGuiComponents();
@@ -998,6 +1000,12 @@ public:
 	//
 	void DrawTextInWorldSpace(Cmd* pCmd, const char* pText, const mat4& matWorld, const mat4& matProjView, const TextDrawDesc* pDrawDesc = NULL);
 
+	// screen space text drawn between these calls is recorded as a single draw call when EndTextBatch is called.
+	// see Fontstash::beginBatch
+	//
+	void BeginTextBatch();
+	void EndTextBatch(Cmd* pCmd);
+
 	bool    OnText(const wchar_t* pText) { return pDriver->onText(pText); }
 	bool    OnButton(uint32_t button, bool press, const float2* vec) { return pDriver->onButton(button, press, vec); }
 	uint8_t WantTextInput() { return pDriver->wantTextInput(); }